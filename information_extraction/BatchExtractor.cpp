@@ -0,0 +1,483 @@
+/**
+*******************************************************************************
+* @file			BatchExtractor.cpp
+* @brief 		This file provides the implementations of the class BatchExtractor.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "BatchExtractor.h"
+#include "../web_crawler/PageRecordFormat.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//boost lib
+#include <boost/thread.hpp>
+
+//tidy to clean the HTML pages
+#include <tidy.h>
+#include <buffio.h>
+
+//libxml2 parsers and XPath (libxml++ is built on libxml2)
+#include <libxml/parser.h>
+#include <libxml/HTMLparser.h>
+#include <libxml/xpath.h>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+
+
+/**
+*******************************************************************************
+* @class		ParserContext
+* @brief 		This class holds the parsers of one worker, created once and
+reused for every page of the worker.
+*******************************************************************************
+*/
+class ParserContext
+{
+	public:
+		//the tidy document and its buffers
+		TidyDoc tidy;
+		TidyBuffer tidyOutput;
+		TidyBuffer tidyErrors;
+		//the libxml2 parser contexts of the XML feeds and of the HTML pages
+		xmlParserCtxtPtr xmlParser;
+		htmlParserCtxtPtr htmlParser;
+		//the compiled XPath expression and its evaluation context
+		xmlXPathCompExprPtr recordsXPath;
+		xmlXPathContextPtr xpathContext;
+
+		//constructor
+		ParserContext(const string& expression)
+		{
+			tidy = tidyCreate();
+			tidyBufInit(&tidyOutput);
+			tidyBufInit(&tidyErrors);
+			tidySetErrorBuffer(tidy, &tidyErrors);
+			tidyOptSetBool(tidy, TidyForceOutput, yes);
+			tidyOptSetBool(tidy, TidyQuiet, yes);
+			tidyOptSetBool(tidy, TidyShowWarnings, no);
+			tidyOptSetBool(tidy, TidyNumEntities, yes);
+			tidyOptSetInt(tidy, TidyShowErrors, 0);
+			tidySetCharEncoding(tidy, "utf8");
+
+			xmlParser = xmlNewParserCtxt();
+			htmlParser = htmlNewParserCtxt();
+			recordsXPath = xmlXPathCompile(BAD_CAST expression.c_str());
+			xpathContext = xmlXPathNewContext(NULL);
+		}
+
+		//destructor
+		~ParserContext()
+		{
+			xmlXPathFreeContext(xpathContext);
+			xmlXPathFreeCompExpr(recordsXPath);
+			htmlFreeParserCtxt(htmlParser);
+			xmlFreeParserCtxt(xmlParser);
+			tidyBufFree(&tidyOutput);
+			tidyBufFree(&tidyErrors);
+			tidyRelease(tidy);
+		}
+
+		//check whether all the parsers have been created
+		bool isValid() const
+		{
+			return tidy != NULL && xmlParser != NULL && htmlParser != NULL &&
+				recordsXPath != NULL && xpathContext != NULL;
+		}
+};
+
+
+
+/**
+*******************************************************************************
+* @brief		This function appends the non-blank text of a subtree to a line,
+one field per text node; the tabs and line breaks of the text become spaces.
+* @param		xmlNodePtr -- node (the root of the subtree)
+* @param		string& -- line (output, the line of the record)
+* @return		void
+*******************************************************************************
+*/
+static void appendText(xmlNodePtr node, string& line)
+{
+	for (xmlNodePtr child = node->children; child != NULL; child = child->next) {
+		if ((child->type == XML_TEXT_NODE || child->type == XML_CDATA_SECTION_NODE) &&
+				child->content != NULL && !xmlIsBlankNode(child)) {
+			const char* text = (const char*)child->content;
+			size_t begin = line.size();
+			line += "\t";
+			line += text + strspn(text, " \t\r\n");
+			while (line.size() > begin + 1 && strchr(" \t\r\n", line[line.size() - 1]) != NULL) {
+				line.erase(line.size() - 1);
+			}
+			replace(line.begin() + begin + 1, line.end(), '\t', ' ');
+			replace(line.begin() + begin + 1, line.end(), '\n', ' ');
+			replace(line.begin() + begin + 1, line.end(), '\r', ' ');
+		}
+		else if (child->type == XML_ELEMENT_NODE && !xmlStrEqual(child->name, BAD_CAST "script") &&
+				!xmlStrEqual(child->name, BAD_CAST "style")) {
+			appendText(child, line);
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class BatchExtractor.
+* @param		string -- recordsXPath (the XPath expression selecting the records)
+* @return		None
+*******************************************************************************
+*/
+BatchExtractor::BatchExtractor(const string& recordsXPath) : recordsXPath_(recordsXPath),
+	nextEntry_(0), output_(NULL), numberPages_(0), numberRecords_(0), numberFailures_(0)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function lists the records of a segment file. Only the
+record headers are read; a record cut off by a crash ends the list.
+* @param		string -- path (the path of the segment file)
+* @return		int -- return 0 on success, and 1 if the file cannot be opened.
+*******************************************************************************
+*/
+int BatchExtractor::addSegment(const string& path)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == NULL) {
+		cerr << "Failed to open the segment " << path << endl;
+		return 1;
+	}
+	fseeko(file, 0, SEEK_END);
+	boost::uint64_t fileSize = ftello(file);
+	boost::uint64_t offset = 0;
+	char bytes[kPageRecordHeaderSize];
+	PageRecordHeader header;
+	while (offset + kPageRecordHeaderSize <= fileSize && fseeko(file, offset, SEEK_SET) == 0 &&
+			fread(bytes, 1, kPageRecordHeaderSize, file) == kPageRecordHeaderSize) {
+		if (!decodePageRecordHeader(bytes, kPageRecordHeaderSize, header) ||
+				header.getRecordLength() > fileSize - offset) {
+			break;
+		}
+		boost::uint64_t length = header.getRecordLength();
+		CorpusEntry entry;
+		entry.path = path;
+		entry.offset = offset;
+		entry.length = (boost::uint32_t)length;
+		entryVector_.push_back(entry);
+		offset += length;
+	}
+	fclose(file);
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function adds a path to the corpus: a segment file (*.seg)
+adds its records, a directory adds its files (not its subdirectories) and any
+other file is one page. In a directory the index, checkpoint, log, record,
+metrics and temporary files of the crawler are skipped.
+* @param		string -- path (the path of the file or directory)
+* @return		int -- return 0 on success, and 1 if the path cannot be read.
+*******************************************************************************
+*/
+int BatchExtractor::addPath(const string& path)
+{
+	struct stat status;
+	if (stat(path.c_str(), &status) != 0) {
+		cerr << "Failed to find " << path << endl;
+		return 1;
+	}
+	if (S_ISREG(status.st_mode)) {
+		if (path.size() > 4 && path.compare(path.size() - 4, 4, ".seg") == 0) {
+			return addSegment(path);
+		}
+		CorpusEntry entry;
+		entry.path = path;
+		entry.offset = 0;
+		entry.length = 0;
+		entryVector_.push_back(entry);
+		return 0;
+	}
+	if (!S_ISDIR(status.st_mode)) {
+		return 1;
+	}
+
+	DIR* dir = opendir(path.c_str());
+	if (dir == NULL) {
+		cerr << "Failed to open the folder " << path << endl;
+		return 1;
+	}
+	vector<string> fileVector;
+	struct dirent* dirEntry;
+	while ((dirEntry = readdir(dir)) != NULL) {
+		string name = dirEntry->d_name;
+		size_t dot = name.rfind('.');
+		string extension = (dot == string::npos) ? "" : name.substr(dot);
+		if (name[0] == '.' || extension == ".idx" || extension == ".ckp" ||
+				extension == ".log" || extension == ".tmp" || extension == ".rec" ||
+				extension == ".prom" || extension == ".snapshot") {
+			continue;
+		}
+		string filePath = path + "/" + name;
+		if (stat(filePath.c_str(), &status) == 0 && S_ISREG(status.st_mode)) {
+			fileVector.push_back(filePath);
+		}
+	}
+	closedir(dir);
+	//the same corpus is always listed in the same order
+	sort(fileVector.begin(), fileVector.end());
+	int result = 0;
+	for (size_t i = 0; i < fileVector.size(); i++) {
+		result |= addPath(fileVector[i]);
+	}
+	return result;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function reads the content of a page.
+* @param		CorpusEntry -- entry (the page)
+* @param		string& -- source (output, the path of the file or the URL of the
+segment record)
+* @param		string& -- content (output, the page)
+* @return		bool -- return false if the page cannot be read
+*******************************************************************************
+*/
+bool BatchExtractor::readEntry(const CorpusEntry& entry, string& source, string& content)
+{
+	int fd = ::open(entry.path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	bool isRead = false;
+	if (entry.length == 0) {
+		//a saved file
+		struct stat status;
+		if (fstat(fd, &status) == 0) {
+			content.resize(status.st_size);
+			isRead = (status.st_size == 0 || pread(fd, &content[0], status.st_size, 0) == status.st_size);
+		}
+		source = entry.path;
+	}
+	else {
+		//a record of a segment
+		string bytes(entry.length, '\0');
+		PageRecord record;
+		if (pread(fd, &bytes[0], entry.length, entry.offset) == (ssize_t)entry.length &&
+				decodePageRecord(bytes.data(), bytes.size(), record) == entry.length) {
+			source.swap(record.url);
+			content.swap(record.body);
+			isRead = true;
+		}
+	}
+	::close(fd);
+	return isRead;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the body of a worker: it takes the next page
+until the corpus is exhausted, parses it with its own parsers, and writes the
+lines of its records in one write.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void BatchExtractor::work()
+{
+	ParserContext context(recordsXPath_);
+	if (!context.isValid()) {
+		cerr << "Failed to create the parsers of a worker" << endl;
+		return;
+	}
+	string source, content, lines;
+	size_t i;
+	while ((i = nextEntry_.fetch_add(1, boost::memory_order_relaxed)) < entryVector_.size()) {
+		const CorpusEntry& entry = entryVector_[i];
+		if (!readEntry(entry, source, content)) {
+			cerr << "Failed to read " << entry.path << " at " << entry.offset << endl;
+			numberFailures_++;
+			continue;
+		}
+
+		xmlDocPtr doc;
+		bool isFeed = entry.length == 0 && entry.path.size() > 4 &&
+			entry.path.compare(entry.path.size() - 4, 4, ".xml") == 0;
+		if (isFeed) {
+			doc = xmlCtxtReadMemory(context.xmlParser, content.data(), (int)content.size(),
+				source.c_str(), NULL, XML_PARSE_NONET | XML_PARSE_NOBLANKS | XML_PARSE_NOERROR |
+				XML_PARSE_NOWARNING);
+		}
+		else {
+			//tidy repairs the page, the HTML parser ignores the namespaces of XHTML
+			tidyBufClear(&context.tidyOutput);
+			tidyBufClear(&context.tidyErrors);
+			const char* html = content.c_str();
+			int length = (int)content.size();
+			if (tidyParseString(context.tidy, content.c_str()) >= 0 &&
+					tidyCleanAndRepair(context.tidy) >= 0 &&
+					tidySaveBuffer(context.tidy, &context.tidyOutput) >= 0 &&
+					context.tidyOutput.size > 0) {
+				html = (const char*)context.tidyOutput.bp;
+				length = (int)context.tidyOutput.size;
+			}
+			doc = htmlCtxtReadMemory(context.htmlParser, html, length, source.c_str(), NULL,
+				HTML_PARSE_RECOVER | HTML_PARSE_NONET | HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING);
+		}
+		if (doc == NULL) {
+			numberFailures_++;
+			continue;
+		}
+
+		lines.clear();
+		long numberRecords = 0;
+		context.xpathContext->doc = doc;
+		context.xpathContext->node = NULL;
+		xmlXPathObjectPtr result = xmlXPathCompiledEval(context.recordsXPath, context.xpathContext);
+		if (result != NULL && result->nodesetval != NULL) {
+			for (int j = 0; j < result->nodesetval->nodeNr; j++) {
+				xmlNodePtr node = result->nodesetval->nodeTab[j];
+				if (node->type != XML_ELEMENT_NODE) {
+					continue;
+				}
+				lines += source;
+				lines += "\t";
+				char index[24];
+				snprintf(index, sizeof(index), "%ld", numberRecords++);
+				lines += index;
+				xmlChar* category = xmlGetProp(node, BAD_CAST "category");
+				if (category != NULL) {
+					lines += "\t";
+					lines += (const char*)category;
+					xmlFree(category);
+				}
+				appendText(node, lines);
+				lines += "\n";
+			}
+		}
+		xmlXPathFreeObject(result);
+		xmlFreeDoc(doc);
+
+		if (!lines.empty()) {
+			boost::mutex::scoped_lock lock(outputMutex_);
+			fwrite(lines.data(), 1, lines.size(), output_);
+		}
+		numberRecords_ += numberRecords;
+		numberPages_++;
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function extracts all the pages of the corpus.
+* @param		int -- numberThreads (the number of workers, 0 for one per core)
+* @param		FILE* -- output (the merged output of the records)
+* @return		int -- return 0 if the extraction ran, and 1 if the XPath
+expression is invalid
+*******************************************************************************
+*/
+int BatchExtractor::run(int numberThreads, FILE* output)
+{
+	//libxml2 must be initialized once before the workers use it
+	xmlInitParser();
+	xmlXPathCompExprPtr compiled = xmlXPathCompile(BAD_CAST recordsXPath_.c_str());
+	if (compiled == NULL) {
+		cerr << "Invalid XPath expression " << recordsXPath_ << endl;
+		return 1;
+	}
+	xmlXPathFreeCompExpr(compiled);
+
+	if (numberThreads <= 0) {
+		numberThreads = max(1, (int)boost::thread::hardware_concurrency());
+	}
+	numberThreads = (int)min((size_t)numberThreads, max((size_t)1, entryVector_.size()));
+	output_ = output;
+	nextEntry_ = 0;
+
+	boost::thread_group workers;
+	for (int i = 0; i < numberThreads; i++) {
+		workers.create_thread(boost::bind(&BatchExtractor::work, this));
+	}
+	workers.join_all();
+	fflush(output_);
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of pages in the corpus.
+* @param		none
+* @return		size_t -- the number of files and segment records added
+*******************************************************************************
+*/
+size_t BatchExtractor::getNumberEntries() const
+{
+	return entryVector_.size();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of pages extracted.
+* @param		none
+* @return		long -- the number of pages parsed by the last run
+*******************************************************************************
+*/
+long BatchExtractor::getNumberPages() const
+{
+	return numberPages_;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of records written.
+* @param		none
+* @return		long -- the number of records written by the last run
+*******************************************************************************
+*/
+long BatchExtractor::getNumberRecords() const
+{
+	return numberRecords_;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of pages which failed.
+* @param		none
+* @return		long -- the number of pages which could not be read or parsed
+*******************************************************************************
+*/
+long BatchExtractor::getNumberFailures() const
+{
+	return numberFailures_;
+}
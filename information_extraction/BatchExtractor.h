@@ -0,0 +1,102 @@
+/**
+*******************************************************************************
+* @file		BatchExtractor.h
+* @brief	This file provides the interfaces of the class BatchExtractor.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _BATCHEXTRACTOR_H_
+#define _BATCHEXTRACTOR_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//boost lib
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+
+using namespace std;
+
+/**
+*******************************************************************************
+* @struct		CorpusEntry
+* @brief 		This structure is one page of the corpus: a saved file, or one
+record of a segment file written by the crawler's PageStore.
+*******************************************************************************
+*/
+struct CorpusEntry
+{
+	//the path of the file or of the segment
+	string path;
+	//the offset and the length of the record in the segment (length 0 for a file)
+	boost::uint64_t offset;
+	boost::uint32_t length;
+};
+
+
+/**
+*******************************************************************************
+* @class		BatchExtractor
+* @brief 		This class re-runs the extraction over a stored corpus without
+the network. The inputs are saved pages, XML feeds, segment files of the
+crawler (./data/segment-NNNNN.seg) or directories of them. The pages are shared
+out one at a time to a pool of workers, so that a few large pages do not keep a
+single worker busy while the others are idle. Each worker keeps its own tidy
+document and libxml2 parser contexts for the whole run: HTML pages are cleaned
+by tidy and parsed by the HTML parser, XML feeds (*.xml) are parsed directly.
+The records matched by an XPath expression are written to one output, one line
+per record, holding the source of the page, the index of the record, the
+category attribute if any and the non-blank text of the record, tab-separated.
+The lines of one page are written together, but the pages are in no particular
+order.
+*******************************************************************************
+*/
+class BatchExtractor
+{
+	private:
+		//the XPath expression selecting the records
+		string recordsXPath_;
+		//the pages to extract
+		vector<CorpusEntry> entryVector_;
+		//the index of the next page to hand out
+		boost::atomic<size_t> nextEntry_;
+
+		//the merged output and its mutex
+		FILE* output_;
+		boost::mutex outputMutex_;
+
+		//statistics of the run
+		boost::atomic<long> numberPages_;
+		boost::atomic<long> numberRecords_;
+		boost::atomic<long> numberFailures_;
+
+		//list the records of a segment file
+		int addSegment(const string& path);
+		//read the content of an entry
+		bool readEntry(const CorpusEntry& entry, string& source, string& content);
+		//the body of a worker thread
+		void work();
+
+	public:
+ 		//constructor
+ 		BatchExtractor(const string& recordsXPath);
+ 		//add a file, a segment file or the files of a directory, return 0 on success
+ 		int addPath(const string& path);
+ 		//extract all the pages with numberThreads workers into output, return 0 on success
+ 		int run(int numberThreads, FILE* output);
+ 		//get the number of pages in the corpus
+ 		size_t getNumberEntries() const;
+ 		//get the number of pages extracted
+ 		long getNumberPages() const;
+ 		//get the number of records written
+ 		long getNumberRecords() const;
+ 		//get the number of pages which could not be read or parsed
+ 		long getNumberFailures() const;
+
+}; //end of class BatchExtractor
+
+#endif //_BATCHEXTRACTOR_H_
@@ -13,13 +13,17 @@ http://therealmarv.blogspot.ca/2012/12/installing-tidy-html5-on-ubuntu-first.htm
 #include <string>
 #include <fstream>
 #include <streambuf>
+#include <vector>
 
 #include <tidy.h>
 #include <buffio.h>
 
 #include <libxml++/libxml++.h>
 #include "testutilities.h"
+#include "ProductFeedReader.h"
+#include "BatchExtractor.h"
 #include <cstdlib>
+#include <cstring>
 
 using namespace std;
  
@@ -61,8 +65,106 @@ void print_node(const xmlpp::Node* node, bool substitute_entities, unsigned int
   }
 }
 
-int main()
+//read the feed one PRODUCT at a time and print the same rows as the DOM path
+int stream_products(const string& fileName)
 {
+	ProductFeedReader reader;
+	if (reader.open(fileName) != 0) {
+		return 1;
+	}
+	cout << "ID\t\t" << "CATEGORY\t\t" << "SKU\t\t" << "SUB_CATEGORY\t\t" << "NAME\t\t" << "PRICE" << endl;
+	ProductRecord record;
+	long i = 0;
+	while (reader.next(record)) {
+		cout << i++ << "\t";
+		for (size_t j = 0; j < record.attributes.size(); j++) {
+			if (record.attributes[j].first == "category") {
+				cout << record.attributes[j].second << "\t";
+			}
+		}
+		for (size_t j = 0; j < record.fields.size(); j++) {
+			if (record.fields[j].second.find_first_not_of(" \t\r\n") != string::npos) {
+				cout << record.fields[j].second << "\t";
+			}
+		}
+		cout << "\n";
+	}
+	cout.flush();
+	return reader.hasError() ? 1 : 0;
+}
+
+//extract the records of all the pages of a stored corpus with a pool of workers
+int batch_extract(const vector<string>& paths, int numberThreads, const string& recordsXPath,
+	const string& outputName)
+{
+	BatchExtractor extractor(recordsXPath);
+	for (size_t k = 0; k < paths.size(); k++) {
+		if (extractor.addPath(paths[k]) != 0) {
+			return 1;
+		}
+	}
+	FILE* output = outputName.empty() ? stdout : fopen(outputName.c_str(), "w");
+	if (output == NULL) {
+		cerr << "Failed to create " << outputName << endl;
+		return 1;
+	}
+	int result = extractor.run(numberThreads, output);
+	if (output != stdout) {
+		fclose(output);
+	}
+	cerr << extractor.getNumberPages() << " of " << extractor.getNumberEntries() << " pages, "
+		<< extractor.getNumberRecords() << " records, " << extractor.getNumberFailures()
+		<< " failures" << endl;
+	return result;
+}
+
+/*
+usage: HTMLParser [--stream] [feed.xml]
+       HTMLParser --batch [--threads N] [--records XPATH] [--output FILE] PATH...
+--stream reads large feeds in constant memory instead of building the DOM
+--batch extracts the pages of files, segment files or folders (e.g. ../web_crawler/data)
+on all the cores (--threads 0)
+*/
+int main(int argc, char* argv[])
+{
+	string fileName = "products.xml";
+	bool isStreaming = false;
+	bool isBatch = false;
+	int numberThreads = 0;
+	string recordsXPath = "/PRODUCTS/PRODUCT | //*[@itemtype='http://schema.org/Product']";
+	string outputName;
+	vector<string> paths;
+	for (int k = 1; k < argc; k++) {
+		if (strcmp(argv[k], "--stream") == 0) {
+			isStreaming = true;
+		}
+		else if (strcmp(argv[k], "--batch") == 0) {
+			isBatch = true;
+		}
+		else if (strcmp(argv[k], "--threads") == 0 && k + 1 < argc) {
+			numberThreads = atoi(argv[++k]);
+		}
+		else if (strcmp(argv[k], "--records") == 0 && k + 1 < argc) {
+			recordsXPath = argv[++k];
+		}
+		else if (strcmp(argv[k], "--output") == 0 && k + 1 < argc) {
+			outputName = argv[++k];
+		}
+		else {
+			fileName = argv[k];
+			paths.push_back(argv[k]);
+		}
+	}
+	if (isBatch) {
+		if (paths.empty()) {
+			paths.push_back("../web_crawler/data");
+		}
+		return batch_extract(paths, numberThreads, recordsXPath, outputName);
+	}
+	if (isStreaming) {
+		return stream_products(fileName);
+	}
+
 	//create an instance of XML DOM parser
 	xmlpp::DomParser doc; 
 	
@@ -70,7 +172,7 @@ int main()
 	//string str=CleanHTML("canadiantire");
 	
 	
-	std::ifstream t("products.xml");
+	std::ifstream t(fileName.c_str());
 	std::string str((std::istreambuf_iterator<char>(t)),
                  std::istreambuf_iterator<char>());
   //cout << str << endl;
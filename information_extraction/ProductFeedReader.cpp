@@ -0,0 +1,180 @@
+/**
+*******************************************************************************
+* @file			ProductFeedReader.cpp
+* @brief 		This file provides the implementations of the class ProductFeedReader.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "ProductFeedReader.h"
+
+#include <iostream>
+
+//namespaces used in this file
+using namespace std;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class ProductFeedReader.
+* @param		string -- recordName (the name of the record elements)
+* @return		None
+*******************************************************************************
+*/
+ProductFeedReader::ProductFeedReader(const string& recordName) : reader_(NULL),
+	recordName_(recordName), numberRecords_(0), hasError_(false)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class ProductFeedReader.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+ProductFeedReader::~ProductFeedReader()
+{
+	close();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function opens a feed file.
+* @param		string -- fileName (the path of the feed)
+* @return		int -- return 0 if the feed is open, and 1 if it cannot be opened.
+*******************************************************************************
+*/
+int ProductFeedReader::open(const string& fileName)
+{
+	close();
+	//skip the white space between the elements, and never access the network
+	reader_ = xmlReaderForFile(fileName.c_str(), NULL, XML_PARSE_NOBLANKS |
+		XML_PARSE_NONET | XML_PARSE_COMPACT);
+	if (reader_ == NULL) {
+		cerr << "Failed to open the feed " << fileName << endl;
+		return 1;
+	}
+	numberRecords_ = 0;
+	hasError_ = false;
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function reads the next record. The reader moves forward to
+the next record element and reads its attributes and its subtree; the nodes of
+the previous record have been freed by then.
+* @param		ProductRecord& -- record (output, the record; its vectors are
+cleared first, so reusing one record avoids reallocations)
+* @return		bool -- return true if a record has been read, and false at the
+end of the feed or if the feed is malformed (see hasError())
+*******************************************************************************
+*/
+bool ProductFeedReader::next(ProductRecord& record)
+{
+	if (reader_ == NULL) {
+		return false;
+	}
+	record.attributes.clear();
+	record.fields.clear();
+
+	//move to the next record element
+	int status;
+	while ((status = xmlTextReaderRead(reader_)) == 1) {
+		if (xmlTextReaderNodeType(reader_) == XML_READER_TYPE_ELEMENT &&
+				recordName_ == (const char*)xmlTextReaderConstLocalName(reader_)) {
+			break;
+		}
+	}
+	if (status != 1) {
+		hasError_ = (status < 0);
+		return false;
+	}
+
+	int recordDepth = xmlTextReaderDepth(reader_);
+	bool isEmpty = xmlTextReaderIsEmptyElement(reader_) == 1;
+	while (xmlTextReaderMoveToNextAttribute(reader_) == 1) {
+		record.attributes.push_back(make_pair(string((const char*)xmlTextReaderConstName(reader_)),
+			string((const char*)xmlTextReaderConstValue(reader_))));
+	}
+	xmlTextReaderMoveToElement(reader_);
+
+	//read the subtree: each child element becomes a field
+	while (!isEmpty && (status = xmlTextReaderRead(reader_)) == 1) {
+		int nodeType = xmlTextReaderNodeType(reader_);
+		int depth = xmlTextReaderDepth(reader_);
+		if (nodeType == XML_READER_TYPE_END_ELEMENT && depth == recordDepth) {
+			break;
+		}
+		if (nodeType == XML_READER_TYPE_ELEMENT && depth == recordDepth + 1) {
+			record.fields.push_back(make_pair(string((const char*)xmlTextReaderConstLocalName(reader_)),
+				string()));
+		}
+		else if ((nodeType == XML_READER_TYPE_TEXT || nodeType == XML_READER_TYPE_CDATA ||
+				nodeType == XML_READER_TYPE_SIGNIFICANT_WHITESPACE) && !record.fields.empty() &&
+				depth > recordDepth + 1) {
+			record.fields.back().second += (const char*)xmlTextReaderConstValue(reader_);
+		}
+	}
+	if (status != 1) {
+		hasError_ = true;
+		cerr << "Malformed feed after " << numberRecords_ << " records" << endl;
+		return false;
+	}
+	numberRecords_++;
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function closes the feed.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void ProductFeedReader::close()
+{
+	if (reader_ != NULL) {
+		xmlFreeTextReader(reader_);
+		reader_ = NULL;
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of records read.
+* @param		none
+* @return		long -- the number of records returned by next()
+*******************************************************************************
+*/
+long ProductFeedReader::getNumberRecords() const
+{
+	return numberRecords_;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function checks whether the reader stopped on an error.
+* @param		none
+* @return		bool -- return true if the feed is malformed
+*******************************************************************************
+*/
+bool ProductFeedReader::hasError() const
+{
+	return hasError_;
+}
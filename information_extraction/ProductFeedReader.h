@@ -0,0 +1,77 @@
+/**
+*******************************************************************************
+* @file		ProductFeedReader.h
+* @brief	This file provides the interfaces of the class ProductFeedReader.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _PRODUCTFEEDREADER_H_
+#define _PRODUCTFEEDREADER_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+
+//libxml2 streaming reader (libxml++ is built on libxml2)
+#include <libxml/xmlreader.h>
+
+using namespace std;
+
+/**
+*******************************************************************************
+* @struct		ProductRecord
+* @brief 		This structure holds one PRODUCT element of a feed.
+*******************************************************************************
+*/
+struct ProductRecord
+{
+	//the attributes of the PRODUCT element, e.g. ("category", "software")
+	vector< pair<string, string> > attributes;
+	//the child elements with their text, in document order, e.g. ("SKU", "soft32323")
+	vector< pair<string, string> > fields;
+};
+
+
+/**
+*******************************************************************************
+* @class		ProductFeedReader
+* @brief 		This class reads the product records of an XML feed one at a time
+with the libxml2 xmlTextReader. Only the record being read is kept in memory,
+so feeds of several GB are read in constant memory, unlike the DomParser which
+builds the whole document first. The text of the elements nested in a child
+element is added to the text of that child.
+*******************************************************************************
+*/
+class ProductFeedReader
+{
+	private:
+		//the libxml2 reader
+		xmlTextReaderPtr reader_;
+		//the name of the record elements
+		string recordName_;
+		//the number of records returned
+		long numberRecords_;
+		//true if the reader stopped on a malformed feed
+		bool hasError_;
+
+	public:
+ 		//constructor
+ 		ProductFeedReader(const string& recordName = "PRODUCT");
+ 		//destructor: closes the feed
+ 		~ProductFeedReader();
+ 		//open a feed file, return 0 on success
+ 		int open(const string& fileName);
+ 		//read the next record, return false at the end of the feed or on an error
+ 		bool next(ProductRecord& record);
+ 		//close the feed
+ 		void close();
+ 		//get the number of records read
+ 		long getNumberRecords() const;
+ 		//check whether the reader stopped on a malformed feed
+ 		bool hasError() const;
+
+}; //end of class ProductFeedReader
+
+#endif //_PRODUCTFEEDREADER_H_
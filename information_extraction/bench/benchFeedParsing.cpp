@@ -0,0 +1,178 @@
+/**
+*******************************************************************************
+* @file			benchFeedParsing.cpp
+* @brief 		This file provides the benchmark comparing the DOM parsing of a
+product feed with the streaming ProductFeedReader on a generated feed.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "../ProductFeedReader.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <libxml++/libxml++.h>
+
+using namespace std;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function writes a feed in the format of products.xml.
+* @param		string -- fileName (the path of the feed)
+* @param		long -- numberProducts (the number of PRODUCT elements)
+* @return		long -- the size of the feed in bytes, or -1 if it fails
+*******************************************************************************
+*/
+long generateFeed(const string& fileName, long numberProducts)
+{
+	static const char* categories[] = {"software", "hardware", "book", "music"};
+	FILE* file = fopen(fileName.c_str(), "w");
+	if (file == NULL) {
+		cerr << "Failed to create the feed " << fileName << endl;
+		return -1;
+	}
+	fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<PRODUCTS>\n");
+	for (long i = 0; i < numberProducts; i++) {
+		fprintf(file, "  <PRODUCT category=\"%s\">\n"
+			"    <SKU>sku%08ld</SKU>\n"
+			"    <SUB_CATEGORY>sub category %ld</SUB_CATEGORY>\n"
+			"    <NAME>Product &amp; name number %ld</NAME>\n"
+			"    <PRICE>%ld.%02ld</PRICE>\n"
+			"  </PRODUCT>\n", categories[i % 4], i, i % 97, i, 1 + i % 1000, i % 100);
+	}
+	fprintf(file, "</PRODUCTS>\n");
+	long size = ftell(file);
+	fclose(file);
+	return size;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function reads the feed with the ProductFeedReader.
+* @param		string -- fileName (the path of the feed)
+* @param		size_t& -- checksum (output, the number of text bytes read)
+* @return		long -- the number of products read
+*******************************************************************************
+*/
+long parseStream(const string& fileName, size_t& checksum)
+{
+	ProductFeedReader reader;
+	if (reader.open(fileName) != 0) {
+		return 0;
+	}
+	ProductRecord record;
+	while (reader.next(record)) {
+		for (size_t j = 0; j < record.fields.size(); j++) {
+			checksum += record.fields[j].second.size();
+		}
+	}
+	return reader.getNumberRecords();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function reads the feed the way HTMLParser does: DomParser,
+then /PRODUCTS/PRODUCT and the text of the children of each product.
+* @param		string -- fileName (the path of the feed)
+* @param		size_t& -- checksum (output, the number of text bytes read)
+* @return		long -- the number of products read
+*******************************************************************************
+*/
+long parseDOM(const string& fileName, size_t& checksum)
+{
+	xmlpp::DomParser parser;
+	parser.parse_file(fileName);
+	xmlpp::NodeSet products = parser.get_document()->get_root_node()->find("/PRODUCTS/PRODUCT");
+	for (size_t i = 0; i < products.size(); i++) {
+		xmlpp::Node::NodeList children = products[i]->get_children();
+		for (xmlpp::Node::NodeList::iterator it = children.begin(); it != children.end(); ++it) {
+			const xmlpp::Element* element = dynamic_cast<const xmlpp::Element*>(*it);
+			if (element != NULL && element->get_child_text() != NULL) {
+				checksum += element->get_child_text()->get_content().bytes();
+			}
+		}
+	}
+	return (long)products.size();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function runs one parser in a child process, so that the
+peak memory of each parser is measured on its own, and prints its throughput.
+* @param		string -- name (the name of the parser)
+* @param		long (*)(const string&, size_t&) -- parse (the parser)
+* @param		string -- fileName (the path of the feed)
+* @param		long -- feedSize (the size of the feed in bytes)
+* @return		int -- return 0 if the parser succeeded
+*******************************************************************************
+*/
+int runParser(const string& name, long (*parse)(const string&, size_t&),
+	const string& fileName, long feedSize)
+{
+	cout.flush();
+	pid_t pid = fork();
+	if (pid == 0) {
+		struct timeval start, end;
+		size_t checksum = 0;
+		gettimeofday(&start, NULL);
+		long numberProducts = parse(fileName, checksum);
+		gettimeofday(&end, NULL);
+		double seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		printf("%-8s %10ld products %8.3f s %8.1f MB/s %10.0f products/s peak RSS %8ld KB (checksum %lu)\n",
+			name.c_str(), numberProducts, seconds, feedSize / seconds / 1e6,
+			numberProducts / seconds, usage.ru_maxrss, (unsigned long)checksum);
+		fflush(stdout);
+		_exit(numberProducts > 0 ? 0 : 1);
+	}
+	int status = 1;
+	waitpid(pid, &status, 0);
+	return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : 1;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the main function of the benchmark.
+usage: benchFeedParsing [numberProducts] [feedFile]
+* @param		int -- argc
+* @param		char* [] -- argv
+* @return		int -- return 0 if both parsers succeeded
+*******************************************************************************
+*/
+int main(int argc, char* argv[])
+{
+	long numberProducts = (argc > 1) ? atol(argv[1]) : 1000000;
+	string fileName = (argc > 2) ? argv[2] : "/tmp/benchFeed.xml";
+
+	long feedSize = generateFeed(fileName, numberProducts);
+	if (feedSize < 0) {
+		return 1;
+	}
+	cout << "feed: " << numberProducts << " products, " << feedSize / 1000000.0 << " MB" << endl;
+
+	int result = runParser("stream", parseStream, fileName, feedSize);
+	result |= runParser("dom", parseDOM, fileName, feedSize);
+	remove(fileName.c_str());
+	return result;
+}
@@ -0,0 +1,394 @@
+/**
+*******************************************************************************
+* @file			AsyncLogger.cpp
+* @brief 		This file provides the implementations of the class AsyncLogger.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "AsyncLogger.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+//the names of the levels in the output
+static const char* levelNames[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+//the time between two drains
+static const int drainIntervalMs = 10;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of a text argument.
+* @param		const char* -- value (the text, NULL is written as "(null)")
+* @return		None
+*******************************************************************************
+*/
+LogArgument::LogArgument(const char* value) : type(TEXT), integer(0),
+	text((value != NULL) ? value : "(null)"), length(strlen(text))
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class AsyncLogger. It
+starts the drain thread.
+* @param		LogLevel -- level (the lowest level written)
+* @return		None
+*******************************************************************************
+*/
+AsyncLogger::AsyncLogger(LogLevel level) : level_(level), currentRing_(releaseRing),
+	numberReportedDrops_(0), isStopping_(false)
+{
+	drainThread_ = boost::thread(boost::bind(&AsyncLogger::run, this));
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class AsyncLogger.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+AsyncLogger::~AsyncLogger()
+{
+	stop();
+	for (size_t i = 0; i < rings_.size(); i++) {
+		delete rings_[i];
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the logger shared by the whole process.
+* @param		none
+* @return		AsyncLogger& -- the logger, created on the first call
+*******************************************************************************
+*/
+AsyncLogger& AsyncLogger::getShared()
+{
+	static AsyncLogger sharedLogger;
+	return sharedLogger;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the level named by a string.
+* @param		string -- name (debug, info, warning or error)
+* @param		LogLevel& -- level (output, the level)
+* @return		bool -- return false if the name is unknown
+*******************************************************************************
+*/
+bool AsyncLogger::parseLevel(const string& name, LogLevel& level)
+{
+	static const char* names[] = {"debug", "info", "warning", "error"};
+	for (int i = 0; i < 4; i++) {
+		if (name == names[i]) {
+			level = (LogLevel)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function sets the lowest level written.
+* @param		LogLevel -- level (the level)
+* @return		void
+*******************************************************************************
+*/
+void AsyncLogger::setLevel(LogLevel level)
+{
+	level_ = level;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the cleanup of boost::thread_specific_ptr. The
+ring is owned by rings_, so that the records of a thread which has exited are
+still written.
+* @param		ThreadRing* -- ptrRing (the ring of the exiting thread)
+* @return		void
+*******************************************************************************
+*/
+void AsyncLogger::releaseRing(ThreadRing* /*ptrRing*/)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the ring of the calling thread.
+* @param		none
+* @return		ThreadRing& -- the ring, created and listed on first use
+*******************************************************************************
+*/
+AsyncLogger::ThreadRing& AsyncLogger::getRing()
+{
+	ThreadRing* ptrRing = currentRing_.get();
+	if (ptrRing == NULL) {
+		ptrRing = new ThreadRing;
+		ptrRing->head.store(0);
+		ptrRing->tail.store(0);
+		ptrRing->numberDropped.store(0);
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			rings_.push_back(ptrRing);
+		}
+		currentRing_.reset(ptrRing);
+	}
+	return *ptrRing;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function copies a message into the ring of the calling thread.
+It does not block: if the ring is full, the message is dropped and counted.
+* @param		LogLevel -- level (the level of the message)
+* @param		const char* -- format (the message, a literal, with a "{}" per argument)
+* @param		LogArgument -- argument1 to argument8 (the arguments, copied)
+* @return		void
+*******************************************************************************
+*/
+void AsyncLogger::log(LogLevel level, const char* format, const LogArgument& argument1,
+	const LogArgument& argument2, const LogArgument& argument3, const LogArgument& argument4,
+	const LogArgument& argument5, const LogArgument& argument6, const LogArgument& argument7,
+	const LogArgument& argument8)
+{
+	if (!isEnabled(level)) {
+		return;
+	}
+	ThreadRing& ring = getRing();
+	size_t head = ring.head.load(boost::memory_order_relaxed);
+	if (head - ring.tail.load(boost::memory_order_acquire) >= (size_t)RING_SIZE) {
+		ring.numberDropped.store(ring.numberDropped.load(boost::memory_order_relaxed) + 1,
+			boost::memory_order_relaxed);
+		return;
+	}
+
+	LogRecord& record = ring.records[head % RING_SIZE];
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	record.header.microseconds = (boost::uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+	record.header.format = format;
+	record.header.level = (boost::uint8_t)level;
+	record.header.numberValues = 0;
+	record.header.textLength = 0;
+	const LogArgument* arguments[MAX_ARGUMENTS] = {&argument1, &argument2, &argument3,
+		&argument4, &argument5, &argument6, &argument7, &argument8};
+	for (int i = 0; i < MAX_ARGUMENTS && arguments[i]->type != LogArgument::NONE; i++) {
+		LogValue& value = record.header.values[i];
+		value.type = arguments[i]->type;
+		if (value.type == LogArgument::TEXT) {
+			//a text longer than the space left is cut
+			size_t length = min(arguments[i]->length, sizeof(record.text) - record.header.textLength);
+			memcpy(record.text + record.header.textLength, arguments[i]->text, length);
+			value.text.offset = record.header.textLength;
+			value.text.length = (boost::uint16_t)length;
+			record.header.textLength += (boost::uint16_t)length;
+		}
+		else {
+			value.unsignedInteger = arguments[i]->unsignedInteger;
+		}
+		record.header.numberValues++;
+	}
+	ring.head.store(head + 1, boost::memory_order_release);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function formats a record: each "{}" of the format is replaced
+by the next argument, the extra arguments are appended.
+* @param		LogRecord -- record (the record)
+* @return		string -- the message
+*******************************************************************************
+*/
+string AsyncLogger::format(const LogRecord& record)
+{
+	stringstream message;
+	const char* format = record.header.format;
+	int index = 0;
+	while (*format != '\0') {
+		if (format[0] == '{' && format[1] == '}' && index < record.header.numberValues) {
+			const LogValue& value = record.header.values[index++];
+			switch (value.type) {
+				case LogArgument::INTEGER:
+					message << value.integer;
+					break;
+				case LogArgument::UNSIGNED:
+					message << value.unsignedInteger;
+					break;
+				case LogArgument::REAL:
+					message << value.real;
+					break;
+				default:
+					message.write(record.text + value.text.offset, value.text.length);
+					break;
+			}
+			format += 2;
+		}
+		else {
+			message << *format++;
+		}
+	}
+	return message.str();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function takes the records of all the rings, formats them and
+writes them in the order of their time stamps, then reports the new drops.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void AsyncLogger::drain()
+{
+	vector<ThreadRing*> rings;
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		rings = rings_;
+	}
+	vector<LogLine> lines;
+	long numberDropped = 0;
+	for (size_t i = 0; i < rings.size(); i++) {
+		ThreadRing& ring = *rings[i];
+		size_t tail = ring.tail.load(boost::memory_order_relaxed);
+		size_t head = ring.head.load(boost::memory_order_acquire);
+		for (; tail != head; tail++) {
+			const LogRecord& record = ring.records[tail % RING_SIZE];
+			LogLine line;
+			line.microseconds = record.header.microseconds;
+			line.level = record.header.level;
+			line.text = format(record);
+			lines.push_back(line);
+		}
+		//the slots can be written again
+		ring.tail.store(tail, boost::memory_order_release);
+		numberDropped += ring.numberDropped.load(boost::memory_order_relaxed);
+	}
+	if (lines.empty() && numberDropped == numberReportedDrops_) {
+		return;
+	}
+
+	stable_sort(lines.begin(), lines.end());
+	for (size_t i = 0; i < lines.size(); i++) {
+		time_t seconds = (time_t)(lines[i].microseconds / 1000000);
+		struct tm localTime;
+		localtime_r(&seconds, &localTime);
+		char prefix[32];
+		snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%03d %s ", localTime.tm_hour,
+			localTime.tm_min, localTime.tm_sec, (int)(lines[i].microseconds % 1000000 / 1000),
+			levelNames[lines[i].level]);
+		FILE* stream = (lines[i].level >= LOG_WARNING) ? stderr : stdout;
+		fputs(prefix, stream);
+		fwrite(lines[i].text.data(), 1, lines[i].text.size(), stream);
+		fputc('\n', stream);
+	}
+	if (numberDropped > numberReportedDrops_) {
+		fprintf(stderr, "%ld log messages dropped (%ld in total)\n",
+			numberDropped - numberReportedDrops_, numberDropped);
+		numberReportedDrops_ = numberDropped;
+	}
+	fflush(stdout);
+	fflush(stderr);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the body of the drain thread.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void AsyncLogger::run()
+{
+	while (true) {
+		{
+			boost::mutex::scoped_lock lock(drainMutex_);
+			if (!isStopping_) {
+				drainCondition_.timed_wait(lock, boost::posix_time::milliseconds(drainIntervalMs));
+			}
+			if (isStopping_) {
+				break;
+			}
+		}
+		drain();
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of messages dropped so far.
+* @param		none
+* @return		long -- the number of dropped messages
+*******************************************************************************
+*/
+long AsyncLogger::getNumberDropped()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	long numberDropped = 0;
+	for (size_t i = 0; i < rings_.size(); i++) {
+		numberDropped += rings_[i]->numberDropped.load(boost::memory_order_relaxed);
+	}
+	return numberDropped;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function stops the drain thread and writes the records still
+queued. The messages logged afterwards are written by the destructor.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void AsyncLogger::stop()
+{
+	{
+		boost::mutex::scoped_lock lock(drainMutex_);
+		isStopping_ = true;
+	}
+	drainCondition_.notify_all();
+	if (drainThread_.joinable()) {
+		drainThread_.join();
+	}
+	drain();
+}
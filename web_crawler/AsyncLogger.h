@@ -0,0 +1,216 @@
+/**
+*******************************************************************************
+* @file		AsyncLogger.h
+* @brief	This file provides the interfaces of the class AsyncLogger.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _ASYNCLOGGER_H_
+#define _ASYNCLOGGER_H_
+
+#include <string>
+#include <vector>
+
+//boost lib
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/tss.hpp>
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+//the levels of the log messages, in increasing severity
+enum LogLevel
+{
+	LOG_DEBUG = 0,
+	LOG_INFO = 1,
+	LOG_WARNING = 2,
+	LOG_ERROR = 3
+};
+
+
+/**
+*******************************************************************************
+* @struct		LogArgument
+* @brief 		This structure holds an argument of a log message until it is
+copied into the record: an integer, a real, or a text which is not copied here.
+*******************************************************************************
+*/
+struct LogArgument
+{
+	enum Type
+	{
+		NONE,
+		INTEGER,
+		UNSIGNED,
+		REAL,
+		TEXT
+	};
+	Type type;
+	union
+	{
+		long long integer;
+		unsigned long long unsignedInteger;
+		double real;
+	};
+	const char* text;
+	size_t length;
+
+	//no argument
+	LogArgument() : type(NONE), integer(0), text(NULL), length(0) {}
+	//the arguments converted implicitly by AsyncLogger::log()
+	LogArgument(int value) : type(INTEGER), integer(value), text(NULL), length(0) {}
+	LogArgument(long value) : type(INTEGER), integer(value), text(NULL), length(0) {}
+	LogArgument(long long value) : type(INTEGER), integer(value), text(NULL), length(0) {}
+	LogArgument(unsigned int value) : type(UNSIGNED), unsignedInteger(value), text(NULL), length(0) {}
+	LogArgument(unsigned long value) : type(UNSIGNED), unsignedInteger(value), text(NULL), length(0) {}
+	LogArgument(unsigned long long value) : type(UNSIGNED), unsignedInteger(value), text(NULL), length(0) {}
+	LogArgument(double value) : type(REAL), real(value), text(NULL), length(0) {}
+	LogArgument(const char* value);
+	LogArgument(const string& value) : type(TEXT), integer(0), text(value.data()), length(value.size()) {}
+};
+
+
+/**
+*******************************************************************************
+* @class		AsyncLogger
+* @brief 		This class takes the console output off the crawl threads. A
+message is not formatted by the thread logging it: its format string, which must
+be a literal, and its arguments are copied into a fixed-size record of the ring
+of the thread, a single-producer single-consumer queue which needs no lock. A
+background thread drains the rings every few milliseconds, formats the records
+("{}" is replaced by the next argument), and writes them in the order of their
+time stamps, the warnings and errors to stderr and the others to stdout. When
+the ring of a thread is full the message is dropped and counted instead of
+blocking the caller; the drops are reported by the drain thread. Messages below
+the level of the logger cost only a comparison.
+*******************************************************************************
+*/
+class AsyncLogger
+{
+	public:
+		//the maximum number of arguments of a message
+		static const int MAX_ARGUMENTS = 8;
+		//the size of a record, and the number of records in the ring of a thread
+		static const int RECORD_BYTES = 512;
+		static const int RING_SIZE = 1024;
+
+	private:
+		//an argument copied into a record; a text is stored in the text area
+		struct LogValue
+		{
+			LogArgument::Type type;
+			union
+			{
+				long long integer;
+				unsigned long long unsignedInteger;
+				double real;
+				struct
+				{
+					boost::uint16_t offset;
+					boost::uint16_t length;
+				} text;
+			};
+		};
+		//the fixed part of a record
+		struct LogHeader
+		{
+			boost::uint64_t microseconds;
+			const char* format;
+			boost::uint8_t level;
+			boost::uint8_t numberValues;
+			boost::uint16_t textLength;
+			LogValue values[MAX_ARGUMENTS];
+		};
+		//a record: the fixed part and the texts of the arguments
+		struct LogRecord
+		{
+			LogHeader header;
+			char text[RECORD_BYTES - sizeof(LogHeader)];
+		};
+		//the ring of a thread: written by the thread, read by the drain thread
+		struct ThreadRing
+		{
+			LogRecord records[RING_SIZE];
+			//the next record to write, and the next record to read, on their own cache lines
+			boost::atomic<size_t> head;
+			char headPadding[64];
+			boost::atomic<size_t> tail;
+			char tailPadding[64];
+			//the messages dropped because the ring was full
+			boost::atomic<long> numberDropped;
+		};
+		//a drained record, formatted
+		struct LogLine
+		{
+			boost::uint64_t microseconds;
+			int level;
+			string text;
+			bool operator<(const LogLine& other) const { return microseconds < other.microseconds; }
+		};
+
+		//the messages below this level are ignored
+		boost::atomic<int> level_;
+		//mutex protecting the list of rings
+		boost::mutex mutex_;
+		//the rings of all the threads which have logged
+		vector<ThreadRing*> rings_;
+		//the ring of the calling thread, owned by rings_
+		boost::thread_specific_ptr<ThreadRing> currentRing_;
+		//the drops already reported
+		long numberReportedDrops_;
+		//mutex and condition on which the drain thread waits
+		boost::mutex drainMutex_;
+		boost::condition_variable drainCondition_;
+		//set by stop()
+		bool isStopping_;
+		//the drain thread
+		boost::thread drainThread_;
+
+		//get the ring of the calling thread, created on first use
+		ThreadRing& getRing();
+		//the body of the drain thread
+		void run();
+		//format and write the records of all the rings
+		void drain();
+		//format a record
+		static string format(const LogRecord& record);
+		//the thread_specific_ptr cleanup: the ring stays in rings_
+		static void releaseRing(ThreadRing* ptrRing);
+
+	public:
+ 		//constructor: starts the drain thread
+ 		AsyncLogger(LogLevel level = LOG_INFO);
+ 		//destructor: writes the remaining records
+ 		~AsyncLogger();
+ 		//get the logger shared by the whole process
+ 		static AsyncLogger& getShared();
+ 		//get the level from its name (debug, info, warning, error), return false if unknown
+ 		static bool parseLevel(const string& name, LogLevel& level);
+ 		//set the lowest level written
+ 		void setLevel(LogLevel level);
+ 		//check whether the messages of a level are written
+ 		bool isEnabled(LogLevel level) const { return level >= level_.load(boost::memory_order_relaxed); }
+ 		//queue a message; format must be a literal, each "{}" is replaced by an argument
+ 		void log(LogLevel level, const char* format, const LogArgument& argument1 = LogArgument(),
+ 			const LogArgument& argument2 = LogArgument(), const LogArgument& argument3 = LogArgument(),
+ 			const LogArgument& argument4 = LogArgument(), const LogArgument& argument5 = LogArgument(),
+ 			const LogArgument& argument6 = LogArgument(), const LogArgument& argument7 = LogArgument(),
+ 			const LogArgument& argument8 = LogArgument());
+ 		//get the number of messages dropped because a ring was full
+ 		long getNumberDropped();
+ 		//write the queued records and stop the drain thread
+ 		void stop();
+
+}; //end of class AsyncLogger
+
+} //end of namespace WebDataExtraction
+
+#endif //_ASYNCLOGGER_H_
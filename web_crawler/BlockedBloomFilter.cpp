@@ -0,0 +1,225 @@
+/**
+*******************************************************************************
+* @file			BlockedBloomFilter.cpp
+* @brief 		This file provides the implementations of the class
+BlockedBloomFilter.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "BlockedBloomFilter.h"
+
+#include <cmath>
+#include <algorithm>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class BlockedBloomFilter.
+The bits are m = -n ln(p) / (ln 2)^2 and the hashes k = (m / n) ln 2, the
+optimum of a standard Bloom filter.
+* @param		size_t -- expectedURLs (the number of URLs expected in the crawl)
+* @param		double -- falsePositiveRate (the tolerated rate of new URLs
+reported as seen)
+* @return		None
+*******************************************************************************
+*/
+BlockedBloomFilter::BlockedBloomFilter(size_t expectedURLs, double falsePositiveRate) :
+	size_(0)
+{
+	double ln2 = log(2.0);
+	double numberBits = -(double)max(expectedURLs, (size_t)1) * log(falsePositiveRate) / (ln2 * ln2);
+	size_t bitsPerBlock = kWordsPerBlock * 64;
+	numberBlocks_ = max((size_t)1, (size_t)ceil(numberBits / bitsPerBlock));
+	numberHashes_ = (int)floor(numberBits / max(expectedURLs, (size_t)1) * ln2 + 0.5);
+	numberHashes_ = max(1, min(numberHashes_, 16));
+
+	size_t numberWords = numberBlocks_ * kWordsPerBlock;
+	words_.reset(new boost::atomic<boost::uint64_t>[numberWords]);
+	for (size_t i = 0; i < numberWords; i++) {
+		words_[i].store(0, boost::memory_order_relaxed);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function inserts a fingerprint. The high 32 bits select the
+block, and the bit positions in the block are h1 + i * h2 (double hashing) with
+h1 and h2 taken from the low 32 bits.
+* @param		URLFingerprint -- fingerprint (the fingerprint of the URL)
+* @return		bool -- return true if at least one bit was not set before, i.e. the
+URL is new.
+*******************************************************************************
+*/
+bool BlockedBloomFilter::insert(URLFingerprint fingerprint)
+{
+	boost::atomic<boost::uint64_t>* block =
+		&words_[((fingerprint >> 32) % numberBlocks_) * kWordsPerBlock];
+	boost::uint32_t h1 = (boost::uint32_t)fingerprint & 0xffff;
+	boost::uint32_t h2 = ((boost::uint32_t)fingerprint >> 16) | 1;
+	bool isNew = false;
+	for (int i = 0; i < numberHashes_; i++) {
+		boost::uint32_t bit = (h1 + i * h2) & (kWordsPerBlock * 64 - 1);
+		boost::uint64_t mask = (boost::uint64_t)1 << (bit & 63);
+		boost::uint64_t old = block[bit >> 6].fetch_or(mask, boost::memory_order_relaxed);
+		if ((old & mask) == 0) {
+			isNew = true;
+		}
+	}
+	if (isNew) {
+		size_.fetch_add(1, boost::memory_order_relaxed);
+	}
+	return isNew;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function checks whether a fingerprint has been inserted.
+* @param		URLFingerprint -- fingerprint (the fingerprint of the URL)
+* @return		bool -- return true if all its bits are set (seen, or a false positive).
+*******************************************************************************
+*/
+bool BlockedBloomFilter::contains(URLFingerprint fingerprint) const
+{
+	const boost::atomic<boost::uint64_t>* block =
+		&words_[((fingerprint >> 32) % numberBlocks_) * kWordsPerBlock];
+	boost::uint32_t h1 = (boost::uint32_t)fingerprint & 0xffff;
+	boost::uint32_t h2 = ((boost::uint32_t)fingerprint >> 16) | 1;
+	for (int i = 0; i < numberHashes_; i++) {
+		boost::uint32_t bit = (h1 + i * h2) & (kWordsPerBlock * 64 - 1);
+		boost::uint64_t mask = (boost::uint64_t)1 << (bit & 63);
+		if ((block[bit >> 6].load(boost::memory_order_relaxed) & mask) == 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of fingerprints inserted.
+* @param		none
+* @return		size_t -- the number of URLs reported as new
+*******************************************************************************
+*/
+size_t BlockedBloomFilter::size() const
+{
+	return size_.load(boost::memory_order_relaxed);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the memory used by the filter.
+* @param		none
+* @return		size_t -- the number of bytes of the bit array
+*******************************************************************************
+*/
+size_t BlockedBloomFilter::memoryUsage() const
+{
+	return numberBlocks_ * kWordsPerBlock * sizeof(boost::uint64_t);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function estimates the false-positive rate at the current
+number of URLs, (1 - e^(-k n / m))^k. Blocking raises the real rate slightly
+above this estimate.
+* @param		none
+* @return		double -- the probability that a new URL is reported as seen
+*******************************************************************************
+*/
+double BlockedBloomFilter::expectedFalsePositiveRate() const
+{
+	double numberBits = (double)numberBlocks_ * kWordsPerBlock * 64;
+	double fillRatio = 1.0 - exp(-numberHashes_ * (double)size() / numberBits);
+	return pow(fillRatio, numberHashes_);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of words of the bit array.
+* @param		none
+* @return		size_t -- the number of 64-bit words
+*******************************************************************************
+*/
+size_t BlockedBloomFilter::getNumberWords() const
+{
+	return numberBlocks_ * kWordsPerBlock;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of bits set per fingerprint.
+* @param		none
+* @return		int -- the number of hashes k
+*******************************************************************************
+*/
+int BlockedBloomFilter::getNumberHashes() const
+{
+	return numberHashes_;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function copies a range of the bit array. The filter keeps
+taking inserts, so bits set meanwhile may or may not be copied.
+* @param		size_t -- begin (the first word)
+* @param		size_t -- count (the number of words)
+* @param		uint64_t* -- words (output, count words)
+* @return		void
+*******************************************************************************
+*/
+void BlockedBloomFilter::copyWords(size_t begin, size_t count, boost::uint64_t* words) const
+{
+	for (size_t i = 0; i < count; i++) {
+		words[i] = words_[begin + i].load(boost::memory_order_relaxed);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function merges a saved bit array into the filter.
+* @param		uint64_t* -- words (the saved bit array)
+* @param		size_t -- numberWords (the number of words saved)
+* @param		int -- numberHashes (the number of hashes of the saved filter)
+* @param		size_t -- size (the number of fingerprints of the saved filter)
+* @return		bool -- return false if the saved filter has another geometry, i.e.
+it was sized for another number of URLs or false-positive rate.
+*******************************************************************************
+*/
+bool BlockedBloomFilter::loadWords(const boost::uint64_t* words, size_t numberWords,
+	int numberHashes, size_t size)
+{
+	if (numberWords != getNumberWords() || numberHashes != numberHashes_) {
+		return false;
+	}
+	for (size_t i = 0; i < numberWords; i++) {
+		words_[i].fetch_or(words[i], boost::memory_order_relaxed);
+	}
+	size_.fetch_add(size, boost::memory_order_relaxed);
+	return true;
+}
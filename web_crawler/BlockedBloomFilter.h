@@ -0,0 +1,78 @@
+/**
+*******************************************************************************
+* @file		BlockedBloomFilter.h
+* @brief	This file provides the interfaces of the class BlockedBloomFilter.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _BLOCKEDBLOOMFILTER_H_
+#define _BLOCKEDBLOOMFILTER_H_
+
+#include <cstddef>
+
+//boost lib
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_array.hpp>
+
+#include "URLFingerprint.h"
+
+namespace WebDataExtraction
+{
+
+
+/**
+*******************************************************************************
+* @class		BlockedBloomFilter
+* @brief 		This class is a Bloom filter over URL fingerprints whose k bits for
+one fingerprint all fall into one 512-bit block (one cache line), so a lookup
+touches a single cache line. Bits are set with atomic OR, so no lock is taken.
+Two threads inserting the same new URL at the same moment may both be told it
+is new; a seen URL is never reported as new.
+*******************************************************************************
+*/
+class BlockedBloomFilter
+{
+	private:
+		//the number of 64-bit words in one block
+		static const size_t kWordsPerBlock = 8;
+
+		//the bit array, aligned blocks of kWordsPerBlock words
+		boost::scoped_array< boost::atomic<boost::uint64_t> > words_;
+		//the number of blocks
+		size_t numberBlocks_;
+		//the number of bits set per fingerprint
+		int numberHashes_;
+		//the number of fingerprints inserted
+		boost::atomic<size_t> size_;
+
+	public:
+ 		//constructor: size the filter for the expected URLs and false-positive rate
+ 		BlockedBloomFilter(size_t expectedURLs, double falsePositiveRate);
+ 		//insert a fingerprint, return true if it had (probably) not been seen before
+ 		bool insert(URLFingerprint fingerprint);
+ 		//check whether a fingerprint has (probably) been seen
+ 		bool contains(URLFingerprint fingerprint) const;
+ 		//get the number of fingerprints inserted
+ 		size_t size() const;
+ 		//get the number of bytes used by the bit array
+ 		size_t memoryUsage() const;
+ 		//get the expected false-positive rate at the current number of URLs
+ 		double expectedFalsePositiveRate() const;
+ 		//get the number of 64-bit words of the bit array
+ 		size_t getNumberWords() const;
+ 		//get the number of bits set per fingerprint
+ 		int getNumberHashes() const;
+ 		//copy count words of the bit array from begin (for checkpoints)
+ 		void copyWords(size_t begin, size_t count, boost::uint64_t* words) const;
+ 		//OR a saved bit array into the filter, return false if the sizes differ
+ 		bool loadWords(const boost::uint64_t* words, size_t numberWords,
+ 			int numberHashes, size_t size);
+
+}; //end of class BlockedBloomFilter
+
+} //end of namespace WebDataExtraction
+
+#endif //_BLOCKEDBLOOMFILTER_H_
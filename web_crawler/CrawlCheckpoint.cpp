@@ -0,0 +1,663 @@
+/**
+*******************************************************************************
+* @file			CrawlCheckpoint.cpp
+* @brief 		This file provides the implementations of the class CrawlCheckpoint.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "CrawlCheckpoint.h"
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <boost/bind.hpp>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+//the first bytes of every checkpoint file
+static const boost::uint32_t kCheckpointMagic = 0x43584457; //"WDXC"
+//the number of Bloom filter words copied at a time
+static const size_t kBloomChunkWords = 65536;
+
+
+
+/**
+*******************************************************************************
+* @brief		These functions write bytes or a length-prefixed string to a
+checkpoint file and advance the offset.
+* @return		bool -- return false on a write error
+*******************************************************************************
+*/
+static bool writeBytes(FILE* file, const void* data, size_t size, boost::uint64_t& offset)
+{
+	if (size > 0 && fwrite(data, size, 1, file) != 1) {
+		return false;
+	}
+	offset += size;
+	return true;
+}
+
+static bool writeString(FILE* file, const string& value, boost::uint64_t& offset)
+{
+	boost::uint32_t length = (boost::uint32_t)value.size();
+	return writeBytes(file, &length, sizeof(length), offset) &&
+		writeBytes(file, value.data(), value.size(), offset);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		These functions read a value or a length-prefixed string from a
+mapped checkpoint file and advance the position.
+* @return		bool -- return false if the value runs past the end of the file
+*******************************************************************************
+*/
+template <typename T>
+static bool readValue(const char* data, size_t size, size_t& position, T& value)
+{
+	if (position + sizeof(T) > size) {
+		return false;
+	}
+	memcpy(&value, data + position, sizeof(T));
+	position += sizeof(T);
+	return true;
+}
+
+static bool readString(const char* data, size_t size, size_t& position, string& value)
+{
+	boost::uint32_t length;
+	if (!readValue(data, size, position, length) || position + length > size) {
+		return false;
+	}
+	value.assign(data + position, length);
+	position += length;
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class CrawlCheckpoint.
+* @param		string -- folder (the folder holding the checkpoint files)
+* @param		CrawlFrontier& -- crawlFrontier (the URLs to be crawled)
+* @param		URLSeenFilter& -- urlSeenFilter (the URLs discovered)
+* @param		RecordBatch& -- productRecordBatch (the product records)
+* @param		boost::mutex& -- productMutex (the mutex protecting the records)
+* @param		boost::atomic<int>& -- numberCompleted (the number of pages crawled)
+* @param		int -- fullInterval (a full snapshot every fullInterval checkpoints)
+* @return		None
+*******************************************************************************
+*/
+CrawlCheckpoint::CrawlCheckpoint(const string& folder, CrawlFrontier& crawlFrontier,
+	URLSeenFilter& urlSeenFilter, RecordBatch& productRecordBatch,
+	boost::mutex& productMutex, boost::atomic<int>& numberCompleted, int fullInterval) :
+	folder_(folder), crawlFrontier_(crawlFrontier), urlSeenFilter_(urlSeenFilter),
+	productRecordBatch_(productRecordBatch), productMutex_(productMutex),
+	numberCompleted_(numberCompleted), fullInterval_(max(1, fullInterval)), sequence_(1),
+	baseSequence_(0), numberProductsSaved_(0), numberDeltas_(0), lastCheckpointBytes_(0),
+	isStopping_(false)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class CrawlCheckpoint.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+CrawlCheckpoint::~CrawlCheckpoint()
+{
+	stop();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the path of a checkpoint file, e.g.
+./data/checkpoint-0000000012.ckp
+* @param		uint64_t -- sequence (the sequence number of the checkpoint)
+* @return		string -- the path of the file
+*******************************************************************************
+*/
+string CrawlCheckpoint::getCheckpointPath(boost::uint64_t sequence) const
+{
+	stringstream strStream;
+	strStream << folder_ << "/checkpoint-" << setw(10) << setfill('0') << sequence << ".ckp";
+	return strStream.str();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function starts the checkpoint thread.
+* @param		int -- intervalSeconds (the time between two checkpoints)
+* @return		void
+*******************************************************************************
+*/
+void CrawlCheckpoint::start(int intervalSeconds)
+{
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		isStopping_ = false;
+	}
+	thread_ = boost::thread(boost::bind(&CrawlCheckpoint::run, this, intervalSeconds));
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function stops the checkpoint thread. A checkpoint being
+written is completed first.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void CrawlCheckpoint::stop()
+{
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		isStopping_ = true;
+	}
+	condition_.notify_all();
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the body of the checkpoint thread.
+* @param		int -- intervalSeconds (the time between two checkpoints)
+* @return		void
+*******************************************************************************
+*/
+void CrawlCheckpoint::run(int intervalSeconds)
+{
+	while (true) {
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			boost::system_time deadline = boost::get_system_time() +
+				boost::posix_time::seconds(intervalSeconds);
+			while (!isStopping_) {
+				if (!condition_.timed_wait(lock, deadline)) {
+					break;
+				}
+			}
+			if (isStopping_) {
+				return;
+			}
+		}
+		write(false);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function writes a checkpoint into a temporary file and renames
+it, so that a crash while writing leaves the previous checkpoints intact. After a
+full snapshot the other files are removed.
+* @param		bool -- isFull (write a full snapshot; a full snapshot is also
+written if none has been written by this run, after a failed write, and every
+fullInterval checkpoints)
+* @return		int -- return 0 if the checkpoint is written, and 1 if it fails.
+*******************************************************************************
+*/
+int CrawlCheckpoint::write(bool isFull)
+{
+	boost::mutex::scoped_lock lock(writeMutex_);
+	if (baseSequence_ == 0 || numberDeltas_ + 1 >= fullInterval_) {
+		isFull = true;
+	}
+
+	Header header;
+	memset(&header, 0, sizeof(header));
+	header.magic = kCheckpointMagic;
+	header.isFull = isFull ? 1 : 0;
+	header.mode = (boost::uint32_t)urlSeenFilter_.getMode();
+	header.sequence = sequence_;
+	header.baseSequence = isFull ? sequence_ : baseSequence_;
+
+	string fileName = getCheckpointPath(sequence_);
+	string tempFileName = fileName + ".tmp";
+	FILE* file = fopen(tempFileName.c_str(), "wb");
+	bool isWritten = (file != NULL) && writeSections(file, header, isFull);
+	if (file != NULL) {
+		isWritten = (fflush(file) == 0) && (fsync(fileno(file)) == 0) && isWritten;
+		isWritten = (fclose(file) == 0) && isWritten;
+	}
+	if (!isWritten || rename(tempFileName.c_str(), fileName.c_str()) != 0) {
+		std::cerr << "Failed to write the checkpoint " << fileName << std::endl;
+		remove(tempFileName.c_str());
+		//the journal taken for this delta is lost, so the next one must be full
+		baseSequence_ = 0;
+		return 1;
+	}
+
+	lastCheckpointBytes_ = header.fileSize;
+	if (isFull) {
+		//the new snapshot replaces every other checkpoint, including those of an earlier crawl
+		DIR* dir = opendir(folder_.c_str());
+		struct dirent* entry;
+		while (dir != NULL && (entry = readdir(dir)) != NULL) {
+			unsigned long long sequence;
+			if (sscanf(entry->d_name, "checkpoint-%llu.ckp", &sequence) == 1 &&
+					sequence != sequence_) {
+				remove((folder_ + "/" + entry->d_name).c_str());
+			}
+		}
+		if (dir != NULL) {
+			closedir(dir);
+		}
+		baseSequence_ = sequence_;
+		numberDeltas_ = 0;
+	}
+	else {
+		numberDeltas_++;
+	}
+	sequence_++;
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function writes the sections of a checkpoint and then the
+header. The seen-URL filter is copied before the frontier, so that a URL pushed
+meanwhile is in the frontier section even if it is missing from the filter; the
+loader inserts the frontier URLs into the filter again. The spilled URLs of the
+frontier are copied one segment at a time, after the frontier lock has been
+released. The records are copied last, since a task adds its records before it
+is done.
+* @param		FILE* -- file (the checkpoint file, positioned at 0)
+* @param		Header& -- header (input/output, the header to complete)
+* @param		bool -- isFull (write a full snapshot or a delta)
+* @return		bool -- return false on a write error
+*******************************************************************************
+*/
+bool CrawlCheckpoint::writeSections(FILE* file, Header& header, bool isFull)
+{
+	boost::uint64_t offset = 0;
+	if (!writeBytes(file, &header, sizeof(header), offset)) {
+		return false;
+	}
+
+	vector<string> pushedVector;
+	vector<string> doneVector;
+	vector<string> segmentVector;
+	if (isFull) {
+		URLSeenSet* ptrSeenSet = urlSeenFilter_.getSeenSet();
+		BlockedBloomFilter* ptrBloomFilter = urlSeenFilter_.getBloomFilter();
+		if (ptrSeenSet != NULL) {
+			header.fingerprintOffset = offset;
+			vector<URLFingerprint> fingerprintVector;
+			for (size_t i = 0; i < ptrSeenSet->getNumberShards(); i++) {
+				ptrSeenSet->copyShard(i, fingerprintVector);
+				if (!fingerprintVector.empty() && !writeBytes(file, &fingerprintVector[0],
+						fingerprintVector.size() * sizeof(URLFingerprint), offset)) {
+					return false;
+				}
+				header.numberFingerprints += fingerprintVector.size();
+			}
+		}
+		else {
+			header.bloomOffset = offset;
+			header.bloomSize = ptrBloomFilter->size();
+			header.numberHashes = ptrBloomFilter->getNumberHashes();
+			header.numberBloomWords = ptrBloomFilter->getNumberWords();
+			vector<boost::uint64_t> wordVector(kBloomChunkWords);
+			for (size_t begin = 0; begin < header.numberBloomWords; begin += kBloomChunkWords) {
+				size_t count = min(kBloomChunkWords, (size_t)header.numberBloomWords - begin);
+				ptrBloomFilter->copyWords(begin, count, &wordVector[0]);
+				if (!writeBytes(file, &wordVector[0], count * sizeof(boost::uint64_t), offset)) {
+					return false;
+				}
+			}
+		}
+		crawlFrontier_.snapshot(pushedVector, segmentVector);
+		numberProductsSaved_ = 0;
+	}
+	else {
+		crawlFrontier_.takeJournal(pushedVector, doneVector);
+	}
+	header.numberCompleted = numberCompleted_;
+
+	header.pushedOffset = offset;
+	header.numberPushedURLs = pushedVector.size();
+	for (size_t i = 0; i < pushedVector.size(); i++) {
+		if (!writeString(file, pushedVector[i], offset)) {
+			return false;
+		}
+	}
+	//every link is read, which removes it, even after a failure
+	bool isCopied = true;
+	for (size_t i = 0; i < segmentVector.size(); i++) {
+		vector<string> urlVector;
+		if (!CrawlFrontier::readSnapshotSegment(segmentVector[i], urlVector)) {
+			std::cerr << "Failed to read the frontier segment " << segmentVector[i] << std::endl;
+			isCopied = false;
+		}
+		for (size_t k = 0; isCopied && k < urlVector.size(); k++) {
+			isCopied = writeString(file, urlVector[k], offset);
+		}
+		header.numberPushedURLs += urlVector.size();
+	}
+	if (!isCopied) {
+		return false;
+	}
+	header.doneOffset = offset;
+	header.numberDoneURLs = doneVector.size();
+	for (size_t i = 0; i < doneVector.size(); i++) {
+		if (!writeString(file, doneVector[i], offset)) {
+			return false;
+		}
+	}
+
+	//copy the records added since the previous checkpoint, one copy per column
+	RecordBatch productBatch;
+	{
+		boost::mutex::scoped_lock lock(productMutex_);
+		RecordBatchView records = productRecordBatch_.view();
+		productBatch.append(records.slice(min(numberProductsSaved_, records.size()), records.size()));
+		numberProductsSaved_ = records.size();
+	}
+	//the records are read in place, so they start on an 8-byte boundary
+	static const char padding[8] = {0};
+	if (!writeBytes(file, padding, (8 - offset % 8) % 8, offset)) {
+		return false;
+	}
+	RecordBatchView productRecords = productBatch.view();
+	header.productOffset = offset;
+	header.numberProducts = productRecords.size();
+	if (!productRecords.write(file)) {
+		return false;
+	}
+	offset += productRecords.getEncodedSize();
+
+	header.fileSize = offset;
+	boost::uint64_t headerOffset = 0;
+	return fseek(file, 0, SEEK_SET) == 0 &&
+		writeBytes(file, &header, sizeof(header), headerOffset);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function loads the last full snapshot and the deltas written
+after it, and pushes the URLs which were not crawled into the frontier. Only
+the URLs of the deltas are gathered in memory; the URLs of the full snapshot are
+pushed one by one from the mapped file, so that a frontier which spills keeps
+its memory bound. The next checkpoint written is a full snapshot.
+* @param		none
+* @return		long -- the number of URLs pushed into the frontier, 0 if there is
+no checkpoint, or -1 if a checkpoint cannot be loaded.
+*******************************************************************************
+*/
+long CrawlCheckpoint::load()
+{
+	boost::mutex::scoped_lock lock(writeMutex_);
+	vector<boost::uint64_t> sequenceVector;
+	DIR* dir = opendir(folder_.c_str());
+	if (dir == NULL) {
+		std::cerr << "Failed to open the checkpoint folder " << folder_ << std::endl;
+		return -1;
+	}
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL) {
+		unsigned long long sequence;
+		char extension[5];
+		if (sscanf(entry->d_name, "checkpoint-%llu.%4s", &sequence, extension) == 2 &&
+				strcmp(extension, "ckp") == 0) {
+			sequenceVector.push_back(sequence);
+		}
+	}
+	closedir(dir);
+	sort(sequenceVector.begin(), sequenceVector.end());
+
+	/*map the files from the newest: skip back to the last full snapshot, then
+	apply it and the deltas based on it until one is missing or damaged */
+	boost::unordered_set<string> urlSet;
+	vector< pair<boost::uint64_t, bool> > loadVector;
+	for (size_t i = sequenceVector.size(); i > 0; i--) {
+		string fileName = getCheckpointPath(sequenceVector[i - 1]);
+		int fd = open(fileName.c_str(), O_RDONLY);
+		struct stat fileStat;
+		Header header;
+		bool isValid = (fd >= 0) && fstat(fd, &fileStat) == 0 &&
+			pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+			header.magic == kCheckpointMagic && header.fileSize == (boost::uint64_t)fileStat.st_size;
+		if (fd >= 0) {
+			close(fd);
+		}
+		if (isValid) {
+			loadVector.push_back(make_pair(header.baseSequence, header.isFull != 0));
+			if (header.isFull) {
+				break;
+			}
+		}
+		else {
+			loadVector.clear();
+		}
+	}
+	if (loadVector.empty() || !loadVector.back().second) {
+		return sequenceVector.empty() ? 0 : -1;
+	}
+	boost::uint64_t baseSequence = loadVector.back().first;
+
+	//the full snapshot stays mapped until its URLs are pushed
+	const char* baseData = NULL;
+	size_t baseSize = 0;
+	boost::unordered_set<string> doneSet;
+	boost::uint64_t sequence = baseSequence;
+	for (; binary_search(sequenceVector.begin(), sequenceVector.end(), sequence); sequence++) {
+		string fileName = getCheckpointPath(sequence);
+		int fd = open(fileName.c_str(), O_RDONLY);
+		struct stat fileStat;
+		if (fd < 0 || fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+			if (fd >= 0) {
+				close(fd);
+			}
+			break;
+		}
+		void* data = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (data == MAP_FAILED) {
+			break;
+		}
+		Header header;
+		memcpy(&header, data, min(sizeof(header), (size_t)fileStat.st_size));
+		int status = 1;
+		if ((size_t)fileStat.st_size >= sizeof(header) && header.magic == kCheckpointMagic &&
+				header.baseSequence == baseSequence && header.fileSize == (boost::uint64_t)fileStat.st_size) {
+			status = apply(static_cast<const char*>(data), fileStat.st_size, urlSet, doneSet);
+		}
+		if (status == 0 && sequence == baseSequence) {
+			baseData = static_cast<const char*>(data);
+			baseSize = fileStat.st_size;
+		}
+		else {
+			munmap(data, fileStat.st_size);
+		}
+		if (status != 0) {
+			if (sequence == baseSequence) {
+				std::cerr << "Failed to load the checkpoint " << fileName << std::endl;
+				return -1;
+			}
+			break;
+		}
+	}
+
+	if (baseData == NULL) {
+		std::cerr << "Failed to load the checkpoint " << getCheckpointPath(baseSequence) << std::endl;
+		return -1;
+	}
+
+	/*push the URLs of the full snapshot through the normal path, which spills
+	them beyond the memory limit, except those done or pushed again since */
+	long numberPushed = 0;
+	Header baseHeader;
+	memcpy(&baseHeader, baseData, sizeof(baseHeader));
+	size_t position = baseHeader.pushedOffset;
+	string url;
+	for (size_t i = 0; i < baseHeader.numberPushedURLs &&
+			readString(baseData, baseSize, position, url); i++) {
+		if (doneSet.find(url) == doneSet.end() && urlSet.find(url) == urlSet.end() &&
+				crawlFrontier_.push(url)) {
+			numberPushed++;
+		}
+	}
+	munmap(const_cast<char*>(baseData), baseSize);
+	for (boost::unordered_set<string>::iterator it = urlSet.begin(); it != urlSet.end(); it++) {
+		if (crawlFrontier_.push(*it)) {
+			numberPushed++;
+		}
+	}
+	{
+		boost::mutex::scoped_lock productLock(productMutex_);
+		numberProductsSaved_ = productRecordBatch_.size();
+	}
+	sequence_ = sequence;
+	baseSequence_ = 0;
+	numberDeltas_ = 0;
+	return numberPushed;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function applies one mapped checkpoint file: the fingerprints
+or the Bloom filter bits, the pushed and done URLs, the records and the counter.
+The URLs of a full snapshot are only checked and inserted into the filter here;
+load() pushes them from the mapped file at the end.
+* @param		char* -- data (the mapped file, whose header has been checked)
+* @param		size_t -- size (the size of the file)
+* @param		unordered_set<string>& -- urlSet (input/output, the URLs pushed by
+the deltas and not crawled)
+* @param		unordered_set<string>& -- doneSet (input/output, the URLs done
+since the full snapshot)
+* @return		int -- return 0 on success, and 1 if the file is damaged or was
+written with another seen-URL filter.
+*******************************************************************************
+*/
+int CrawlCheckpoint::apply(const char* data, size_t size, boost::unordered_set<string>& urlSet,
+	boost::unordered_set<string>& doneSet)
+{
+	Header header;
+	memcpy(&header, data, sizeof(header));
+	if (header.mode != (boost::uint32_t)urlSeenFilter_.getMode()) {
+		std::cerr << "The checkpoint was written with another seen-URL filter mode" << std::endl;
+		return 1;
+	}
+
+	//the sections are 8-byte aligned and are read in place
+	if (header.numberFingerprints > 0) {
+		if (header.fingerprintOffset + header.numberFingerprints * sizeof(URLFingerprint) > size) {
+			return 1;
+		}
+		const URLFingerprint* fingerprints =
+			reinterpret_cast<const URLFingerprint*>(data + header.fingerprintOffset);
+		for (size_t i = 0; i < header.numberFingerprints; i++) {
+			urlSeenFilter_.insert(fingerprints[i]);
+		}
+	}
+	if (header.numberBloomWords > 0) {
+		if (header.bloomOffset + header.numberBloomWords * sizeof(boost::uint64_t) > size) {
+			return 1;
+		}
+		const boost::uint64_t* words = reinterpret_cast<const boost::uint64_t*>(data + header.bloomOffset);
+		if (!urlSeenFilter_.getBloomFilter()->loadWords(words, header.numberBloomWords,
+				header.numberHashes, header.bloomSize)) {
+			std::cerr << "The checkpoint was written with another Bloom filter size" << std::endl;
+			return 1;
+		}
+	}
+
+	//the pushed URLs were not crawled yet and have been seen
+	size_t position = header.pushedOffset;
+	string url;
+	for (size_t i = 0; i < header.numberPushedURLs; i++) {
+		if (!readString(data, size, position, url)) {
+			return 1;
+		}
+		urlSeenFilter_.insert(url);
+		if (!header.isFull) {
+			urlSet.insert(url);
+		}
+	}
+	position = header.doneOffset;
+	for (size_t i = 0; i < header.numberDoneURLs; i++) {
+		if (!readString(data, size, position, url)) {
+			return 1;
+		}
+		urlSet.erase(url);
+		doneSet.insert(url);
+	}
+
+	RecordBatchView productRecords;
+	if (header.productOffset > size || productRecords.attach(data + header.productOffset,
+			size - header.productOffset) == 0 || productRecords.size() != header.numberProducts) {
+		return 1;
+	}
+	{
+		boost::mutex::scoped_lock lock(productMutex_);
+		productRecordBatch_.append(productRecords);
+	}
+	numberCompleted_ = (int)header.numberCompleted;
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the sequence number of the last checkpoint.
+* @param		none
+* @return		uint64_t -- the sequence number (0 if there is none)
+*******************************************************************************
+*/
+boost::uint64_t CrawlCheckpoint::getSequence()
+{
+	boost::mutex::scoped_lock lock(writeMutex_);
+	return sequence_ - 1;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the size of the last checkpoint written.
+* @param		none
+* @return		uint64_t -- the number of bytes
+*******************************************************************************
+*/
+boost::uint64_t CrawlCheckpoint::getLastCheckpointBytes()
+{
+	boost::mutex::scoped_lock lock(writeMutex_);
+	return lastCheckpointBytes_;
+}
@@ -0,0 +1,155 @@
+/**
+*******************************************************************************
+* @file		CrawlCheckpoint.h
+* @brief	This file provides the interfaces of the class CrawlCheckpoint.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _CRAWLCHECKPOINT_H_
+#define _CRAWLCHECKPOINT_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//boost lib
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "RecordBatch.h"
+#include "CrawlFrontier.h"
+#include "URLSeenFilter.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @class		CrawlCheckpoint
+* @brief 		This class saves the state of the crawl (the URLs not crawled yet,
+the seen-URL filter, the product records and the counters) so that a crawl which
+died can resume where it stopped. A background thread writes a full snapshot,
+then deltas holding only the URLs pushed and done and the records added since
+the previous checkpoint; every fullInterval checkpoints a new full snapshot
+replaces the older files. The crawl threads are only stopped for the copy of
+one seen-set shard at a time, and of the frontier URLs in memory: the spilled
+URLs are read from links to their segments after the frontier lock is released.
+The files are loaded with mmap: the fingerprints and the Bloom filter bits are
+stored as aligned arrays and are read in place.
+
+File layout (checkpoint-NNNNNNNNNN.ckp, native byte order): the Header below,
+then the sections at the offsets given in it:
+  fingerprints  u64[numberFingerprints] (EXACT mode)
+  bloom words   u64[numberBloomWords] (BLOOM mode)
+  pushed URLs   per URL: u32 length, bytes (all URLs not crawled in a full)
+  done URLs     per URL: u32 length, bytes (delta only)
+  products      the records added, in the binary layout of RecordBatchView
+                (8-byte aligned, read in place)
+A delta applies to the full snapshot baseSequence and all deltas before it.
+*******************************************************************************
+*/
+class CrawlCheckpoint
+{
+	private:
+		//the fixed-size start of a checkpoint file
+		struct Header
+		{
+			boost::uint32_t magic;
+			boost::uint32_t isFull;
+			boost::uint32_t mode;
+			boost::uint32_t numberHashes;
+			boost::uint64_t sequence;
+			boost::uint64_t baseSequence;
+			boost::uint64_t numberCompleted;
+			boost::uint64_t numberFingerprints;
+			boost::uint64_t fingerprintOffset;
+			boost::uint64_t numberBloomWords;
+			boost::uint64_t bloomOffset;
+			boost::uint64_t bloomSize;
+			boost::uint64_t numberPushedURLs;
+			boost::uint64_t pushedOffset;
+			boost::uint64_t numberDoneURLs;
+			boost::uint64_t doneOffset;
+			boost::uint64_t numberProducts;
+			boost::uint64_t productOffset;
+			boost::uint64_t fileSize;
+		};
+
+		//the folder holding the checkpoint files
+		string folder_;
+		//the state saved in the checkpoints
+		CrawlFrontier& crawlFrontier_;
+		URLSeenFilter& urlSeenFilter_;
+		RecordBatch& productRecordBatch_;
+		boost::mutex& productMutex_;
+		boost::atomic<int>& numberCompleted_;
+		//a full snapshot is written every fullInterval checkpoints
+		int fullInterval_;
+
+		//the sequence number of the next checkpoint
+		boost::uint64_t sequence_;
+		//the sequence number of the last full snapshot (0 if none yet)
+		boost::uint64_t baseSequence_;
+		//the number of product records saved so far
+		size_t numberProductsSaved_;
+		//the number of checkpoints written since the last full snapshot
+		int numberDeltas_;
+		//the number of bytes of the last checkpoint
+		boost::uint64_t lastCheckpointBytes_;
+
+		//mutex protecting isStopping_
+		boost::mutex mutex_;
+		//mutex serializing write() and load()
+		boost::mutex writeMutex_;
+		//signalled by stop()
+		boost::condition_variable condition_;
+		//set by stop()
+		bool isStopping_;
+		//the checkpoint thread
+		boost::thread thread_;
+
+		//the body of the checkpoint thread
+		void run(int intervalSeconds);
+		//write the sections of a checkpoint, return false on a write error
+		bool writeSections(FILE* file, Header& header, bool isFull);
+		//apply one mapped checkpoint file, return 0 on success
+		int apply(const char* data, size_t size, boost::unordered_set<string>& urlSet,
+			boost::unordered_set<string>& doneSet);
+		//get the path of a checkpoint file
+		string getCheckpointPath(boost::uint64_t sequence) const;
+
+	public:
+ 		//constructor
+ 		CrawlCheckpoint(const string& folder, CrawlFrontier& crawlFrontier,
+ 			URLSeenFilter& urlSeenFilter, RecordBatch& productRecordBatch,
+ 			boost::mutex& productMutex, boost::atomic<int>& numberCompleted,
+ 			int fullInterval = 10);
+ 		//destructor: stops the checkpoint thread
+ 		~CrawlCheckpoint();
+ 		/*load the last full snapshot and its deltas into the frontier, the filter
+ 		and the records, return the number of URLs to crawl, or -1 on failure */
+ 		long load();
+ 		//start writing a checkpoint every intervalSeconds seconds
+ 		void start(int intervalSeconds);
+ 		//stop the checkpoint thread
+ 		void stop();
+ 		//write a checkpoint now, return 0 on success
+ 		int write(bool isFull);
+ 		//get the sequence number of the last checkpoint written or loaded
+ 		boost::uint64_t getSequence();
+ 		//get the size of the last checkpoint written
+ 		boost::uint64_t getLastCheckpointBytes();
+
+}; //end of class CrawlCheckpoint
+
+} //end of namespace WebDataExtraction
+
+#endif //_CRAWLCHECKPOINT_H_
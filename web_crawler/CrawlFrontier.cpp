@@ -0,0 +1,735 @@
+/**
+*******************************************************************************
+* @file			CrawlFrontier.cpp
+* @brief 		This file provides the implementations of the class CrawlFrontier.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "CrawlFrontier.h"
+#include "Metrics.h"
+#include "AsyncLogger.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <dirent.h>
+#include <unistd.h>
+
+#include <boost/bind.hpp>
+#include <boost/static_assert.hpp>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+//one bit of nonEmptyMask_ per bucket
+BOOST_STATIC_ASSERT(URLPrioritizer::NUMBER_PRIORITIES <= 64);
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class CrawlFrontier.
+* @param		int -- maxInFlight (the maximum number of tasks in flight, 0 means
+no limit)
+* @param		URLPrioritizer* -- ptrPrioritizer (the scorer of the URLs, or NULL
+to crawl breadth first)
+* @return		None
+*******************************************************************************
+*/
+CrawlFrontier::CrawlFrontier(int maxInFlight, URLPrioritizer* ptrPrioritizer) :
+	buckets_(URLPrioritizer::NUMBER_PRIORITIES), nonEmptyMask_(0),
+	ptrPrioritizer_(ptrPrioritizer), maxInFlight_(maxInFlight), closed_(false),
+	isJournaling_(false), maxInMemory_(0), spillBatchSize_(0), nextSegmentID_(0),
+	numberSpilled_(0), isStoppingSpill_(false), spilledMetric_(-1), refilledMetric_(-1)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class CrawlFrontier.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+CrawlFrontier::~CrawlFrontier()
+{
+	stopSpilling();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function bounds the pending URLs kept in memory: the others
+are spilled into segment files in a folder, written and read back by the spill
+thread. The segments left in the folder by an earlier run are removed, since a
+resumed crawl restores its frontier from the checkpoint.
+* @param		string -- folder (the folder of the segments)
+* @param		size_t -- maxInMemory (the maximum number of pending URLs in memory)
+* @param		size_t -- batchSize (the number of URLs per segment)
+* @return		int -- return 0 if the spill thread is started, and 1 if the folder
+cannot be opened.
+*******************************************************************************
+*/
+int CrawlFrontier::startSpilling(const string& folder, size_t maxInMemory, size_t batchSize)
+{
+	DIR* dir = opendir(folder.c_str());
+	if (dir == NULL) {
+		cerr << "Failed to open the frontier folder " << folder << endl;
+		return 1;
+	}
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL) {
+		unsigned int segmentID;
+		if (sscanf(entry->d_name, "frontier-%u.seg", &segmentID) == 1) {
+			remove((folder + "/" + entry->d_name).c_str());
+		}
+	}
+	closedir(dir);
+
+	spilledMetric_ = Metrics::getShared().addCounter("frontier_spilled_urls");
+	refilledMetric_ = Metrics::getShared().addCounter("frontier_refilled_urls");
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		spillFolder_ = folder;
+		maxInMemory_ = max((size_t)2, maxInMemory);
+		//a refill at half the limit must fit under the limit
+		spillBatchSize_ = max((size_t)1, min(batchSize, maxInMemory_ / 2));
+		isStoppingSpill_ = false;
+		//the URLs beyond the limit pushed before
+		while (pendingMap_.size() > maxInMemory_) {
+			evict();
+		}
+	}
+	spillThread_ = boost::thread(boost::bind(&CrawlFrontier::runSpill, this));
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function stops the spill thread and removes the segments. The
+URLs still spilled are dropped: it is called when the crawl is over, and a
+checkpoint holds them.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void CrawlFrontier::stopSpilling()
+{
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		isStoppingSpill_ = true;
+	}
+	spillCondition_.notify_all();
+	spaceCondition_.notify_all();
+	if (spillThread_.joinable()) {
+		spillThread_.join();
+	}
+	boost::mutex::scoped_lock lock(mutex_);
+	for (size_t i = 0; i < segments_.size(); i++) {
+		remove(segments_[i].fileName.c_str());
+	}
+	segments_.clear();
+	spillBuffer_.clear();
+	numberSpilled_ = 0;
+	maxInMemory_ = 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function sets the scorer of the URLs. It must be called before
+the first push().
+* @param		URLPrioritizer* -- ptrPrioritizer (the scorer, or NULL to crawl
+breadth first)
+* @return		void
+*******************************************************************************
+*/
+void CrawlFrontier::setPrioritizer(URLPrioritizer* ptrPrioritizer)
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	ptrPrioritizer_ = ptrPrioritizer;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function queues a pending URL at the back of the bucket of a
+priority. The caller holds mutex_.
+* @param		PendingMap::value_type* -- ptrEntry (the URL in pendingMap_)
+* @param		int -- priority (the priority of the URL)
+* @return		void
+*******************************************************************************
+*/
+void CrawlFrontier::enqueue(PendingMap::value_type* ptrEntry, int priority)
+{
+	buckets_[priority].push_back(ptrEntry);
+	nonEmptyMask_ |= (boost::uint64_t)1 << priority;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function takes the oldest URL of the highest priority out of
+the frontier. A URL whose priority has fallen since its push is moved down to
+its new bucket instead, and the next URL is taken. The caller holds mutex_ and
+checks that a URL is pending.
+* @param		string& -- url (output, the URL)
+* @param		LinkOrigin& -- origin (output, where the URL was found)
+* @return		void
+*******************************************************************************
+*/
+void CrawlFrontier::dequeue(string& url, LinkOrigin& origin)
+{
+	while (true) {
+		//the highest bit set is the highest bucket which is not empty
+		int priority = 63 - __builtin_clzll(nonEmptyMask_);
+		deque<PendingMap::value_type*>& bucket = buckets_[priority];
+		PendingMap::value_type* ptrEntry = bucket.front();
+		bucket.pop_front();
+		if (bucket.empty()) {
+			nonEmptyMask_ &= ~((boost::uint64_t)1 << priority);
+		}
+		if (ptrPrioritizer_ != NULL) {
+			int newPriority = ptrPrioritizer_->getPriority(ptrEntry->first, ptrEntry->second);
+			if (newPriority < priority) {
+				enqueue(ptrEntry, newPriority);
+				continue;
+			}
+		}
+		url = ptrEntry->first;
+		origin = ptrEntry->second;
+		pendingMap_.erase(url);
+		return;
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function moves the newest URL of the lowest priority out of
+memory into the spill buffer, and wakes the spill thread when a batch is full.
+The caller holds mutex_ and checks that a URL is pending.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void CrawlFrontier::evict()
+{
+	//the lowest bit set is the lowest bucket which is not empty
+	int priority = __builtin_ctzll(nonEmptyMask_);
+	deque<PendingMap::value_type*>& bucket = buckets_[priority];
+	PendingMap::value_type* ptrEntry = bucket.back();
+	bucket.pop_back();
+	if (bucket.empty()) {
+		nonEmptyMask_ &= ~((boost::uint64_t)1 << priority);
+	}
+	spillBuffer_.push_back(*ptrEntry);
+	pendingMap_.erase(ptrEntry->first);
+	numberSpilled_++;
+	if (spillBuffer_.size() == spillBatchSize_) {
+		spillCondition_.notify_one();
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function queues spilled URLs in memory again, scored with the
+yields learned since they were spilled. A URL which has been pushed again and is
+pending or in flight is not queued twice. The caller holds mutex_.
+* @param		SpillBatch -- batch (the URLs read back, counted in numberSpilled_)
+* @return		void
+*******************************************************************************
+*/
+void CrawlFrontier::refill(const SpillBatch& batch)
+{
+	for (size_t i = 0; i < batch.size(); i++) {
+		const string& url = batch[i].first;
+		if (inFlightSet_.find(url) != inFlightSet_.end()) {
+			continue;
+		}
+		pair<PendingMap::iterator, bool> result = pendingMap_.insert(batch[i]);
+		if (result.second) {
+			enqueue(&*result.first, (ptrPrioritizer_ != NULL) ?
+				ptrPrioritizer_->getPriority(url, batch[i].second) : 0);
+		}
+	}
+	numberSpilled_ -= batch.size();
+	Metrics::getShared().increment(refilledMetric_, (long)batch.size());
+	condition_.notify_all();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the path of a segment.
+* @param		unsigned int -- segmentID (the id of the segment)
+* @return		string -- the path, e.g. ./data/frontier-00012.seg
+*******************************************************************************
+*/
+string CrawlFrontier::getSegmentPath(unsigned int segmentID) const
+{
+	stringstream strStream;
+	strStream << spillFolder_ << "/frontier-" << setw(5) << setfill('0') << segmentID << ".seg";
+	return strStream.str();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function writes a batch of URLs into a segment file with one
+sequential write. Each URL is stored as its length, depth and source pattern
+(32-bit integers) followed by its bytes.
+* @param		string -- fileName (the path of the segment)
+* @param		SpillBatch -- batch (the URLs)
+* @return		bool -- return true if the whole segment is written
+*******************************************************************************
+*/
+bool CrawlFrontier::writeSegment(const string& fileName, const SpillBatch& batch)
+{
+	string bytes;
+	for (size_t i = 0; i < batch.size(); i++) {
+		boost::int32_t header[3] = {(boost::int32_t)batch[i].first.size(),
+			batch[i].second.depth, batch[i].second.sourcePattern};
+		bytes.append((const char*)header, sizeof(header));
+		bytes.append(batch[i].first);
+	}
+	FILE* file = fopen(fileName.c_str(), "wb");
+	if (file == NULL) {
+		return false;
+	}
+	bool isWritten = (bytes.empty() || fwrite(bytes.data(), bytes.size(), 1, file) == 1);
+	isWritten = (fclose(file) == 0) && isWritten;
+	if (!isWritten) {
+		remove(fileName.c_str());
+	}
+	return isWritten;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function reads a segment file written by writeSegment().
+* @param		string -- fileName (the path of the segment)
+* @param		SpillBatch& -- batch (output, the URLs)
+* @return		bool -- return true if the whole segment is read
+*******************************************************************************
+*/
+bool CrawlFrontier::readSegment(const string& fileName, SpillBatch& batch)
+{
+	batch.clear();
+	FILE* file = fopen(fileName.c_str(), "rb");
+	if (file == NULL) {
+		return false;
+	}
+	string bytes;
+	char buffer[65536];
+	size_t numberRead;
+	while ((numberRead = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		bytes.append(buffer, numberRead);
+	}
+	bool isRead = (ferror(file) == 0);
+	fclose(file);
+
+	size_t offset = 0;
+	while (isRead && offset < bytes.size()) {
+		boost::int32_t header[3];
+		if (offset + sizeof(header) > bytes.size()) {
+			return false;
+		}
+		memcpy(header, bytes.data() + offset, sizeof(header));
+		offset += sizeof(header);
+		if (header[0] < 0 || offset + header[0] > bytes.size()) {
+			return false;
+		}
+		batch.push_back(make_pair(bytes.substr(offset, header[0]), LinkOrigin(header[1], header[2])));
+		offset += header[0];
+	}
+	return isRead;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the body of the spill thread. It writes a full
+spill buffer into a new segment, and when the URLs in memory fall to half the
+limit it reads the oldest segment back, or takes the spill buffer if nothing has
+been written yet. The files are written and read without the lock; a segment
+stays listed until its URLs are back in memory, so that a snapshot sees each
+spilled URL once.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void CrawlFrontier::runSpill()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	while (!isStoppingSpill_) {
+		bool isWriting = (spillBuffer_.size() >= spillBatchSize_);
+		bool isReading = (numberSpilled_ > 0 && pendingMap_.size() <= maxInMemory_ / 2);
+		if (!isWriting && !isReading) {
+			spillCondition_.wait(lock);
+			continue;
+		}
+
+		if (isWriting) {
+			writingBatch_.swap(spillBuffer_);
+			spaceCondition_.notify_all();
+			SpillSegment segment;
+			segment.fileName = getSegmentPath(nextSegmentID_++);
+			segment.numberURLs = writingBatch_.size();
+			lock.unlock();
+			bool isWritten = writeSegment(segment.fileName, writingBatch_);
+			lock.lock();
+			if (isWritten) {
+				segments_.push_back(segment);
+				Metrics::getShared().increment(spilledMetric_, (long)segment.numberURLs);
+			}
+			else {
+				//keep the URLs in memory over the limit rather than losing them
+				AsyncLogger::getShared().log(LOG_ERROR, "Failed to write the frontier segment {}",
+					segment.fileName);
+				refill(writingBatch_);
+			}
+			writingBatch_.clear();
+		}
+		else if (!segments_.empty()) {
+			SpillSegment segment = segments_.front();
+			lock.unlock();
+			SpillBatch batch;
+			bool isRead = readSegment(segment.fileName, batch);
+			lock.lock();
+			segments_.pop_front();
+			if (!isRead) {
+				AsyncLogger::getShared().log(LOG_ERROR, "Failed to read the frontier segment {}, "
+					"{} URLs lost", segment.fileName, (long)(segment.numberURLs - batch.size()));
+			}
+			refill(batch);
+			numberSpilled_ -= segment.numberURLs - batch.size();
+			//the file stays listed until its URLs are back, so a snapshot taken
+			//meanwhile still finds them on disk
+			remove(segment.fileName.c_str());
+		}
+		else {
+			SpillBatch batch;
+			batch.swap(spillBuffer_);
+			spaceCondition_.notify_all();
+			refill(batch);
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function adds a URL to the frontier, in the bucket of its
+priority. If the URLs in memory are over the limit, the URL of the lowest
+priority is spilled; the call blocks while the spill thread is behind.
+* @param		string -- url (the validated URL to be crawled)
+* @param		LinkOrigin -- origin (the depth and the source page of the URL)
+* @return		bool -- return true if the URL is added, and false if it is
+already pending.
+*******************************************************************************
+*/
+bool CrawlFrontier::push(const string& url, const LinkOrigin& origin)
+{
+	//score the URL before taking the lock
+	int priority = (ptrPrioritizer_ != NULL) ? ptrPrioritizer_->getPriority(url, origin) : 0;
+	bool isInserted;
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		//wait while the spill thread is two batches behind
+		while (maxInMemory_ > 0 && !isStoppingSpill_ && spillBuffer_.size() >= 2 * spillBatchSize_) {
+			spaceCondition_.wait(lock);
+		}
+		pair<PendingMap::iterator, bool> result = pendingMap_.insert(make_pair(url, origin));
+		isInserted = result.second;
+		if (isInserted) {
+			enqueue(&*result.first, priority);
+			if (isJournaling_) {
+				pushedJournal_.push_back(url);
+			}
+			if (maxInMemory_ > 0 && pendingMap_.size() > maxInMemory_) {
+				evict();
+			}
+		}
+	}
+	if (isInserted) {
+		condition_.notify_one();
+	}
+	return isInserted;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function blocks until a URL can be dispatched. The popped
+URL is counted as in flight until taskDone() is called.
+* @param		string& -- url (output, the URL to be crawled)
+* @return		bool -- return true if a URL is popped, and false if the crawl is
+quiescent (no pending URL and no task in flight) or the frontier is closed.
+*******************************************************************************
+*/
+bool CrawlFrontier::pop(string& url)
+{
+	LinkOrigin origin;
+	return pop(url, origin);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function blocks until a URL can be dispatched, and returns the
+pending URL of the highest priority. The popped URL is counted as in flight
+until taskDone() is called.
+* @param		string& -- url (output, the URL to be crawled)
+* @param		LinkOrigin& -- origin (output, the depth and the source page of the
+URL, to derive the origin of the links found on it)
+* @return		bool -- return true if a URL is popped, and false if the crawl is
+quiescent (no pending URL, in memory or spilled, and no task in flight) or the
+frontier is closed.
+*******************************************************************************
+*/
+bool CrawlFrontier::pop(string& url, LinkOrigin& origin)
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	while (true) {
+		if (closed_) {
+			return false;
+		}
+		bool isBelowLimit = (maxInFlight_ <= 0 || (int)inFlightSet_.size() < maxInFlight_);
+		if (!pendingMap_.empty() && isBelowLimit) {
+			dequeue(url, origin);
+			inFlightSet_.insert(url);
+			//read the next segment back before the URLs in memory run out
+			if (numberSpilled_ > 0 && pendingMap_.size() <= maxInMemory_ / 2) {
+				spillCondition_.notify_one();
+			}
+			return true;
+		}
+		//nothing is pending and nothing can add new URLs any more
+		if (pendingMap_.empty() && inFlightSet_.empty() && numberSpilled_ == 0) {
+			return false;
+		}
+		if (pendingMap_.empty() && numberSpilled_ > 0) {
+			spillCondition_.notify_one();
+		}
+		condition_.wait(lock);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function marks a task obtained from pop() as finished. It
+must be called after the task has pushed all the URLs it discovered.
+* @param		string -- url (the URL obtained from pop())
+* @return		void
+*******************************************************************************
+*/
+void CrawlFrontier::taskDone(const string& url)
+{
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		//only this task: the URL may have been dispatched again meanwhile
+		multiset<string>::iterator it = inFlightSet_.find(url);
+		if (it != inFlightSet_.end()) {
+			inFlightSet_.erase(it);
+		}
+		if (isJournaling_) {
+			doneJournal_.push_back(url);
+		}
+	}
+	//wakes the dispatcher to either pop under the limit or detect quiescence
+	condition_.notify_all();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function closes the frontier. pop() returns false afterwards.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void CrawlFrontier::close()
+{
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		closed_ = true;
+	}
+	condition_.notify_all();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of pending URLs.
+* @param		none
+* @return		size_t -- the number of URLs waiting to be dispatched, in memory or
+spilled
+*******************************************************************************
+*/
+size_t CrawlFrontier::pendingSize()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return pendingMap_.size() + numberSpilled_;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of pending URLs spilled out of
+memory.
+* @param		none
+* @return		size_t -- the number of URLs buffered for, or written into, the
+segments
+*******************************************************************************
+*/
+size_t CrawlFrontier::spilledSize()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return numberSpilled_;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of tasks in flight.
+* @param		none
+* @return		int -- the number of dispatched tasks not yet done
+*******************************************************************************
+*/
+int CrawlFrontier::inFlightSize()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return (int)inFlightSet_.size();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the URLs which have not been crawled yet:
+the pending URLs in memory and in the spill buffers, and the URLs in flight,
+which are crawled again after a resume. The segments on disk are not read under
+the lock: each is linked under another name, which the spill thread does not
+remove, and the caller reads the links with readSnapshotSegment() once the crawl
+goes on. It empties the journals and starts journaling.
+* @param		vector<string>& -- urlVector (output, the URLs in memory)
+* @param		vector<string>& -- segmentVector (output, the links to the segments)
+* @return		void
+*******************************************************************************
+*/
+void CrawlFrontier::snapshot(vector<string>& urlVector, vector<string>& segmentVector)
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	urlVector.clear();
+	segmentVector.clear();
+	urlVector.reserve(pendingMap_.size() + inFlightSet_.size());
+	for (PendingMap::iterator it = pendingMap_.begin(); it != pendingMap_.end(); it++) {
+		urlVector.push_back(it->first);
+	}
+	//the batch being written is only read by the spill thread
+	const SpillBatch* batches[2] = {&spillBuffer_, &writingBatch_};
+	for (int i = 0; i < 2; i++) {
+		for (size_t k = 0; k < batches[i]->size(); k++) {
+			urlVector.push_back((*batches[i])[k].first);
+		}
+	}
+	for (size_t i = 0; i < segments_.size(); i++) {
+		string linkName = segments_[i].fileName + ".snapshot";
+		remove(linkName.c_str());
+		if (link(segments_[i].fileName.c_str(), linkName.c_str()) == 0) {
+			segmentVector.push_back(linkName);
+			continue;
+		}
+		//without a link the segment has to be read before a refill removes it
+		SpillBatch batch;
+		if (!readSegment(segments_[i].fileName, batch)) {
+			AsyncLogger::getShared().log(LOG_ERROR, "Failed to read the frontier segment {}",
+				segments_[i].fileName);
+		}
+		for (size_t k = 0; k < batch.size(); k++) {
+			urlVector.push_back(batch[k].first);
+		}
+	}
+	//a URL in flight in several tasks is written once
+	for (multiset<string>::iterator it = inFlightSet_.begin(); it != inFlightSet_.end();
+		it = inFlightSet_.upper_bound(*it)) {
+		urlVector.push_back(*it);
+	}
+	pushedJournal_.clear();
+	doneJournal_.clear();
+	isJournaling_ = true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function reads the URLs of a segment linked by snapshot(), and
+removes the link.
+* @param		string -- fileName (the link returned by snapshot())
+* @param		vector<string>& -- urlVector (output, the URLs are appended)
+* @return		bool -- return true if the whole segment is read
+*******************************************************************************
+*/
+bool CrawlFrontier::readSnapshotSegment(const string& fileName, vector<string>& urlVector)
+{
+	SpillBatch batch;
+	bool isRead = readSegment(fileName, batch);
+	remove(fileName.c_str());
+	for (size_t i = 0; i < batch.size(); i++) {
+		urlVector.push_back(batch[i].first);
+	}
+	return isRead;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function moves the journals out. Replaying the pushed and then
+the done URLs on the previous snapshot gives the URLs not crawled yet.
+* @param		vector<string>& -- pushedVector (output, the URLs pushed since the
+last snapshot() or takeJournal())
+* @param		vector<string>& -- doneVector (output, the URLs done since then)
+* @return		void
+*******************************************************************************
+*/
+void CrawlFrontier::takeJournal(vector<string>& pushedVector, vector<string>& doneVector)
+{
+	pushedVector.clear();
+	doneVector.clear();
+	boost::mutex::scoped_lock lock(mutex_);
+	pushedJournal_.swap(pushedVector);
+	doneJournal_.swap(doneVector);
+}
@@ -0,0 +1,182 @@
+/**
+*******************************************************************************
+* @file		CrawlFrontier.h
+* @brief	This file provides the interfaces of the class CrawlFrontier.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _CRAWLFRONTIER_H_
+#define _CRAWLFRONTIER_H_
+
+#include <string>
+#include <set>
+#include <deque>
+#include <vector>
+
+//boost lib
+#include <boost/cstdint.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "URLPrioritizer.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+
+/**
+*******************************************************************************
+* @class		CrawlFrontier
+* @brief 		This class holds the URLs waiting to be crawled. The dispatcher
+blocks in pop() until a URL is available, and every popped URL is counted as
+an in-flight task until taskDone() is called for it. The crawl is finished
+(quiescent) when the frontier is empty and no task is in flight, since only
+the running tasks can add new URLs.
+The pending URLs are dispatched best first: each URL is scored by the
+URLPrioritizer when it is pushed, and queued in the bucket of its priority, one
+FIFO queue per priority with a bit mask of the buckets which are not empty, so
+that push and pop take constant time and touch only the head of one queue. As
+the yields learned by the prioritizer change, a popped URL is scored again and
+moved down to its new bucket if its priority has fallen. Without a prioritizer
+all the URLs share one bucket and are crawled breadth first.
+After startSpilling(), at most maxInMemory URLs are pending in memory: beyond
+that, the URL at the back of the lowest bucket is moved to a spill buffer, which
+a background thread writes in batches to segment files, sequentially. When the
+URLs in memory fall to half the limit, the thread reads the oldest segment back
+ahead of the dispatcher and queues its URLs again by their current priority,
+skipping those which are pending or in flight meanwhile. Each URL enters the
+frontier once through the seen-URL filter, so that the memory of the frontier
+stays constant however large the site is.
+For checkpoints, snapshot() returns the pending and in-flight URLs in memory and
+links to the segments, read after the lock is released, and starts a journal of
+the URLs pushed and done since then, which takeJournal() hands over.
+*******************************************************************************
+*/
+class CrawlFrontier
+{
+	private:
+		//mutex protecting all the members below
+		boost::mutex mutex_;
+		//signalled when a URL is pushed, a task is done, or the frontier is closed
+		boost::condition_variable condition_;
+		//the URLs waiting to be dispatched, and where they were found
+		typedef boost::unordered_map<string, LinkOrigin> PendingMap;
+		PendingMap pendingMap_;
+		//the pending URLs by priority in the order of their push, pointing into pendingMap_
+		vector< deque<PendingMap::value_type*> > buckets_;
+		//bit i is set if buckets_[i] is not empty
+		boost::uint64_t nonEmptyMask_;
+		//the scorer of the URLs, or NULL to crawl breadth first
+		URLPrioritizer* ptrPrioritizer_;
+		//the dispatched URLs which have not called taskDone(), once per task
+		multiset<string> inFlightSet_;
+		//the maximum number of tasks in flight (0 means no limit)
+		int maxInFlight_;
+		//set by close() to stop the crawl before it is quiescent
+		bool closed_;
+		//set by snapshot(): record the pushed and done URLs in the journals
+		bool isJournaling_;
+		//the URLs pushed since the last snapshot() or takeJournal()
+		vector<string> pushedJournal_;
+		//the URLs done since the last snapshot() or takeJournal()
+		vector<string> doneJournal_;
+
+		//the URLs moved out of memory, with where they were found
+		typedef vector< pair<string, LinkOrigin> > SpillBatch;
+		//a file of spilled URLs
+		struct SpillSegment
+		{
+			string fileName;
+			size_t numberURLs;
+		};
+		//the maximum number of pending URLs in memory (0 means no limit)
+		size_t maxInMemory_;
+		//the number of URLs written into a segment at once
+		size_t spillBatchSize_;
+		//the folder of the segments, and the id of the next segment
+		string spillFolder_;
+		unsigned int nextSegmentID_;
+		//the URLs evicted from memory, waiting to be written
+		SpillBatch spillBuffer_;
+		//the batch being written by the spill thread, read without the lock meanwhile
+		SpillBatch writingBatch_;
+		//the segments on disk, the oldest first
+		deque<SpillSegment> segments_;
+		//the spilled URLs: buffered, being written or on disk
+		size_t numberSpilled_;
+		//signalled when the spill thread has work, and when the spill buffer has room
+		boost::condition_variable spillCondition_;
+		boost::condition_variable spaceCondition_;
+		//set by stopSpilling()
+		bool isStoppingSpill_;
+		//the thread writing and reading the segments
+		boost::thread spillThread_;
+		//the counters of the URLs written and read back (Metrics ids)
+		int spilledMetric_;
+		int refilledMetric_;
+
+		//queue a pending URL in the bucket of a priority (locked)
+		void enqueue(PendingMap::value_type* ptrEntry, int priority);
+		//take the pending URL of the highest priority (locked, not empty)
+		void dequeue(string& url, LinkOrigin& origin);
+		//move the pending URL of the lowest priority into the spill buffer (locked)
+		void evict();
+		//queue spilled URLs in memory again, except those pending or in flight (locked)
+		void refill(const SpillBatch& batch);
+		//get the path of a segment
+		string getSegmentPath(unsigned int segmentID) const;
+		//write a batch into a segment file, return true on success
+		static bool writeSegment(const string& fileName, const SpillBatch& batch);
+		//read a segment file into a batch, return true on success
+		static bool readSegment(const string& fileName, SpillBatch& batch);
+		//the body of the spill thread
+		void runSpill();
+
+	public:
+ 		//constructor
+ 		CrawlFrontier(int maxInFlight = 0, URLPrioritizer* ptrPrioritizer = NULL);
+ 		//destructor: stops the spill thread
+ 		~CrawlFrontier();
+ 		/*keep at most maxInMemory pending URLs in memory and spill the others into
+ 		segments in a folder, return 0 on success */
+ 		int startSpilling(const string& folder, size_t maxInMemory, size_t batchSize = 4096);
+ 		//stop the spill thread and remove the segments
+ 		void stopSpilling();
+ 		//set the scorer of the URLs (NULL: breadth first), before the first push
+ 		void setPrioritizer(URLPrioritizer* ptrPrioritizer);
+ 		//add a URL to the frontier, return false if it is already pending
+ 		bool push(const string& url, const LinkOrigin& origin = LinkOrigin());
+ 		/*block until a URL can be dispatched, and return true with the URL of the
+ 		highest priority; return false when the crawl is quiescent or the frontier
+ 		is closed */
+ 		bool pop(string& url);
+ 		//pop() which also returns where the URL was found
+ 		bool pop(string& url, LinkOrigin& origin);
+ 		//mark a task obtained from pop() as finished
+ 		void taskDone(const string& url);
+ 		//stop the crawl: wake up the dispatcher and make pop() return false
+ 		void close();
+ 		//get the number of pending URLs, in memory or spilled
+ 		size_t pendingSize();
+ 		//get the number of pending URLs spilled out of memory
+ 		size_t spilledSize();
+ 		//get the number of tasks in flight
+ 		int inFlightSize();
+ 		//get the pending and in-flight URLs and the links to the segments, and restart the journals
+ 		void snapshot(vector<string>& urlVector, vector<string>& segmentVector);
+ 		//read the URLs of a segment linked by snapshot() and remove the link
+ 		static bool readSnapshotSegment(const string& fileName, vector<string>& urlVector);
+ 		//move the journals out: the URLs pushed and done since the last call
+ 		void takeJournal(vector<string>& pushedVector, vector<string>& doneVector);
+
+}; //end of class CrawlFrontier
+
+} //end of namespace WebDataExtraction
+
+#endif //_CRAWLFRONTIER_H_
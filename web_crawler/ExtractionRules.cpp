@@ -0,0 +1,763 @@
+/**
+*******************************************************************************
+* @file			ExtractionRules.cpp
+* @brief 		This file provides the implementations of the class ExtractionRules.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "ExtractionRules.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include <boost/algorithm/string.hpp>
+
+//libxml2 HTML parser (part of the libxml++ dependency), used in SAX mode
+#include <libxml/HTMLparser.h>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+//the names of the fields in a rule file, in the order of ExtractionRules::Field
+static const char* kFieldNames[] = {"id", "category", "description", "image",
+	"originalPrice", "currentPrice", "record"};
+
+
+
+/**
+*******************************************************************************
+* @brief		These structures hold the state of one extraction pass: the open
+elements, the text being collected, and the records found so far.
+*******************************************************************************
+*/
+namespace
+{
+	struct OpenElement
+	{
+		string tag;
+		string id;
+		vector<string> classVector;
+		vector< pair<string, string> > attributeVector;
+	};
+
+	struct Capture
+	{
+		int field;
+		size_t recordIndex;
+		size_t depth;
+		string text;
+	};
+
+	struct RecordState
+	{
+		string values[ExtractionRules::FIELD_RECORD];
+		bool isClaimed[ExtractionRules::FIELD_RECORD];
+		RecordState()
+		{
+			for (int i = 0; i < ExtractionRules::FIELD_RECORD; i++) {
+				isClaimed[i] = false;
+			}
+		}
+	};
+
+	struct MatchState
+	{
+		const ExtractionRules::Site* ptrSite;
+		vector<OpenElement> elementStack;
+		vector<Capture> captureVector;
+		//record 0 holds the fields matched outside any record
+		vector<RecordState> recordVector;
+		size_t currentRecord;
+		//the depth of the open record element (0 if none)
+		size_t recordDepth;
+		vector<int> candidateVector;
+	};
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function checks an element against one compound selector.
+* @param		SelectorStep -- step (the compound selector)
+* @param		OpenElement -- element (the element)
+* @return		bool -- return true if the element has the tag, id, classes and
+attributes of the step
+*******************************************************************************
+*/
+static bool matchStep(const ExtractionRules::SelectorStep& step, const OpenElement& element)
+{
+	if ((step.tag != "" && step.tag != element.tag) || (step.id != "" && step.id != element.id)) {
+		return false;
+	}
+	for (size_t i = 0; i < step.classVector.size(); i++) {
+		if (find(element.classVector.begin(), element.classVector.end(),
+				step.classVector[i]) == element.classVector.end()) {
+			return false;
+		}
+	}
+	for (size_t i = 0; i < step.attributeVector.size(); i++) {
+		bool isFound = false;
+		for (size_t j = 0; j < element.attributeVector.size() && !isFound; j++) {
+			isFound = element.attributeVector[j].first == step.attributeVector[i].first &&
+				(step.attributeVector[i].second == "" ||
+				element.attributeVector[j].second == step.attributeVector[i].second);
+		}
+		if (!isFound) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function matches the steps [0, stepIndex] of a selector from
+right to left, the step stepIndex against the element elementIndex of the stack.
+* @param		vector<SelectorStep> -- stepVector (the steps of the selector)
+* @param		size_t -- stepIndex (the step to match)
+* @param		vector<OpenElement> -- elementStack (the open elements)
+* @param		size_t -- elementIndex (the element to match)
+* @return		bool -- return true if the element and its ancestors match
+*******************************************************************************
+*/
+static bool matchSelector(const vector<ExtractionRules::SelectorStep>& stepVector,
+	size_t stepIndex, const vector<OpenElement>& elementStack, size_t elementIndex)
+{
+	if (!matchStep(stepVector[stepIndex], elementStack[elementIndex])) {
+		return false;
+	}
+	if (stepIndex == 0) {
+		return true;
+	}
+	if (stepVector[stepIndex].isChild) {
+		return elementIndex > 0 &&
+			matchSelector(stepVector, stepIndex - 1, elementStack, elementIndex - 1);
+	}
+	for (size_t i = elementIndex; i > 0; i--) {
+		if (matchSelector(stepVector, stepIndex - 1, elementStack, i - 1)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function appends the selectors indexed under a key to the
+candidates of an element.
+*******************************************************************************
+*/
+static void addCandidates(const ExtractionRules::Site& site, const string& key,
+	vector<int>& candidateVector)
+{
+	boost::unordered_map<string, vector<int> >::const_iterator it = site.selectorIndex.find(key);
+	if (it != site.selectorIndex.end()) {
+		candidateVector.insert(candidateVector.end(), it->second.begin(), it->second.end());
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the SAX callback of an opening tag. It pushes the
+element, opens a record if the element matches the record selector, and starts
+the fields it matches.
+* @param		void* -- context (the MatchState)
+* @param		xmlChar* -- name (the tag, in lower case)
+* @param		xmlChar** -- attributes (name/value pairs, NULL-terminated)
+* @return		void
+*******************************************************************************
+*/
+static void startElement(void* context, const xmlChar* name, const xmlChar** attributes)
+{
+	MatchState& state = *static_cast<MatchState*>(context);
+	const ExtractionRules::Site& site = *state.ptrSite;
+	state.elementStack.push_back(OpenElement());
+	OpenElement& element = state.elementStack.back();
+	element.tag = (const char*)name;
+	for (size_t i = 0; attributes != NULL && attributes[i] != NULL; i += 2) {
+		string attributeName = (const char*)attributes[i];
+		string attributeValue = (attributes[i + 1] != NULL) ? (const char*)attributes[i + 1] : "";
+		if (attributeName == "id") {
+			element.id = attributeValue;
+		}
+		else if (attributeName == "class") {
+			boost::algorithm::split(element.classVector, attributeValue,
+				boost::algorithm::is_space(), boost::algorithm::token_compress_on);
+		}
+		element.attributeVector.push_back(make_pair(attributeName, attributeValue));
+	}
+
+	//only the selectors indexed by a key of this element can match it
+	vector<int>& candidateVector = state.candidateVector;
+	candidateVector.clear();
+	if (element.id != "") {
+		addCandidates(site, "#" + element.id, candidateVector);
+	}
+	for (size_t i = 0; i < element.classVector.size(); i++) {
+		addCandidates(site, "." + element.classVector[i], candidateVector);
+	}
+	for (size_t i = 0; i < element.attributeVector.size(); i++) {
+		addCandidates(site, "[" + element.attributeVector[i].first, candidateVector);
+	}
+	addCandidates(site, element.tag, candidateVector);
+	addCandidates(site, "*", candidateVector);
+	if (candidateVector.empty()) {
+		return;
+	}
+
+	size_t depth = state.elementStack.size();
+	//the record starts before the fields of the same element
+	for (int pass = 0; pass < 2; pass++) {
+		for (size_t i = 0; i < candidateVector.size(); i++) {
+			const ExtractionRules::Selector& selector = site.selectorVector[candidateVector[i]];
+			bool isRecord = (selector.field == ExtractionRules::FIELD_RECORD);
+			if (isRecord != (pass == 0) || !matchSelector(selector.stepVector,
+					selector.stepVector.size() - 1, state.elementStack, depth - 1)) {
+				continue;
+			}
+			if (isRecord) {
+				//nested records belong to the outer one
+				if (state.recordDepth == 0) {
+					state.recordVector.push_back(RecordState());
+					state.currentRecord = state.recordVector.size() - 1;
+					state.recordDepth = depth;
+				}
+				continue;
+			}
+			RecordState& record = state.recordVector[state.currentRecord];
+			if (record.isClaimed[selector.field]) {
+				continue;
+			}
+			record.isClaimed[selector.field] = true;
+			if (selector.outputAttribute != "") {
+				for (size_t j = 0; j < element.attributeVector.size(); j++) {
+					if (element.attributeVector[j].first == selector.outputAttribute) {
+						record.values[selector.field] =
+							boost::algorithm::trim_copy(element.attributeVector[j].second);
+					}
+				}
+			}
+			else {
+				Capture capture;
+				capture.field = selector.field;
+				capture.recordIndex = state.currentRecord;
+				capture.depth = depth;
+				state.captureVector.push_back(capture);
+			}
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the SAX callback of a closing tag. It completes
+the fields collected inside the element and closes its record.
+* @param		void* -- context (the MatchState)
+* @param		xmlChar* -- name (the tag)
+* @return		void
+*******************************************************************************
+*/
+static void endElement(void* context, const xmlChar* /*name*/)
+{
+	MatchState& state = *static_cast<MatchState*>(context);
+	size_t depth = state.elementStack.size();
+	if (depth == 0) {
+		return;
+	}
+	while (!state.captureVector.empty() && state.captureVector.back().depth == depth) {
+		Capture& capture = state.captureVector.back();
+		//collapse the white space of the text
+		vector<string> wordVector;
+		string text = boost::algorithm::trim_copy(capture.text);
+		boost::algorithm::split(wordVector, text, boost::algorithm::is_space(),
+			boost::algorithm::token_compress_on);
+		state.recordVector[capture.recordIndex].values[capture.field] =
+			boost::algorithm::join(wordVector, " ");
+		state.captureVector.pop_back();
+	}
+	if (state.recordDepth == depth) {
+		state.recordDepth = 0;
+		state.currentRecord = 0;
+	}
+	state.elementStack.pop_back();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the SAX callback of the text. The text goes to all
+the fields being collected.
+* @param		void* -- context (the MatchState)
+* @param		xmlChar* -- text (the text, not NULL-terminated)
+* @param		int -- length (the number of bytes)
+* @return		void
+*******************************************************************************
+*/
+static void characters(void* context, const xmlChar* text, int length)
+{
+	MatchState& state = *static_cast<MatchState*>(context);
+	for (size_t i = 0; i < state.captureVector.size(); i++) {
+		state.captureVector[i].text.append((const char*)text, length);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function reads a price such as "$1,299.00" or "1 299,00 $" in
+cents, without going through a float.
+* @param		string -- text (the text of the price)
+* @return		int64_t -- the price in cents (rounded), or 0 if the text has no number
+*******************************************************************************
+*/
+static boost::int64_t parsePriceCents(const string& text)
+{
+	size_t start = text.find_first_of("0123456789");
+	if (start == string::npos) {
+		return 0;
+	}
+	string number;
+	for (size_t i = start; i < text.size(); i++) {
+		char c = text[i];
+		if (isdigit((unsigned char)c) || c == '.' || c == ',') {
+			number += c;
+		}
+		//a space is a thousands separator only if three digits follow
+		else if (c != ' ' || i + 3 >= text.size() || !isdigit((unsigned char)text[i + 1]) ||
+				!isdigit((unsigned char)text[i + 2]) || !isdigit((unsigned char)text[i + 3]) ||
+				(i + 4 < text.size() && isdigit((unsigned char)text[i + 4]))) {
+			break;
+		}
+	}
+	//a comma followed by two digits at the end is a decimal comma
+	size_t comma = number.rfind(',');
+	if (comma != string::npos && number.find('.') == string::npos && number.size() - comma == 3) {
+		number[comma] = '.';
+	}
+	number.erase(remove(number.begin(), number.end(), ','), number.end());
+	//the units, then two decimals rounded by the third; a second '.' ends the number
+	boost::int64_t cents = 0;
+	size_t i = 0;
+	for (; i < number.size() && number[i] != '.'; i++) {
+		cents = cents * 10 + (number[i] - '0');
+	}
+	cents *= 100;
+	for (int decimal = 0; decimal < 3 && ++i < number.size() && number[i] != '.'; decimal++) {
+		int digit = number[i] - '0';
+		cents += (decimal == 0) ? digit * 10 : (decimal == 1) ? digit : (digit >= 5);
+	}
+	return cents;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class ExtractionRules.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+ExtractionRules::ExtractionRules()
+{
+	//initialize libxml2 once, before the parsing threads use it
+	xmlInitParser();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function loads and compiles a rule file.
+* @param		string -- fileName (the path of the rule file)
+* @return		int -- return 0 if the rules are compiled, and 1 if the file
+cannot be read or has an error.
+*******************************************************************************
+*/
+int ExtractionRules::load(const string& fileName)
+{
+	ifstream file(fileName.c_str());
+	if (!file) {
+		std::cerr << "Failed to open the extraction rules " << fileName << std::endl;
+		return 1;
+	}
+	stringstream strStream;
+	strStream << file.rdbuf();
+	return compile(strStream.str());
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function compiles the rules in the format of a rule file. The
+sections are added to the rules already compiled.
+* @param		string -- text (the rules)
+* @return		int -- return 0 if the rules are compiled, and 1 on a syntax error.
+*******************************************************************************
+*/
+int ExtractionRules::compile(const string& text)
+{
+	istringstream lineStream(text);
+	string line;
+	int lineNumber = 0;
+	vector<Site> siteVector;
+	while (getline(lineStream, line)) {
+		lineNumber++;
+		boost::algorithm::trim(line);
+		if (line == "" || line[0] == '#') {
+			continue;
+		}
+		//a section: [host suffix]
+		if (line[0] == '[' && line[line.size() - 1] == ']' && line.find('=') == string::npos) {
+			siteVector.push_back(Site());
+			siteVector.back().hostSuffix = boost::algorithm::to_lower_copy(
+				boost::algorithm::trim_copy(line.substr(1, line.size() - 2)));
+			siteVector.back().hasRecordSelector = false;
+			continue;
+		}
+		//a field: name = selector [@attribute]
+		size_t equal = line.find('=');
+		if (equal == string::npos || siteVector.empty()) {
+			std::cerr << "Extraction rules, line " << lineNumber << ": expecting [site] or field = selector" << std::endl;
+			return 1;
+		}
+		string fieldName = boost::algorithm::trim_copy(line.substr(0, equal));
+		Selector selector;
+		selector.field = NUMBER_FIELDS;
+		for (int i = 0; i < NUMBER_FIELDS; i++) {
+			if (boost::algorithm::iequals(fieldName, kFieldNames[i])) {
+				selector.field = (Field)i;
+			}
+		}
+		if (selector.field == NUMBER_FIELDS) {
+			std::cerr << "Extraction rules, line " << lineNumber << ": unknown field " << fieldName << std::endl;
+			return 1;
+		}
+		if (!compileSelector(line.substr(equal + 1), selector)) {
+			std::cerr << "Extraction rules, line " << lineNumber << ": invalid selector" << std::endl;
+			return 1;
+		}
+		if (selector.field == FIELD_RECORD) {
+			siteVector.back().hasRecordSelector = true;
+		}
+		siteVector.back().selectorVector.push_back(selector);
+	}
+
+	for (size_t i = 0; i < siteVector.size(); i++) {
+		indexSite(siteVector[i]);
+		siteVector_.push_back(siteVector[i]);
+	}
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function compiles a selector such as
+div.product > span[itemprop=price] @content
+* @param		string -- text (the selector)
+* @param		Selector& -- selector (output, the steps and the output attribute)
+* @return		bool -- return false if the selector is empty or invalid
+*******************************************************************************
+*/
+bool ExtractionRules::compileSelector(const string& text, Selector& selector)
+{
+	//split the selector into compound selectors, '>' and the @attribute
+	vector<string> tokenVector;
+	string token;
+	char quote = 0;
+	int bracketLevel = 0;
+	for (size_t i = 0; i <= text.size(); i++) {
+		char c = (i < text.size()) ? text[i] : ' ';
+		if (quote != 0) {
+			if (c == quote) {
+				quote = 0;
+			}
+			token += c;
+			continue;
+		}
+		if (bracketLevel > 0 && (c == '"' || c == '\'')) {
+			quote = c;
+		}
+		bracketLevel += (c == '[') ? 1 : ((c == ']') ? -1 : 0);
+		if (bracketLevel == 0 && (isspace((unsigned char)c) || c == '>')) {
+			if (token != "") {
+				tokenVector.push_back(token);
+				token = "";
+			}
+			if (c == '>') {
+				tokenVector.push_back(">");
+			}
+			continue;
+		}
+		token += c;
+	}
+	if (quote != 0 || bracketLevel != 0) {
+		return false;
+	}
+	if (!tokenVector.empty() && tokenVector.back()[0] == '@') {
+		selector.outputAttribute = boost::algorithm::to_lower_copy(tokenVector.back().substr(1));
+		tokenVector.pop_back();
+		if (selector.outputAttribute == "") {
+			return false;
+		}
+	}
+
+	bool isChild = false;
+	for (size_t i = 0; i < tokenVector.size(); i++) {
+		if (tokenVector[i] == ">") {
+			if (selector.stepVector.empty() || isChild) {
+				return false;
+			}
+			isChild = true;
+			continue;
+		}
+		const string& compound = tokenVector[i];
+		SelectorStep step;
+		step.isChild = isChild;
+		isChild = false;
+		size_t position = 0;
+		while (position < compound.size() && (isalnum((unsigned char)compound[position]) ||
+				compound[position] == '-' || compound[position] == '*')) {
+			position++;
+		}
+		step.tag = boost::algorithm::to_lower_copy(compound.substr(0, position));
+		if (step.tag == "*") {
+			step.tag = "";
+		}
+		while (position < compound.size()) {
+			char prefix = compound[position];
+			if (prefix == '#' || prefix == '.') {
+				size_t end = compound.find_first_of("#.[", position + 1);
+				if (end == string::npos) {
+					end = compound.size();
+				}
+				string name = compound.substr(position + 1, end - position - 1);
+				if (name == "") {
+					return false;
+				}
+				if (prefix == '#') {
+					step.id = name;
+				}
+				else {
+					step.classVector.push_back(name);
+				}
+				position = end;
+			}
+			else if (prefix == '[') {
+				size_t end = compound.find(']', position);
+				string attribute = compound.substr(position + 1, end - position - 1);
+				size_t equal = attribute.find('=');
+				string name = boost::algorithm::to_lower_copy(boost::algorithm::trim_copy(
+					attribute.substr(0, equal)));
+				string value = (equal == string::npos) ? "" :
+					boost::algorithm::trim_copy(attribute.substr(equal + 1));
+				if (value.size() >= 2 && (value[0] == '"' || value[0] == '\'') &&
+						value[value.size() - 1] == value[0]) {
+					value = value.substr(1, value.size() - 2);
+				}
+				if (name == "") {
+					return false;
+				}
+				step.attributeVector.push_back(make_pair(name, value));
+				position = end + 1;
+			}
+			else {
+				return false;
+			}
+		}
+		selector.stepVector.push_back(step);
+	}
+	return !selector.stepVector.empty() && !isChild;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function indexes the selectors of a site by the most selective
+key of their last step: #id, .class, [attribute, tag, or * if the step has none.
+* @param		Site& -- site (input/output, the site to index)
+* @return		void
+*******************************************************************************
+*/
+void ExtractionRules::indexSite(Site& site)
+{
+	site.selectorIndex.clear();
+	for (size_t i = 0; i < site.selectorVector.size(); i++) {
+		const SelectorStep& step = site.selectorVector[i].stepVector.back();
+		string key = "*";
+		if (step.id != "") {
+			key = "#" + step.id;
+		}
+		else if (!step.classVector.empty()) {
+			key = "." + step.classVector[0];
+		}
+		else if (!step.attributeVector.empty()) {
+			key = "[" + step.attributeVector[0].first;
+		}
+		else if (step.tag != "") {
+			key = step.tag;
+		}
+		site.selectorIndex[key].push_back((int)i);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the rules of a host: the section with the
+longest suffix of the host name, or else the [*] section.
+* @param		string -- hostName (e.g., http://www.walmart.ca)
+* @return		Site* -- the rules of the host, or NULL if none applies
+*******************************************************************************
+*/
+const ExtractionRules::Site* ExtractionRules::findSite(const string& hostName) const
+{
+	string host = boost::algorithm::to_lower_copy(hostName);
+	size_t schemeEnd = host.find("://");
+	if (schemeEnd != string::npos) {
+		host = host.substr(schemeEnd + 3);
+	}
+	host = host.substr(0, host.find_first_of(":/"));
+
+	const Site* ptrSite = NULL;
+	const Site* ptrDefaultSite = NULL;
+	for (size_t i = 0; i < siteVector_.size(); i++) {
+		const string& suffix = siteVector_[i].hostSuffix;
+		if (suffix == "*") {
+			ptrDefaultSite = &siteVector_[i];
+		}
+		else if ((host == suffix || boost::algorithm::ends_with(host, "." + suffix)) &&
+				(ptrSite == NULL || suffix.size() > ptrSite->hostSuffix.size())) {
+			ptrSite = &siteVector_[i];
+		}
+	}
+	return (ptrSite != NULL) ? ptrSite : ptrDefaultSite;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function extracts the product records of a page in one SAX
+pass of the libxml2 HTML parser.
+* @param		char* -- data (the html page)
+* @param		size_t -- length (the size of the page)
+* @param		string -- hostName (the host of the page, selects the rules and
+completes the relative image links)
+* @param		RecordBatch& -- recordBatch (output, the records are appended)
+* @return		int -- the number of records appended
+*******************************************************************************
+*/
+int ExtractionRules::extract(const char* data, size_t length, const string& hostName,
+	RecordBatch& recordBatch) const
+{
+	const Site* ptrSite = findSite(hostName);
+	if (ptrSite == NULL || ptrSite->selectorVector.empty() || length == 0) {
+		return 0;
+	}
+
+	MatchState state;
+	state.ptrSite = ptrSite;
+	state.recordVector.push_back(RecordState());
+	state.currentRecord = 0;
+	state.recordDepth = 0;
+
+	htmlSAXHandler saxHandler;
+	memset(&saxHandler, 0, sizeof(saxHandler));
+	saxHandler.startElement = startElement;
+	saxHandler.endElement = endElement;
+	saxHandler.characters = characters;
+	saxHandler.cdataBlock = characters;
+	htmlParserCtxtPtr parserContext = htmlCreatePushParserCtxt(&saxHandler, &state,
+		NULL, 0, NULL, XML_CHAR_ENCODING_NONE);
+	if (parserContext == NULL) {
+		return 0;
+	}
+	htmlCtxtUseOptions(parserContext, HTML_PARSE_RECOVER | HTML_PARSE_NOERROR |
+		HTML_PARSE_NOWARNING | HTML_PARSE_NONET);
+	htmlParseChunk(parserContext, data, (int)length, 1);
+	htmlFreeParserCtxt(parserContext);
+	//close the elements left open by a truncated page
+	while (!state.elementStack.empty()) {
+		endElement(&state, NULL);
+	}
+
+	//the page is one record unless the site has a record selector
+	size_t firstRecord = ptrSite->hasRecordSelector ? 1 : 0;
+	int numberRecords = 0;
+	string imageLink;
+	for (size_t i = firstRecord; i < state.recordVector.size(); i++) {
+		//the values are copied once, into the arenas of the batch
+		const string* values[FIELD_RECORD];
+		for (int field = 0; field < FIELD_RECORD; field++) {
+			values[field] = (state.recordVector[i].values[field] != "") ?
+				&state.recordVector[i].values[field] : &state.recordVector[0].values[field];
+		}
+		if (*values[FIELD_ID] == "" && *values[FIELD_DESCRIPTION] == "") {
+			continue;
+		}
+		size_t digits = values[FIELD_ID]->find_first_of("0123456789");
+		long productID = (digits == string::npos) ? 0 :
+			strtol(values[FIELD_ID]->c_str() + digits, NULL, 10);
+		boost::string_view imageView(*values[FIELD_IMAGE]);
+		if (boost::algorithm::starts_with(*values[FIELD_IMAGE], "//")) {
+			imageLink = "http:" + *values[FIELD_IMAGE];
+			imageView = imageLink;
+		}
+		else if (boost::algorithm::starts_with(*values[FIELD_IMAGE], "/")) {
+			imageLink = hostName + *values[FIELD_IMAGE];
+			imageView = imageLink;
+		}
+		boost::int64_t originalPriceCents = parsePriceCents(*values[FIELD_ORIGINAL_PRICE]);
+		boost::int64_t currentPriceCents = parsePriceCents(*values[FIELD_CURRENT_PRICE]);
+		//a product which is not on sale has one price
+		if (originalPriceCents == 0) {
+			originalPriceCents = currentPriceCents;
+		}
+		if (currentPriceCents == 0) {
+			currentPriceCents = originalPriceCents;
+		}
+		recordBatch.append(productID, *values[FIELD_CATEGORY], *values[FIELD_DESCRIPTION],
+			imageView, originalPriceCents, currentPriceCents);
+		numberRecords++;
+	}
+	return numberRecords;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of compiled sites.
+* @param		none
+* @return		size_t -- the number of sections
+*******************************************************************************
+*/
+size_t ExtractionRules::getNumberSites() const
+{
+	return siteVector_.size();
+}
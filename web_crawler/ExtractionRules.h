@@ -0,0 +1,140 @@
+/**
+*******************************************************************************
+* @file		ExtractionRules.h
+* @brief	This file provides the interfaces of the class ExtractionRules.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _EXTRACTIONRULES_H_
+#define _EXTRACTIONRULES_H_
+
+#include <string>
+#include <vector>
+
+//boost lib
+#include <boost/unordered_map.hpp>
+
+//the record batch filled by the rules
+#include "RecordBatch.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @class		ExtractionRules
+* @brief 		This class extracts the product records of a page with declarative
+rules instead of code. A rule file has one section per site, and in each section
+one CSS-like selector per field:
+
+  [walmart.ca]
+  record        = [itemtype="http://schema.org/Product"]
+  id            = [itemprop=productID] @content
+  category      = .breadcrumb li > a.current
+  description   = h1[itemprop=name]
+  image         = img[itemprop=image] @src
+  originalPrice = .was-price
+  currentPrice  = [itemprop=price]
+
+A selector is a list of compound selectors (tag, #id, .class, [attribute] and
+[attribute=value]) joined by descendant (space) or child (>) combinators; a
+trailing @attribute takes that attribute instead of the text of the element.
+Each match of the record selector is one product; fields matched outside a
+record fill the fields missing in all records of the page (e.g. a breadcrumb).
+Without a record selector the page is one product. A section applies to the
+hosts ending with its name; [*] applies to the hosts without a section.
+
+The rules are compiled once: every selector is indexed by the most selective
+part of its last compound selector (id, class, attribute name or tag), and the
+page is parsed in a single SAX pass in which each element is only tested
+against the selectors indexed by its own id, classes, attributes and tag. The
+cost per page therefore does not grow with the number of fields and sites.
+*******************************************************************************
+*/
+class ExtractionRules
+{
+	public:
+		//the fields of a product record, plus the record selector
+		enum Field
+		{
+			FIELD_ID = 0,
+			FIELD_CATEGORY,
+			FIELD_DESCRIPTION,
+			FIELD_IMAGE,
+			FIELD_ORIGINAL_PRICE,
+			FIELD_CURRENT_PRICE,
+			FIELD_RECORD,
+			NUMBER_FIELDS
+		};
+
+		//one compound selector, e.g. img.main[itemprop=image]
+		struct SelectorStep
+		{
+			//the tag ("" matches any tag)
+			string tag;
+			//the id ("" if none)
+			string id;
+			//the classes the element must have
+			vector<string> classVector;
+			//the attributes the element must have, with their values ("" for any)
+			vector< pair<string, string> > attributeVector;
+			//true if the element must be a child of the previous step (>)
+			bool isChild;
+		};
+		//one compiled selector
+		struct Selector
+		{
+			//the field filled by the selector
+			Field field;
+			//the compound selectors, the last one matching the element itself
+			vector<SelectorStep> stepVector;
+			//the attribute taken as the value ("" for the text of the element)
+			string outputAttribute;
+		};
+		//the compiled rules of one site
+		struct Site
+		{
+			//the suffix of the host names of the site ("*" for any host)
+			string hostSuffix;
+			//all the selectors of the site
+			vector<Selector> selectorVector;
+			//the selectors indexed by the key of their last step
+			boost::unordered_map<string, vector<int> > selectorIndex;
+			//true if the site has a record selector
+			bool hasRecordSelector;
+		};
+
+	private:
+		//the compiled sites
+		vector<Site> siteVector_;
+
+		//compile a selector, return false if its syntax is invalid
+		static bool compileSelector(const string& text, Selector& selector);
+		//build the index of a site
+		static void indexSite(Site& site);
+
+	public:
+ 		//constructor: no rules
+ 		ExtractionRules();
+ 		//load and compile a rule file, return 0 on success
+ 		int load(const string& fileName);
+ 		//compile the rules in a string, return 0 on success
+ 		int compile(const string& text);
+ 		//get the rules of a host, or NULL if no section applies to it
+ 		const Site* findSite(const string& hostName) const;
+ 		/*extract the product records of a page, append them to the batch and
+ 		return their number */
+ 		int extract(const char* data, size_t length, const string& hostName,
+ 			RecordBatch& recordBatch) const;
+ 		//get the number of sites
+ 		size_t getNumberSites() const;
+
+}; //end of class ExtractionRules
+
+} //end of namespace WebDataExtraction
+
+#endif //_EXTRACTIONRULES_H_
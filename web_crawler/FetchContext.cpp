@@ -0,0 +1,282 @@
+/**
+*******************************************************************************
+* @file			FetchContext.cpp
+* @brief 		This file provides the implementations of the class FetchContext.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "FetchContext.h"
+
+#include <algorithm>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class FetchContext. It
+creates the share handle of the DNS and TLS session caches.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+FetchContext::FetchContext() : resolveList_(NULL), threadHandle_(releaseThreadHandle),
+	numberTransfers_(0), numberFailedTransfers_(0), numberReusedConnections_(0), numberDNSResolves_(0),
+	numberTLSHandshakes_(0), tlsHandshakeMicroseconds_(0), setupMicroseconds_(0)
+{
+	curl_global_init(CURL_GLOBAL_ALL);
+	share_ = curl_share_init();
+	curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lock);
+	curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlock);
+	curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+	curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	Metrics& metrics = Metrics::getShared();
+	dnsMetric_ = metrics.addHistogram("fetch_dns_us");
+	connectMetric_ = metrics.addHistogram("fetch_connect_us");
+	tlsMetric_ = metrics.addHistogram("fetch_tls_us");
+	ttfbMetric_ = metrics.addHistogram("fetch_ttfb_us");
+	transferMetric_ = metrics.addHistogram("fetch_transfer_us");
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class FetchContext.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+FetchContext::~FetchContext()
+{
+	//the easy handle of the destroying thread is still attached
+	threadHandle_.reset();
+	curl_share_cleanup(share_);
+	curl_slist_free_all(resolveList_);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the context shared by the whole process.
+* @param		none
+* @return		FetchContext& -- the context, created on the first call
+*******************************************************************************
+*/
+FetchContext& FetchContext::getShared()
+{
+	static FetchContext sharedContext;
+	return sharedContext;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		These functions are the callbacks specified by CURLSHOPT_LOCKFUNC
+and CURLSHOPT_UNLOCKFUNC. Each kind of shared data has its own mutex, so that a
+DNS lookup does not wait for a TLS session lookup.
+*******************************************************************************
+*/
+void FetchContext::lock(CURL* /*handle*/, curl_lock_data data, curl_lock_access /*access*/, void* userData)
+{
+	static_cast<FetchContext*>(userData)->locks_[data].lock();
+}
+
+void FetchContext::unlock(CURL* /*handle*/, curl_lock_data data, void* userData)
+{
+	static_cast<FetchContext*>(userData)->locks_[data].unlock();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the callback specified by
+CURLOPT_RESOLVER_START_FUNCTION. libcurl calls it only when the host name is not
+in the DNS cache, so it counts the cache misses.
+* @param		void* -- resolverState (the state of the resolver, unused)
+* @param		void* -- reserved (unused)
+* @param		void* -- userData (the FetchContext)
+* @return		int -- 0 to let the resolution go on
+*******************************************************************************
+*/
+int FetchContext::resolverStarted(void* /*resolverState*/, void* /*reserved*/, void* userData)
+{
+	static_cast<FetchContext*>(userData)->numberDNSResolves_++;
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function frees the easy handle of a thread. It is called by
+boost::thread_specific_ptr when the thread exits.
+* @param		ThreadHandle* -- ptrThreadHandle (the easy handle of the thread)
+* @return		void
+*******************************************************************************
+*/
+void FetchContext::releaseThreadHandle(ThreadHandle* ptrThreadHandle)
+{
+	curl_easy_cleanup(ptrThreadHandle->handle);
+	delete ptrThreadHandle;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function pins a host and port to an address instead of
+resolving it, e.g. to crawl a site served by a local stand-in server. It must be
+called before the downloads start.
+* @param		string -- entry (host:port:address, as CURLOPT_RESOLVE)
+* @return		void
+*******************************************************************************
+*/
+void FetchContext::addResolve(const string& entry)
+{
+	resolveList_ = curl_slist_append(resolveList_, entry.c_str());
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function attaches an easy handle to the DNS and TLS session
+caches, and counts the host names it resolves.
+* @param		CURL* -- handle (the easy handle)
+* @return		void
+*******************************************************************************
+*/
+void FetchContext::attach(CURL* handle)
+{
+	curl_easy_setopt(handle, CURLOPT_SHARE, share_);
+	curl_easy_setopt(handle, CURLOPT_RESOLVER_START_FUNCTION, resolverStarted);
+	curl_easy_setopt(handle, CURLOPT_RESOLVER_START_DATA, this);
+	if (resolveList_ != NULL) {
+		curl_easy_setopt(handle, CURLOPT_RESOLVE, resolveList_);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the easy handle of the calling thread. The
+handle lives as long as the thread, so that the connection of a page is kept
+alive for the next page of the same host.
+* @param		none
+* @return		CURL* -- the easy handle, reset and attached to the caches
+*******************************************************************************
+*/
+CURL* FetchContext::acquireThreadHandle()
+{
+	ThreadHandle* ptrThreadHandle = threadHandle_.get();
+	if (ptrThreadHandle == NULL) {
+		ptrThreadHandle = new ThreadHandle;
+		ptrThreadHandle->handle = curl_easy_init();
+		threadHandle_.reset(ptrThreadHandle);
+	}
+	else {
+		//the live connections survive the reset
+		curl_easy_reset(ptrThreadHandle->handle);
+	}
+	attach(ptrThreadHandle->handle);
+	return ptrThreadHandle->handle;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function counts the connection setup of a completed transfer,
+and records the time of its phases. The times of libcurl run from the start of
+the transfer, so each phase is the difference with the previous one; DNS, connect
+and TLS are only recorded for the transfers which opened a connection. A failed
+transfer reports no connection, so it is only counted as failed, not as reusing
+one.
+* @param		CURL* -- handle (the easy handle of the transfer)
+* @param		CURLcode -- curlCode (the result of the transfer)
+* @return		void
+*******************************************************************************
+*/
+void FetchContext::recordTransfer(CURL* handle, CURLcode curlCode)
+{
+	if (curlCode != CURLE_OK) {
+		numberFailedTransfers_++;
+		return;
+	}
+	long numberConnects = 0;
+	curl_off_t connectTime = 0;
+	curl_off_t appConnectTime = 0;
+	curl_off_t nameLookupTime = 0;
+	curl_off_t startTransferTime = 0;
+	curl_off_t totalTime = 0;
+	curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &numberConnects);
+	curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME_T, &connectTime);
+	curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME_T, &appConnectTime);
+	curl_easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME_T, &nameLookupTime);
+	curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME_T, &startTransferTime);
+	curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME_T, &totalTime);
+
+	numberTransfers_++;
+	if (numberConnects == 0) {
+		numberReusedConnections_++;
+	}
+	else if (appConnectTime > connectTime) {
+		numberTLSHandshakes_++;
+		tlsHandshakeMicroseconds_ += (long)(appConnectTime - connectTime);
+	}
+	setupMicroseconds_ += (long)max(connectTime, appConnectTime);
+
+	Metrics& metrics = Metrics::getShared();
+	if (numberConnects > 0) {
+		metrics.record(dnsMetric_, nameLookupTime);
+		metrics.record(connectMetric_, max(connectTime - nameLookupTime, (curl_off_t)0));
+		if (appConnectTime > connectTime) {
+			metrics.record(tlsMetric_, appConnectTime - connectTime);
+		}
+	}
+	//no first byte if the transfer failed
+	if (startTransferTime > 0) {
+		metrics.record(ttfbMetric_, startTransferTime);
+		metrics.record(transferMetric_, max(totalTime - startTransferTime, (curl_off_t)0));
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the counters and the hit rates of the caches.
+* @param		none
+* @return		FetchContextStats -- the counters
+*******************************************************************************
+*/
+FetchContextStats FetchContext::getStats() const
+{
+	FetchContextStats stats;
+	stats.numberTransfers = numberTransfers_;
+	stats.numberFailedTransfers = numberFailedTransfers_;
+	stats.numberReusedConnections = numberReusedConnections_;
+	stats.numberNewConnections = stats.numberTransfers - stats.numberReusedConnections;
+	stats.numberDNSResolves = numberDNSResolves_;
+	stats.numberTLSHandshakes = numberTLSHandshakes_;
+	stats.connectionReuseRate = (stats.numberTransfers > 0) ?
+		(double)stats.numberReusedConnections / stats.numberTransfers : 0.0;
+	stats.dnsHitRate = (stats.numberNewConnections > 0) ? max(0.0,
+		1.0 - (double)stats.numberDNSResolves / stats.numberNewConnections) : 0.0;
+	stats.meanTLSHandshakeMs = (stats.numberTLSHandshakes > 0) ?
+		tlsHandshakeMicroseconds_ / 1000.0 / stats.numberTLSHandshakes : 0.0;
+	stats.meanSetupMs = (stats.numberTransfers > 0) ?
+		setupMicroseconds_ / 1000.0 / stats.numberTransfers : 0.0;
+	return stats;
+}
@@ -0,0 +1,137 @@
+/**
+*******************************************************************************
+* @file		FetchContext.h
+* @brief	This file provides the interfaces of the class FetchContext.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _FETCHCONTEXT_H_
+#define _FETCHCONTEXT_H_
+
+#include <string>
+
+//boost lib
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+//libcurl share interface
+#include <curl/curl.h>
+
+#include "Metrics.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @struct		FetchContextStats
+* @brief 		This structure holds the counters of the connection setup of the
+transfers made through a FetchContext.
+*******************************************************************************
+*/
+struct FetchContextStats
+{
+	//the number of completed transfers, and of the failed ones, which are not counted in the rates
+	long numberTransfers;
+	long numberFailedTransfers;
+	//the transfers which reused a live connection, and those which opened one
+	long numberReusedConnections;
+	long numberNewConnections;
+	//the host names resolved, i.e. the new connections which missed the DNS cache
+	long numberDNSResolves;
+	//the TLS handshakes of the new connections
+	long numberTLSHandshakes;
+	//the fraction of the transfers which reused a connection
+	double connectionReuseRate;
+	//the fraction of the new connections which found their host in the DNS cache
+	double dnsHitRate;
+	//the mean time (ms) of a TLS handshake, shortened by the TLS session cache
+	double meanTLSHandshakeMs;
+	//the mean time (ms) from the start of a transfer to a ready connection
+	double meanSetupMs;
+};
+
+
+/**
+*******************************************************************************
+* @class		FetchContext
+* @brief 		This class holds the state which the downloads of all the threads
+share, so that a page does not pay again for what an earlier page has set up.
+A libcurl share handle keeps one DNS cache and one TLS session cache for every
+easy handle attached to it, so that a host is resolved once and a new
+connection resumes the TLS session of an earlier one. The connections themselves
+stay in the pool of the multi handle of each FetchEngine thread, or of the easy
+handle of each thread calling acquireThreadHandle(): libcurl does not support
+sharing live connections between concurrent threads. The setup time of every
+transfer is counted, to report the hit rates of the caches, and the time of
+each phase (DNS, connect, TLS, first byte, body) goes to the shared Metrics.
+*******************************************************************************
+*/
+class FetchContext
+{
+	private:
+		//the easy handle of a thread, with its connection pool
+		struct ThreadHandle
+		{
+			CURL* handle;
+		};
+
+		//the share handle holding the DNS and TLS session caches
+		CURLSH* share_;
+		//the host names pinned to an address (CURLOPT_RESOLVE entries)
+		struct curl_slist* resolveList_;
+		//one mutex per kind of data in the share handle
+		boost::mutex locks_[CURL_LOCK_DATA_LAST];
+		//the easy handle of each thread calling acquireThreadHandle()
+		boost::thread_specific_ptr<ThreadHandle> threadHandle_;
+		//the counters of the transfers
+		boost::atomic<long> numberTransfers_;
+		boost::atomic<long> numberFailedTransfers_;
+		boost::atomic<long> numberReusedConnections_;
+		boost::atomic<long> numberDNSResolves_;
+		boost::atomic<long> numberTLSHandshakes_;
+		boost::atomic<long> tlsHandshakeMicroseconds_;
+		boost::atomic<long> setupMicroseconds_;
+		//the histograms of the phases of the transfers (Metrics ids)
+		int dnsMetric_;
+		int connectMetric_;
+		int tlsMetric_;
+		int ttfbMetric_;
+		int transferMetric_;
+
+		//the callbacks of the share handle locking its data
+		static void lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userData);
+		static void unlock(CURL* handle, curl_lock_data data, void* userData);
+		//the callback of an easy handle starting to resolve a host name
+		static int resolverStarted(void* resolverState, void* reserved, void* userData);
+		//free the easy handle of a thread when the thread exits
+		static void releaseThreadHandle(ThreadHandle* ptrThreadHandle);
+
+	public:
+ 		//constructor
+ 		FetchContext();
+ 		//destructor
+ 		~FetchContext();
+ 		//get the context shared by the whole process
+ 		static FetchContext& getShared();
+ 		//pin host:port to an address (host:port:address), before the downloads start
+ 		void addResolve(const string& entry);
+ 		//attach an easy handle to the caches; call again after curl_easy_reset()
+ 		void attach(CURL* handle);
+ 		//get the easy handle of the calling thread, reset and attached to the caches
+ 		CURL* acquireThreadHandle();
+ 		//count the connection setup and the phases of a completed transfer
+ 		void recordTransfer(CURL* handle, CURLcode curlCode);
+ 		//get the counters and the hit rates
+ 		FetchContextStats getStats() const;
+
+}; //end of class FetchContext
+
+} //end of namespace WebDataExtraction
+
+#endif //_FETCHCONTEXT_H_
@@ -0,0 +1,405 @@
+/**
+*******************************************************************************
+* @file			FetchEngine.cpp
+* @brief 		This file provides the implementations of the class FetchEngine.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "FetchEngine.h"
+#include "AsyncLogger.h"
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <new>
+#include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/algorithm/string.hpp>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+//the largest buffer allocated from the Content-Length (the default largest buffer of PagePool)
+static const size_t maxReserveBytes = 4 * 1024 * 1024;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the callback specified by CURLOPT_WRITEFUNCTION.
+* @param		char* -- data (the data that has just been obtained)
+* @param		size_t -- size (the size of each data block)
+* @param		size_t -- nmemb (the number of data blocks)
+* @param		void* -- userData (the Transfer assigned to CURLOPT_WRITEDATA)
+* @return		size_t -- the amount of bytes appended to the page, or 0 to abort
+the transfer when the memory is exhausted
+*******************************************************************************
+*/
+size_t WebDataExtraction::fetchWriter(char* data, size_t size, size_t nmemb, void* userData)
+{
+	FetchEngine::Transfer* ptrTransfer = static_cast<FetchEngine::Transfer*>(userData);
+	size_t len = size * nmemb;
+	PageBuffer& body = *ptrTransfer->result.ptrBody;
+	//an exception must not cross the C code of libcurl: returning 0 aborts this transfer only
+	try {
+		//allocate the page up front when the server announced its size, which is not trusted
+		if (body.size() == 0) {
+			curl_off_t contentLength = -1;
+			curl_easy_getinfo(ptrTransfer->handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength);
+			if (contentLength > 0) {
+				body.reserve(min((size_t)contentLength, maxReserveBytes));
+			}
+		}
+		body.append(data, len);
+	}
+	catch (std::bad_alloc&) {
+		AsyncLogger::getShared().log(LOG_ERROR, "Out of memory downloading {}, {} bytes received",
+			ptrTransfer->result.url, (unsigned long)body.size());
+		return 0;
+	}
+	
+	//let the caller process the page while the rest is downloading
+	if (ptrTransfer->progressCallback) {
+		long httpStatus = 0;
+		curl_easy_getinfo(ptrTransfer->handle, CURLINFO_RESPONSE_CODE, &httpStatus);
+		if (httpStatus == 200) {
+			ptrTransfer->progressCallback(body);
+		}
+	}
+	return len;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the callback specified by CURLOPT_HEADERFUNCTION.
+It is called once per header line; a status line starts the headers of a new
+response, so only the headers of the final response are kept.
+* @param		char* -- data (the header line)
+* @param		size_t -- size (the size of each data block)
+* @param		size_t -- nmemb (the number of data blocks)
+* @param		void* -- userData (the Transfer assigned to CURLOPT_HEADERDATA)
+* @return		size_t -- the amount of bytes processed
+*******************************************************************************
+*/
+size_t WebDataExtraction::fetchHeaderWriter(char* data, size_t size, size_t nmemb, void* userData)
+{
+	FetchEngine::Transfer* ptrTransfer = static_cast<FetchEngine::Transfer*>(userData);
+	size_t len = size * nmemb;
+	if (len >= 5 && strncmp(data, "HTTP/", 5) == 0) {
+		ptrTransfer->result.headers.clear();
+	}
+	ptrTransfer->result.headers.append(data, len);
+	return len;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the value of a response header, e.g. the
+ETag in "ETag: \"5f3a\"\r\n" is "\"5f3a\"".
+* @param		string -- headers (the response headers, see FetchResult)
+* @param		string -- name (the header name, compared case-insensitively)
+* @return		string -- the trimmed value of the first such header, or ""
+*******************************************************************************
+*/
+string WebDataExtraction::getHeaderValue(const string& headers, const string& name)
+{
+	size_t lineStart = 0;
+	while (lineStart < headers.size()) {
+		size_t lineEnd = headers.find('\n', lineStart);
+		if (lineEnd == string::npos) {
+			lineEnd = headers.size();
+		}
+		size_t colon = headers.find(':', lineStart);
+		if (colon < lineEnd && colon - lineStart == name.size() &&
+				boost::algorithm::iequals(headers.substr(lineStart, colon - lineStart), name)) {
+			return boost::algorithm::trim_copy(headers.substr(colon + 1, lineEnd - colon - 1));
+		}
+		lineStart = lineEnd + 1;
+	}
+	return "";
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function hashes the scheme, host and port of a URL.
+* @param		string -- url (the URL of the html page)
+* @return		size_t -- the hash, equal for all the URLs of a host
+*******************************************************************************
+*/
+static size_t hashHost(const string& url)
+{
+	size_t hostStart = url.find("://");
+	hostStart = (hostStart == string::npos) ? 0 : hostStart + 3;
+	size_t hostEnd = url.find_first_of("/?#", hostStart);
+	if (hostEnd == string::npos) {
+		hostEnd = url.size();
+	}
+	//host names are case-insensitive
+	return boost::hash_value(boost::algorithm::to_lower_copy(url.substr(0, hostEnd)));
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class FetchEngine.
+* @param		int -- numberThreads (the number of engine threads)
+* @param		int -- maxTransfers (the maximum number of concurrent transfers
+per engine thread)
+* @param		int -- maxHostConnections (the maximum number of connections to
+one host per engine thread)
+* @param		PageBufferFactory -- bufferFactory (provides the buffer of each
+transfer; if empty, a new PageBuffer is allocated per transfer)
+* @param		FetchContext& -- context (the DNS and TLS session caches, shared by
+the whole process by default)
+* @return		None
+*******************************************************************************
+*/
+FetchEngine::FetchEngine(int numberThreads, int maxTransfers, int maxHostConnections,
+	PageBufferFactory bufferFactory, FetchContext& context) : maxTransfers_(maxTransfers),
+	maxHostConnections_(maxHostConnections), bufferFactory_(bufferFactory), context_(context)
+{
+	curl_global_init(CURL_GLOBAL_ALL);
+
+	for (int i = 0; i < numberThreads; i++) {
+		boost::shared_ptr<FetchLoop> ptrLoop(new FetchLoop);
+		ptrLoop->multi = curl_multi_init();
+		ptrLoop->numberActive = 0;
+		ptrLoop->isStopping = false;
+		//keep enough idle connections alive to reuse one per transfer
+		curl_multi_setopt(ptrLoop->multi, CURLMOPT_MAXCONNECTS, (long)maxTransfers_);
+		curl_multi_setopt(ptrLoop->multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)maxHostConnections_);
+		curl_multi_setopt(ptrLoop->multi, CURLMOPT_PIPELINING, (long)CURLPIPE_MULTIPLEX);
+		loops_.push_back(ptrLoop);
+	}
+	for (size_t i = 0; i < loops_.size(); i++) {
+		loops_[i]->thread = boost::thread(boost::bind(&FetchEngine::runLoop, this, loops_[i]));
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class FetchEngine.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+FetchEngine::~FetchEngine()
+{
+	stop();
+	for (size_t i = 0; i < loops_.size(); i++) {
+		for (size_t j = 0; j < loops_[i]->idleHandles.size(); j++) {
+			curl_easy_cleanup(loops_[i]->idleHandles[j]);
+		}
+		curl_multi_cleanup(loops_[i]->multi);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function queues a URL for download.
+* @param		string -- url (the URL of the html page)
+* @param		FetchCallback -- callback (invoked on an engine thread with the
+result; it should hand the page over to the parsing threads and return quickly)
+* @param		FetchProgressCallback -- progressCallback (optional, invoked on an
+engine thread after each chunk of a 200 response; it must return quickly)
+* @param		vector<string> -- requestHeaders (optional, extra request headers
+such as "If-None-Match: ...")
+* @return		void
+*******************************************************************************
+*/
+void FetchEngine::submit(const string& url, FetchCallback callback,
+	FetchProgressCallback progressCallback, const vector<string>& requestHeaders)
+{
+	FetchRequest request;
+	request.url = url;
+	request.callback = callback;
+	request.progressCallback = progressCallback;
+	request.requestHeaders = requestHeaders;
+
+	FetchLoop& loop = *loops_[hashHost(url) % loops_.size()];
+	{
+		boost::mutex::scoped_lock lock(loop.mutex);
+		loop.requestQueue.push_back(request);
+	}
+	//interrupt curl_multi_poll() so the request is started right away
+	curl_multi_wakeup(loop.multi);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function waits for all queued transfers to complete and
+stops the engine threads.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void FetchEngine::stop()
+{
+	for (size_t i = 0; i < loops_.size(); i++) {
+		{
+			boost::mutex::scoped_lock lock(loops_[i]->mutex);
+			loops_[i]->isStopping = true;
+		}
+		curl_multi_wakeup(loops_[i]->multi);
+	}
+	for (size_t i = 0; i < loops_.size(); i++) {
+		if (loops_[i]->thread.joinable()) {
+			loops_[i]->thread.join();
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the body of an engine thread. It keeps driving
+the multi handle until stop() is called and no transfer is left.
+* @param		boost::shared_ptr<FetchLoop> -- ptrLoop (the state of this thread)
+* @return		void
+*******************************************************************************
+*/
+void FetchEngine::runLoop(boost::shared_ptr<FetchLoop> ptrLoop)
+{
+	FetchLoop& loop = *ptrLoop;
+	while (true) {
+		startTransfers(loop);
+
+		int numberRunning = 0;
+		curl_multi_perform(loop.multi, &numberRunning);
+		finishTransfers(loop);
+
+		{
+			boost::mutex::scoped_lock lock(loop.mutex);
+			if (loop.isStopping && loop.requestQueue.empty() && loop.numberActive == 0) {
+				break;
+			}
+		}
+		//sleep until a socket is ready, submit() wakes us up, or 100 ms pass
+		curl_multi_poll(loop.multi, NULL, 0, 100, NULL);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function moves queued requests into the multi handle, up to
+maxTransfers_ concurrent transfers.
+* @param		FetchLoop& -- loop (the state of this thread)
+* @return		void
+*******************************************************************************
+*/
+void FetchEngine::startTransfers(FetchLoop& loop)
+{
+	while (true) {
+		FetchRequest request;
+		{
+			boost::mutex::scoped_lock lock(loop.mutex);
+			if (loop.requestQueue.empty() || loop.numberActive >= maxTransfers_) {
+				return;
+			}
+			request = loop.requestQueue.front();
+			loop.requestQueue.pop_front();
+			loop.numberActive++;
+		}
+
+		//reuse an easy handle so its connection and DNS state survive
+		CURL* handle;
+		if (loop.idleHandles.empty()) {
+			handle = curl_easy_init();
+		}
+		else {
+			handle = loop.idleHandles.back();
+			loop.idleHandles.pop_back();
+			curl_easy_reset(handle);
+		}
+		context_.attach(handle);
+
+		Transfer* ptrTransfer = new Transfer;
+		ptrTransfer->callback = request.callback;
+		ptrTransfer->progressCallback = request.progressCallback;
+		ptrTransfer->handle = handle;
+		ptrTransfer->requestHeaders = NULL;
+		for (size_t i = 0; i < request.requestHeaders.size(); i++) {
+			ptrTransfer->requestHeaders = curl_slist_append(ptrTransfer->requestHeaders,
+				request.requestHeaders[i].c_str());
+		}
+		ptrTransfer->result.url = request.url;
+		ptrTransfer->result.httpStatus = 0;
+		ptrTransfer->result.curlCode = CURLE_OK;
+		ptrTransfer->result.fetchTime = 0;
+		ptrTransfer->result.ptrBody = bufferFactory_ ? bufferFactory_() :
+			boost::shared_ptr<PageBuffer>(new PageBuffer);
+
+		curl_easy_setopt(handle, CURLOPT_URL, ptrTransfer->result.url.c_str());
+		curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+		curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+		curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, fetchWriter);
+		curl_easy_setopt(handle, CURLOPT_WRITEDATA, ptrTransfer);
+		curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, fetchHeaderWriter);
+		curl_easy_setopt(handle, CURLOPT_HEADERDATA, ptrTransfer);
+		curl_easy_setopt(handle, CURLOPT_PRIVATE, ptrTransfer);
+		if (ptrTransfer->requestHeaders != NULL) {
+			curl_easy_setopt(handle, CURLOPT_HTTPHEADER, ptrTransfer->requestHeaders);
+		}
+		curl_multi_add_handle(loop.multi, handle);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function hands the completed transfers to their callbacks
+and keeps their easy handles for reuse.
+* @param		FetchLoop& -- loop (the state of this thread)
+* @return		void
+*******************************************************************************
+*/
+void FetchEngine::finishTransfers(FetchLoop& loop)
+{
+	CURLMsg* msg;
+	int numberMessages;
+	while ((msg = curl_multi_info_read(loop.multi, &numberMessages)) != NULL) {
+		if (msg->msg != CURLMSG_DONE) {
+			continue;
+		}
+		CURL* handle = msg->easy_handle;
+		Transfer* ptrTransfer = NULL;
+		curl_easy_getinfo(handle, CURLINFO_PRIVATE, &ptrTransfer);
+		ptrTransfer->result.curlCode = msg->data.result;
+		ptrTransfer->result.fetchTime = time(NULL);
+		curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &ptrTransfer->result.httpStatus);
+		context_.recordTransfer(handle, msg->data.result);
+		curl_multi_remove_handle(loop.multi, handle);
+		loop.idleHandles.push_back(handle);
+
+		if (ptrTransfer->result.curlCode != CURLE_OK) {
+			AsyncLogger::getShared().log(LOG_WARNING, "Exception in obtaining the page {}: {}",
+				ptrTransfer->result.url, curl_easy_strerror(ptrTransfer->result.curlCode));
+		}
+		ptrTransfer->callback(ptrTransfer->result);
+		curl_slist_free_all(ptrTransfer->requestHeaders);
+		delete ptrTransfer;
+
+		boost::mutex::scoped_lock lock(loop.mutex);
+		loop.numberActive--;
+	}
+}
@@ -0,0 +1,161 @@
+/**
+*******************************************************************************
+* @file		FetchEngine.h
+* @brief	This file provides the interfaces of the class FetchEngine.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _FETCHENGINE_H_
+#define _FETCHENGINE_H_
+
+#include <ctime>
+#include <string>
+#include <deque>
+#include <vector>
+
+//boost lib
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+
+//libcurl multi interface to drive many transfers from one thread
+#include <curl/curl.h>
+
+#include "PageBuffer.h"
+#include "FetchContext.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @struct		FetchResult
+* @brief 		This structure holds the outcome of one transfer.
+*******************************************************************************
+*/
+struct FetchResult
+{
+	//the requested URL
+	string url;
+	//the http status returned by the HTTP server (0 if no response)
+	long httpStatus;
+	//the libcurl result code of the transfer (CURLE_OK on success)
+	CURLcode curlCode;
+	//the time the transfer completed (seconds since the epoch)
+	time_t fetchTime;
+	//the headers of the final response (after redirects)
+	string headers;
+	//the downloaded html page, written once by the engine and then shared read-only
+	boost::shared_ptr<PageBuffer> ptrBody;
+};
+
+//the callback invoked on the engine thread when a transfer completes
+typedef boost::function<void (const FetchResult&)> FetchCallback;
+/*the callback invoked on the engine thread each time a chunk of a 200 response
+has been appended to the body; it receives the body received so far */
+typedef boost::function<void (const PageBuffer&)> FetchProgressCallback;
+//the function providing an empty buffer for each transfer (e.g. from a PagePool)
+typedef boost::function<boost::shared_ptr<PageBuffer> ()> PageBufferFactory;
+
+
+/**
+*******************************************************************************
+* @class		FetchEngine
+* @brief 		This class downloads pages asynchronously with the libcurl multi
+interface. Each engine thread owns one multi handle which drives hundreds of
+concurrent transfers and keeps their connections alive for reuse. All the
+requests of a host go to the same engine thread, so that they find the live
+connections of that host in its pool; the DNS and TLS session caches are shared
+by all the threads through a FetchContext. Completed transfers are handed to the
+callback given to submit().
+*******************************************************************************
+*/
+class FetchEngine
+{
+	private:
+		/*the state of one engine thread: its multi handle, the requests waiting
+		to be added to it, and the easy handles kept for reuse */
+		struct FetchRequest
+		{
+			string url;
+			FetchCallback callback;
+			FetchProgressCallback progressCallback;
+			vector<string> requestHeaders;
+		};
+		struct FetchLoop
+		{
+			CURLM* multi;
+			boost::mutex mutex;
+			deque<FetchRequest> requestQueue;
+			vector<CURL*> idleHandles;
+			int numberActive;
+			bool isStopping;
+			boost::thread thread;
+		};
+		//one transfer in progress, attached to its easy handle by CURLOPT_PRIVATE
+		struct Transfer
+		{
+			FetchResult result;
+			FetchCallback callback;
+			FetchProgressCallback progressCallback;
+			CURL* handle;
+			//the extra request headers, freed when the transfer completes
+			struct curl_slist* requestHeaders;
+		};
+
+		//the engine threads
+		vector< boost::shared_ptr<FetchLoop> > loops_;
+		//the maximum number of concurrent transfers per engine thread
+		int maxTransfers_;
+		//the maximum number of connections per host per engine thread
+		int maxHostConnections_;
+		//the provider of the page buffers (a new PageBuffer if empty)
+		PageBufferFactory bufferFactory_;
+		//the DNS and TLS session caches shared with the other downloads
+		FetchContext& context_;
+
+		//the body of an engine thread
+		void runLoop(boost::shared_ptr<FetchLoop> ptrLoop);
+		//move queued requests into the multi handle
+		void startTransfers(FetchLoop& loop);
+		//hand completed transfers to their callbacks
+		void finishTransfers(FetchLoop& loop);
+
+	public:
+ 		//constructor
+ 		FetchEngine(int numberThreads = 1, int maxTransfers = 256,
+ 			int maxHostConnections = 32, PageBufferFactory bufferFactory = PageBufferFactory(),
+ 			FetchContext& context = FetchContext::getShared());
+ 		//destructor: stops the engine threads
+ 		~FetchEngine();
+ 		//queue a URL for download, the callbacks run on an engine thread
+ 		void submit(const string& url, FetchCallback callback,
+ 			FetchProgressCallback progressCallback = FetchProgressCallback(),
+ 			const vector<string>& requestHeaders = vector<string>());
+ 		//wait for the queued transfers to complete and stop the engine threads
+ 		void stop();
+
+ 		/*friend function: the callback specified by
+ 		CURLOPT_WRITEFUNCTION for every transfer */
+ 		friend size_t fetchWriter(char* data, size_t size, size_t nmemb, void* userData);
+ 		/*friend function: the callback specified by
+ 		CURLOPT_HEADERFUNCTION for every transfer */
+ 		friend size_t fetchHeaderWriter(char* data, size_t size, size_t nmemb, void* userData);
+
+}; //end of class FetchEngine
+
+//the callback specified by CURLOPT_WRITEFUNCTION for every transfer
+size_t fetchWriter(char* data, size_t size, size_t nmemb, void* userData);
+//the callback specified by CURLOPT_HEADERFUNCTION for every transfer
+size_t fetchHeaderWriter(char* data, size_t size, size_t nmemb, void* userData);
+//get the value of a response header (case-insensitive name), or "" if absent
+string getHeaderValue(const string& headers, const string& name);
+
+} //end of namespace WebDataExtraction
+
+#endif //_FETCHENGINE_H_
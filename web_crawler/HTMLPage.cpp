@@ -8,27 +8,30 @@
 **/
 
 #include "HTMLPage.h"
+#include "ExtractionRules.h"
+#include "AsyncLogger.h"
+
+#include <boost/algorithm/string.hpp>
 
 //namespaces used in this file
 using namespace std;
 using namespace WebDataExtraction;
-using namespace curlpp;
 
 
 
 /**
 *******************************************************************************
-* @brief		This function is a callback function used by curl.perform().
+* @brief		This function is a callback function used by curl_easy_perform().
 * @param		char* -- data (the data that has just been obtained)
 * @param		size_t -- size (the size of each data block)
 * @param		size_t -- nmemb (the number of data blocks. multiply this by size to 
 obtain the total size of data)
-* @param		tidypp::buffer* -- dst (This is output, the destination buffer that 
+* @param		PageBuffer* -- dst (This is output, the destination buffer that 
 was assigned to CURLOPT_WRITEDATA)
 * @return		int -- the amount of bytes that were dispatched to the destination buffer
 *******************************************************************************
 */
-int writer(char *data, size_t size, size_t nmemb, tidypp::buffer *dst)
+int writer(char *data, size_t size, size_t nmemb, PageBuffer *dst)
 {
     size_t len;
 
@@ -41,6 +44,66 @@ int writer(char *data, size_t size, size_t nmemb, tidypp::buffer *dst)
     return len; // must return the amount of written bytes
 }
 
+/**
+*******************************************************************************
+* @brief		This function validates a link found on a page of the site.
+* @param		string -- url (the link on the HTML page)
+* @param		string -- hostName (the scheme, host and port of the site, e.g.,
+http://www.walmart.ca)
+* @return		string -- return a complete and valid URL, or "" in case validation 
+failure: an absolute URL must be in the domain of the host name (the host name
+without "www."). Whether the URL has been seen is checked by the caller.
+*******************************************************************************
+*/
+string WebDataExtraction::validateURL(const string& url, const string& hostName)
+{
+	//the string to be returned
+	string validatedURL = "";
+	
+	if (boost::algorithm::starts_with(url, "/")) {
+		validatedURL = hostName + url;
+	}
+	if (boost::algorithm::starts_with(url, "http") || 
+						boost::algorithm::starts_with(url, "www") ) {
+		//the domain of the site, e.g., walmart.ca
+		size_t domainStart = hostName.find("://");
+		domainStart = (domainStart == string::npos) ? 0 : domainStart + 3;
+		if (boost::algorithm::istarts_with(hostName.c_str() + domainStart, "www.")) {
+			domainStart += 4;
+		}
+		size_t domainEnd = hostName.find_first_of(":/", domainStart);
+		string domain = hostName.substr(domainStart, (domainEnd == string::npos) ?
+			string::npos : domainEnd - domainStart);
+		if (boost::algorithm::icontains(url, domain)) {
+			validatedURL = url;
+		}
+		else {
+			validatedURL = "";
+		}	
+	}		
+  
+  //cout << "validation result: " << validatedURL << endl;
+  return validatedURL;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the empty page shared by all the HTMLPage
+objects which have not been initialized.
+* @param		none
+* @return		boost::shared_ptr<const PageBuffer>
+*******************************************************************************
+*/
+static boost::shared_ptr<const PageBuffer> emptyPage()
+{
+	static const boost::shared_ptr<const PageBuffer> ptrEmptyPage(new PageBuffer);
+	return ptrEmptyPage;
+}
+
+
+
 /**
 *******************************************************************************
 * @brief		This function is the constructor of the class HTMLPage.
@@ -50,9 +113,9 @@ int writer(char *data, size_t size, size_t nmemb, tidypp::buffer *dst)
 */
 HTMLPage::HTMLPage(string url) : url_(url)
 {
-	ptrHtmlPage_ = boost::shared_ptr<string> (new string);
+	ptrHtmlPage_ = emptyPage();
 	ptrLinkSet_ = boost::shared_ptr< set<string> > (new set<string>);
-	ptrProductInfoVector_ = boost::shared_ptr< vector<Information> > (new vector<Information>);
+	ptrRecordBatch_ = boost::shared_ptr<RecordBatch> (new RecordBatch);
 }
 
 
@@ -89,10 +152,10 @@ string HTMLPage::getHostName() const
 *******************************************************************************
 * @brief		This function returns the pointer to the HTML page.
 * @param		none
-* @return		boost::shared_ptr<string>
+* @return		boost::shared_ptr<const PageBuffer>
 *******************************************************************************
 */
-boost::shared_ptr<string> HTMLPage::getPtrHtmlPage() const
+boost::shared_ptr<const PageBuffer> HTMLPage::getPtrHtmlPage() const
 {
 	return ptrHtmlPage_;
 }
@@ -114,14 +177,14 @@ boost::shared_ptr< set<string> > HTMLPage::getPtrLinkSet() const
 
 /**
 *******************************************************************************
-* @brief		This function returns the pointer to the vector of product information.
+* @brief		This function returns the pointer to the batch of product records.
 * @param		none
-* @return		boost::shared_ptr< vector<Information> >
+* @return		boost::shared_ptr<RecordBatch>
 *******************************************************************************
 */
-boost::shared_ptr< vector<Information> > HTMLPage::getPtrProductInfoVector() const
+boost::shared_ptr<RecordBatch> HTMLPage::getPtrRecordBatch() const
 {
-	return ptrProductInfoVector_;
+	return ptrRecordBatch_;
 }
 
 /**
@@ -140,18 +203,38 @@ void HTMLPage::setURL(string url)
 
 /**
 *******************************************************************************
-* @brief		This function gets the host name and downloads the html page.
+* @brief		This function prepares the object for another page. The link set
+and the record batch are cleared, not reallocated, and the reference to
+the previous page buffer is dropped.
+* @param		string -- url (the URL of the next html page)
+* @return		Void
+*******************************************************************************
+*/
+void HTMLPage::reset(const string& url)
+{
+	url_ = url;
+	hostName_.clear();
+	ptrHtmlPage_ = emptyPage();
+	ptrLinkSet_->clear();
+	ptrRecordBatch_->clear();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function gets the host name from the URL.
 * @param		none
-* @return		int -- return 0 if the init succeeds, and 1 if the init fails.
+* @return		void
 *******************************************************************************
 */
-int HTMLPage::init()
+void HTMLPage::extractHostName()
 {
-	//step 1): get the host name
 	/*get the host name from the URL, for example:
 	URL: http://www.walmart.ca/en/health-beauty/pharmacy/foot-care/N-1441
 	host name: http://www.walmart.ca */
-	boost::regex hostNamePattern("(https?:\\/\\/)?([\\da-z\\.-]+)\\.([a-z\\.]{2,6})");
+	//compiled once and shared, matching with a const regex is thread-safe
+	static const boost::regex hostNamePattern("(https?:\\/\\/)?([\\da-z\\.-]+)\\.([a-z\\.]{2,6})");
 	string::const_iterator start, end;
 	start = url_.begin();
 	end = url_.end();
@@ -167,59 +250,102 @@ int HTMLPage::init()
 		start = what[0].second;
 	}
 	if (matchedStr == "") {
-		cout << "Failed to extract the host name." << endl;
+		AsyncLogger::getShared().log(LOG_WARNING, "Failed to extract the host name of {}", url_);
 	}	
 	else {
 		hostName_ = matchedStr;
 	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function gets the host name and downloads the html page.
+* @param		none
+* @return		int -- return 0 if the init succeeds, and 1 if the init fails.
+*******************************************************************************
+*/
+int HTMLPage::init()
+{
+	//step 1): get the host name
+	extractHostName();
 	
 	//step 2): download the HTML page via cURL lib
-	//store our html code
-	tidypp::buffer html; 
-	//tore the warnings and errors encountered by html tidy
- 	tidypp::buffer errbuf;
+	//store our html code, written once by the write callback
+	boost::shared_ptr<PageBuffer> ptrHtml(new PageBuffer);
+
+	//the easy handle of this thread keeps the connection alive for the next page
+	CURL* curl = FetchContext::getShared().acquireThreadHandle();
+	//store the result of the curl request
+	long http_status = 0;
+
+	//std::cout << "Obtaining page..." << std::endl;
+	//assign URL
+	curl_easy_setopt(curl, CURLOPT_URL, url_.c_str());
+	//set options
+	curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+	//assign write callback
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writer);
+	//assign write buffer
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, ptrHtml.get());
+	//perform curl to download the html page
+	CURLcode curlCode = curl_easy_perform(curl);
+	FetchContext::getShared().recordTransfer(curl, curlCode);
+	//print the error on screen
+	if (curlCode != CURLE_OK) {
+		AsyncLogger::getShared().log(LOG_WARNING, "Exception in obtaining the page {}: {}", url_,
+			curl_easy_strerror(curlCode));
+		return INIT_FAILURE;
+	}
+	//get result http status returned by the HTTP server
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_status);
 
-	try
-	{
-		//handle to the curl easy interface
-	  curlpp::easy curl; 
-	  //store the result of the curl request
-	  long http_status; 
-
-	  //std::cout << "Obtaining page..." << std::endl;
-	  //assign URL
-	  curl.setopt(CURLOPT_URL, url_.c_str()); 
-	  //set options
-	  curl.setopt(CURLOPT_FOLLOWLOCATION, 1);
-	  //assign write callback
-	  curl.setopt(CURLOPT_WRITEFUNCTION, writer); 
-
-	  //assign write buffer (our tidypp buffer)
-	  curl.setopt(CURLOPT_WRITEDATA, &html); 
-	  //perform curl to download the html page
-	  curl.perform(); 
-	  //get result http status returned by the HTTP server
-	  curl.getinfo(CURLINFO_RESPONSE_CODE, &http_status); 
-
-		//code 200 means sucessful download, other code means failure
-	  if (http_status != 200) 
-	  {
-			std::cerr << "Expecting HTTP 200 OK, got " << http_status << std::endl;
-      return 1;
-	  }
+	//a 2xx code means sucessful download, other code means failure
+	if (http_status < 200 || http_status >= 300) {
+		AsyncLogger::getShared().log(LOG_WARNING, "Expecting HTTP 2xx, got {} for {}", http_status, url_);
+		return INIT_FAILURE;
+	}
+	//store the the obtained html page without copying it
+	ptrHtmlPage_ = ptrHtml;
+	
+	return INIT_SUCCESS;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function gets the host name and takes the html page which has
+been downloaded by the FetchEngine.
+* @param		long -- httpStatus (the http status returned by the HTTP server)
+* @param		boost::shared_ptr<const PageBuffer> -- ptrHtmlPage (the downloaded html
+page, or for a 304 response the copy stored by the last crawl)
+* @return		int -- return INIT_SUCCESS (0) for a 2xx response, INIT_NOT_MODIFIED
+(2) for a 304 response, and INIT_FAILURE (1) otherwise.
+*******************************************************************************
+*/
+int HTMLPage::init(long httpStatus, boost::shared_ptr<const PageBuffer> ptrHtmlPage)
+{
+	//step 1): get the host name
+	extractHostName();
+	
+	//step 2): check the download result
+	//304 answers a conditional request: the stored copy is still valid
+	if (httpStatus == 304) {
+		ptrHtmlPage_ = ptrHtmlPage;
+		return INIT_NOT_MODIFIED;
 	}
-	//catch exceptions and print the error on screen
-	catch (const curlpp::exception &e) 
+	//a 2xx code means sucessful download, other code means failure
+	if (httpStatus < 200 || httpStatus >= 300) 
 	{
-  	std::cerr << "Exception in obtaining the page: " << e.what() << std::endl;
-	  return 1;
+		AsyncLogger::getShared().log(LOG_WARNING, "Expecting HTTP 2xx, got {} for {}", httpStatus, url_);
+		return INIT_FAILURE;
 	}
-	//store the the obtained html page
-	std::ostringstream ss;
-	ss << html.ptr();
-	*ptrHtmlPage_ = ss.str();
+	ptrHtmlPage_ = ptrHtmlPage;
 	
-	return 0;
+	return INIT_SUCCESS;
 }
 
 
@@ -233,31 +359,24 @@ int HTMLPage::init()
 */
 int HTMLPage::extractLinks()
 {
-	//number of links
-	int numberLinks = 0;
-	//regular expression pattern for the links on the HTML page
-	boost::regex linkPattern("[hH][rR][eE][fF]\\s*=\\s*\"([^\"]+)\"");
+	//the scanner finding the href attributes on the HTML page
+	static const LinkScanner linkScanner(LinkScanner::HREF);
 	
-	string::const_iterator start, end;
-	start = (*ptrHtmlPage_).begin();
-	end = (*ptrHtmlPage_).end();
-	boost::match_results<std::string::const_iterator> what;
-	boost::match_flag_type flags = boost::match_default;
-	string matchedStr;
-	string matchedstrgroup1;
-	while (boost::regex_search(start, end, what, linkPattern, flags)) {
-		numberLinks++;
-		//the matched string
-		matchedStr=what.str();
-		//the matched group-1 substring
-		matchedstrgroup1=what[1].str(); 
+	vector<ScannedLink> links;
+	linkScanner.scan(ptrHtmlPage_->data(), ptrHtmlPage_->size(), 0, links);
+	for (size_t i = 0; i < links.size(); i++) {
 		//store the links into the link set
-		ptrLinkSet_->insert(matchedstrgroup1);
-		//cout << "Link " << index << " : " << matchedstrgroup1 << endl;
-		start = what[0].second;
-	}	
+		if (links[i].hasEntity) {
+			ptrLinkSet_->insert(LinkScanner::decodeEntities(links[i].value));
+		}
+		else {
+			ptrLinkSet_->insert(string(links[i].value.data(), links[i].value.size()));
+		}
+		//cout << "Link " << i << " : " << links[i].value << endl;
+	}
 	
-	return numberLinks;
+	//number of links
+	return (int)links.size();
 }
 
 
@@ -265,33 +384,16 @@ int HTMLPage::extractLinks()
 /**
 *******************************************************************************
 * @brief		This function extracts the useful information on the HTML page.
-* @param		none
+* @param		ExtractionRules -- extractionRules (the compiled rules; the rules of
+the host of the page are applied)
 * @return		int -- return the number of records.
 *******************************************************************************
 */
-int HTMLPage::extractInfo()
+int HTMLPage::extractInfo(const ExtractionRules& extractionRules)
 {
-	//to be filled by Xiaoming and Ning
-	//a simple example
-	//number of records
-	int numberRecords = 0;	
-	
-	//typedef boost::tuple<long /*1) product id*/, string/*2) product categoty*/, 
-	//string/*3) product description*/, string/*4) link of the product image*/, 
-	//float/*5) original price*/, float/*6) current price*/> Information;
-	Information infoRecord1(
-		101, 
-		"Electronics", 
-		"PROSCAN 7\" Android 4.1 Tablet with Case & Keyboard (PLT7-K)",
-		"http://i-store.walmart.ca/images/WMTCNPE/NewImages/be51e2bbbd63432db8b7c26581ca8649/Large_.jpeg",
-		78.00f,
-		64.00f );
-	
-	numberRecords++;
-	//push it into the vector
-	ptrProductInfoVector_->push_back(infoRecord1);	
-	
-	return numberRecords;
+	//the records are appended to the columns of the page's batch
+	return extractionRules.extract(ptrHtmlPage_->data(), ptrHtmlPage_->size(),
+		hostName_, *ptrRecordBatch_);
 }
 
 
@@ -24,29 +24,25 @@
 //boost lib
 #include <boost/shared_ptr.hpp> 
 #include <boost/regex.hpp> 
-#include <boost/tuple/tuple.hpp> 
-#include <boost/tuple/tuple_io.hpp> 
 
-//curlplusplus lib to download html page
-#include <curlplusplus/easy.hpp>
+//the libcurl handles sharing the DNS and TLS session caches to download html page
+#include "FetchContext.h"
 
-//tidypp lib to download html page 
-#include <tidypp/buffer.hpp>
-#include <tidypp/document.hpp>
-#include <tidypp/attribute.hpp>
-#include <tidypp/node.hpp>
-#include <curlplusplus/easy.hpp>
+//href scanner replacing the regular expression in extractLinks()
+#include "LinkScanner.h"
+//the buffer holding the downloaded page
+#include "PageBuffer.h"
+//the product records extracted from the page
+#include "RecordBatch.h"
 
 using namespace std;
 
-//define the structure to record the useful information extacted on the html page
-typedef boost::tuple<long /*1) product id*/, string/*2) product categoty*/, 
-	string/*3) product description*/, string/*4) link of the product image*/, 
-	float/*5) original price*/, float/*6) current price*/> Information; 
-
 namespace WebDataExtraction 
 {
 
+//the compiled rules used by extractInfo()
+class ExtractionRules;
+
 
 /**
 *******************************************************************************
@@ -62,14 +58,24 @@ class HTMLPage
 		string url_;
 		//the host name
 		string hostName_;
-		//html page
-		boost::shared_ptr<string> ptrHtmlPage_; 
+		//html page, shared read-only with the other stages
+		boost::shared_ptr<const PageBuffer> ptrHtmlPage_; 
 		//pointer to the set of links on the page
 		boost::shared_ptr< set<string> > ptrLinkSet_;
-		//pointer to the vector of product information on the page
-		boost::shared_ptr< vector<Information> > ptrProductInfoVector_;
+		//pointer to the batch of product records on the page
+		boost::shared_ptr<RecordBatch> ptrRecordBatch_;
+
+		//get the host name from the URL
+		void extractHostName();
 
 	public:
+ 		//the results of init()
+ 		enum InitStatus
+ 		{
+ 			INIT_SUCCESS = 0,      //a new page has been downloaded (2xx)
+ 			INIT_FAILURE = 1,      //no page (network error, 4xx, 5xx, ...)
+ 			INIT_NOT_MODIFIED = 2  //304: the page is the copy kept from the last crawl
+ 		};
  		//constructor
  		HTMLPage(string url);
  		//get the http URL
@@ -77,26 +83,34 @@ class HTMLPage
  		//get host name
  		string getHostName() const;
  		//get the pointer to the HTML page
- 		boost::shared_ptr<string> getPtrHtmlPage() const;
+ 		boost::shared_ptr<const PageBuffer> getPtrHtmlPage() const;
  		//get the pointer to the link set
  		boost::shared_ptr< set<string> > getPtrLinkSet() const;
- 		//get the pointer to the vector of product information
- 		boost::shared_ptr< vector<Information> > getPtrProductInfoVector() const;
+ 		//get the pointer to the batch of product records
+ 		boost::shared_ptr<RecordBatch> getPtrRecordBatch() const;
  		//set URL
  		void setURL(string url);
+ 		//prepare the object for another page, keeping the allocated containers
+ 		void reset(const string& url);
  		//initialize: 1) get the host name, 2) download the html page
  		int init();
+ 		/*initialize: 1) get the host name, 2) take a page downloaded by FetchEngine,
+ 		or the stored copy of the page if the response is 304 */
+ 		int init(long httpStatus, boost::shared_ptr<const PageBuffer> ptrHtmlPage);
  		//extract all links on the html page
  		int extractLinks();
- 		//extract useful information fron the html page
- 		int extractInfo();
+ 		//extract useful information fron the html page with the rules of its site
+ 		int extractInfo(const ExtractionRules& extractionRules);
  
  		/*friend function: a callback function specified by 
- 		curl.setopt(CURLOPT_WRITEFUNCTION, writer) in init(); */
-		friend int writer(char* data, size_t size, size_t nmemb, tidypp::buffer *dst);
+ 		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writer) in init(); */
+		friend int writer(char* data, size_t size, size_t nmemb, PageBuffer *dst);
 	
 }; //end of class HTMLPage
 
+//complete a link found on a page of hostName, or return "" if it leaves the site
+string validateURL(const string& url, const string& hostName);
+
 } //end of namespace WebDataExtraction
 
 #endif //_HTMLPAGE_H_
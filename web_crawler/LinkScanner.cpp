@@ -0,0 +1,340 @@
+/**
+*******************************************************************************
+* @file			LinkScanner.cpp
+* @brief 		This file provides the implementations of the class LinkScanner.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "LinkScanner.h"
+
+#include <cstring>
+#include <cstdlib>
+
+//SIMD intrinsics for the byte search
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function checks whether a byte is HTML whitespace.
+* @param		char -- c (the byte)
+* @return		bool -- return true for space, tab, CR, LF and FF
+*******************************************************************************
+*/
+static inline bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function compares the bytes at p with a lowercase name,
+ignoring case.
+* @param		char* -- p (the bytes in the page)
+* @param		char* -- name (the lowercase attribute name)
+* @param		size_t -- len (the length of the name)
+* @return		bool -- return true if they are equal
+*******************************************************************************
+*/
+static inline bool equalsIgnoreCase(const char* p, const char* name, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		//setting bit 0x20 lowercases ASCII letters; the names contain letters only
+		if ((p[i] | 0x20) != name[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class LinkScanner.
+* @param		int -- attributeMask (HREF, SRC or HREF | SRC)
+* @return		None
+*******************************************************************************
+*/
+LinkScanner::LinkScanner(int attributeMask) : attributeMask_(attributeMask)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function finds the first occurrence of a byte. It compares 32
+bytes per step with AVX2, 16 bytes with SSE2, and falls back to memchr.
+* @param		char* -- begin (the first byte to search)
+* @param		char* -- end (one past the last byte to search)
+* @param		char -- c (the byte to find)
+* @return		char* -- the position of the byte, or end if it is not found
+*******************************************************************************
+*/
+const char* LinkScanner::findByte(const char* begin, const char* end, char c)
+{
+	const char* p = begin;
+#if defined(__AVX2__)
+	const __m256i needle32 = _mm256_set1_epi8(c);
+	while (end - p >= 32) {
+		__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle32));
+		if (mask != 0) {
+			return p + __builtin_ctz(mask);
+		}
+		p += 32;
+	}
+#endif
+#if defined(__SSE2__)
+	const __m128i needle16 = _mm_set1_epi8(c);
+	while (end - p >= 16) {
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle16));
+		if (mask != 0) {
+			return p + __builtin_ctz(mask);
+		}
+		p += 16;
+	}
+#endif
+	if (p >= end) {
+		return end;
+	}
+	const char* found = static_cast<const char*>(memchr(p, c, end - p));
+	return found ? found : end;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function scans a buffer for href/src attribute values.
+* @param		char* -- data (the page buffer)
+* @param		size_t -- length (the number of bytes in the buffer)
+* @param		size_t -- from (the offset to start at; the bytes before it are only
+used to read the attribute name of an '=' at the offset)
+* @param		vector<ScannedLink>& -- links (output, the values found are appended)
+* @param		bool -- isFinal (false if more bytes of the page will follow)
+* @return		size_t -- length if the buffer was scanned completely, or the offset
+of the '=' whose value is cut off by the end of a non-final buffer
+*******************************************************************************
+*/
+size_t LinkScanner::scan(const char* data, size_t length, size_t from,
+	vector<ScannedLink>& links, bool isFinal) const
+{
+	const char* end = data + length;
+	const char* p = data + from;
+	while ((p = findByte(p, end, '=')) != end) {
+		const char* equals = p;
+		p++;
+
+		//step 1): read the attribute name in front of '=', e.g. <a href = "...">
+		const char* nameEnd = equals;
+		while (nameEnd > data && isSpace(nameEnd[-1])) {
+			nameEnd--;
+		}
+		int attribute = 0;
+		const char* nameStart = nameEnd;
+		if ((attributeMask_ & HREF) && nameEnd - data >= 4 && equalsIgnoreCase(nameEnd - 4, "href", 4)) {
+			attribute = HREF;
+			nameStart = nameEnd - 4;
+		}
+		else if ((attributeMask_ & SRC) && nameEnd - data >= 3 && equalsIgnoreCase(nameEnd - 3, "src", 3)) {
+			attribute = SRC;
+			nameStart = nameEnd - 3;
+		}
+		//the name must start the attribute, so that e.g. data-href is skipped
+		if (attribute == 0 || (nameStart > data && !isSpace(nameStart[-1]) &&
+				nameStart[-1] != '"' && nameStart[-1] != '\'' && nameStart[-1] != '/')) {
+			continue;
+		}
+
+		//step 2): read the value behind '='
+		const char* valueStart = p;
+		while (valueStart < end && isSpace(*valueStart)) {
+			valueStart++;
+		}
+		if (valueStart == end) {
+			if (!isFinal) {
+				return equals - data;
+			}
+			break;
+		}
+		const char* valueEnd;
+		if (*valueStart == '"' || *valueStart == '\'') {
+			char quote = *valueStart;
+			valueStart++;
+			valueEnd = findByte(valueStart, end, quote);
+			if (valueEnd == end) {
+				if (!isFinal) {
+					return equals - data;
+				}
+				//an unterminated quote is not a link
+				continue;
+			}
+			p = valueEnd + 1;
+		}
+		else {
+			valueEnd = valueStart;
+			while (valueEnd < end && !isSpace(*valueEnd) && *valueEnd != '>') {
+				valueEnd++;
+			}
+			if (valueEnd == end && !isFinal) {
+				return equals - data;
+			}
+			p = valueEnd;
+		}
+		if (valueEnd == valueStart) {
+			continue;
+		}
+
+		ScannedLink link;
+		link.value = boost::string_view(valueStart, valueEnd - valueStart);
+		link.attribute = attribute;
+		link.hasEntity = (memchr(valueStart, '&', valueEnd - valueStart) != NULL);
+		links.push_back(link);
+	}
+	return length;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function replaces the character entities in an attribute
+value: &amp; &lt; &gt; &quot; &apos; and numeric references. Numeric references
+are encoded as UTF-8. Unknown entities are kept as they are.
+* @param		boost::string_view -- value (the raw attribute value)
+* @return		string -- the decoded value
+*******************************************************************************
+*/
+string LinkScanner::decodeEntities(boost::string_view value)
+{
+	string decoded;
+	decoded.reserve(value.size());
+	size_t i = 0;
+	while (i < value.size()) {
+		size_t semicolon;
+		if (value[i] != '&' || (semicolon = value.find(';', i)) == boost::string_view::npos ||
+				semicolon - i > 10) {
+			decoded += value[i++];
+			continue;
+		}
+		boost::string_view name = value.substr(i + 1, semicolon - i - 1);
+		long codePoint = -1;
+		if (name == "amp") codePoint = '&';
+		else if (name == "lt") codePoint = '<';
+		else if (name == "gt") codePoint = '>';
+		else if (name == "quot") codePoint = '"';
+		else if (name == "apos") codePoint = '\'';
+		else if (name.size() > 1 && name[0] == '#') {
+			string digits(name.data() + 1, name.size() - 1);
+			char* digitsEnd;
+			if (digits[0] == 'x' || digits[0] == 'X') {
+				codePoint = strtol(digits.c_str() + 1, &digitsEnd, 16);
+			}
+			else {
+				codePoint = strtol(digits.c_str(), &digitsEnd, 10);
+			}
+			if (*digitsEnd != '\0' || codePoint <= 0 || codePoint > 0x10FFFF) {
+				codePoint = -1;
+			}
+		}
+		if (codePoint < 0) {
+			decoded += value[i++];
+			continue;
+		}
+
+		//encode the code point as UTF-8
+		if (codePoint < 0x80) {
+			decoded += (char)codePoint;
+		}
+		else if (codePoint < 0x800) {
+			decoded += (char)(0xC0 | (codePoint >> 6));
+			decoded += (char)(0x80 | (codePoint & 0x3F));
+		}
+		else if (codePoint < 0x10000) {
+			decoded += (char)(0xE0 | (codePoint >> 12));
+			decoded += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			decoded += (char)(0x80 | (codePoint & 0x3F));
+		}
+		else {
+			decoded += (char)(0xF0 | (codePoint >> 18));
+			decoded += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+			decoded += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			decoded += (char)(0x80 | (codePoint & 0x3F));
+		}
+		i = semicolon + 1;
+	}
+	return decoded;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class IncrementalLinkScanner.
+* @param		int -- attributeMask (HREF, SRC or HREF | SRC)
+* @return		None
+*******************************************************************************
+*/
+IncrementalLinkScanner::IncrementalLinkScanner(int attributeMask) :
+	linkScanner_(attributeMask), resumeOffset_(0)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function scans the bytes received since the last call. The
+buffer may have been reallocated since then, so the views in links are only valid
+until the buffer grows again.
+* @param		char* -- data (the page received so far)
+* @param		size_t -- length (the number of bytes received so far)
+* @param		vector<ScannedLink>& -- links (output, the values found are appended)
+* @return		size_t -- the number of links found
+*******************************************************************************
+*/
+size_t IncrementalLinkScanner::feed(const char* data, size_t length, vector<ScannedLink>& links)
+{
+	//a shorter buffer means the transfer was restarted
+	if (length < resumeOffset_) {
+		resumeOffset_ = 0;
+	}
+	size_t numberLinks = links.size();
+	resumeOffset_ = linkScanner_.scan(data, length, resumeOffset_, links, false);
+	return links.size() - numberLinks;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function scans the rest of the complete page.
+* @param		char* -- data (the complete page)
+* @param		size_t -- length (the size of the page)
+* @param		vector<ScannedLink>& -- links (output, the values found are appended)
+* @return		size_t -- the number of links found
+*******************************************************************************
+*/
+size_t IncrementalLinkScanner::finish(const char* data, size_t length, vector<ScannedLink>& links)
+{
+	if (length < resumeOffset_) {
+		resumeOffset_ = 0;
+	}
+	size_t numberLinks = links.size();
+	resumeOffset_ = linkScanner_.scan(data, length, resumeOffset_, links, true);
+	return links.size() - numberLinks;
+}
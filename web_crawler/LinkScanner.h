@@ -0,0 +1,111 @@
+/**
+*******************************************************************************
+* @file		LinkScanner.h
+* @brief	This file provides the interfaces of the class LinkScanner.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _LINKSCANNER_H_
+#define _LINKSCANNER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//boost lib
+#include <boost/utility/string_view.hpp>
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @struct		ScannedLink
+* @brief 		This structure holds one attribute value found by the LinkScanner.
+*******************************************************************************
+*/
+struct ScannedLink
+{
+	//the raw attribute value, pointing into the scanned page buffer
+	boost::string_view value;
+	//the attribute the value belongs to (LinkScanner::HREF or LinkScanner::SRC)
+	int attribute;
+	//true if the value contains '&' and must go through decodeEntities()
+	bool hasEntity;
+};
+
+
+/**
+*******************************************************************************
+* @class		LinkScanner
+* @brief 		This class extracts href/src attribute values from an HTML page
+without regular expressions. It jumps from '=' to '=' with an SSE2/AVX2 byte
+search (memchr when neither is available), checks the attribute name in front of
+each '=', and reads the double-quoted, single-quoted or unquoted value behind it.
+The values are returned as string_views into the page buffer.
+*******************************************************************************
+*/
+class LinkScanner
+{
+	private:
+		//the attributes to extract (a combination of HREF and SRC)
+		int attributeMask_;
+
+	public:
+		//the attributes which can be extracted
+		enum Attribute
+		{
+			HREF = 1,
+			SRC = 2
+		};
+
+ 		//constructor
+ 		LinkScanner(int attributeMask = HREF);
+ 		/*scan the bytes [from, length) of the buffer and append the values found;
+ 		if isFinal is false, a value cut off by the end of the buffer is not
+ 		returned, and its offset is returned so that the scan can resume there */
+ 		size_t scan(const char* data, size_t length, size_t from,
+ 			vector<ScannedLink>& links, bool isFinal = true) const;
+ 		//find the first byte c in [begin, end), or return end
+ 		static const char* findByte(const char* begin, const char* end, char c);
+ 		//replace the character entities (&amp; &#38; &#x26; ...) in a value
+ 		static string decodeEntities(boost::string_view value);
+
+}; //end of class LinkScanner
+
+
+/**
+*******************************************************************************
+* @class		IncrementalLinkScanner
+* @brief 		This class runs the LinkScanner on a page while it is being
+downloaded. feed() is called with the whole buffer received so far, each time a
+chunk has been appended to it; only the bytes after the resume offset are
+scanned, and a value cut off by the end of the chunk is scanned again once the
+next chunk has arrived. finish() scans the rest when the download is complete.
+*******************************************************************************
+*/
+class IncrementalLinkScanner
+{
+	private:
+		//the scanner
+		LinkScanner linkScanner_;
+		//the offset at which the next scan starts
+		size_t resumeOffset_;
+
+	public:
+ 		//constructor
+ 		IncrementalLinkScanner(int attributeMask = LinkScanner::HREF);
+ 		//scan the bytes received since the last call, return the number of links found
+ 		size_t feed(const char* data, size_t length, vector<ScannedLink>& links);
+ 		//scan the rest of the complete page, return the number of links found
+ 		size_t finish(const char* data, size_t length, vector<ScannedLink>& links);
+
+}; //end of class IncrementalLinkScanner
+
+} //end of namespace WebDataExtraction
+
+#endif //_LINKSCANNER_H_
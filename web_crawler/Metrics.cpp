@@ -0,0 +1,687 @@
+/**
+*******************************************************************************
+* @file			Metrics.cpp
+* @brief 		This file provides the implementations of the classes
+LatencyHistogram and Metrics.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "Metrics.h"
+
+#include <cstdio>
+#include <ctime>
+#include <cmath>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+//the quantiles exported for each histogram
+static const double exportedQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+static const int numberExportedQuantiles = 4;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class LatencyHistogram.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+LatencyHistogram::LatencyHistogram() : count_(0), sum_(0), max_(0)
+{
+	for (int i = 0; i < NUMBER_BUCKETS; i++) {
+		counts_[i].store(0, boost::memory_order_relaxed);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the bucket of a value: the values below
+NUMBER_SUB_BUCKETS have a bucket each, then each power of two is split into
+NUMBER_SUB_BUCKETS buckets of equal width.
+* @param		boost::uint64_t -- value (the value)
+* @return		int -- the bucket
+*******************************************************************************
+*/
+int LatencyHistogram::getBucket(boost::uint64_t value)
+{
+	if (value < (boost::uint64_t)NUMBER_SUB_BUCKETS) {
+		return (int)value;
+	}
+	int highestBit = 63 - __builtin_clzll(value);
+	int shift = highestBit - SUB_BUCKET_BITS;
+	return (shift + 1) * NUMBER_SUB_BUCKETS + (int)((value >> shift) - NUMBER_SUB_BUCKETS);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the largest value counted in a bucket.
+* @param		int -- bucket (the bucket)
+* @return		boost::uint64_t -- the largest value of the bucket
+*******************************************************************************
+*/
+boost::uint64_t LatencyHistogram::getBucketUpperBound(int bucket)
+{
+	if (bucket < NUMBER_SUB_BUCKETS) {
+		return (boost::uint64_t)bucket;
+	}
+	int shift = bucket / NUMBER_SUB_BUCKETS - 1;
+	boost::uint64_t lowerBound = (boost::uint64_t)(NUMBER_SUB_BUCKETS + bucket % NUMBER_SUB_BUCKETS) << shift;
+	return lowerBound + (((boost::uint64_t)1 << shift) - 1);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function counts a value. Only one thread records into a
+histogram, so a relaxed load and store replace the locked read-modify-write.
+* @param		boost::uint64_t -- value (the value)
+* @return		void
+*******************************************************************************
+*/
+void LatencyHistogram::record(boost::uint64_t value)
+{
+	boost::atomic<boost::uint64_t>& bucketCount = counts_[getBucket(value)];
+	bucketCount.store(bucketCount.load(boost::memory_order_relaxed) + 1, boost::memory_order_relaxed);
+	count_.store(count_.load(boost::memory_order_relaxed) + 1, boost::memory_order_relaxed);
+	sum_.store(sum_.load(boost::memory_order_relaxed) + value, boost::memory_order_relaxed);
+	if (value > max_.load(boost::memory_order_relaxed)) {
+		max_.store(value, boost::memory_order_relaxed);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function adds the counts of another histogram, e.g. of the
+shard of another thread.
+* @param		LatencyHistogram -- other (the histogram to add)
+* @return		void
+*******************************************************************************
+*/
+void LatencyHistogram::add(const LatencyHistogram& other)
+{
+	for (int i = 0; i < NUMBER_BUCKETS; i++) {
+		boost::uint64_t otherCount = other.counts_[i].load(boost::memory_order_relaxed);
+		if (otherCount > 0) {
+			counts_[i].store(counts_[i].load(boost::memory_order_relaxed) + otherCount,
+				boost::memory_order_relaxed);
+		}
+	}
+	count_.store(count_.load(boost::memory_order_relaxed) + other.getCount(), boost::memory_order_relaxed);
+	sum_.store(sum_.load(boost::memory_order_relaxed) + other.getSum(), boost::memory_order_relaxed);
+	if (other.getMax() > max_.load(boost::memory_order_relaxed)) {
+		max_.store(other.getMax(), boost::memory_order_relaxed);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		These functions return the number, the sum, the largest and the
+mean of the values.
+*******************************************************************************
+*/
+boost::uint64_t LatencyHistogram::getCount() const
+{
+	return count_.load(boost::memory_order_relaxed);
+}
+
+boost::uint64_t LatencyHistogram::getSum() const
+{
+	return sum_.load(boost::memory_order_relaxed);
+}
+
+boost::uint64_t LatencyHistogram::getMax() const
+{
+	return max_.load(boost::memory_order_relaxed);
+}
+
+double LatencyHistogram::getMean() const
+{
+	boost::uint64_t count = getCount();
+	return (count > 0) ? (double)getSum() / count : 0.0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns a percentile: the largest value of the
+bucket holding the value of rank fraction * count, bounded by the largest value.
+* @param		double -- fraction (e.g. 0.99 for the 99th percentile)
+* @return		boost::uint64_t -- the percentile, or 0 if there is no value
+*******************************************************************************
+*/
+boost::uint64_t LatencyHistogram::getPercentile(double fraction) const
+{
+	boost::uint64_t count = 0;
+	for (int i = 0; i < NUMBER_BUCKETS; i++) {
+		count += counts_[i].load(boost::memory_order_relaxed);
+	}
+	if (count == 0) {
+		return 0;
+	}
+	boost::uint64_t rank = (boost::uint64_t)ceil(fraction * count);
+	if (rank == 0) {
+		rank = 1;
+	}
+	boost::uint64_t cumulativeCount = 0;
+	for (int i = 0; i < NUMBER_BUCKETS; i++) {
+		cumulativeCount += counts_[i].load(boost::memory_order_relaxed);
+		if (cumulativeCount >= rank) {
+			return min(getBucketUpperBound(i), getMax());
+		}
+	}
+	return getMax();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class Metrics.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+Metrics::Metrics() : currentShard_(releaseShard), isStopping_(false)
+{
+	for (int i = 0; i < MAX_GAUGES; i++) {
+		gauges_[i].store(0);
+		isGaugeSet_[i].store(false);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class Metrics.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+Metrics::~Metrics()
+{
+	stop();
+	for (size_t i = 0; i < shards_.size(); i++) {
+		for (int j = 0; j < MAX_HISTOGRAMS; j++) {
+			delete shards_[i]->histograms[j].load();
+		}
+		delete shards_[i];
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the metrics shared by the whole process.
+* @param		none
+* @return		Metrics& -- the metrics, created on the first call
+*******************************************************************************
+*/
+Metrics& Metrics::getShared()
+{
+	static Metrics sharedMetrics;
+	return sharedMetrics;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		These functions return the time of the monotonic clock, which is
+read without a system call and does not jump with the time of day.
+*******************************************************************************
+*/
+boost::uint64_t Metrics::nowNanoseconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (boost::uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+boost::uint64_t Metrics::nowMicroseconds()
+{
+	return nowNanoseconds() / 1000;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the cleanup of boost::thread_specific_ptr. The
+shard is owned by shards_, so that the counts of a thread which has exited are
+still merged.
+* @param		ThreadShard* -- ptrShard (the shard of the exiting thread)
+* @return		void
+*******************************************************************************
+*/
+void Metrics::releaseShard(ThreadShard* /*ptrShard*/)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the shard of the calling thread.
+* @param		none
+* @return		ThreadShard& -- the shard, created and listed on first use
+*******************************************************************************
+*/
+Metrics::ThreadShard& Metrics::getShard()
+{
+	ThreadShard* ptrShard = currentShard_.get();
+	if (ptrShard == NULL) {
+		ptrShard = new ThreadShard;
+		for (int i = 0; i < MAX_HISTOGRAMS; i++) {
+			ptrShard->histograms[i].store(NULL);
+		}
+		for (int i = 0; i < MAX_COUNTERS; i++) {
+			ptrShard->counters[i].store(0);
+		}
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			shards_.push_back(ptrShard);
+		}
+		currentShard_.reset(ptrShard);
+	}
+	return *ptrShard;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function registers the name of a metric. The mutex must be held.
+* @param		vector<string>& -- names (input/output, the names of the metrics of
+one kind, indexed by id)
+* @param		int -- maxNames (the maximum number of metrics of the kind)
+* @param		string -- name (the name of the metric)
+* @param		char* -- kind (the kind, for the error message, e.g. "histograms")
+* @return		int -- the id of the metric, or -1 if there are too many metrics
+*******************************************************************************
+*/
+int Metrics::addName(vector<string>& names, int maxNames, const string& name, const char* kind)
+{
+	for (size_t i = 0; i < names.size(); i++) {
+		if (names[i] == name) {
+			return (int)i;
+		}
+	}
+	if ((int)names.size() >= maxNames) {
+		cerr << "Too many " << kind << ", " << name << " is not recorded" << endl;
+		return -1;
+	}
+	names.push_back(name);
+	return (int)names.size() - 1;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		These functions register a histogram, a counter or a gauge.
+Registering a name again returns its id, so that each user can register what it
+records.
+* @param		string -- name (the name of the metric, with its unit, e.g. fetch_ttfb_us)
+* @return		int -- the id of the metric, or -1 if there are too many metrics
+*******************************************************************************
+*/
+int Metrics::addHistogram(const string& name)
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return addName(histogramNames_, MAX_HISTOGRAMS, name, "histograms");
+}
+
+int Metrics::addCounter(const string& name)
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return addName(counterNames_, MAX_COUNTERS, name, "counters");
+}
+
+int Metrics::addGauge(const string& name)
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return addName(gaugeNames_, MAX_GAUGES, name, "gauges");
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function counts a value in the histogram of the calling thread.
+* @param		int -- histogramID (the id returned by addHistogram())
+* @param		boost::uint64_t -- value (the value, in the unit of the histogram)
+* @return		void
+*******************************************************************************
+*/
+void Metrics::record(int histogramID, boost::uint64_t value)
+{
+	if (histogramID < 0) {
+		return;
+	}
+	ThreadShard& shard = getShard();
+	LatencyHistogram* ptrHistogram = shard.histograms[histogramID].load(boost::memory_order_acquire);
+	if (ptrHistogram == NULL) {
+		ptrHistogram = new LatencyHistogram;
+		shard.histograms[histogramID].store(ptrHistogram, boost::memory_order_release);
+	}
+	ptrHistogram->record(value);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function adds to the counter of the calling thread.
+* @param		int -- counterID (the id returned by addCounter())
+* @param		long -- value (the amount added)
+* @return		void
+*******************************************************************************
+*/
+void Metrics::increment(int counterID, long value)
+{
+	if (counterID < 0) {
+		return;
+	}
+	boost::atomic<long>& counter = getShard().counters[counterID];
+	counter.store(counter.load(boost::memory_order_relaxed) + value, boost::memory_order_relaxed);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function sets a gauge.
+* @param		int -- gaugeID (the id returned by addGauge())
+* @param		long -- value (the value)
+* @return		void
+*******************************************************************************
+*/
+void Metrics::set(int gaugeID, long value)
+{
+	if (gaugeID < 0) {
+		return;
+	}
+	gauges_[gaugeID].store(value, boost::memory_order_relaxed);
+	isGaugeSet_[gaugeID].store(true, boost::memory_order_release);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function sets a gauge the first time only, e.g. the time at
+which a milestone is passed, which later calls must not overwrite.
+* @param		int -- gaugeID (the id returned by addGauge())
+* @param		long -- value (the value)
+* @return		bool -- return true if the gauge is set by this call
+*******************************************************************************
+*/
+bool Metrics::setOnce(int gaugeID, long value)
+{
+	if (gaugeID < 0) {
+		return false;
+	}
+	//the lock makes the test and the set one step; the flag is stored last
+	boost::mutex::scoped_lock lock(mutex_);
+	if (isGaugeSet_[gaugeID].load(boost::memory_order_relaxed)) {
+		return false;
+	}
+	gauges_[gaugeID].store(value, boost::memory_order_relaxed);
+	isGaugeSet_[gaugeID].store(true, boost::memory_order_release);
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function merges the shards of a histogram.
+* @param		int -- histogramID (the id returned by addHistogram())
+* @param		LatencyHistogram& -- histogram (output, an empty histogram)
+* @return		void
+*******************************************************************************
+*/
+void Metrics::merge(int histogramID, LatencyHistogram& histogram) const
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	for (size_t i = 0; i < shards_.size(); i++) {
+		LatencyHistogram* ptrHistogram = shards_[i]->histograms[histogramID].load(boost::memory_order_acquire);
+		if (ptrHistogram != NULL) {
+			histogram.add(*ptrHistogram);
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function sums the shards of a counter.
+* @param		int -- counterID (the id returned by addCounter())
+* @return		long -- the value of the counter
+*******************************************************************************
+*/
+long Metrics::getCounter(int counterID) const
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	long value = 0;
+	for (size_t i = 0; i < shards_.size(); i++) {
+		value += shards_[i]->counters[counterID].load(boost::memory_order_relaxed);
+	}
+	return value;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the value of a gauge.
+* @param		int -- gaugeID (the id returned by addGauge())
+* @param		long& -- value (output, the last value set)
+* @return		bool -- return true if the gauge has been set
+*******************************************************************************
+*/
+bool Metrics::getGauge(int gaugeID, long& value) const
+{
+	if (gaugeID < 0 || !isGaugeSet_[gaugeID].load(boost::memory_order_acquire)) {
+		return false;
+	}
+	value = gauges_[gaugeID].load(boost::memory_order_relaxed);
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function writes the merged metrics in the Prometheus text
+format: a summary (quantiles, sum, count) and a max gauge per histogram, a
+counter per counter, and a gauge per gauge which has been set. The file is
+written under a temporary name and renamed, so that a reader never sees half of
+it.
+* @param		string -- fileName (the file)
+* @return		int -- return 0 if successful, or 1 if the file cannot be written
+*******************************************************************************
+*/
+int Metrics::exportFile(const string& fileName) const
+{
+	vector<string> histogramNames;
+	vector<string> counterNames;
+	vector<string> gaugeNames;
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		histogramNames = histogramNames_;
+		counterNames = counterNames_;
+		gaugeNames = gaugeNames_;
+	}
+	stringstream text;
+	for (size_t i = 0; i < histogramNames.size(); i++) {
+		LatencyHistogram histogram;
+		merge((int)i, histogram);
+		string name = "crawler_" + histogramNames[i];
+		text << "# TYPE " << name << " summary" << endl;
+		for (int j = 0; j < numberExportedQuantiles; j++) {
+			text << name << "{quantile=\"" << exportedQuantiles[j] << "\"} " <<
+				histogram.getPercentile(exportedQuantiles[j]) << endl;
+		}
+		text << name << "_sum " << histogram.getSum() << endl;
+		text << name << "_count " << histogram.getCount() << endl;
+		text << "# TYPE " << name << "_max gauge" << endl;
+		text << name << "_max " << histogram.getMax() << endl;
+	}
+	for (size_t i = 0; i < counterNames.size(); i++) {
+		string name = "crawler_" + counterNames[i];
+		text << "# TYPE " << name << " counter" << endl;
+		text << name << " " << getCounter((int)i) << endl;
+	}
+	for (size_t i = 0; i < gaugeNames.size(); i++) {
+		long value;
+		if (getGauge((int)i, value)) {
+			string name = "crawler_" + gaugeNames[i];
+			text << "# TYPE " << name << " gauge" << endl;
+			text << name << " " << value << endl;
+		}
+	}
+
+	string temporaryName = fileName + ".tmp";
+	ofstream file(temporaryName.c_str());
+	file << text.str();
+	file.close();
+	if (!file || rename(temporaryName.c_str(), fileName.c_str()) != 0) {
+		cerr << "Failed to write the metrics file " << fileName << endl;
+		return 1;
+	}
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function prints one line per histogram (number, mean and
+percentiles), per counter and per gauge which has been set.
+* @param		ostream& -- out (the stream)
+* @return		void
+*******************************************************************************
+*/
+void Metrics::print(ostream& out) const
+{
+	vector<string> histogramNames;
+	vector<string> counterNames;
+	vector<string> gaugeNames;
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		histogramNames = histogramNames_;
+		counterNames = counterNames_;
+		gaugeNames = gaugeNames_;
+	}
+	for (size_t i = 0; i < histogramNames.size(); i++) {
+		LatencyHistogram histogram;
+		merge((int)i, histogram);
+		out << histogramNames[i] << ": " << histogram.getCount() << " values, mean " <<
+			histogram.getMean() << ", p50 " << histogram.getPercentile(0.5) << ", p99 " <<
+			histogram.getPercentile(0.99) << ", max " << histogram.getMax() << endl;
+	}
+	for (size_t i = 0; i < counterNames.size(); i++) {
+		out << counterNames[i] << ": " << getCounter((int)i) << endl;
+	}
+	for (size_t i = 0; i < gaugeNames.size(); i++) {
+		long value;
+		if (getGauge((int)i, value)) {
+			out << gaugeNames[i] << ": " << value << endl;
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function starts the thread exporting the metrics.
+* @param		string -- fileName (the file replaced at each export)
+* @param		int -- intervalSeconds (the time between two exports)
+* @return		void
+*******************************************************************************
+*/
+void Metrics::start(const string& fileName, int intervalSeconds)
+{
+	{
+		boost::mutex::scoped_lock lock(exportMutex_);
+		isStopping_ = false;
+	}
+	exportThread_ = boost::thread(boost::bind(&Metrics::run, this, fileName, intervalSeconds));
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function stops the export thread.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void Metrics::stop()
+{
+	{
+		boost::mutex::scoped_lock lock(exportMutex_);
+		isStopping_ = true;
+	}
+	exportCondition_.notify_all();
+	if (exportThread_.joinable()) {
+		exportThread_.join();
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the body of the export thread.
+* @param		string -- fileName (the file replaced at each export)
+* @param		int -- intervalSeconds (the time between two exports)
+* @return		void
+*******************************************************************************
+*/
+void Metrics::run(const string& fileName, int intervalSeconds)
+{
+	while (true) {
+		{
+			boost::mutex::scoped_lock lock(exportMutex_);
+			boost::system_time deadline = boost::get_system_time() +
+				boost::posix_time::seconds(intervalSeconds);
+			while (!isStopping_) {
+				if (!exportCondition_.timed_wait(lock, deadline)) {
+					break;
+				}
+			}
+			if (isStopping_) {
+				return;
+			}
+		}
+		exportFile(fileName);
+	}
+}
@@ -0,0 +1,188 @@
+/**
+*******************************************************************************
+* @file		Metrics.h
+* @brief	This file provides the interfaces of the classes LatencyHistogram
+and Metrics.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+//boost lib
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/tss.hpp>
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @class		LatencyHistogram
+* @brief 		This class counts values in log-linear buckets, as an HDR
+histogram does: each power of two is split into NUMBER_SUB_BUCKETS buckets, so
+that a percentile is exact to within 1/16 of its value from nanoseconds to hours
+with a fixed array of counters. record() must be called by one thread only; the
+counters are atomic so that another thread can read them while it records.
+*******************************************************************************
+*/
+class LatencyHistogram
+{
+	public:
+		//the number of buckets per power of two
+		static const int SUB_BUCKET_BITS = 4;
+		static const int NUMBER_SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+		//the number of buckets covering the 64-bit values
+		static const int NUMBER_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * NUMBER_SUB_BUCKETS;
+
+	private:
+		//the number of values in each bucket
+		boost::atomic<boost::uint64_t> counts_[NUMBER_BUCKETS];
+		//the number, the sum and the largest of the values
+		boost::atomic<boost::uint64_t> count_;
+		boost::atomic<boost::uint64_t> sum_;
+		boost::atomic<boost::uint64_t> max_;
+
+	public:
+ 		//constructor: no value
+ 		LatencyHistogram();
+ 		//count a value (one writer thread)
+ 		void record(boost::uint64_t value);
+ 		//add the counts of another histogram (one writer thread)
+ 		void add(const LatencyHistogram& other);
+ 		//get the number of values
+ 		boost::uint64_t getCount() const;
+ 		//get the sum of the values
+ 		boost::uint64_t getSum() const;
+ 		//get the largest value
+ 		boost::uint64_t getMax() const;
+ 		//get the mean of the values, or 0 if there is none
+ 		double getMean() const;
+ 		//get the smallest value above the fraction of the values (e.g. 0.99)
+ 		boost::uint64_t getPercentile(double fraction) const;
+ 		//get the bucket of a value
+ 		static int getBucket(boost::uint64_t value);
+ 		//get the largest value of a bucket
+ 		static boost::uint64_t getBucketUpperBound(int bucket);
+
+}; //end of class LatencyHistogram
+
+
+/**
+*******************************************************************************
+* @class		Metrics
+* @brief 		This class collects the counters and the latency histograms of
+the hot paths of the crawler at the cost of a few uncontended memory writes per
+value, and the gauges holding a last value, e.g. the time to a milestone. Each
+thread records into its own shard, so that recording takes no lock and shares
+no cache line with the other threads; the shards are merged only when the
+metrics are read. A metric is registered once by name and then recorded by its
+id. A background thread exports the merged metrics periodically to a file in
+the Prometheus text format, replaced atomically, so that a local scraper or a
+person with cat can follow the crawl without a profiler. The shard of a thread
+outlives the thread, so that its counts are never lost.
+*******************************************************************************
+*/
+class Metrics
+{
+	public:
+		//the maximum numbers of histograms and counters
+		static const int MAX_HISTOGRAMS = 32;
+		static const int MAX_COUNTERS = 32;
+		static const int MAX_GAUGES = 32;
+
+	private:
+		//the metrics recorded by one thread, the histograms created on first use
+		struct ThreadShard
+		{
+			boost::atomic<LatencyHistogram*> histograms[MAX_HISTOGRAMS];
+			boost::atomic<long> counters[MAX_COUNTERS];
+		};
+
+		//mutex protecting the names and the list of shards
+		mutable boost::mutex mutex_;
+		//the names of the registered metrics, indexed by id
+		vector<string> histogramNames_;
+		vector<string> counterNames_;
+		vector<string> gaugeNames_;
+		/*the gauges, shared by the threads since they are seldom set, and whether
+		they have been set: a gauge never set is not exported */
+		boost::atomic<long> gauges_[MAX_GAUGES];
+		boost::atomic<bool> isGaugeSet_[MAX_GAUGES];
+		//the shards of all the threads which have recorded
+		vector<ThreadShard*> shards_;
+		//the shard of the calling thread, owned by shards_
+		boost::thread_specific_ptr<ThreadShard> currentShard_;
+		//mutex and condition on which the export thread waits
+		boost::mutex exportMutex_;
+		boost::condition_variable exportCondition_;
+		//set by stop()
+		bool isStopping_;
+		//the export thread
+		boost::thread exportThread_;
+
+		//get the shard of the calling thread, created on first use
+		ThreadShard& getShard();
+		//register a metric name and return its id, -1 if full (locked)
+		int addName(vector<string>& names, int maxNames, const string& name, const char* kind);
+		//the body of the export thread
+		void run(const string& fileName, int intervalSeconds);
+		//the thread_specific_ptr cleanup: the shard stays in shards_
+		static void releaseShard(ThreadShard* ptrShard);
+
+	public:
+ 		//constructor: no metric
+ 		Metrics();
+ 		//destructor: stops the export thread and frees the shards
+ 		~Metrics();
+ 		//get the metrics shared by the whole process
+ 		static Metrics& getShared();
+ 		//get the time of a monotonic clock, to time the hot paths
+ 		static boost::uint64_t nowMicroseconds();
+ 		static boost::uint64_t nowNanoseconds();
+ 		//register a histogram and return its id (the same id for the same name), -1 if full
+ 		int addHistogram(const string& name);
+ 		//register a counter and return its id (the same id for the same name), -1 if full
+ 		int addCounter(const string& name);
+ 		//count a value in a histogram (ignored if the id is -1)
+ 		void record(int histogramID, boost::uint64_t value);
+ 		//register a gauge and return its id (the same id for the same name), -1 if full
+ 		int addGauge(const string& name);
+ 		//add to a counter (ignored if the id is -1)
+ 		void increment(int counterID, long value = 1);
+ 		//set a gauge (ignored if the id is -1)
+ 		void set(int gaugeID, long value);
+ 		//set a gauge unless it has been set, return true if it is set now
+ 		bool setOnce(int gaugeID, long value);
+ 		//add the shards of a histogram to an empty histogram
+ 		void merge(int histogramID, LatencyHistogram& histogram) const;
+ 		//get the sum of the shards of a counter
+ 		long getCounter(int counterID) const;
+ 		//get the value of a gauge, false if it has not been set
+ 		bool getGauge(int gaugeID, long& value) const;
+ 		//write the merged metrics into a file in the Prometheus text format, return 0 on success
+ 		int exportFile(const string& fileName) const;
+ 		//print one line per metric
+ 		void print(ostream& out) const;
+ 		//start exporting to the file every intervalSeconds seconds
+ 		void start(const string& fileName, int intervalSeconds);
+ 		//stop the export thread
+ 		void stop();
+
+}; //end of class Metrics
+
+} //end of namespace WebDataExtraction
+
+#endif //_METRICS_H_
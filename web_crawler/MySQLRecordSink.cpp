@@ -0,0 +1,555 @@
+/**
+*******************************************************************************
+* @file			MySQLRecordSink.cpp
+* @brief 		This file provides the implementations of the class MySQLRecordSink.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "MySQLRecordSink.h"
+#include "URLFingerprint.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+
+#include <boost/bind.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+using namespace boost::posix_time;
+
+//the number of placeholders of one record in the upsert
+static const size_t kNumberColumns = 7;
+//the number of placeholders allowed in one statement by the server
+static const size_t kMaxPlaceholders = 65535;
+//the time (s) allowed to open the connection
+static const unsigned int kConnectTimeoutSeconds = 5;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function sets the account, the server and the database from
+a location such as crawler:secret@localhost:3306/webdata
+* @param		string -- location (user[:password]@host[:port]/database)
+* @return		bool -- return false if the location is malformed
+*******************************************************************************
+*/
+bool MySQLSinkConfig::parse(const string& location)
+{
+	size_t at = location.rfind('@');
+	size_t slash = location.find('/', at == string::npos ? 0 : at);
+	if (at == string::npos || slash == string::npos) {
+		return false;
+	}
+	string account = location.substr(0, at);
+	size_t colon = account.find(':');
+	user = account.substr(0, colon);
+	password = (colon == string::npos) ? "" : account.substr(colon + 1);
+
+	string server = location.substr(at + 1, slash - at - 1);
+	colon = server.find(':');
+	host = server.substr(0, colon);
+	if (colon != string::npos) {
+		port = (unsigned int)atoi(server.c_str() + colon + 1);
+	}
+	database = location.substr(slash + 1);
+	return user != "" && host != "" && database != "";
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class MySQLRecordSink.
+* @param		MySQLSinkConfig -- config (the connection and the batching limits)
+* @return		None
+*******************************************************************************
+*/
+MySQLRecordSink::MySQLRecordSink(const MySQLSinkConfig& config) : config_(config),
+	isClosing_(false), numberRecordsWritten_(0), numberRecordsFailed_(0), numberBatches_(0),
+	connection_(NULL), batchStatement_(NULL)
+{
+	//one statement may not have more placeholders than the server accepts
+	config_.batchSize = max((size_t)1, min(config_.batchSize, kMaxPlaceholders / kNumberColumns));
+	config_.maxQueuedRecords = max(config_.maxQueuedRecords, config_.batchSize);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class MySQLRecordSink.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+MySQLRecordSink::~MySQLRecordSink()
+{
+	close();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function opens the connection, creates the table if needed,
+migrates a table of an older schema, and prepares the statement of a full batch.
+* @param		none
+* @return		bool -- return true if the connection is ready
+*******************************************************************************
+*/
+bool MySQLRecordSink::connect()
+{
+	connection_ = mysql_init(NULL);
+	if (connection_ == NULL) {
+		cerr << "Failed to create the MySQL connection" << endl;
+		return false;
+	}
+	mysql_options(connection_, MYSQL_OPT_CONNECT_TIMEOUT, &kConnectTimeoutSeconds);
+	mysql_options(connection_, MYSQL_SET_CHARSET_NAME, "utf8mb4");
+	if (mysql_real_connect(connection_, config_.host.c_str(), config_.user.c_str(),
+			config_.password.c_str(), config_.database.c_str(), config_.port, NULL, 0) == NULL) {
+		cerr << "Failed to connect to MySQL " << config_.user << "@" << config_.host << ":" <<
+			config_.port << "/" << config_.database << ": " << mysql_error(connection_) << endl;
+		disconnect();
+		return false;
+	}
+
+	string createTable = "CREATE TABLE IF NOT EXISTS `" + config_.table + "` ("
+		"product_id BIGINT NOT NULL, "
+		"description_hash BIGINT UNSIGNED NOT NULL, "
+		"category VARCHAR(255) NOT NULL, "
+		"description TEXT NOT NULL, "
+		"image_link VARCHAR(1024) NOT NULL, "
+		"original_price_cents BIGINT NOT NULL, "
+		"current_price_cents BIGINT NOT NULL, "
+		"updated_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP, "
+		"PRIMARY KEY (product_id, description_hash)"
+		") ENGINE=InnoDB DEFAULT CHARSET=utf8mb4";
+	if (mysql_query(connection_, createTable.c_str()) != 0) {
+		cerr << "Failed to create the table " << config_.table << ": " <<
+			mysql_error(connection_) << endl;
+		disconnect();
+		return false;
+	}
+	if (!migrateTable()) {
+		disconnect();
+		return false;
+	}
+
+	batchStatement_ = prepare(config_.batchSize);
+	if (batchStatement_ == NULL) {
+		disconnect();
+		return false;
+	}
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function migrates a table created when the prices were FLOAT
+columns: original_price and current_price are replaced by original_price_cents
+and current_price_cents, filled with the prices rounded to the cent. The
+statements are not one transaction, but each is run again on the next connection
+if the migration was interrupted before the old columns were dropped.
+* @param		none
+* @return		bool -- return true if the table has the price columns in cents
+*******************************************************************************
+*/
+bool MySQLRecordSink::migrateTable()
+{
+	//the columns of the table
+	vector<char> escapedTable(config_.table.size() * 2 + 1);
+	mysql_real_escape_string(connection_, &escapedTable[0], config_.table.c_str(),
+		config_.table.size());
+	string selectColumns = string("SELECT COLUMN_NAME FROM information_schema.COLUMNS "
+		"WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = '") + &escapedTable[0] + "'";
+	MYSQL_RES* result = NULL;
+	if (mysql_query(connection_, selectColumns.c_str()) != 0 ||
+			(result = mysql_store_result(connection_)) == NULL) {
+		cerr << "Failed to read the columns of the table " << config_.table << ": " <<
+			mysql_error(connection_) << endl;
+		return false;
+	}
+	set<string> columnSet;
+	MYSQL_ROW row;
+	while ((row = mysql_fetch_row(result)) != NULL) {
+		if (row[0] != NULL) {
+			columnSet.insert(boost::algorithm::to_lower_copy(string(row[0])));
+		}
+	}
+	mysql_free_result(result);
+
+	bool hasCents = (columnSet.count("original_price_cents") > 0 &&
+		columnSet.count("current_price_cents") > 0);
+	bool hasFloatPrices = (columnSet.count("original_price") > 0 &&
+		columnSet.count("current_price") > 0);
+	if (!hasFloatPrices) {
+		if (!hasCents) {
+			cerr << "The table " << config_.table << " has no original_price_cents and " <<
+				"current_price_cents columns; drop it or add them" << endl;
+		}
+		return hasCents;
+	}
+
+	cout << "Migrating the table " << config_.table << " to prices in cents" << endl;
+	string table = "`" + config_.table + "`";
+	vector<string> statementVector;
+	if (!hasCents) {
+		statementVector.push_back("ALTER TABLE " + table + " "
+			"ADD COLUMN original_price_cents BIGINT NOT NULL DEFAULT 0, "
+			"ADD COLUMN current_price_cents BIGINT NOT NULL DEFAULT 0");
+	}
+	statementVector.push_back("UPDATE " + table + " SET "
+		"original_price_cents = ROUND(original_price * 100), "
+		"current_price_cents = ROUND(current_price * 100)");
+	statementVector.push_back("ALTER TABLE " + table + " "
+		"DROP COLUMN original_price, DROP COLUMN current_price, "
+		"ALTER COLUMN original_price_cents DROP DEFAULT, "
+		"ALTER COLUMN current_price_cents DROP DEFAULT");
+	for (size_t i = 0; i < statementVector.size(); i++) {
+		if (mysql_query(connection_, statementVector[i].c_str()) != 0) {
+			cerr << "Failed to migrate the table " << config_.table << " to prices in cents: " <<
+				mysql_error(connection_) << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function closes the batch statement and the connection.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void MySQLRecordSink::disconnect()
+{
+	if (batchStatement_ != NULL) {
+		mysql_stmt_close(batchStatement_);
+		batchStatement_ = NULL;
+	}
+	if (connection_ != NULL) {
+		mysql_close(connection_);
+		connection_ = NULL;
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function prepares the upsert of a number of records: one
+INSERT ... VALUES (...), (...) ON DUPLICATE KEY UPDATE statement.
+* @param		size_t -- numberRows (the number of records of the statement)
+* @return		MYSQL_STMT* -- the prepared statement, or NULL if it fails
+*******************************************************************************
+*/
+MYSQL_STMT* MySQLRecordSink::prepare(size_t numberRows)
+{
+	string sql = "INSERT INTO `" + config_.table + "` (product_id, description_hash, "
+		"category, description, image_link, original_price_cents, current_price_cents) VALUES ";
+	sql.reserve(sql.size() + numberRows * 16 + 256);
+	for (size_t i = 0; i < numberRows; i++) {
+		sql += (i == 0) ? "(?,?,?,?,?,?,?)" : ",(?,?,?,?,?,?,?)";
+	}
+	sql += " ON DUPLICATE KEY UPDATE category = VALUES(category), "
+		"image_link = VALUES(image_link), original_price_cents = VALUES(original_price_cents), "
+		"current_price_cents = VALUES(current_price_cents)";
+
+	MYSQL_STMT* statement = mysql_stmt_init(connection_);
+	if (statement == NULL) {
+		cerr << "Failed to create a MySQL statement: " << mysql_error(connection_) << endl;
+		return NULL;
+	}
+	if (mysql_stmt_prepare(statement, sql.c_str(), sql.size()) != 0) {
+		cerr << "Failed to prepare the upsert of " << numberRows << " records: " <<
+			mysql_stmt_error(statement) << endl;
+		mysql_stmt_close(statement);
+		return NULL;
+	}
+	return statement;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function binds the fields of the records to the placeholders
+of a prepared upsert and executes it. The ids, the prices and the strings are
+bound in place, from the columns of the records.
+* @param		MYSQL_STMT* -- statement (prepared for records.size() records)
+* @param		RecordBatchView -- records (the records)
+* @return		bool -- return true if the records have been written
+*******************************************************************************
+*/
+bool MySQLRecordSink::execute(MYSQL_STMT* statement, const RecordBatchView& records)
+{
+	//the bound values must live until the statement has been executed
+	size_t numberRows = records.size();
+	vector<MYSQL_BIND> binds(numberRows * kNumberColumns);
+	vector<unsigned long long> descriptionHashes(numberRows);
+	vector<unsigned long> lengths(numberRows * NUMBER_STRING_COLUMNS);
+	for (size_t i = 0; i < numberRows; i++) {
+		MYSQL_BIND* bind = &binds[i * kNumberColumns];
+		boost::string_view description = records.getDescription(i);
+		descriptionHashes[i] = fingerprintBytes(description.data(), description.size());
+
+		bind[0].buffer_type = MYSQL_TYPE_LONGLONG;
+		bind[0].buffer = const_cast<boost::int64_t*>(records.getProductIDColumn() + i);
+		bind[1].buffer_type = MYSQL_TYPE_LONGLONG;
+		bind[1].buffer = &descriptionHashes[i];
+		bind[1].is_unsigned = 1;
+		for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+			boost::string_view value = records.getString((RecordStringColumn)column, i);
+			lengths[i * NUMBER_STRING_COLUMNS + column] = value.size();
+			bind[2 + column].buffer_type = MYSQL_TYPE_STRING;
+			bind[2 + column].buffer = const_cast<char*>(value.data());
+			bind[2 + column].buffer_length = value.size();
+			bind[2 + column].length = &lengths[i * NUMBER_STRING_COLUMNS + column];
+		}
+		bind[5].buffer_type = MYSQL_TYPE_LONGLONG;
+		bind[5].buffer = const_cast<boost::int64_t*>(records.getOriginalPriceColumn() + i);
+		bind[6].buffer_type = MYSQL_TYPE_LONGLONG;
+		bind[6].buffer = const_cast<boost::int64_t*>(records.getCurrentPriceColumn() + i);
+	}
+
+	if (mysql_stmt_bind_param(statement, &binds[0]) != 0 || mysql_stmt_execute(statement) != 0) {
+		cerr << "Failed to write " << numberRows << " records: " << mysql_stmt_error(statement) << endl;
+		return false;
+	}
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function writes records in statements of batchSize records;
+only the last statement may be smaller. If a statement fails because the
+connection is lost, the connection is opened again and the statement retried
+once; records rejected by the server are counted and dropped.
+* @param		RecordBatchView -- records (the records taken off the queue)
+* @return		void
+*******************************************************************************
+*/
+void MySQLRecordSink::writeRecords(const RecordBatchView& records)
+{
+	for (size_t begin = 0; begin < records.size(); begin += config_.batchSize) {
+		size_t numberRows = min(config_.batchSize, records.size() - begin);
+		bool isWritten = false;
+		for (int attempt = 0; attempt < 2 && !isWritten; attempt++) {
+			if (connection_ == NULL && !connect()) {
+				continue;
+			}
+			MYSQL_STMT* statement = (numberRows == config_.batchSize) ? batchStatement_ :
+				prepare(numberRows);
+			if (statement != NULL) {
+				isWritten = execute(statement, records.slice(begin, begin + numberRows));
+				if (statement != batchStatement_) {
+					mysql_stmt_close(statement);
+				}
+			}
+			//a statement which failed on a live connection would fail again
+			if (!isWritten && mysql_ping(connection_) == 0) {
+				break;
+			}
+			if (!isWritten) {
+				disconnect();
+			}
+		}
+
+		boost::mutex::scoped_lock lock(mutex_);
+		if (isWritten) {
+			numberRecordsWritten_ += numberRows;
+			numberBatches_++;
+		}
+		else {
+			numberRecordsFailed_ += numberRows;
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function connects to the database and starts the writer
+thread, so that a wrong account or server is reported before the crawl starts.
+* @param		none
+* @return		int -- return 0 if the sink is ready, and 1 if it fails.
+*******************************************************************************
+*/
+int MySQLRecordSink::open()
+{
+	if (!connect()) {
+		return 1;
+	}
+	thread_ = boost::thread(boost::bind(&MySQLRecordSink::run, this));
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function queues records for the writer thread. It blocks
+while maxQueuedRecords records are waiting, so a slow database slows the
+extraction down instead of filling the memory.
+* @param		RecordBatchView -- records (the records of a page)
+* @param		bool -- isBlocking (false to queue the records even above the
+limit, for a caller which must not block, e.g. a worker of an executor)
+* @return		void
+*******************************************************************************
+*/
+void MySQLRecordSink::submit(const RecordBatchView& records, bool isBlocking)
+{
+	if (records.empty()) {
+		return;
+	}
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		while (isBlocking && recordQueue_.size() >= config_.maxQueuedRecords && !isClosing_) {
+			spaceCondition_.wait(lock);
+		}
+		//no writer is left to take them
+		if (isClosing_) {
+			numberRecordsFailed_ += records.size();
+			return;
+		}
+		recordQueue_.append(records);
+	}
+	queueCondition_.notify_one();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function blocks while maxQueuedRecords records are waiting
+for the writer. A producer calls it before handing work over to the callers of
+submit() which must not block.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void MySQLRecordSink::waitForSpace()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	while (recordQueue_.size() >= config_.maxQueuedRecords && !isClosing_) {
+		spaceCondition_.wait(lock);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the body of the writer thread. Once a record is
+queued, it waits until a batch is full or flushIntervalMs has passed, then takes
+the full batches (or everything on a timeout or close) and writes them.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void MySQLRecordSink::run()
+{
+	mysql_thread_init();
+	while (true) {
+		RecordBatch records;
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			while (recordQueue_.empty() && !isClosing_) {
+				queueCondition_.wait(lock);
+			}
+			if (recordQueue_.empty() && isClosing_) {
+				break;
+			}
+			ptime deadline = microsec_clock::universal_time() + milliseconds(config_.flushIntervalMs);
+			bool isTimedOut = false;
+			while (recordQueue_.size() < config_.batchSize && !isClosing_ && !isTimedOut) {
+				isTimedOut = !queueCondition_.timed_wait(lock, deadline);
+			}
+			//leave a partial batch to be filled up unless it has waited long enough
+			size_t numberTaken = recordQueue_.size();
+			if (!isTimedOut && !isClosing_) {
+				numberTaken -= numberTaken % config_.batchSize;
+			}
+			if (numberTaken == recordQueue_.size()) {
+				records.swap(recordQueue_);
+			}
+			else {
+				records.append(recordQueue_.view().slice(0, numberTaken));
+				recordQueue_.eraseFront(numberTaken);
+			}
+		}
+		spaceCondition_.notify_all();
+		writeRecords(records.view());
+	}
+	disconnect();
+	mysql_thread_end();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function writes the queued records, stops the writer thread
+and closes the connection.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void MySQLRecordSink::close()
+{
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		isClosing_ = true;
+	}
+	queueCondition_.notify_all();
+	spaceCondition_.notify_all();
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+	disconnect();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		These functions return the numbers of records written and lost,
+and of statements executed.
+* @param		none
+* @return		long -- the number of records or statements
+*******************************************************************************
+*/
+long MySQLRecordSink::getNumberRecordsWritten()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return numberRecordsWritten_;
+}
+
+long MySQLRecordSink::getNumberRecordsFailed()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return numberRecordsFailed_;
+}
+
+long MySQLRecordSink::getNumberBatches()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return numberBatches_;
+}
@@ -0,0 +1,147 @@
+/**
+*******************************************************************************
+* @file		MySQLRecordSink.h
+* @brief	This file provides the interfaces of the class MySQLRecordSink.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _MYSQLRECORDSINK_H_
+#define _MYSQLRECORDSINK_H_
+
+#include <string>
+#include <vector>
+
+//boost lib
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+//mysqlclient lib
+#include <mysql.h>
+
+#include "RecordBatch.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @struct		MySQLSinkConfig
+* @brief 		This structure holds the connection and the batching limits of
+the sink.
+*******************************************************************************
+*/
+struct MySQLSinkConfig
+{
+	//the server and the account
+	string host;
+	unsigned int port;
+	string user;
+	string password;
+	string database;
+	//the table of the records, created if it does not exist
+	string table;
+	//the number of records inserted by one statement
+	size_t batchSize;
+	//the time (ms) a record may wait for its batch to fill up
+	long flushIntervalMs;
+	//the number of records waiting for the writer before submit() and waitForSpace() block
+	size_t maxQueuedRecords;
+
+	//constructor with the default limits
+	MySQLSinkConfig() : host("localhost"), port(3306), user("root"), password(""),
+		database("webdata"), table("products"), batchSize(500), flushIntervalMs(1000),
+		maxQueuedRecords(20000) {}
+	//set the account and the server from user[:password]@host[:port]/database
+	bool parse(const string& location);
+};
+
+
+/**
+*******************************************************************************
+* @class		MySQLRecordSink
+* @brief 		This class writes the extracted product records into MySQL
+or MariaDB on a dedicated connection thread. The records are inserted in batches
+of batchSize rows by one prepared multi-row statement; a record waits at most
+flushIntervalMs for its batch to fill up. The statement is an upsert keyed by
+the product id and a hash of the description, so that a re-crawl updates the
+prices instead of adding rows. submit() blocks while maxQueuedRecords records
+are waiting, so a database which falls behind slows the extraction down instead
+of filling the memory. A caller which must not block, such as a task of an
+executor, submits without waiting and leaves the wait to its producer with
+waitForSpace(); the queue then exceeds the limit by the records of the pages
+already past that producer. A lost connection is opened again and the batch retried
+once.
+*******************************************************************************
+*/
+class MySQLRecordSink
+{
+	private:
+		//the connection and the batching limits
+		MySQLSinkConfig config_;
+
+		//mutex protecting the members below
+		boost::mutex mutex_;
+		//signalled when records are queued or the sink is closed
+		boost::condition_variable queueCondition_;
+		//signalled when the writer has taken records off the queue
+		boost::condition_variable spaceCondition_;
+		//the records waiting to be written
+		RecordBatch recordQueue_;
+		//set by close()
+		bool isClosing_;
+		//the numbers of records written and lost, and of statements executed
+		long numberRecordsWritten_;
+		long numberRecordsFailed_;
+		long numberBatches_;
+
+		//the connection and the statement of a full batch (owned by the writer thread)
+		MYSQL* connection_;
+		MYSQL_STMT* batchStatement_;
+		//the writer thread
+		boost::thread thread_;
+
+		//the body of the writer thread
+		void run();
+		//open the connection, create the table and prepare the batch statement
+		bool connect();
+		//replace the price columns of a table created before the prices in cents
+		bool migrateTable();
+		//close the batch statement and the connection
+		void disconnect();
+		//prepare the upsert of numberRows records
+		MYSQL_STMT* prepare(size_t numberRows);
+		//bind and execute the upsert of the records, return true on success
+		bool execute(MYSQL_STMT* statement, const RecordBatchView& records);
+		//write the records in batches, opening the connection again if it is lost
+		void writeRecords(const RecordBatchView& records);
+
+	public:
+ 		//constructor
+ 		MySQLRecordSink(const MySQLSinkConfig& config);
+ 		//destructor: writes the queued records and closes the connection
+ 		~MySQLRecordSink();
+ 		//connect, create the table and start the writer, return 0 on success
+ 		int open();
+ 		//queue records for writing (blocks while the queue is full, unless isBlocking is false)
+ 		void submit(const RecordBatchView& records, bool isBlocking = true);
+ 		//wait while the queue is full
+ 		void waitForSpace();
+ 		//write the queued records and stop the writer thread
+ 		void close();
+ 		//get the number of records written
+ 		long getNumberRecordsWritten();
+ 		//get the number of records which could not be written
+ 		long getNumberRecordsFailed();
+ 		//get the number of statements executed
+ 		long getNumberBatches();
+
+}; //end of class MySQLRecordSink
+
+} //end of namespace WebDataExtraction
+
+#endif //_MYSQLRECORDSINK_H_
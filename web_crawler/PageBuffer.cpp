@@ -0,0 +1,214 @@
+/**
+*******************************************************************************
+* @file			PageBuffer.cpp
+* @brief 		This file provides the implementations of the class PageBuffer.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "PageBuffer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+//the copy counters
+boost::atomic<long> PageBuffer::numberCopies_(0);
+boost::atomic<long> PageBuffer::numberBytesCopied_(0);
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class PageBuffer.
+* @param		size_t -- capacity (the number of bytes to allocate up front)
+* @return		None
+*******************************************************************************
+*/
+PageBuffer::PageBuffer(size_t capacity) : data_(NULL), size_(0), capacity_(0)
+{
+	reserve(capacity);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class PageBuffer.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+PageBuffer::~PageBuffer()
+{
+	free(data_);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function appends bytes to the page. The capacity is doubled
+when it is exceeded.
+* @param		char* -- data (the bytes received)
+* @param		size_t -- length (the number of bytes received)
+* @return		void
+*******************************************************************************
+*/
+void PageBuffer::append(const char* data, size_t length)
+{
+	if (size_ + length > capacity_) {
+		size_t capacity = (capacity_ == 0) ? 16384 : capacity_;
+		while (capacity < size_ + length) {
+			capacity *= 2;
+		}
+		reserve(capacity);
+	}
+	memcpy(data_ + size_, data, length);
+	size_ += length;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function allocates room for at least capacity bytes. If the
+buffer moves, the bytes moved are counted as a copy.
+* @param		size_t -- capacity (the number of bytes)
+* @return		void
+*******************************************************************************
+*/
+void PageBuffer::reserve(size_t capacity)
+{
+	if (capacity <= capacity_) {
+		return;
+	}
+	char* oldData = data_;
+	char* newData = static_cast<char*>(realloc(data_, capacity));
+	if (newData == NULL) {
+		throw std::bad_alloc();
+	}
+	if (oldData != NULL && newData != oldData && size_ > 0) {
+		recordCopy(size_);
+	}
+	data_ = newData;
+	capacity_ = capacity;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function forgets the content but keeps the allocated memory.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void PageBuffer::clear()
+{
+	size_ = 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the bytes of the page.
+* @param		none
+* @return		char* -- the first byte (not NUL-terminated)
+*******************************************************************************
+*/
+const char* PageBuffer::data() const
+{
+	return data_;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the size of the page.
+* @param		none
+* @return		size_t -- the number of bytes written
+*******************************************************************************
+*/
+size_t PageBuffer::size() const
+{
+	return size_;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the capacity of the buffer.
+* @param		none
+* @return		size_t -- the number of bytes allocated
+*******************************************************************************
+*/
+size_t PageBuffer::capacity() const
+{
+	return capacity_;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the page as a string_view.
+* @param		none
+* @return		boost::string_view -- the view of the page bytes
+*******************************************************************************
+*/
+boost::string_view PageBuffer::view() const
+{
+	return boost::string_view(data_ ? data_ : "", size_);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function records a copy of page bytes.
+* @param		size_t -- length (the number of bytes copied)
+* @return		void
+*******************************************************************************
+*/
+void PageBuffer::recordCopy(size_t length)
+{
+	numberCopies_.fetch_add(1, boost::memory_order_relaxed);
+	numberBytesCopied_.fetch_add((long)length, boost::memory_order_relaxed);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of copies of page bytes.
+* @param		none
+* @return		long -- the number of copies made in the process
+*******************************************************************************
+*/
+long PageBuffer::getNumberCopies()
+{
+	return numberCopies_.load(boost::memory_order_relaxed);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of page bytes copied.
+* @param		none
+* @return		long -- the number of bytes copied in the process
+*******************************************************************************
+*/
+long PageBuffer::getNumberBytesCopied()
+{
+	return numberBytesCopied_.load(boost::memory_order_relaxed);
+}
@@ -0,0 +1,81 @@
+/**
+*******************************************************************************
+* @file		PageBuffer.h
+* @brief	This file provides the interfaces of the class PageBuffer.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _PAGEBUFFER_H_
+#define _PAGEBUFFER_H_
+
+#include <cstddef>
+
+//boost lib
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/utility/string_view.hpp>
+
+namespace WebDataExtraction
+{
+
+
+/**
+*******************************************************************************
+* @class		PageBuffer
+* @brief 		This class holds the bytes of one downloaded page. The fetcher
+writes it once; afterwards it is shared read-only (through
+boost::shared_ptr<const PageBuffer>) by the disk writer, the link extractor and
+the info extractor, so the page is never copied between stages. It is binary
+safe: embedded NUL bytes are kept. The class counts every copy of page bytes
+(growing the buffer, and the copies made outside the class, reported with
+recordCopy()) in process-wide counters.
+*******************************************************************************
+*/
+class PageBuffer : private boost::noncopyable
+{
+	private:
+		//the bytes of the page
+		char* data_;
+		//the number of bytes written
+		size_t size_;
+		//the number of bytes allocated
+		size_t capacity_;
+
+		//the number of copies of page bytes made in the process
+		static boost::atomic<long> numberCopies_;
+		//the number of page bytes copied in the process
+		static boost::atomic<long> numberBytesCopied_;
+
+	public:
+ 		//constructor
+ 		PageBuffer(size_t capacity = 0);
+ 		//destructor
+ 		~PageBuffer();
+ 		//append bytes received from the network
+ 		void append(const char* data, size_t length);
+ 		//allocate room for at least capacity bytes (e.g. the Content-Length)
+ 		void reserve(size_t capacity);
+ 		//forget the content but keep the allocated memory
+ 		void clear();
+ 		//get the bytes of the page
+ 		const char* data() const;
+ 		//get the number of bytes of the page
+ 		size_t size() const;
+ 		//get the number of bytes allocated
+ 		size_t capacity() const;
+ 		//get the page as a string_view
+ 		boost::string_view view() const;
+ 		//record a copy of page bytes made outside this class
+ 		static void recordCopy(size_t length);
+ 		//get the number of copies of page bytes made in the process
+ 		static long getNumberCopies();
+ 		//get the number of page bytes copied in the process
+ 		static long getNumberBytesCopied();
+
+}; //end of class PageBuffer
+
+} //end of namespace WebDataExtraction
+
+#endif //_PAGEBUFFER_H_
@@ -0,0 +1,195 @@
+/**
+*******************************************************************************
+* @file			PagePool.cpp
+* @brief 		This file provides the implementations of the class PagePool.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "PagePool.h"
+
+#include <boost/bind.hpp>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class PagePool.
+* @param		size_t -- maxPagesPerThread (the pages kept per worker thread)
+* @param		size_t -- maxBuffers (the buffers kept in the shared free list)
+* @param		size_t -- maxBufferCapacity (the largest buffer kept for reuse)
+* @return		None
+*******************************************************************************
+*/
+PagePool::PagePool(size_t maxPagesPerThread, size_t maxBuffers, size_t maxBufferCapacity) :
+	maxPagesPerThread_(maxPagesPerThread), maxBufferCapacity_(maxBufferCapacity),
+	freePages_(deletePages), freeBuffers_(maxBuffers), numberPageHits_(0),
+	numberPageMisses_(0), numberBufferHits_(0), numberBufferMisses_(0)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class PagePool.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+PagePool::~PagePool()
+{
+	PageBuffer* ptrBuffer;
+	while (freeBuffers_.pop(ptrBuffer)) {
+		delete ptrBuffer;
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function deletes the pages of a thread's free list. It is
+called by boost::thread_specific_ptr when the thread exits.
+* @param		vector<HTMLPage*>* -- ptrPages (the free list)
+* @return		void
+*******************************************************************************
+*/
+void PagePool::deletePages(vector<HTMLPage*>* ptrPages)
+{
+	for (size_t i = 0; i < ptrPages->size(); i++) {
+		delete (*ptrPages)[i];
+	}
+	delete ptrPages;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function gets a page from the free list of the calling thread,
+or allocates one if the list is empty.
+* @param		string -- url (the URL of the html page)
+* @return		boost::shared_ptr<HTMLPage> -- the page, which goes back to the free
+list of the releasing thread when the last reference is dropped
+*******************************************************************************
+*/
+boost::shared_ptr<HTMLPage> PagePool::acquirePage(const string& url)
+{
+	vector<HTMLPage*>* ptrPages = freePages_.get();
+	HTMLPage* ptrPage;
+	if (ptrPages != NULL && !ptrPages->empty()) {
+		ptrPage = ptrPages->back();
+		ptrPages->pop_back();
+		ptrPage->reset(url);
+		numberPageHits_++;
+	}
+	else {
+		ptrPage = new HTMLPage(url);
+		numberPageMisses_++;
+	}
+	return boost::shared_ptr<HTMLPage>(ptrPage, boost::bind(&PagePool::releasePage, this, _1));
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns a page to the free list of the calling thread.
+* @param		HTMLPage* -- ptrPage (the released page)
+* @return		void
+*******************************************************************************
+*/
+void PagePool::releasePage(HTMLPage* ptrPage)
+{
+	vector<HTMLPage*>* ptrPages = freePages_.get();
+	if (ptrPages == NULL) {
+		ptrPages = new vector<HTMLPage*>;
+		ptrPages->reserve(maxPagesPerThread_);
+		freePages_.reset(ptrPages);
+	}
+	if (ptrPages->size() < maxPagesPerThread_) {
+		//drop the references to the buffers now, not when the page is reused
+		ptrPage->reset("");
+		ptrPages->push_back(ptrPage);
+	}
+	else {
+		delete ptrPage;
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function gets an empty buffer from the shared free list, or
+allocates one if the list is empty.
+* @param		none
+* @return		boost::shared_ptr<PageBuffer> -- the buffer, which goes back to the
+free list when the last reference is dropped
+*******************************************************************************
+*/
+boost::shared_ptr<PageBuffer> PagePool::acquireBuffer()
+{
+	PageBuffer* ptrBuffer;
+	if (freeBuffers_.pop(ptrBuffer)) {
+		numberBufferHits_++;
+	}
+	else {
+		ptrBuffer = new PageBuffer;
+		numberBufferMisses_++;
+	}
+	return boost::shared_ptr<PageBuffer>(ptrBuffer, boost::bind(&PagePool::releaseBuffer, this, _1));
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns a buffer to the shared free list. Buffers
+above maxBufferCapacity_, or beyond the capacity of the list, are freed.
+* @param		PageBuffer* -- ptrBuffer (the released buffer)
+* @return		void
+*******************************************************************************
+*/
+void PagePool::releaseBuffer(PageBuffer* ptrBuffer)
+{
+	ptrBuffer->clear();
+	if (ptrBuffer->capacity() > maxBufferCapacity_ || !freeBuffers_.bounded_push(ptrBuffer)) {
+		delete ptrBuffer;
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		These functions return the pool statistics.
+* @param		none
+* @return		long -- the number of objects reused or newly allocated
+*******************************************************************************
+*/
+long PagePool::getNumberPageHits() const
+{
+	return numberPageHits_;
+}
+
+long PagePool::getNumberPageMisses() const
+{
+	return numberPageMisses_;
+}
+
+long PagePool::getNumberBufferHits() const
+{
+	return numberBufferHits_;
+}
+
+long PagePool::getNumberBufferMisses() const
+{
+	return numberBufferMisses_;
+}
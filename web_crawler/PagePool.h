@@ -0,0 +1,87 @@
+/**
+*******************************************************************************
+* @file		PagePool.h
+* @brief	This file provides the interfaces of the class PagePool.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _PAGEPOOL_H_
+#define _PAGEPOOL_H_
+
+#include <string>
+#include <vector>
+
+//boost lib
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/lockfree/stack.hpp>
+#include <boost/atomic.hpp>
+
+#include "HTMLPage.h"
+#include "PageBuffer.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+
+/**
+*******************************************************************************
+* @class		PagePool
+* @brief 		This class recycles the HTMLPage objects and the page buffers, so
+that a page does not cost a round of allocations and frees. Pages are acquired
+and released by the same parsing task, so each worker thread keeps its own free
+list of pages. Buffers are filled on a fetch thread and released on a parsing
+thread, so they go through one shared lock-free stack. Both keep their capacity
+between pages. The pool must outlive every object it has handed out.
+*******************************************************************************
+*/
+class PagePool
+{
+	private:
+		//the maximum number of pages kept per worker thread
+		size_t maxPagesPerThread_;
+		//the largest buffer kept for reuse; larger ones are freed
+		size_t maxBufferCapacity_;
+		//the free list of pages of each worker thread
+		boost::thread_specific_ptr< vector<HTMLPage*> > freePages_;
+		//the free buffers of all threads
+		boost::lockfree::stack<PageBuffer*> freeBuffers_;
+		//the number of objects served from the free lists, and newly allocated
+		boost::atomic<long> numberPageHits_;
+		boost::atomic<long> numberPageMisses_;
+		boost::atomic<long> numberBufferHits_;
+		boost::atomic<long> numberBufferMisses_;
+
+		//return a page to the free list of the calling thread
+		void releasePage(HTMLPage* ptrPage);
+		//return a buffer to the shared free list
+		void releaseBuffer(PageBuffer* ptrBuffer);
+		//delete the pages left in the free list of an exiting thread
+		static void deletePages(vector<HTMLPage*>* ptrPages);
+
+	public:
+ 		//constructor
+ 		PagePool(size_t maxPagesPerThread = 64, size_t maxBuffers = 1024,
+ 			size_t maxBufferCapacity = 4 * 1024 * 1024);
+ 		//destructor: frees the buffers in the free list
+ 		~PagePool();
+ 		//get a page reset to the URL; it returns to the pool when released
+ 		boost::shared_ptr<HTMLPage> acquirePage(const string& url);
+ 		//get an empty buffer; it returns to the pool when released
+ 		boost::shared_ptr<PageBuffer> acquireBuffer();
+ 		//get the number of pages reused and allocated
+ 		long getNumberPageHits() const;
+ 		long getNumberPageMisses() const;
+ 		//get the number of buffers reused and allocated
+ 		long getNumberBufferHits() const;
+ 		long getNumberBufferMisses() const;
+
+}; //end of class PagePool
+
+} //end of namespace WebDataExtraction
+
+#endif //_PAGEPOOL_H_
@@ -0,0 +1,171 @@
+/**
+*******************************************************************************
+* @file		PageRecordFormat.h
+* @brief	This file provides the record layout of the PageStore segment files,
+shared by the PageStore and the readers of its segments (the benchmarks and the
+BatchExtractor of information_extraction). It only needs boost and zlib.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _PAGERECORDFORMAT_H_
+#define _PAGERECORDFORMAT_H_
+
+#include <cstring>
+#include <ctime>
+#include <string>
+
+//boost lib
+#include <boost/cstdint.hpp>
+
+//zlib to decompress the pages
+#include <zlib.h>
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+//the first bytes of every record
+const boost::uint32_t kPageRecordMagic = 0x52584457; //"WDXR"
+//the size of the fixed part of a record
+const size_t kPageRecordHeaderSize = 6 * sizeof(boost::uint32_t) + sizeof(boost::int64_t);
+
+
+/**
+*******************************************************************************
+* @struct		PageRecord
+* @brief 		This structure holds one stored page with its fetch metadata.
+*******************************************************************************
+*/
+struct PageRecord
+{
+	//the URL of the page
+	string url;
+	//the http status returned by the HTTP server
+	long httpStatus;
+	//the time the page was fetched (seconds since the epoch)
+	time_t fetchTime;
+	//the response headers
+	string headers;
+	//the uncompressed page
+	string body;
+};
+
+
+/**
+*******************************************************************************
+* @struct		PageRecordHeader
+* @brief 		This structure is the fixed part of a record. Layout (integers
+little-endian): u32 magic 'WDXR', u32 url length, u32 headers length, u32
+compressed length, u32 page length, u32 http status, i64 fetch time, followed by
+the url, the headers and the compressed page.
+*******************************************************************************
+*/
+struct PageRecordHeader
+{
+	boost::uint32_t urlLength;
+	boost::uint32_t headersLength;
+	boost::uint32_t compressedLength;
+	boost::uint32_t pageLength;
+	boost::uint32_t httpStatus;
+	boost::int64_t fetchTime;
+
+	//get the size of the whole record
+	boost::uint64_t getRecordLength() const
+	{
+		return kPageRecordHeaderSize + (boost::uint64_t)urlLength + headersLength + compressedLength;
+	}
+};
+
+
+
+/**
+*******************************************************************************
+* @brief		This function appends the fixed part of a record to a byte string.
+* @param		PageRecordHeader -- header (the lengths, status and fetch time)
+* @param		string& -- bytes (output, the header is appended)
+* @return		void
+*******************************************************************************
+*/
+inline void encodePageRecordHeader(const PageRecordHeader& header, string& bytes)
+{
+	char fixed[kPageRecordHeaderSize];
+	memcpy(fixed, &kPageRecordMagic, 4);
+	memcpy(fixed + 4, &header.urlLength, 4);
+	memcpy(fixed + 8, &header.headersLength, 4);
+	memcpy(fixed + 12, &header.compressedLength, 4);
+	memcpy(fixed + 16, &header.pageLength, 4);
+	memcpy(fixed + 20, &header.httpStatus, 4);
+	memcpy(fixed + 24, &header.fetchTime, 8);
+	bytes.append(fixed, kPageRecordHeaderSize);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function reads the fixed part of a record.
+* @param		char* -- bytes (the start of the record)
+* @param		size_t -- size (the number of bytes available)
+* @param		PageRecordHeader& -- header (output, the fixed part)
+* @return		bool -- return false if the bytes are too short or do not start
+with the magic number
+*******************************************************************************
+*/
+inline bool decodePageRecordHeader(const char* bytes, size_t size, PageRecordHeader& header)
+{
+	boost::uint32_t magic;
+	if (size < kPageRecordHeaderSize) {
+		return false;
+	}
+	memcpy(&magic, bytes, 4);
+	memcpy(&header.urlLength, bytes + 4, 4);
+	memcpy(&header.headersLength, bytes + 8, 4);
+	memcpy(&header.compressedLength, bytes + 12, 4);
+	memcpy(&header.pageLength, bytes + 16, 4);
+	memcpy(&header.httpStatus, bytes + 20, 4);
+	memcpy(&header.fetchTime, bytes + 24, 8);
+	return magic == kPageRecordMagic;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function decodes the record at the start of a byte array and
+decompresses its page.
+* @param		char* -- bytes (the bytes of the record and possibly of the next)
+* @param		size_t -- size (the number of bytes)
+* @param		PageRecord& -- record (output, the decoded record)
+* @return		size_t -- the size of the record, or 0 if it is cut off or damaged
+*******************************************************************************
+*/
+inline size_t decodePageRecord(const char* bytes, size_t size, PageRecord& record)
+{
+	PageRecordHeader header;
+	if (!decodePageRecordHeader(bytes, size, header) || header.getRecordLength() > size) {
+		return 0;
+	}
+	const char* p = bytes + kPageRecordHeaderSize;
+	record.httpStatus = header.httpStatus;
+	record.fetchTime = (time_t)header.fetchTime;
+	record.url.assign(p, header.urlLength);
+	p += header.urlLength;
+	record.headers.assign(p, header.headersLength);
+	p += header.headersLength;
+
+	record.body.resize(header.pageLength);
+	uLongf bodyLength = header.pageLength;
+	if (uncompress(reinterpret_cast<Bytef*>(header.pageLength ? &record.body[0] : NULL), &bodyLength,
+			reinterpret_cast<const Bytef*>(p), header.compressedLength) != Z_OK ||
+			bodyLength != header.pageLength) {
+		return 0;
+	}
+	return (size_t)header.getRecordLength();
+}
+
+} //end of namespace WebDataExtraction
+
+#endif //_PAGERECORDFORMAT_H_
@@ -0,0 +1,526 @@
+/**
+*******************************************************************************
+* @file			PageStore.cpp
+* @brief 		This file provides the implementations of the class PageStore.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "PageStore.h"
+#include "AsyncLogger.h"
+
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <dirent.h>
+
+#include <boost/bind.hpp>
+
+//zlib to compress the pages
+#include <zlib.h>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+//the size of an index entry
+static const size_t kIndexEntrySize = 2 * sizeof(boost::uint64_t) + 2 * sizeof(boost::uint32_t);
+
+
+
+/**
+*******************************************************************************
+* @brief		These functions append an integer to a byte string, and read one
+from a byte array.
+*******************************************************************************
+*/
+template <typename T>
+static void appendInteger(string& bytes, T value)
+{
+	bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static T readInteger(const char* bytes)
+{
+	T value;
+	memcpy(&value, bytes, sizeof(T));
+	return value;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class PageStore.
+* @param		string -- folder (the folder holding the segment files)
+* @param		size_t -- maxSegmentBytes (the size at which a segment is closed)
+* @param		size_t -- maxQueuedRecords (the records queued before store() blocks)
+* @return		None
+*******************************************************************************
+*/
+PageStore::PageStore(const string& folder, size_t maxSegmentBytes, size_t maxQueuedRecords) :
+	folder_(folder), maxSegmentBytes_(maxSegmentBytes), maxQueuedRecords_(maxQueuedRecords),
+	isClosing_(false), numberRecords_(0), numberBytes_(0), segmentID_(0), segmentSize_(0),
+	segmentFile_(NULL), indexFile_(NULL)
+{
+	writeMetric_ = Metrics::getShared().addHistogram("page_store_write_us");
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class PageStore.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+PageStore::~PageStore()
+{
+	close();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the path of a segment or index file, e.g.
+./data/segment-00003.seg
+* @param		uint32_t -- segmentID (the id of the segment)
+* @param		char* -- extension ("seg" or "idx")
+* @return		string -- the path of the file
+*******************************************************************************
+*/
+string PageStore::getSegmentPath(boost::uint32_t segmentID, const char* extension) const
+{
+	stringstream strStream;
+	strStream << folder_ << "/segment-" << setw(5) << setfill('0') << segmentID << "." << extension;
+	return strStream.str();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function loads the indexes left by previous runs and starts
+the writer thread on a new segment.
+* @param		none
+* @return		int -- return 0 if the store is ready, and 1 if it fails.
+*******************************************************************************
+*/
+int PageStore::open()
+{
+	DIR* dir = opendir(folder_.c_str());
+	if (dir == NULL) {
+		std::cerr << "Failed to open the page store folder " << folder_ << std::endl;
+		return 1;
+	}
+	boost::uint32_t nextSegmentID = 0;
+	vector<boost::uint32_t> indexIDVector;
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL) {
+		unsigned int segmentID;
+		char extension[4];
+		if (sscanf(entry->d_name, "segment-%u.%3s", &segmentID, extension) != 2) {
+			continue;
+		}
+		if (segmentID + 1 > nextSegmentID) {
+			nextSegmentID = segmentID + 1;
+		}
+		if (strcmp(extension, "idx") == 0) {
+			indexIDVector.push_back(segmentID);
+		}
+	}
+	closedir(dir);
+	//readdir() has no order: load the oldest index first, so that the last record of a URL wins
+	sort(indexIDVector.begin(), indexIDVector.end());
+	for (size_t i = 0; i < indexIDVector.size(); i++) {
+		loadIndex(getSegmentPath(indexIDVector[i], "idx"));
+	}
+
+	if (!openSegment(nextSegmentID)) {
+		return 1;
+	}
+	thread_ = boost::thread(boost::bind(&PageStore::run, this));
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function loads the index file of a previous segment. Later
+entries of the same URL replace earlier ones.
+* @param		string -- fileName (the path of the index file)
+* @return		void
+*******************************************************************************
+*/
+void PageStore::loadIndex(const string& fileName)
+{
+	FILE* file = fopen(fileName.c_str(), "rb");
+	if (file == NULL) {
+		return;
+	}
+	char entry[kIndexEntrySize];
+	boost::mutex::scoped_lock lock(mutex_);
+	while (fread(entry, kIndexEntrySize, 1, file) == 1) {
+		PageLocation location;
+		URLFingerprint fingerprint = readInteger<boost::uint64_t>(entry);
+		location.offset = readInteger<boost::uint64_t>(entry + 8);
+		location.length = readInteger<boost::uint32_t>(entry + 16);
+		location.segmentID = readInteger<boost::uint32_t>(entry + 20);
+		index_[fingerprint] = location;
+	}
+	fclose(file);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function closes the current segment and opens a new one.
+* @param		uint32_t -- segmentID (the id of the new segment)
+* @return		bool -- return true if both files of the new segment are open
+*******************************************************************************
+*/
+bool PageStore::openSegment(boost::uint32_t segmentID)
+{
+	if (segmentFile_ != NULL) {
+		fclose(segmentFile_);
+	}
+	if (indexFile_ != NULL) {
+		fclose(indexFile_);
+	}
+	segmentID_ = segmentID;
+	segmentSize_ = 0;
+	segmentFile_ = fopen(getSegmentPath(segmentID, "seg").c_str(), "wb");
+	indexFile_ = fopen(getSegmentPath(segmentID, "idx").c_str(), "wb");
+	if (segmentFile_ == NULL || indexFile_ == NULL) {
+		std::cerr << "Failed to create the segment " << getSegmentPath(segmentID, "seg") << std::endl;
+		return false;
+	}
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function compresses a page into a record and queues it for
+the writer thread. It blocks while maxQueuedRecords_ records are waiting, so a
+slow disk slows the crawl down instead of filling the memory.
+* @param		string -- url (the URL of the page)
+* @param		long -- httpStatus (the http status returned by the HTTP server)
+* @param		time_t -- fetchTime (the time the page was fetched)
+* @param		string -- headers (the response headers)
+* @param		PageBuffer -- page (the downloaded page)
+* @param		bool -- isBlocking (false to queue the record even above the
+limit, for a caller which must not block, e.g. a worker of an executor)
+* @return		void
+*******************************************************************************
+*/
+void PageStore::store(const string& url, long httpStatus, time_t fetchTime,
+	const string& headers, const PageBuffer& page, bool isBlocking)
+{
+	//compress on the calling thread, so that the writer only writes
+	uLongf compressedLength = compressBound(page.size());
+	string compressed(compressedLength, '\0');
+	if (compress2(reinterpret_cast<Bytef*>(&compressed[0]), &compressedLength,
+			reinterpret_cast<const Bytef*>(page.data()), page.size(), Z_BEST_SPEED) != Z_OK) {
+		AsyncLogger::getShared().log(LOG_ERROR, "Failed to compress the page {}", url);
+		return;
+	}
+
+	PageRecordHeader header;
+	header.urlLength = url.size();
+	header.headersLength = headers.size();
+	header.compressedLength = compressedLength;
+	header.pageLength = page.size();
+	header.httpStatus = httpStatus;
+	header.fetchTime = fetchTime;
+	string record;
+	record.reserve(header.getRecordLength());
+	encodePageRecordHeader(header, record);
+	record += url;
+	record += headers;
+	record.append(compressed.data(), compressedLength);
+
+	URLFingerprint fingerprint = fingerprintURL(url);
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		while (isBlocking && recordQueue_.size() >= maxQueuedRecords_ && !isClosing_) {
+			spaceCondition_.wait(lock);
+		}
+		recordQueue_.push_back(make_pair(fingerprint, string()));
+		recordQueue_.back().second.swap(record);
+	}
+	queueCondition_.notify_one();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function blocks while maxQueuedRecords_ records are waiting
+for the writer. A producer calls it before handing work over to the callers of
+store() which must not block.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void PageStore::waitForSpace()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	while (recordQueue_.size() >= maxQueuedRecords_ && !isClosing_) {
+		spaceCondition_.wait(lock);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the body of the writer thread. It takes all the
+queued records at once and writes them as one batch, timing the write.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void PageStore::run()
+{
+	while (true) {
+		deque< pair<URLFingerprint, string> > batch;
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			while (recordQueue_.empty() && !isClosing_) {
+				queueCondition_.wait(lock);
+			}
+			if (recordQueue_.empty() && isClosing_) {
+				break;
+			}
+			batch.swap(recordQueue_);
+		}
+		spaceCondition_.notify_all();
+		boost::uint64_t begin = Metrics::nowMicroseconds();
+		writeBatch(batch);
+		Metrics::getShared().record(writeMetric_, Metrics::nowMicroseconds() - begin);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function writes a batch of records with one write per file
+and segment, and adds them to the index.
+* @param		deque< pair<URLFingerprint, string> >& -- batch (the encoded records)
+* @return		void
+*******************************************************************************
+*/
+void PageStore::writeBatch(deque< pair<URLFingerprint, string> >& batch)
+{
+	//the last segment could not be created
+	if (segmentFile_ == NULL || indexFile_ == NULL) {
+		return;
+	}
+	string segmentBytes;
+	string indexBytes;
+	vector< pair<URLFingerprint, PageLocation> > locations;
+	for (size_t i = 0; i < batch.size(); i++) {
+		const string& record = batch[i].second;
+		//roll over to a new segment when this one is full
+		if (segmentSize_ + segmentBytes.size() > 0 &&
+				segmentSize_ + segmentBytes.size() + record.size() > maxSegmentBytes_) {
+			writeChunk(segmentBytes, indexBytes, locations);
+			segmentBytes.clear();
+			indexBytes.clear();
+			locations.clear();
+			if (!openSegment(segmentID_ + 1)) {
+				return;
+			}
+		}
+
+		PageLocation location;
+		location.segmentID = segmentID_;
+		location.offset = segmentSize_ + segmentBytes.size();
+		location.length = record.size();
+		appendInteger<boost::uint64_t>(indexBytes, batch[i].first);
+		appendInteger<boost::uint64_t>(indexBytes, location.offset);
+		appendInteger<boost::uint32_t>(indexBytes, location.length);
+		appendInteger<boost::uint32_t>(indexBytes, location.segmentID);
+		segmentBytes += record;
+		locations.push_back(make_pair(batch[i].first, location));
+	}
+	writeChunk(segmentBytes, indexBytes, locations);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function appends records to the current segment and their
+entries to its index, and adds them to the index in memory only once both are
+on disk. If a write fails (e.g. the disk is full), the records are dropped and
+the writer moves to a new segment, since the offsets of the current one are no
+longer known.
+* @param		string -- segmentBytes (the encoded records)
+* @param		string -- indexBytes (their index entries)
+* @param		vector< pair<URLFingerprint, PageLocation> > -- locations (their
+locations in the current segment)
+* @return		void
+*******************************************************************************
+*/
+void PageStore::writeChunk(const string& segmentBytes, const string& indexBytes,
+	const vector< pair<URLFingerprint, PageLocation> >& locations)
+{
+	if (segmentBytes.empty() || segmentFile_ == NULL || indexFile_ == NULL) {
+		return;
+	}
+	//the records first: an index entry must never point to bytes not written
+	bool isWritten = (fwrite(segmentBytes.data(), segmentBytes.size(), 1, segmentFile_) == 1 &&
+		fflush(segmentFile_) == 0);
+	isWritten = isWritten && (fwrite(indexBytes.data(), indexBytes.size(), 1, indexFile_) == 1 &&
+		fflush(indexFile_) == 0);
+	if (!isWritten) {
+		AsyncLogger::getShared().log(LOG_ERROR, "Failed to write {} pages into the segment {}, "
+			"they are not stored", (long)locations.size(), getSegmentPath(segmentID_, "seg"));
+		openSegment(segmentID_ + 1);
+		return;
+	}
+	segmentSize_ += segmentBytes.size();
+
+	//make the batch readable by read() only once it is on disk
+	boost::mutex::scoped_lock lock(mutex_);
+	for (size_t i = 0; i < locations.size(); i++) {
+		index_[locations[i].first] = locations[i].second;
+		numberBytes_ += locations[i].second.length;
+	}
+	numberRecords_ += locations.size();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function reads the last stored record of a URL.
+* @param		string -- url (the URL of the page)
+* @param		PageRecord& -- record (output, the decoded record)
+* @return		int -- return 0 if the record is read, and 1 if the URL is not
+stored or the record is damaged.
+*******************************************************************************
+*/
+int PageStore::read(const string& url, PageRecord& record)
+{
+	PageLocation location;
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		boost::unordered_map<URLFingerprint, PageLocation>::iterator it =
+			index_.find(fingerprintURL(url));
+		if (it == index_.end()) {
+			return 1;
+		}
+		location = it->second;
+	}
+
+	FILE* file = fopen(getSegmentPath(location.segmentID, "seg").c_str(), "rb");
+	if (file == NULL) {
+		return 1;
+	}
+	string bytes(location.length, '\0');
+	bool isRead = (fseeko(file, location.offset, SEEK_SET) == 0 &&
+		fread(&bytes[0], 1, location.length, file) == location.length);
+	fclose(file);
+	return (isRead && decodePageRecord(bytes.data(), bytes.size(), record) == location.length) ? 0 : 1;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function reads all the records of a segment file, e.g. for a
+benchmark over the stored pages. A record cut off by a crash ends the segment.
+* @param		string -- fileName (the path of the segment file)
+* @param		vector<PageRecord>& -- records (output, the records are appended)
+* @return		int -- return 0 on success, and 1 if the file cannot be read.
+*******************************************************************************
+*/
+int PageStore::readSegment(const string& fileName, vector<PageRecord>& records)
+{
+	FILE* file = fopen(fileName.c_str(), "rb");
+	if (file == NULL) {
+		return 1;
+	}
+	string bytes;
+	char buffer[65536];
+	size_t numberRead;
+	while ((numberRead = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		bytes.append(buffer, numberRead);
+	}
+	bool isRead = (ferror(file) == 0);
+	fclose(file);
+
+	size_t offset = 0;
+	PageRecord record;
+	size_t length;
+	while (isRead && (length = decodePageRecord(bytes.data() + offset, bytes.size() - offset, record)) > 0) {
+		records.push_back(record);
+		offset += length;
+	}
+	return isRead ? 0 : 1;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function writes the queued records, stops the writer thread
+and closes the segment.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void PageStore::close()
+{
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		isClosing_ = true;
+	}
+	queueCondition_.notify_all();
+	spaceCondition_.notify_all();
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+	if (segmentFile_ != NULL) {
+		fclose(segmentFile_);
+		segmentFile_ = NULL;
+	}
+	if (indexFile_ != NULL) {
+		fclose(indexFile_);
+		indexFile_ = NULL;
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		These functions return the numbers of records and bytes written.
+* @param		none
+* @return		long -- the number of records or bytes written by this run
+*******************************************************************************
+*/
+long PageStore::getNumberRecords()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return numberRecords_;
+}
+
+long PageStore::getNumberBytes()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return numberBytes_;
+}
@@ -0,0 +1,149 @@
+/**
+*******************************************************************************
+* @file		PageStore.h
+* @brief	This file provides the interfaces of the class PageStore.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _PAGESTORE_H_
+#define _PAGESTORE_H_
+
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <deque>
+#include <vector>
+
+//boost lib
+#include <boost/cstdint.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "PageBuffer.h"
+#include "PageRecordFormat.h"
+#include "URLFingerprint.h"
+#include "Metrics.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @struct		PageLocation
+* @brief 		This structure is one entry of the segment index.
+*******************************************************************************
+*/
+struct PageLocation
+{
+	//the segment holding the record
+	boost::uint32_t segmentID;
+	//the offset of the record in the segment
+	boost::uint64_t offset;
+	//the size of the record in bytes
+	boost::uint32_t length;
+};
+
+
+/**
+*******************************************************************************
+* @class		PageStore
+* @brief 		This class stores the downloaded pages in large append-only
+segment files instead of one file per page. Each record holds the URL, the http
+status, the fetch time, the response headers and the zlib-compressed page. Next
+to each segment an index file lists (URL fingerprint, offset, length) per
+record. The pages are compressed on the calling thread and written in batches,
+with one write per batch, by a dedicated writer thread. A caller which must not
+block, such as a task of an executor, stores without waiting for the queue and
+leaves the wait to its producer with waitForSpace(). A segment is closed when
+it reaches maxSegmentBytes; a new run never appends to an old segment.
+
+Record layout: see PageRecordHeader in PageRecordFormat.h, shared with the
+readers of the segments.
+Index entry layout: u64 URL fingerprint, u64 offset, u32 length, u32 segment id
+*******************************************************************************
+*/
+class PageStore
+{
+	private:
+		//the folder holding the segment files
+		string folder_;
+		//the size at which a segment is closed
+		size_t maxSegmentBytes_;
+		//the number of records waiting for the writer before store() and waitForSpace() block
+		size_t maxQueuedRecords_;
+
+		//mutex protecting the members below
+		boost::mutex mutex_;
+		//signalled when a record is queued or the store is closed
+		boost::condition_variable queueCondition_;
+		//signalled when the writer has taken records off the queue
+		boost::condition_variable spaceCondition_;
+		//the encoded records waiting to be written, with their fingerprints
+		deque< pair<URLFingerprint, string> > recordQueue_;
+		//the location of every record in this and previous runs
+		boost::unordered_map<URLFingerprint, PageLocation> index_;
+		//set by close()
+		bool isClosing_;
+		//the number of records and bytes written by this run
+		long numberRecords_;
+		long numberBytes_;
+
+		//the segment being written (owned by the writer thread)
+		boost::uint32_t segmentID_;
+		boost::uint64_t segmentSize_;
+		FILE* segmentFile_;
+		FILE* indexFile_;
+		//the histogram of the time of a batch write (Metrics id)
+		int writeMetric_;
+		//the writer thread
+		boost::thread thread_;
+
+		//the body of the writer thread
+		void run();
+		//write a batch of records and their index entries
+		void writeBatch(deque< pair<URLFingerprint, string> >& batch);
+		//append records to the segment and entries to its index, then publish the entries
+		void writeChunk(const string& segmentBytes, const string& indexBytes,
+			const vector< pair<URLFingerprint, PageLocation> >& locations);
+		//close the current segment and open the next one
+		bool openSegment(boost::uint32_t segmentID);
+		//load the index file of a segment from a previous run
+		void loadIndex(const string& fileName);
+		//get the path of a segment or index file
+		string getSegmentPath(boost::uint32_t segmentID, const char* extension) const;
+
+	public:
+ 		//constructor
+ 		PageStore(const string& folder, size_t maxSegmentBytes = 256 * 1024 * 1024,
+ 			size_t maxQueuedRecords = 1024);
+ 		//destructor: writes the queued records and closes the segment
+ 		~PageStore();
+ 		//load the indexes of previous runs and start the writer, return 0 on success
+ 		int open();
+ 		//compress a page and queue it for writing (blocks while the queue is full, unless isBlocking is false)
+ 		void store(const string& url, long httpStatus, time_t fetchTime,
+ 			const string& headers, const PageBuffer& page, bool isBlocking = true);
+ 		//wait while the queue is full
+ 		void waitForSpace();
+ 		//read the last stored record of a URL, return 0 on success
+ 		int read(const string& url, PageRecord& record);
+ 		//read all the records of a segment file, return 0 on success
+ 		static int readSegment(const string& fileName, vector<PageRecord>& records);
+ 		//write the queued records and stop the writer thread
+ 		void close();
+ 		//get the number of records written by this run
+ 		long getNumberRecords();
+ 		//get the number of bytes written by this run
+ 		long getNumberBytes();
+
+}; //end of class PageStore
+
+} //end of namespace WebDataExtraction
+
+#endif //_PAGESTORE_H_
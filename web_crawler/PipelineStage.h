@@ -0,0 +1,329 @@
+/**
+*******************************************************************************
+* @file		PipelineStage.h
+* @brief	This file provides the interfaces and the implementations of the
+class template PipelineStage.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _PIPELINESTAGE_H_
+#define _PIPELINESTAGE_H_
+
+#include <string>
+
+//boost lib
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "WorkStealingExecutor.h"
+#include "Metrics.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @struct		StageStats
+* @brief 		This structure holds the statistics of a pipeline stage.
+*******************************************************************************
+*/
+struct StageStats
+{
+	//the name of the stage
+	string name;
+	//the number of worker threads of the executor
+	int numberWorkers;
+	//the number of items queued or in process, the largest number seen and the capacity
+	long depth;
+	long maxDepth;
+	long capacity;
+	//the number of items processed
+	long numberProcessed;
+	//the number of times a producer has waited for space in the stage
+	long numberFullWaits;
+	//the fraction of the executor time spent in the handler since start()
+	double busyRatio;
+};
+
+
+/**
+*******************************************************************************
+* @class		PipelineStage
+* @brief 		This class is one stage of the crawl pipeline: the items of the
+stage are run through the handler of the stage as tasks of a WorkStealingExecutor
+shared by all the stages. The handler owns the item: it hands it over to the
+next stage or deletes it. An item handed over by a worker is queued on the same
+worker, so the next stage of a page runs on the core which has just processed
+it. A producer outside the executor, such as a fetch engine thread, blocks while
+the stage or one of the stages after it (setNextStage()) is full, so a slow
+stage slows down the downloads instead of filling the memory. The workers never
+block on a full stage, since they are the ones which empty it: an item handed
+over by a worker is queued even above the capacity, so a stage holds at most its
+capacity plus the items of the stages before it and one item per producer
+waiting at the first stage. The depth of a stage shows which stage is the
+bottleneck.
+*******************************************************************************
+*/
+template <typename T>
+class PipelineStage
+{
+	private:
+		//the name of the stage in the reports
+		string name_;
+		//the maximum number of items in the stage
+		long capacity_;
+		//the function processing an item
+		boost::function<void (T*)> handler_;
+		//the executor running the handler, set by start()
+		WorkStealingExecutor* ptrExecutor_;
+		//the time start() was called
+		boost::posix_time::ptime startTime_;
+		//the number of items queued or in process, and the largest number seen
+		boost::atomic<long> depth_;
+		boost::atomic<long> maxDepth_;
+		//the histogram of the depth seen by each push (Metrics id)
+		int depthMetric_;
+		//the number of items processed and the time spent in the handler
+		boost::atomic<long> numberProcessed_;
+		boost::atomic<long> busyMicroseconds_;
+		//the number of times a producer has waited for space
+		boost::atomic<long> numberFullWaits_;
+		//the stages before and after this one, set by setNextStage()
+		PipelineStage<T>* ptrPreviousStage_;
+		PipelineStage<T>* ptrNextStage_;
+		//set by close()
+		boost::atomic<bool> isClosed_;
+		//the number of threads waiting on the condition
+		boost::atomic<int> numberSleepers_;
+		//mutex and condition on which the producers and close() wait
+		boost::mutex mutex_;
+		boost::condition_variable condition_;
+
+		//run the handler on an item, as a task of the executor
+		void process(T* item);
+		//whether this stage or a stage after it is full
+		bool isFull() const;
+		//wake the producers waiting at this stage and at the stages before it
+		void notifyProducers();
+
+	public:
+ 		//constructor
+ 		PipelineStage(const string& name, size_t capacity, boost::function<void (T*)> handler) :
+ 			name_(name), capacity_((long)capacity), handler_(handler), ptrExecutor_(NULL),
+ 			depth_(0), maxDepth_(0), depthMetric_(-1), numberProcessed_(0), busyMicroseconds_(0),
+ 			numberFullWaits_(0), ptrPreviousStage_(NULL), ptrNextStage_(NULL), isClosed_(false),
+ 			numberSleepers_(0) {}
+ 		//run the items of the stage on the executor
+ 		void start(WorkStealingExecutor& executor);
+ 		//set the stage the handler hands the items over to
+ 		void setNextStage(PipelineStage<T>& nextStage);
+ 		//queue an item, blocking while the stage or a later one is full; return false once closed
+ 		bool push(T* item);
+ 		//wait until the items of the stage have been processed, then refuse new items
+ 		void close();
+ 		//get the statistics of the stage
+ 		StageStats getStats() const;
+
+}; //end of class PipelineStage
+
+
+
+/**
+*******************************************************************************
+* @brief		This function runs the handler on an item and makes its place in
+the stage available to the waiting producers.
+* @param		T* -- item (the item)
+* @return		void
+*******************************************************************************
+*/
+template <typename T>
+void PipelineStage<T>::process(T* item)
+{
+	boost::posix_time::ptime begin = boost::posix_time::microsec_clock::universal_time();
+	handler_(item);
+	busyMicroseconds_ += (boost::posix_time::microsec_clock::universal_time() - begin).total_microseconds();
+	numberProcessed_++;
+	depth_--;
+	notifyProducers();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function tells whether this stage or one of the stages after
+it is full, in which case a producer outside the executor has to wait.
+* @param		none
+* @return		bool -- return true if a stage is full
+*******************************************************************************
+*/
+template <typename T>
+bool PipelineStage<T>::isFull() const
+{
+	for (const PipelineStage<T>* ptrStage = this; ptrStage != NULL; ptrStage = ptrStage->ptrNextStage_) {
+		if (ptrStage->depth_ >= ptrStage->capacity_) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function wakes the producers waiting at this stage and at the
+stages before it, which all wait for this stage to have space.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+template <typename T>
+void PipelineStage<T>::notifyProducers()
+{
+	for (PipelineStage<T>* ptrStage = this; ptrStage != NULL; ptrStage = ptrStage->ptrPreviousStage_) {
+		if (ptrStage->numberSleepers_ > 0) {
+			boost::mutex::scoped_lock lock(ptrStage->mutex_);
+			ptrStage->condition_.notify_all();
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function sets the executor running the items of the stage, and
+registers the depth histogram of the stage.
+* @param		WorkStealingExecutor& -- executor (the executor, shared by the stages)
+* @return		void
+*******************************************************************************
+*/
+template <typename T>
+void PipelineStage<T>::start(WorkStealingExecutor& executor)
+{
+	ptrExecutor_ = &executor;
+	depthMetric_ = Metrics::getShared().addHistogram("stage_" + name_ + "_depth");
+	startTime_ = boost::posix_time::microsec_clock::universal_time();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function sets the stage to which the handler of this stage
+hands the items over. The producers of this stage then also wait while the next
+stage is full, since the workers cannot wait for it.
+* @param		PipelineStage<T>& -- nextStage (the next stage of the pipeline)
+* @return		void
+*******************************************************************************
+*/
+template <typename T>
+void PipelineStage<T>::setNextStage(PipelineStage<T>& nextStage)
+{
+	ptrNextStage_ = &nextStage;
+	nextStage.ptrPreviousStage_ = this;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function queues an item for the executor. A thread outside
+the executor sleeps while the stage or one of the stages after it is full, until
+an item has been processed there. A worker never sleeps, and may fill the stage
+above its capacity.
+* @param		T* -- item (the item, owned by the stage once queued)
+* @return		bool -- return false if the stage is closed (the item is not queued)
+*******************************************************************************
+*/
+template <typename T>
+bool PipelineStage<T>::push(T* item)
+{
+	if (isClosed_) {
+		return false;
+	}
+	if (!ptrExecutor_->isWorkerThread() && isFull()) {
+		numberFullWaits_++;
+		boost::mutex::scoped_lock lock(mutex_);
+		numberSleepers_++;
+		while (isFull() && !isClosed_) {
+			condition_.wait(lock);
+		}
+		numberSleepers_--;
+		if (isClosed_) {
+			return false;
+		}
+	}
+	long depth = ++depth_;
+	long maxDepth = maxDepth_;
+	while (depth > maxDepth && !maxDepth_.compare_exchange_weak(maxDepth, depth)) {
+	}
+	Metrics::getShared().record(depthMetric_, depth);
+	ptrExecutor_->submit(boost::bind(&PipelineStage<T>::process, this, item));
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function waits until the items of the stage have been
+processed, then makes push() fail. The stages are closed in the order of the
+pipeline, so that the items handed over by a stage find the next one open.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+template <typename T>
+void PipelineStage<T>::close()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	numberSleepers_++;
+	while (depth_ > 0) {
+		condition_.wait(lock);
+	}
+	numberSleepers_--;
+	isClosed_ = true;
+	condition_.notify_all();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the statistics of the stage.
+* @param		none
+* @return		StageStats -- the depth of the stage, the items processed and the
+busy ratio
+*******************************************************************************
+*/
+template <typename T>
+StageStats PipelineStage<T>::getStats() const
+{
+	StageStats stats;
+	stats.name = name_;
+	stats.numberWorkers = (ptrExecutor_ != NULL) ? ptrExecutor_->getNumberWorkers() : 0;
+	stats.depth = depth_;
+	stats.maxDepth = maxDepth_;
+	stats.capacity = capacity_;
+	stats.numberProcessed = numberProcessed_;
+	stats.numberFullWaits = numberFullWaits_;
+	long elapsedMicroseconds = (boost::posix_time::microsec_clock::universal_time() -
+		startTime_).total_microseconds();
+	stats.busyRatio = (stats.numberWorkers > 0 && elapsedMicroseconds > 0) ?
+		(double)busyMicroseconds_ / ((double)elapsedMicroseconds * stats.numberWorkers) : 0.0;
+	return stats;
+}
+
+} //end of namespace WebDataExtraction
+
+#endif //_PIPELINESTAGE_H_
@@ -0,0 +1,337 @@
+/**
+*******************************************************************************
+* @file			PolitenessScheduler.cpp
+* @brief 		This file provides the implementations of the class
+PolitenessScheduler.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "PolitenessScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <boost/bind.hpp>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+using namespace boost::posix_time;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class PolitenessScheduler.
+* @param		FetchEngine& -- fetchEngine (the engine which performs the transfers)
+* @param		PolitenessConfig -- config (the per-host limits)
+* @return		None
+*******************************************************************************
+*/
+PolitenessScheduler::PolitenessScheduler(FetchEngine& fetchEngine,
+	const PolitenessConfig& config) : fetchEngine_(fetchEngine), config_(config),
+	generation_(0), isStopping_(false)
+{
+	thread_ = boost::thread(boost::bind(&PolitenessScheduler::run, this));
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class PolitenessScheduler.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+PolitenessScheduler::~PolitenessScheduler()
+{
+	stop();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the host key of a URL, for example:
+URL: http://www.walmart.ca/en/health-beauty/pharmacy/foot-care/N-1441
+host key: http://www.walmart.ca
+* @param		string -- url (the URL)
+* @return		string -- the scheme, host and port of the URL
+*******************************************************************************
+*/
+string PolitenessScheduler::getHostKey(const string& url)
+{
+	size_t hostStart = url.find("://");
+	hostStart = (hostStart == string::npos) ? 0 : hostStart + 3;
+	size_t hostEnd = url.find_first_of("/?#", hostStart);
+	if (hostEnd == string::npos) {
+		hostEnd = url.size();
+	}
+	string hostKey = url.substr(0, hostEnd);
+	//host names are case-insensitive
+	transform(hostKey.begin(), hostKey.end(), hostKey.begin(), ::tolower);
+	return hostKey;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function queues a URL in the queue of its host.
+* @param		string -- url (the URL of the html page)
+* @param		FetchCallback -- callback (invoked on an engine thread with the result)
+* @param		FetchProgressCallback -- progressCallback (optional, invoked on an
+engine thread after each chunk of a 200 response)
+* @param		vector<string> -- requestHeaders (optional, extra request headers
+such as "If-None-Match: ...")
+* @return		void
+*******************************************************************************
+*/
+void PolitenessScheduler::submit(const string& url, FetchCallback callback,
+	FetchProgressCallback progressCallback, const vector<string>& requestHeaders)
+{
+	Request request;
+	request.url = url;
+	request.callback = callback;
+	request.progressCallback = progressCallback;
+	request.requestHeaders = requestHeaders;
+	request.numberRetries = 0;
+	string host = getHostKey(url);
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		map<string, HostState>::iterator it = hostMap_.find(host);
+		if (it == hostMap_.end()) {
+			HostState hostState;
+			hostState.tokens = config_.burstSize;
+			hostState.lastRefill = microsec_clock::universal_time();
+			hostState.numberInFlight = 0;
+			hostState.concurrencyLimit = config_.initialConcurrency;
+			hostState.smoothedLatencyMs = 0.0;
+			hostState.pausedUntil = hostState.lastRefill;
+			hostState.lastDecrease = hostState.lastRefill;
+			it = hostMap_.insert(make_pair(host, hostState)).first;
+		}
+		it->second.requestQueue.push_back(request);
+		generation_++;
+	}
+	condition_.notify_one();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function waits until all queued requests have completed and
+stops the scheduling thread.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void PolitenessScheduler::stop()
+{
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		isStopping_ = true;
+		generation_++;
+	}
+	condition_.notify_one();
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the current concurrency limit of a host.
+* @param		string -- host (the host key, see getHostKey())
+* @return		double -- the AIMD concurrency limit, or 0 if the host is unknown
+*******************************************************************************
+*/
+double PolitenessScheduler::getConcurrencyLimit(const string& host)
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	map<string, HostState>::iterator it = hostMap_.find(host);
+	return (it == hostMap_.end()) ? 0.0 : it->second.concurrencyLimit;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the body of the scheduling thread. It releases
+the requests allowed by the limits and sleeps until the next token is due or
+the state changes.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void PolitenessScheduler::run()
+{
+	while (true) {
+		vector< pair<string, Request> > readyList;
+		ptime now = microsec_clock::universal_time();
+		ptime nextWakeup;
+		long generation;
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			nextWakeup = dispatch(now, readyList);
+			if (isStopping_ && readyList.empty() && isIdle()) {
+				break;
+			}
+			generation = generation_;
+		}
+
+		//hand the released requests to the engine outside the lock
+		for (size_t i = 0; i < readyList.size(); i++) {
+			fetchEngine_.submit(readyList[i].second.url, boost::bind(
+				&PolitenessScheduler::transferDone, this, readyList[i].first,
+				readyList[i].second, now, _1), readyList[i].second.progressCallback,
+				readyList[i].second.requestHeaders);
+		}
+		if (!readyList.empty()) {
+			continue;
+		}
+
+		boost::mutex::scoped_lock lock(mutex_);
+		while (generation == generation_) {
+			if (!condition_.timed_wait(lock, nextWakeup - microsec_clock::universal_time())) {
+				break;
+			}
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function checks whether every host queue is empty and no
+transfer is in flight. The mutex must be held.
+* @param		none
+* @return		bool -- return true if the scheduler has nothing left to do
+*******************************************************************************
+*/
+bool PolitenessScheduler::isIdle() const
+{
+	for (map<string, HostState>::const_iterator it = hostMap_.begin(); it != hostMap_.end(); it++) {
+		if (!it->second.requestQueue.empty() || it->second.numberInFlight > 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function takes the requests which are allowed now out of the
+host queues. The mutex must be held.
+* @param		ptime -- now (the current time)
+* @param		vector< pair<string, Request> >& -- readyList (output, the released
+requests with their host keys)
+* @return		ptime -- the time at which a blocked host gets its next token
+*******************************************************************************
+*/
+ptime PolitenessScheduler::dispatch(ptime now, vector< pair<string, Request> >& readyList)
+{
+	//wake up at least once per second
+	ptime nextWakeup = now + seconds(1);
+	for (map<string, HostState>::iterator it = hostMap_.begin(); it != hostMap_.end(); it++) {
+		HostState& hostState = it->second;
+
+		//refill the token bucket
+		double elapsedSeconds = (now - hostState.lastRefill).total_microseconds() / 1e6;
+		hostState.tokens = min(config_.burstSize,
+			hostState.tokens + elapsedSeconds * config_.requestsPerSecond);
+		hostState.lastRefill = now;
+
+		if (now < hostState.pausedUntil) {
+			if (!hostState.requestQueue.empty()) {
+				nextWakeup = min(nextWakeup, hostState.pausedUntil);
+			}
+			continue;
+		}
+		int limit = max(1, (int)floor(hostState.concurrencyLimit));
+		while (!hostState.requestQueue.empty() && hostState.numberInFlight < limit &&
+				hostState.tokens >= 1.0) {
+			readyList.push_back(make_pair(it->first, hostState.requestQueue.front()));
+			hostState.requestQueue.pop_front();
+			hostState.tokens -= 1.0;
+			hostState.numberInFlight++;
+		}
+		//a host blocked by its bucket wakes up when the next token is due
+		if (!hostState.requestQueue.empty() && hostState.numberInFlight < limit) {
+			long waitMicroseconds = (long)ceil((1.0 - hostState.tokens) /
+				config_.requestsPerSecond * 1e6);
+			nextWakeup = min(nextWakeup, now + microseconds(waitMicroseconds));
+		}
+	}
+	return nextWakeup;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is called on an engine thread when a transfer
+completes. It updates the AIMD limit of the host, queues the request again if it
+was throttled, and otherwise passes the result to the caller.
+* @param		string -- host (the host key)
+* @param		Request -- request (the completed request)
+* @param		ptime -- startTime (the time the request was released)
+* @param		FetchResult -- result (the result of the transfer)
+* @return		void
+*******************************************************************************
+*/
+void PolitenessScheduler::transferDone(string host, Request request, ptime startTime,
+	const FetchResult& result)
+{
+	ptime now = microsec_clock::universal_time();
+	double latencyMs = (now - startTime).total_microseconds() / 1000.0;
+	bool isThrottled = (result.httpStatus == 429 || result.httpStatus == 503);
+	bool isRetried = false;
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		HostState& hostState = hostMap_[host];
+		hostState.numberInFlight--;
+		hostState.smoothedLatencyMs = (hostState.smoothedLatencyMs == 0.0) ? latencyMs :
+			0.8 * hostState.smoothedLatencyMs + 0.2 * latencyMs;
+
+		bool isOverloaded = isThrottled ||
+			hostState.smoothedLatencyMs > config_.latencyThresholdMs;
+		if (isOverloaded) {
+			/*decrease at most once per round trip, since the responses of one
+			window report the same overload */
+			if ((now - hostState.lastDecrease).total_milliseconds() >
+					(long)hostState.smoothedLatencyMs) {
+				hostState.concurrencyLimit = max(config_.minConcurrency,
+					hostState.concurrencyLimit * config_.decreaseFactor);
+				hostState.lastDecrease = now;
+			}
+		}
+		else {
+			//grow by additiveIncrease once per window of concurrencyLimit responses
+			hostState.concurrencyLimit = min(config_.maxConcurrency,
+				hostState.concurrencyLimit + config_.additiveIncrease / hostState.concurrencyLimit);
+		}
+		if (isThrottled) {
+			hostState.pausedUntil = now + milliseconds(config_.backoffMs);
+			if (request.numberRetries < config_.maxRetries) {
+				request.numberRetries++;
+				hostState.requestQueue.push_front(request);
+				isRetried = true;
+			}
+		}
+		generation_++;
+	}
+	condition_.notify_one();
+
+	if (!isRetried) {
+		request.callback(result);
+	}
+}
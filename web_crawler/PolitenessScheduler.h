@@ -0,0 +1,156 @@
+/**
+*******************************************************************************
+* @file		PolitenessScheduler.h
+* @brief	This file provides the interfaces of the class PolitenessScheduler.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _POLITENESSSCHEDULER_H_
+#define _POLITENESSSCHEDULER_H_
+
+#include <string>
+#include <deque>
+#include <map>
+#include <vector>
+
+//boost lib
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "FetchEngine.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @struct		PolitenessConfig
+* @brief 		This structure holds the per-host limits of the scheduler.
+*******************************************************************************
+*/
+struct PolitenessConfig
+{
+	//the sustained request rate per host (requests per second)
+	double requestsPerSecond;
+	//the number of requests which may be sent back to back (token bucket size)
+	double burstSize;
+	//the number of concurrent transfers per host when the crawl starts
+	double initialConcurrency;
+	//the lower and upper bounds of the concurrent transfers per host
+	double minConcurrency;
+	double maxConcurrency;
+	//the concurrency added after each window of successful responses
+	double additiveIncrease;
+	//the factor applied to the concurrency on throttling or slow responses
+	double decreaseFactor;
+	//the smoothed latency (ms) above which the host is considered overloaded
+	double latencyThresholdMs;
+	//the pause (ms) of a host after it answered 429 or 503
+	long backoffMs;
+	//the number of times a throttled request is sent again
+	int maxRetries;
+
+	//constructor with the default limits
+	PolitenessConfig() : requestsPerSecond(20.0), burstSize(5.0), initialConcurrency(4.0),
+		minConcurrency(1.0), maxConcurrency(64.0), additiveIncrease(1.0),
+		decreaseFactor(0.5), latencyThresholdMs(2000.0), backoffMs(1000), maxRetries(3) {}
+};
+
+
+/**
+*******************************************************************************
+* @class		PolitenessScheduler
+* @brief 		This class sits between the frontier and the FetchEngine. It keeps
+a queue per host and releases requests only when the host's token bucket has a
+token and its in-flight count is below its concurrency limit. The limit follows
+AIMD: it grows additively while the host answers quickly, and shrinks
+multiplicatively on 429/503 responses or when the smoothed latency exceeds the
+threshold.
+*******************************************************************************
+*/
+class PolitenessScheduler
+{
+	private:
+		//a request waiting in a host queue
+		struct Request
+		{
+			string url;
+			FetchCallback callback;
+			FetchProgressCallback progressCallback;
+			vector<string> requestHeaders;
+			int numberRetries;
+		};
+		//the scheduling state of one host
+		struct HostState
+		{
+			deque<Request> requestQueue;
+			//the tokens currently in the bucket and the time of the last refill
+			double tokens;
+			boost::posix_time::ptime lastRefill;
+			//the transfers in flight and the AIMD concurrency limit
+			int numberInFlight;
+			double concurrencyLimit;
+			//the exponentially smoothed latency in ms (0 before the first response)
+			double smoothedLatencyMs;
+			//no request is released before this time
+			boost::posix_time::ptime pausedUntil;
+			//the time of the last multiplicative decrease
+			boost::posix_time::ptime lastDecrease;
+		};
+
+		//the engine which performs the transfers
+		FetchEngine& fetchEngine_;
+		//the per-host limits
+		PolitenessConfig config_;
+		//mutex protecting the members below
+		boost::mutex mutex_;
+		//signalled when a request is queued, a transfer completes or stop() is called
+		boost::condition_variable condition_;
+		//the state of each host, keyed by scheme://host[:port]
+		map<string, HostState> hostMap_;
+		//incremented on every state change, so that no wake-up is lost
+		long generation_;
+		//set by stop()
+		bool isStopping_;
+		//the thread releasing the requests
+		boost::thread thread_;
+
+		//the body of the scheduling thread
+		void run();
+		//release the requests allowed now and return the time of the next token
+		boost::posix_time::ptime dispatch(boost::posix_time::ptime now,
+			vector< pair<string, Request> >& readyList);
+		//check whether no request is queued or in flight
+		bool isIdle() const;
+		//called on the engine thread when a transfer completes
+		void transferDone(string host, Request request,
+			boost::posix_time::ptime startTime, const FetchResult& result);
+
+	public:
+ 		//constructor
+ 		PolitenessScheduler(FetchEngine& fetchEngine,
+ 			const PolitenessConfig& config = PolitenessConfig());
+ 		//destructor: stops the scheduling thread
+ 		~PolitenessScheduler();
+ 		//queue a URL for download, the callbacks run on an engine thread
+ 		void submit(const string& url, FetchCallback callback,
+ 			FetchProgressCallback progressCallback = FetchProgressCallback(),
+ 			const vector<string>& requestHeaders = vector<string>());
+ 		//wait for the queued requests to complete and stop the scheduling thread
+ 		void stop();
+ 		//get the current concurrency limit of a host (0 if the host is unknown)
+ 		double getConcurrencyLimit(const string& host);
+ 		//get the host key (scheme://host[:port]) of a URL
+ 		static string getHostKey(const string& url);
+
+}; //end of class PolitenessScheduler
+
+} //end of namespace WebDataExtraction
+
+#endif //_POLITENESSSCHEDULER_H_
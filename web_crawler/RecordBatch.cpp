@@ -0,0 +1,569 @@
+/**
+*******************************************************************************
+* @file			RecordBatch.cpp
+* @brief 		This file provides the implementations of the classes
+RecordBatchView, RecordBatch and MappedRecordBatch.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "RecordBatch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+//the first bytes of the binary layout
+static const boost::uint32_t kBatchMagic = 0x42584457; //"WDXB"
+//the size of the fixed part of the binary layout
+static const size_t kBatchHeaderSize = 2 * sizeof(boost::uint32_t) +
+	(1 + NUMBER_STRING_COLUMNS) * sizeof(boost::uint64_t);
+//the offsets of an empty column
+static const boost::uint64_t kEmptyOffsets[1] = {0};
+
+
+
+/**
+*******************************************************************************
+* @brief		This function rounds a size up to a multiple of 8 bytes.
+*******************************************************************************
+*/
+static size_t alignSize(size_t size)
+{
+	return (size + 7) & ~(size_t)7;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class RecordBatchView.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+RecordBatchView::RecordBatchView() : numberRecords_(0), productIDs_(NULL),
+	originalPriceCents_(NULL), currentPriceCents_(NULL)
+{
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		offsets_[column] = kEmptyOffsets;
+		arenas_[column] = "";
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the records [begin, end) of the view. The
+offsets are not rebased: they still index the same arenas.
+* @param		size_t -- begin (the first record)
+* @param		size_t -- end (the record after the last one)
+* @return		RecordBatchView -- the records
+*******************************************************************************
+*/
+RecordBatchView RecordBatchView::slice(size_t begin, size_t end) const
+{
+	RecordBatchView records(*this);
+	records.numberRecords_ = end - begin;
+	if (productIDs_ != NULL) {
+		records.productIDs_ += begin;
+		records.originalPriceCents_ += begin;
+		records.currentPriceCents_ += begin;
+	}
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		records.offsets_[column] += begin;
+	}
+	return records;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the size of the view in the binary layout.
+* @param		none
+* @return		size_t -- the number of bytes written by write()
+*******************************************************************************
+*/
+size_t RecordBatchView::getEncodedSize() const
+{
+	size_t size = kBatchHeaderSize + 3 * numberRecords_ * sizeof(boost::int64_t) +
+		NUMBER_STRING_COLUMNS * (numberRecords_ + 1) * sizeof(boost::uint64_t);
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		size += alignSize(offsets_[column][numberRecords_] - offsets_[column][0]);
+	}
+	return size;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function writes the view in the binary layout. The offsets
+of a slice are rebased so that each column starts at 0.
+* @param		FILE* -- file (the file, positioned on an 8-byte boundary)
+* @return		bool -- return false on a write error
+*******************************************************************************
+*/
+bool RecordBatchView::write(FILE* file) const
+{
+	boost::uint32_t header32[2] = {kBatchMagic, NUMBER_STRING_COLUMNS};
+	boost::uint64_t header64[1 + NUMBER_STRING_COLUMNS];
+	header64[0] = numberRecords_;
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		header64[1 + column] = offsets_[column][numberRecords_] - offsets_[column][0];
+	}
+	if (fwrite(header32, sizeof(header32), 1, file) != 1 ||
+			fwrite(header64, sizeof(header64), 1, file) != 1) {
+		return false;
+	}
+
+	const boost::int64_t* numericColumns[3] = {productIDs_, originalPriceCents_, currentPriceCents_};
+	for (int k = 0; k < 3 && numberRecords_ > 0; k++) {
+		if (fwrite(numericColumns[k], sizeof(boost::int64_t), numberRecords_, file) != numberRecords_) {
+			return false;
+		}
+	}
+
+	vector<boost::uint64_t> rebasedOffsets;
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		const boost::uint64_t* offsets = offsets_[column];
+		if (offsets[0] != 0) {
+			rebasedOffsets.resize(numberRecords_ + 1);
+			for (size_t i = 0; i <= numberRecords_; i++) {
+				rebasedOffsets[i] = offsets_[column][i] - offsets_[column][0];
+			}
+			offsets = &rebasedOffsets[0];
+		}
+		if (fwrite(offsets, sizeof(boost::uint64_t), numberRecords_ + 1, file) != numberRecords_ + 1) {
+			return false;
+		}
+	}
+
+	static const char padding[8] = {0};
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		size_t arenaBytes = header64[1 + column];
+		if ((arenaBytes > 0 && fwrite(arenas_[column] + offsets_[column][0], arenaBytes, 1, file) != 1) ||
+				(alignSize(arenaBytes) > arenaBytes &&
+				fwrite(padding, alignSize(arenaBytes) - arenaBytes, 1, file) != 1)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function writes the view into a new file, which can be read
+in place by MappedRecordBatch.
+* @param		string -- fileName (the path of the file)
+* @return		int -- return 0 on success, and 1 if the file cannot be written.
+*******************************************************************************
+*/
+int RecordBatchView::writeFile(const string& fileName) const
+{
+	//write a temporary file, so that a reader never maps a partial batch
+	string temporaryName = fileName + ".tmp";
+	FILE* file = fopen(temporaryName.c_str(), "wb");
+	if (file == NULL) {
+		std::cerr << "Failed to create " << temporaryName << std::endl;
+		return 1;
+	}
+	bool isWritten = write(file);
+	if (fclose(file) != 0 || !isWritten || rename(temporaryName.c_str(), fileName.c_str()) != 0) {
+		std::cerr << "Failed to write " << fileName << std::endl;
+		unlink(temporaryName.c_str());
+		return 1;
+	}
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function points the view to records in the binary layout. The
+sizes and the offsets are checked, so that no field can be read out of the data.
+* @param		char* -- data (the records, 8-byte aligned)
+* @param		size_t -- size (the number of bytes available)
+* @return		size_t -- the number of bytes of the records, or 0 if the data is
+damaged
+*******************************************************************************
+*/
+size_t RecordBatchView::attach(const char* data, size_t size)
+{
+	if (size < kBatchHeaderSize || reinterpret_cast<size_t>(data) % 8 != 0) {
+		return 0;
+	}
+	boost::uint32_t header32[2];
+	boost::uint64_t header64[1 + NUMBER_STRING_COLUMNS];
+	memcpy(header32, data, sizeof(header32));
+	memcpy(header64, data + sizeof(header32), sizeof(header64));
+	boost::uint64_t numberRecords = header64[0];
+	//each record takes at least 6 words
+	if (header32[0] != kBatchMagic || header32[1] != NUMBER_STRING_COLUMNS ||
+			numberRecords > size / (6 * sizeof(boost::uint64_t))) {
+		return 0;
+	}
+
+	size_t position = kBatchHeaderSize;
+	const boost::int64_t* numericColumns[3];
+	for (int k = 0; k < 3; k++) {
+		numericColumns[k] = reinterpret_cast<const boost::int64_t*>(data + position);
+		position += numberRecords * sizeof(boost::int64_t);
+	}
+	const boost::uint64_t* offsets[NUMBER_STRING_COLUMNS];
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		offsets[column] = reinterpret_cast<const boost::uint64_t*>(data + position);
+		position += (numberRecords + 1) * sizeof(boost::uint64_t);
+	}
+	if (position > size) {
+		return 0;
+	}
+	const char* arenas[NUMBER_STRING_COLUMNS];
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		boost::uint64_t arenaBytes = header64[1 + column];
+		if (arenaBytes > size - position || offsets[column][0] != 0 ||
+				offsets[column][numberRecords] != arenaBytes) {
+			return 0;
+		}
+		for (size_t i = 0; i < numberRecords; i++) {
+			if (offsets[column][i] > offsets[column][i + 1]) {
+				return 0;
+			}
+		}
+		arenas[column] = data + position;
+		position += alignSize(arenaBytes);
+	}
+	if (position > size) {
+		return 0;
+	}
+
+	numberRecords_ = numberRecords;
+	productIDs_ = numericColumns[0];
+	originalPriceCents_ = numericColumns[1];
+	currentPriceCents_ = numericColumns[2];
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		offsets_[column] = offsets[column];
+		arenas_[column] = arenas[column];
+	}
+	return position;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class RecordBatch.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+RecordBatch::RecordBatch()
+{
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		offsets_[column].push_back(0);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function appends a record.
+* @param		int64_t -- productID (the product id)
+* @param		string_view -- category (the product category)
+* @param		string_view -- description (the product description)
+* @param		string_view -- imageLink (the link of the product image)
+* @param		int64_t -- originalPriceCents (the original price in cents)
+* @param		int64_t -- currentPriceCents (the current price in cents)
+* @return		void
+*******************************************************************************
+*/
+void RecordBatch::append(boost::int64_t productID, boost::string_view category,
+	boost::string_view description, boost::string_view imageLink,
+	boost::int64_t originalPriceCents, boost::int64_t currentPriceCents)
+{
+	productIDs_.push_back(productID);
+	originalPriceCents_.push_back(originalPriceCents);
+	currentPriceCents_.push_back(currentPriceCents);
+	const boost::string_view values[NUMBER_STRING_COLUMNS] = {category, description, imageLink};
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		arenas_[column].append(values[column].data(), values[column].size());
+		offsets_[column].push_back(arenas_[column].size());
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function appends the records of a view, with one copy of each
+column.
+* @param		RecordBatchView -- records (the records, not pointing into this batch)
+* @return		void
+*******************************************************************************
+*/
+void RecordBatch::append(const RecordBatchView& records)
+{
+	size_t numberRecords = records.size();
+	if (numberRecords == 0) {
+		return;
+	}
+	productIDs_.insert(productIDs_.end(), records.productIDs_, records.productIDs_ + numberRecords);
+	originalPriceCents_.insert(originalPriceCents_.end(), records.originalPriceCents_,
+		records.originalPriceCents_ + numberRecords);
+	currentPriceCents_.insert(currentPriceCents_.end(), records.currentPriceCents_,
+		records.currentPriceCents_ + numberRecords);
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		const boost::uint64_t* offsets = records.offsets_[column];
+		boost::uint64_t base = arenas_[column].size();
+		arenas_[column].append(records.arenas_[column] + offsets[0], offsets[numberRecords] - offsets[0]);
+		vector<boost::uint64_t>& columnOffsets = offsets_[column];
+		columnOffsets.reserve(columnOffsets.size() + numberRecords);
+		for (size_t i = 1; i <= numberRecords; i++) {
+			columnOffsets.push_back(base + offsets[i] - offsets[0]);
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function removes the first records of the batch.
+* @param		size_t -- count (the number of records to remove)
+* @return		void
+*******************************************************************************
+*/
+void RecordBatch::eraseFront(size_t count)
+{
+	count = min(count, size());
+	productIDs_.erase(productIDs_.begin(), productIDs_.begin() + count);
+	originalPriceCents_.erase(originalPriceCents_.begin(), originalPriceCents_.begin() + count);
+	currentPriceCents_.erase(currentPriceCents_.begin(), currentPriceCents_.begin() + count);
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		vector<boost::uint64_t>& offsets = offsets_[column];
+		boost::uint64_t cut = offsets[count];
+		arenas_[column].erase(0, cut);
+		offsets.erase(offsets.begin(), offsets.begin() + count);
+		for (size_t i = 0; i < offsets.size(); i++) {
+			offsets[i] -= cut;
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function removes all the records. The memory is kept for the
+next records.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void RecordBatch::clear()
+{
+	productIDs_.clear();
+	originalPriceCents_.clear();
+	currentPriceCents_.clear();
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		offsets_[column].resize(1);
+		arenas_[column].clear();
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function exchanges the records with another batch.
+* @param		RecordBatch& -- other (the other batch)
+* @return		void
+*******************************************************************************
+*/
+void RecordBatch::swap(RecordBatch& other)
+{
+	productIDs_.swap(other.productIDs_);
+	originalPriceCents_.swap(other.originalPriceCents_);
+	currentPriceCents_.swap(other.currentPriceCents_);
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		offsets_[column].swap(other.offsets_[column]);
+		arenas_[column].swap(other.arenas_[column]);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		These functions return the number of records, and whether there is
+none.
+*******************************************************************************
+*/
+size_t RecordBatch::size() const
+{
+	return productIDs_.size();
+}
+
+bool RecordBatch::empty() const
+{
+	return productIDs_.empty();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns a view of the records. It is invalidated by
+any change of the batch.
+* @param		none
+* @return		RecordBatchView -- the records
+*******************************************************************************
+*/
+RecordBatchView RecordBatch::view() const
+{
+	RecordBatchView records;
+	records.numberRecords_ = productIDs_.size();
+	if (!productIDs_.empty()) {
+		records.productIDs_ = &productIDs_[0];
+		records.originalPriceCents_ = &originalPriceCents_[0];
+		records.currentPriceCents_ = &currentPriceCents_[0];
+	}
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		records.offsets_[column] = &offsets_[column][0];
+		records.arenas_[column] = arenas_[column].data();
+	}
+	return records;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the memory allocated by the batch.
+* @param		none
+* @return		size_t -- the number of bytes
+*******************************************************************************
+*/
+size_t RecordBatch::memoryUsage() const
+{
+	size_t bytes = (productIDs_.capacity() + originalPriceCents_.capacity() +
+		currentPriceCents_.capacity()) * sizeof(boost::int64_t);
+	for (int column = 0; column < NUMBER_STRING_COLUMNS; column++) {
+		bytes += offsets_[column].capacity() * sizeof(boost::uint64_t) + arenas_[column].capacity();
+	}
+	return bytes;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class MappedRecordBatch.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+MappedRecordBatch::MappedRecordBatch() : data_(NULL), size_(0)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class MappedRecordBatch.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+MappedRecordBatch::~MappedRecordBatch()
+{
+	close();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function maps a file of records and checks its layout.
+* @param		string -- fileName (the path of the file)
+* @return		int -- return 0 on success, and 1 if the file cannot be mapped or
+is damaged.
+*******************************************************************************
+*/
+int MappedRecordBatch::open(const string& fileName)
+{
+	close();
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cerr << "Failed to open " << fileName << std::endl;
+		return 1;
+	}
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+		::close(fd);
+		return 1;
+	}
+	void* data = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		std::cerr << "Failed to map " << fileName << std::endl;
+		return 1;
+	}
+	data_ = data;
+	size_ = fileStat.st_size;
+	if (view_.attach(static_cast<const char*>(data_), size_) == 0) {
+		std::cerr << "The record file " << fileName << " is damaged" << std::endl;
+		close();
+		return 1;
+	}
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function unmaps the file.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void MappedRecordBatch::close()
+{
+	if (data_ != NULL) {
+		munmap(data_, size_);
+		data_ = NULL;
+		size_ = 0;
+	}
+	view_ = RecordBatchView();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the records of the mapped file.
+* @param		none
+* @return		RecordBatchView -- the records, valid until the file is unmapped
+*******************************************************************************
+*/
+const RecordBatchView& MappedRecordBatch::view() const
+{
+	return view_;
+}
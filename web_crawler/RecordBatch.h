@@ -0,0 +1,190 @@
+/**
+*******************************************************************************
+* @file		RecordBatch.h
+* @brief	This file provides the interfaces of the classes RecordBatchView,
+RecordBatch and MappedRecordBatch.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _RECORDBATCH_H_
+#define _RECORDBATCH_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//boost lib
+#include <boost/cstdint.hpp>
+#include <boost/utility/string_view.hpp>
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+//the string columns of a product record
+enum RecordStringColumn
+{
+	COLUMN_CATEGORY = 0,
+	COLUMN_DESCRIPTION = 1,
+	COLUMN_IMAGE_LINK = 2,
+	NUMBER_STRING_COLUMNS = 3
+};
+
+
+/**
+*******************************************************************************
+* @class		RecordBatchView
+* @brief 		This class reads product records stored by columns: the product
+ids and the original and current prices (in cents) are contiguous arrays, and
+each string column is one byte arena with numberRecords + 1 offsets. A view does
+not own its memory: it points into a RecordBatch, which must not be modified
+while the view is used, or into a mapped file.
+
+Binary layout (native byte order, every section 8-byte aligned):
+  u32 magic 'WDXB', u32 number of string columns, u64 number of records n,
+  u64 arena size of each string column,
+  i64 product ids[n], i64 original prices[n], i64 current prices[n],
+  u64 offsets[n + 1] of each string column (the first is 0),
+  the bytes of each string column, padded to 8 bytes
+*******************************************************************************
+*/
+class RecordBatchView
+{
+	friend class RecordBatch;
+
+	private:
+		//the number of records
+		size_t numberRecords_;
+		//the numeric columns
+		const boost::int64_t* productIDs_;
+		const boost::int64_t* originalPriceCents_;
+		const boost::int64_t* currentPriceCents_;
+		//the offsets and the bytes of the string columns
+		const boost::uint64_t* offsets_[NUMBER_STRING_COLUMNS];
+		const char* arenas_[NUMBER_STRING_COLUMNS];
+
+	public:
+ 		//constructor: no record
+ 		RecordBatchView();
+ 		//get the number of records
+ 		size_t size() const { return numberRecords_; }
+ 		//check whether there is no record
+ 		bool empty() const { return numberRecords_ == 0; }
+ 		//get the fields of a record
+ 		boost::int64_t getProductID(size_t i) const { return productIDs_[i]; }
+ 		boost::int64_t getOriginalPriceCents(size_t i) const { return originalPriceCents_[i]; }
+ 		boost::int64_t getCurrentPriceCents(size_t i) const { return currentPriceCents_[i]; }
+ 		boost::string_view getString(RecordStringColumn column, size_t i) const
+ 		{
+ 			return boost::string_view(arenas_[column] + offsets_[column][i],
+ 				offsets_[column][i + 1] - offsets_[column][i]);
+ 		}
+ 		boost::string_view getCategory(size_t i) const { return getString(COLUMN_CATEGORY, i); }
+ 		boost::string_view getDescription(size_t i) const { return getString(COLUMN_DESCRIPTION, i); }
+ 		boost::string_view getImageLink(size_t i) const { return getString(COLUMN_IMAGE_LINK, i); }
+ 		//get the numeric columns, for scans over all the records
+ 		const boost::int64_t* getProductIDColumn() const { return productIDs_; }
+ 		const boost::int64_t* getOriginalPriceColumn() const { return originalPriceCents_; }
+ 		const boost::int64_t* getCurrentPriceColumn() const { return currentPriceCents_; }
+ 		//get the records [begin, end) of the view
+ 		RecordBatchView slice(size_t begin, size_t end) const;
+ 		//get the number of bytes of the view in the binary layout
+ 		size_t getEncodedSize() const;
+ 		//write the view in the binary layout, return false on a write error
+ 		bool write(FILE* file) const;
+ 		//write the view into a new file, return 0 on success
+ 		int writeFile(const string& fileName) const;
+ 		/*point the view to records in the binary layout (8-byte aligned), return
+ 		the number of bytes used, or 0 if the data is damaged */
+ 		size_t attach(const char* data, size_t size);
+
+}; //end of class RecordBatchView
+
+
+/**
+*******************************************************************************
+* @class		RecordBatch
+* @brief 		This class holds product records by columns. Appending a record
+copies its strings into the arena of their column: the records of a page cost
+no allocation once the batch has grown, and a batch is appended to another with
+one copy per column.
+*******************************************************************************
+*/
+class RecordBatch
+{
+	private:
+		//the numeric columns
+		vector<boost::int64_t> productIDs_;
+		vector<boost::int64_t> originalPriceCents_;
+		vector<boost::int64_t> currentPriceCents_;
+		//the offsets and the bytes of the string columns
+		vector<boost::uint64_t> offsets_[NUMBER_STRING_COLUMNS];
+		string arenas_[NUMBER_STRING_COLUMNS];
+
+	public:
+ 		//constructor: no record
+ 		RecordBatch();
+ 		//append a record
+ 		void append(boost::int64_t productID, boost::string_view category,
+ 			boost::string_view description, boost::string_view imageLink,
+ 			boost::int64_t originalPriceCents, boost::int64_t currentPriceCents);
+ 		//append the records of a view
+ 		void append(const RecordBatchView& records);
+ 		//remove the first count records
+ 		void eraseFront(size_t count);
+ 		//remove all the records, keeping the allocated memory
+ 		void clear();
+ 		//exchange the records with another batch
+ 		void swap(RecordBatch& other);
+ 		//get the number of records
+ 		size_t size() const;
+ 		//check whether there is no record
+ 		bool empty() const;
+ 		//get a view of the records, valid until the batch is modified
+ 		RecordBatchView view() const;
+ 		//get the number of bytes allocated by the batch
+ 		size_t memoryUsage() const;
+
+}; //end of class RecordBatch
+
+
+/**
+*******************************************************************************
+* @class		MappedRecordBatch
+* @brief 		This class maps a file written by RecordBatchView::writeFile()
+and reads its records in place.
+*******************************************************************************
+*/
+class MappedRecordBatch
+{
+	private:
+		//the mapped file
+		void* data_;
+		size_t size_;
+		//the records of the file
+		RecordBatchView view_;
+
+		//copying would unmap the file twice
+		MappedRecordBatch(const MappedRecordBatch&);
+		MappedRecordBatch& operator=(const MappedRecordBatch&);
+
+	public:
+ 		//constructor: no file
+ 		MappedRecordBatch();
+ 		//destructor: unmaps the file
+ 		~MappedRecordBatch();
+ 		//map a file, return 0 on success
+ 		int open(const string& fileName);
+ 		//unmap the file
+ 		void close();
+ 		//get the records of the file
+ 		const RecordBatchView& view() const;
+
+}; //end of class MappedRecordBatch
+
+} //end of namespace WebDataExtraction
+
+#endif //_RECORDBATCH_H_
@@ -0,0 +1,109 @@
+/**
+*******************************************************************************
+* @file			ResourceUsage.cpp
+* @brief 		This file provides the functions reporting the memory usage of the
+crawler. Built with -DCOUNT_ALLOCATIONS, it replaces the global operator new to
+count the heap allocations.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "ResourceUsage.h"
+
+#include <sys/resource.h>
+#include <cstdlib>
+#include <new>
+
+#include <boost/atomic.hpp>
+
+//namespaces used in this file
+using namespace std;
+
+
+
+#ifdef COUNT_ALLOCATIONS
+//the number of calls to operator new
+static boost::atomic<long> numberAllocations(0);
+
+void* operator new(size_t size)
+{
+	numberAllocations.fetch_add(1, boost::memory_order_relaxed);
+	void* ptr = malloc(size ? size : 1);
+	if (ptr == NULL) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) throw()
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) throw()
+{
+	free(ptr);
+}
+#endif
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the peak resident set size of the process.
+* @param		none
+* @return		long -- the peak RSS in kilobytes
+*******************************************************************************
+*/
+long WebDataExtraction::getPeakRSSKilobytes()
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+	return usage.ru_maxrss;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the CPU time used by all the threads of the
+process.
+* @param		none
+* @return		long -- the user and system time in microseconds
+*******************************************************************************
+*/
+long WebDataExtraction::getCPUMicroseconds()
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+	return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000L +
+		usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of heap allocations.
+* @param		none
+* @return		long -- the calls to operator new, or -1 if they are not counted
+*******************************************************************************
+*/
+long WebDataExtraction::getNumberAllocations()
+{
+#ifdef COUNT_ALLOCATIONS
+	return numberAllocations.load(boost::memory_order_relaxed);
+#else
+	return -1;
+#endif
+}
@@ -0,0 +1,29 @@
+/**
+*******************************************************************************
+* @file		ResourceUsage.h
+* @brief	This file provides the functions reporting the memory usage of the
+crawler.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _RESOURCEUSAGE_H_
+#define _RESOURCEUSAGE_H_
+
+#include <cstddef>
+
+namespace WebDataExtraction
+{
+
+//get the peak resident set size of the process in kilobytes
+long getPeakRSSKilobytes();
+//get the CPU time (user and system) used by the process in microseconds
+long getCPUMicroseconds();
+/*get the number of heap allocations made by operator new in the process, or -1
+if the crawler was not built with -DCOUNT_ALLOCATIONS */
+long getNumberAllocations();
+
+} //end of namespace WebDataExtraction
+
+#endif //_RESOURCEUSAGE_H_
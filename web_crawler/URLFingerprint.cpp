@@ -0,0 +1,56 @@
+/**
+*******************************************************************************
+* @file			URLFingerprint.cpp
+* @brief 		This file provides the implementation of the URL fingerprint function.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "URLFingerprint.h"
+
+//namespaces used in this file
+using namespace std;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function computes the 64-bit fingerprint of a URL. FNV-1a
+hashes the bytes, and the finalizer spreads them over all 64 bits, so that the
+low bits can select a shard and the high bits a bucket.
+* @param		string -- url (the validated URL)
+* @return		URLFingerprint -- the fingerprint of the URL
+*******************************************************************************
+*/
+WebDataExtraction::URLFingerprint WebDataExtraction::fingerprintURL(const string& url)
+{
+	return fingerprintBytes(url.data(), url.size());
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function computes the 64-bit hash of a byte array, the same
+way as fingerprintURL().
+* @param		char* -- data (the bytes)
+* @param		size_t -- length (the number of bytes)
+* @return		uint64_t -- the hash of the bytes
+*******************************************************************************
+*/
+boost::uint64_t WebDataExtraction::fingerprintBytes(const char* data, size_t length)
+{
+	boost::uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ULL;
+	}
+	//finalizer of splitmix64
+	hash ^= hash >> 30;
+	hash *= 0xbf58476d1ce4e5b9ULL;
+	hash ^= hash >> 27;
+	hash *= 0x94d049bb133111ebULL;
+	hash ^= hash >> 31;
+	return hash;
+}
@@ -0,0 +1,31 @@
+/**
+*******************************************************************************
+* @file		URLFingerprint.h
+* @brief	This file provides the interface of the URL fingerprint function.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _URLFINGERPRINT_H_
+#define _URLFINGERPRINT_H_
+
+#include <string>
+#include <boost/cstdint.hpp>
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+//the 64-bit fingerprint identifying a URL in the seen-URL structures
+typedef boost::uint64_t URLFingerprint;
+
+//compute the fingerprint of a URL (FNV-1a followed by a 64-bit finalizer)
+URLFingerprint fingerprintURL(const string& url);
+//compute the same 64-bit hash over a byte array (e.g. the content of a page)
+boost::uint64_t fingerprintBytes(const char* data, size_t length);
+
+} //end of namespace WebDataExtraction
+
+#endif //_URLFINGERPRINT_H_
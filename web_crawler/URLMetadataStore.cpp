@@ -0,0 +1,222 @@
+/**
+*******************************************************************************
+* @file			URLMetadataStore.cpp
+* @brief 		This file provides the implementations of the class URLMetadataStore.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "URLMetadataStore.h"
+#include "AsyncLogger.h"
+
+#include <iostream>
+#include <unistd.h>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class URLMetadataStore.
+* @param		string -- fileName (the path of the log file)
+* @return		None
+*******************************************************************************
+*/
+URLMetadataStore::URLMetadataStore(const string& fileName) : fileName_(fileName),
+	logFile_(NULL)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class URLMetadataStore.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+URLMetadataStore::~URLMetadataStore()
+{
+	close();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function appends one record to a file.
+* @param		FILE* -- file (the log file)
+* @param		URLFingerprint -- fingerprint (the fingerprint of the URL)
+* @param		URLMetadata -- metadata (the metadata of the URL)
+* @return		bool -- return false on a write error
+*******************************************************************************
+*/
+bool URLMetadataStore::writeRecord(FILE* file, URLFingerprint fingerprint,
+	const URLMetadata& metadata)
+{
+	boost::int64_t fetchTime = metadata.fetchTime;
+	boost::uint32_t etagLength = (boost::uint32_t)metadata.etag.size();
+	boost::uint32_t lastModifiedLength = (boost::uint32_t)metadata.lastModified.size();
+	return fwrite(&fingerprint, sizeof(fingerprint), 1, file) == 1 &&
+		fwrite(&fetchTime, sizeof(fetchTime), 1, file) == 1 &&
+		fwrite(&metadata.contentHash, sizeof(metadata.contentHash), 1, file) == 1 &&
+		fwrite(&etagLength, sizeof(etagLength), 1, file) == 1 &&
+		fwrite(&lastModifiedLength, sizeof(lastModifiedLength), 1, file) == 1 &&
+		fwrite(metadata.etag.data(), 1, etagLength, file) == etagLength &&
+		fwrite(metadata.lastModified.data(), 1, lastModifiedLength, file) == lastModifiedLength;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function replays the log of the previous crawls, later
+records of a URL replacing earlier ones, and opens the log for appending. A
+record cut off by a crash is ignored.
+* @param		none
+* @return		int -- return 0 if the store is ready, and 1 if it fails.
+*******************************************************************************
+*/
+int URLMetadataStore::open()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	FILE* file = fopen(fileName_.c_str(), "rb");
+	long validSize = 0;
+	if (file != NULL) {
+		while (true) {
+			URLFingerprint fingerprint;
+			boost::int64_t fetchTime;
+			boost::uint32_t etagLength;
+			boost::uint32_t lastModifiedLength;
+			URLMetadata metadata;
+			if (fread(&fingerprint, sizeof(fingerprint), 1, file) != 1 ||
+					fread(&fetchTime, sizeof(fetchTime), 1, file) != 1 ||
+					fread(&metadata.contentHash, sizeof(metadata.contentHash), 1, file) != 1 ||
+					fread(&etagLength, sizeof(etagLength), 1, file) != 1 ||
+					fread(&lastModifiedLength, sizeof(lastModifiedLength), 1, file) != 1) {
+				break;
+			}
+			metadata.etag.resize(etagLength);
+			metadata.lastModified.resize(lastModifiedLength);
+			if ((etagLength > 0 && fread(&metadata.etag[0], 1, etagLength, file) != etagLength) ||
+					(lastModifiedLength > 0 && fread(&metadata.lastModified[0], 1,
+					lastModifiedLength, file) != lastModifiedLength)) {
+				break;
+			}
+			metadata.fetchTime = (time_t)fetchTime;
+			metadataMap_[fingerprint] = metadata;
+			validSize = ftell(file);
+		}
+		fclose(file);
+		//drop a record cut off by a crash, so that appended records stay readable
+		if (truncate(fileName_.c_str(), validSize) != 0) {
+			std::cerr << "Failed to repair the URL metadata log " << fileName_ << std::endl;
+		}
+	}
+
+	logFile_ = fopen(fileName_.c_str(), "ab");
+	if (logFile_ == NULL) {
+		std::cerr << "Failed to open the URL metadata log " << fileName_ << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the metadata of a URL.
+* @param		string -- url (the validated URL)
+* @param		URLMetadata& -- metadata (output, the metadata of the last fetch)
+* @return		bool -- return true if the URL has been fetched before
+*******************************************************************************
+*/
+bool URLMetadataStore::get(const string& url, URLMetadata& metadata)
+{
+	URLFingerprint fingerprint = fingerprintURL(url);
+	boost::mutex::scoped_lock lock(mutex_);
+	boost::unordered_map<URLFingerprint, URLMetadata>::const_iterator it =
+		metadataMap_.find(fingerprint);
+	if (it == metadataMap_.end()) {
+		return false;
+	}
+	metadata = it->second;
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function records the metadata of a URL and appends it to
+the log.
+* @param		string -- url (the validated URL)
+* @param		URLMetadata -- metadata (the metadata of the last fetch)
+* @return		void
+*******************************************************************************
+*/
+void URLMetadataStore::update(const string& url, const URLMetadata& metadata)
+{
+	URLFingerprint fingerprint = fingerprintURL(url);
+	boost::mutex::scoped_lock lock(mutex_);
+	metadataMap_[fingerprint] = metadata;
+	if (logFile_ != NULL && !writeRecord(logFile_, fingerprint, metadata)) {
+		AsyncLogger::getShared().log(LOG_ERROR, "Failed to write the URL metadata log {}", fileName_);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function rewrites the log with one record per URL into a
+temporary file, renames it over the log, and closes the store.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void URLMetadataStore::close()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	if (logFile_ == NULL) {
+		return;
+	}
+	fclose(logFile_);
+	logFile_ = NULL;
+
+	string tempFileName = fileName_ + ".tmp";
+	FILE* file = fopen(tempFileName.c_str(), "wb");
+	bool isWritten = (file != NULL);
+	for (boost::unordered_map<URLFingerprint, URLMetadata>::const_iterator it =
+			metadataMap_.begin(); isWritten && it != metadataMap_.end(); it++) {
+		isWritten = writeRecord(file, it->first, it->second);
+	}
+	if (file != NULL) {
+		isWritten = (fclose(file) == 0) && isWritten;
+	}
+	//the log is still complete if the compaction fails
+	if (!isWritten || rename(tempFileName.c_str(), fileName_.c_str()) != 0) {
+		remove(tempFileName.c_str());
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of URLs in the store.
+* @param		none
+* @return		size_t -- the number of URLs fetched by this or previous crawls
+*******************************************************************************
+*/
+size_t URLMetadataStore::size()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return metadataMap_.size();
+}
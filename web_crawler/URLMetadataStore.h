@@ -0,0 +1,99 @@
+/**
+*******************************************************************************
+* @file		URLMetadataStore.h
+* @brief	This file provides the interfaces of the class URLMetadataStore.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _URLMETADATASTORE_H_
+#define _URLMETADATASTORE_H_
+
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+//boost lib
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "URLFingerprint.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @struct		URLMetadata
+* @brief 		This structure holds what is known about the last fetch of a URL.
+*******************************************************************************
+*/
+struct URLMetadata
+{
+	//the ETag header of the last response ("" if none)
+	string etag;
+	//the Last-Modified header of the last response ("" if none)
+	string lastModified;
+	//the hash of the page content (see fingerprintBytes())
+	boost::uint64_t contentHash;
+	//the time of the last fetch (seconds since the epoch)
+	time_t fetchTime;
+};
+
+
+/**
+*******************************************************************************
+* @class		URLMetadataStore
+* @brief 		This class keeps the URLMetadata of every fetched URL, keyed by the
+URL fingerprint, across crawls. The next crawl sends the ETag and Last-Modified
+back as If-None-Match and If-Modified-Since, so that an unchanged page costs a
+304 response instead of a download, and compares the content hash to skip the
+extraction of a page which was downloaded again but has not changed.
+Updates are appended to a log file; open() replays it and close() rewrites it
+with one record per URL.
+
+Record layout (native byte order): u64 URL fingerprint, i64 fetch time,
+u64 content hash, u32 ETag length, u32 Last-Modified length, ETag, Last-Modified
+*******************************************************************************
+*/
+class URLMetadataStore
+{
+	private:
+		//the path of the log file
+		string fileName_;
+		//mutex protecting the members below
+		boost::mutex mutex_;
+		//the metadata of every URL
+		boost::unordered_map<URLFingerprint, URLMetadata> metadataMap_;
+		//the log file, open for appending
+		FILE* logFile_;
+
+		//append one record to a file, return false on a write error
+		static bool writeRecord(FILE* file, URLFingerprint fingerprint,
+			const URLMetadata& metadata);
+
+	public:
+ 		//constructor
+ 		URLMetadataStore(const string& fileName);
+ 		//destructor: closes the log file
+ 		~URLMetadataStore();
+ 		//load the log of the previous crawls and open it for appending, return 0 on success
+ 		int open();
+ 		//get the metadata of a URL, return false if the URL has never been fetched
+ 		bool get(const string& url, URLMetadata& metadata);
+ 		//record the metadata of a URL
+ 		void update(const string& url, const URLMetadata& metadata);
+ 		//compact the log to one record per URL and close it
+ 		void close();
+ 		//get the number of URLs
+ 		size_t size();
+
+}; //end of class URLMetadataStore
+
+} //end of namespace WebDataExtraction
+
+#endif //_URLMETADATASTORE_H_
@@ -0,0 +1,255 @@
+/**
+*******************************************************************************
+* @file			URLPrioritizer.cpp
+* @brief 		This file provides the implementations of the class URLPrioritizer.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "URLPrioritizer.h"
+
+#include <cctype>
+#include <algorithm>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+//the number of path segments kept in a pattern, the others become "*"
+static const int patternSegments = 2;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the structure PriorityConfig.
+It avoids the pages of the usual help, legal and account sections.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+PriorityConfig::PriorityConfig() : minPatternPages(8), depthPenalty(0.5)
+{
+	static const char* words[] = {"help", "legal", "privacy", "terms", "policy",
+		"policies", "login", "signin", "sign-in", "account", "cart", "checkout",
+		"careers", "contact", "about", "faq", "feedback", "accessibility"};
+	avoidedWords.assign(words, words + sizeof(words) / sizeof(words[0]));
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class URLPrioritizer.
+* @param		PriorityConfig -- config (the weights)
+* @return		None
+*******************************************************************************
+*/
+URLPrioritizer::URLPrioritizer(const PriorityConfig& config) : config_(config)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the pattern of a URL: its path without the
+scheme, the host and the query, the first segments with each run of digits
+folded into "#", and "*" in place of each further segment.
+* @param		string -- url (the validated URL)
+* @return		string -- the pattern, e.g. /p/# for /p/17, and /en/ip
+followed by two "*" segments for /en/ip/tv-32/6000195
+*******************************************************************************
+*/
+string URLPrioritizer::getPattern(const string& url)
+{
+	size_t pathStart = url.find("://");
+	pathStart = url.find('/', (pathStart == string::npos) ? 0 : pathStart + 3);
+	if (pathStart == string::npos) {
+		return "/";
+	}
+	size_t pathEnd = url.find_first_of("?#", pathStart);
+	if (pathEnd == string::npos) {
+		pathEnd = url.size();
+	}
+
+	string pattern;
+	int numberSegments = 0;
+	for (size_t i = pathStart; i < pathEnd; i++) {
+		if (url[i] == '/') {
+			numberSegments++;
+			pattern += '/';
+			if (numberSegments > patternSegments && i + 1 < pathEnd) {
+				pattern += '*';
+			}
+		}
+		else if (numberSegments > patternSegments) {
+			continue;
+		}
+		else if (isdigit((unsigned char)url[i])) {
+			if (pattern[pattern.size() - 1] != '#') {
+				pattern += '#';
+			}
+		}
+		else {
+			pattern += (char)tolower((unsigned char)url[i]);
+		}
+	}
+	return pattern;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the id of a pattern, and registers it if it
+is new. The caller holds mutex_.
+* @param		string -- pattern (the pattern)
+* @return		int -- the id, or -1 if MAX_PATTERNS patterns are registered
+*******************************************************************************
+*/
+int URLPrioritizer::findPattern(const string& pattern)
+{
+	boost::unordered_map<string, int>::iterator it = patternMap_.find(pattern);
+	if (it != patternMap_.end()) {
+		return it->second;
+	}
+	if ((int)yieldVector_.size() >= MAX_PATTERNS) {
+		return -1;
+	}
+	PatternYield yield = {0, 0, 0, 0};
+	yieldVector_.push_back(yield);
+	patternMap_[pattern] = (int)yieldVector_.size() - 1;
+	return (int)yieldVector_.size() - 1;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the id of the pattern of a URL.
+* @param		string -- url (the validated URL)
+* @return		int -- the id, or -1 if MAX_PATTERNS patterns are registered
+*******************************************************************************
+*/
+int URLPrioritizer::getPatternID(const string& url)
+{
+	string pattern = getPattern(url);
+	boost::mutex::scoped_lock lock(mutex_);
+	return findPattern(pattern);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the score of a yield: 0 until minPatternPages
+pages are known, then -weight if no record has been found, or between weight and
+2 * weight as the yield rises to one record per page.
+* @param		long -- numberPages (the pages crawled)
+* @param		long -- numberRecords (the records extracted from them)
+* @param		int -- weight (the weight of the yield)
+* @return		int -- the score
+*******************************************************************************
+*/
+int URLPrioritizer::scoreYield(long numberPages, long numberRecords, int weight) const
+{
+	if (numberPages < config_.minPatternPages) {
+		return 0;
+	}
+	if (numberRecords == 0) {
+		return -weight;
+	}
+	double yield = min(1.0, (double)numberRecords / numberPages);
+	return weight + (int)(weight * yield);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the priority of a URL. It starts in the
+middle of the range; the yield of the pattern of the URL weighs the most, the
+pages linked from the pattern of the source page half as much, and each link
+followed from the seed costs depthPenalty.
+* @param		string -- url (the validated URL)
+* @param		LinkOrigin -- origin (the depth and the source page of the link)
+* @return		int -- the priority, from 0 to NUMBER_PRIORITIES - 1, the highest
+being crawled first
+*******************************************************************************
+*/
+int URLPrioritizer::getPriority(const string& url, const LinkOrigin& origin)
+{
+	string pattern = getPattern(url);
+	int priority = NUMBER_PRIORITIES / 2;
+	bool isPatternKnown = false;
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		boost::unordered_map<string, int>::iterator it = patternMap_.find(pattern);
+		if (it != patternMap_.end()) {
+			const PatternYield& yield = yieldVector_[it->second];
+			isPatternKnown = (yield.numberPages >= config_.minPatternPages);
+			priority += scoreYield(yield.numberPages, yield.numberRecords, 8);
+		}
+		if (origin.sourcePattern >= 0 && origin.sourcePattern < (int)yieldVector_.size()) {
+			const PatternYield& yield = yieldVector_[origin.sourcePattern];
+			priority += scoreYield(yield.numberLinkedPages, yield.numberLinkedRecords, 4);
+		}
+	}
+
+	//until its yield is known, a pattern is judged by its words
+	if (!isPatternKnown) {
+		for (size_t i = 0; i < config_.avoidedWords.size(); i++) {
+			if (pattern.find(config_.avoidedWords[i]) != string::npos) {
+				priority -= 12;
+				break;
+			}
+		}
+	}
+	priority -= (int)(origin.depth * config_.depthPenalty);
+	return max(0, min(NUMBER_PRIORITIES - 1, priority));
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function learns the number of records extracted from a page,
+for its pattern and for the pages linked from the pattern of its source page.
+* @param		string -- url (the URL of the page)
+* @param		LinkOrigin -- origin (the origin of the page in the frontier)
+* @param		int -- numberRecords (the records extracted from the page)
+* @return		void
+*******************************************************************************
+*/
+void URLPrioritizer::recordYield(const string& url, const LinkOrigin& origin,
+	int numberRecords)
+{
+	string pattern = getPattern(url);
+	boost::mutex::scoped_lock lock(mutex_);
+	int patternID = findPattern(pattern);
+	if (patternID >= 0) {
+		yieldVector_[patternID].numberPages++;
+		yieldVector_[patternID].numberRecords += numberRecords;
+	}
+	if (origin.sourcePattern >= 0 && origin.sourcePattern < (int)yieldVector_.size()) {
+		yieldVector_[origin.sourcePattern].numberLinkedPages++;
+		yieldVector_[origin.sourcePattern].numberLinkedRecords += numberRecords;
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of patterns learned.
+* @param		none
+* @return		size_t -- the number of patterns
+*******************************************************************************
+*/
+size_t URLPrioritizer::getNumberPatterns()
+{
+	boost::mutex::scoped_lock lock(mutex_);
+	return yieldVector_.size();
+}
@@ -0,0 +1,130 @@
+/**
+*******************************************************************************
+* @file		URLPrioritizer.h
+* @brief	This file provides the interfaces of the class URLPrioritizer.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _URLPRIORITIZER_H_
+#define _URLPRIORITIZER_H_
+
+#include <string>
+#include <vector>
+
+//boost lib
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @struct		LinkOrigin
+* @brief 		This structure holds where a link of the frontier was found: the
+depth of the link from the seed, and the pattern of the page linking to it.
+*******************************************************************************
+*/
+struct LinkOrigin
+{
+	//the number of links followed from the seed
+	int depth;
+	//the URLPrioritizer pattern id of the page the link was found on, -1 if none
+	int sourcePattern;
+
+	//constructor: a seed
+	LinkOrigin(int depth = 0, int sourcePattern = -1) : depth(depth),
+		sourcePattern(sourcePattern) {}
+};
+
+
+/**
+*******************************************************************************
+* @struct		PriorityConfig
+* @brief 		This structure holds the weights of the URL priorities.
+*******************************************************************************
+*/
+struct PriorityConfig
+{
+	//the words of a URL path which hardly ever lead to products (help, legal pages)
+	vector<string> avoidedWords;
+	//the number of pages of a pattern after which its yield is trusted
+	int minPatternPages;
+	//the priority lost per link followed from the seed
+	double depthPenalty;
+
+	//constructor with the default weights
+	PriorityConfig();
+};
+
+
+/**
+*******************************************************************************
+* @class		URLPrioritizer
+* @brief 		This class scores the URLs of the frontier, so that the pages
+holding products are crawled first. A URL is reduced to its pattern: the first
+two segments of its path with the digits folded, and one "*" per further
+segment, so that the product pages of a site, e.g. /en/ip/<name>/<id>, share
+one pattern. The yield of each pattern, the records extracted per page, is
+learned during the crawl, both for the pages of the pattern and for the pages
+they link to. The priority of a URL
+rises with the yield of its pattern and of the pattern of the page linking to
+it, and falls with its depth; a pattern not crawled enough yet is judged by the
+words of its path instead.
+*******************************************************************************
+*/
+class URLPrioritizer
+{
+	public:
+		//the number of priorities, 0 being the lowest
+		static const int NUMBER_PRIORITIES = 64;
+		//the maximum number of patterns learned, the others are judged by their words
+		static const int MAX_PATTERNS = 4096;
+
+	private:
+		//the pages and the records of a pattern, and of the pages it links to
+		struct PatternYield
+		{
+			long numberPages;
+			long numberRecords;
+			long numberLinkedPages;
+			long numberLinkedRecords;
+		};
+
+		//the weights
+		PriorityConfig config_;
+		//mutex protecting the patterns
+		boost::mutex mutex_;
+		//the ids of the patterns
+		boost::unordered_map<string, int> patternMap_;
+		//the yields, indexed by pattern id
+		vector<PatternYield> yieldVector_;
+
+		//get the id of a pattern, registered if new; -1 if there are too many (locked)
+		int findPattern(const string& pattern);
+		//get the score of a yield: positive if it is known and not 0 (locked)
+		int scoreYield(long numberPages, long numberRecords, int weight) const;
+
+	public:
+ 		//constructor
+ 		URLPrioritizer(const PriorityConfig& config = PriorityConfig());
+ 		//get the pattern of a URL
+ 		static string getPattern(const string& url);
+ 		//get the id of the pattern of a URL, -1 if there are too many patterns
+ 		int getPatternID(const string& url);
+ 		//get the priority of a URL, from 0 to NUMBER_PRIORITIES - 1
+ 		int getPriority(const string& url, const LinkOrigin& origin);
+ 		//learn the number of records extracted from a page
+ 		void recordYield(const string& url, const LinkOrigin& origin, int numberRecords);
+ 		//get the number of patterns learned
+ 		size_t getNumberPatterns();
+
+}; //end of class URLPrioritizer
+
+} //end of namespace WebDataExtraction
+
+#endif //_URLPRIORITIZER_H_
@@ -0,0 +1,219 @@
+/**
+*******************************************************************************
+* @file			URLSeenFilter.cpp
+* @brief 		This file provides the implementations of the class URLSeenFilter.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "URLSeenFilter.h"
+
+#include <cstdlib>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class URLSeenFilter.
+* @param		Mode -- mode (EXACT or BLOOM)
+* @param		size_t -- expectedURLs (the number of URLs the Bloom filter is sized for)
+* @param		double -- falsePositiveRate (the false-positive rate of the Bloom
+filter at expectedURLs)
+* @return		None
+*******************************************************************************
+*/
+URLSeenFilter::URLSeenFilter(Mode mode, size_t expectedURLs, double falsePositiveRate) :
+	mode_(mode)
+{
+	reset(mode, expectedURLs, falsePositiveRate);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function empties the filter and selects its mode, e.g. from
+the command line. It must be called before the first insertion.
+* @param		Mode -- mode (EXACT or BLOOM)
+* @param		size_t -- expectedURLs (the number of URLs the Bloom filter is sized for)
+* @param		double -- falsePositiveRate (the false-positive rate of the Bloom
+filter at expectedURLs)
+* @return		void
+*******************************************************************************
+*/
+void URLSeenFilter::reset(Mode mode, size_t expectedURLs, double falsePositiveRate)
+{
+	mode_ = mode;
+	if (mode_ == BLOOM) {
+		ptrSeenSet_.reset();
+		ptrBloomFilter_.reset(new BlockedBloomFilter(expectedURLs, falsePositiveRate));
+	}
+	else {
+		ptrBloomFilter_.reset();
+		ptrSeenSet_.reset(new URLSeenSet);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function parses a mode: "exact", "bloom", or "bloom:" followed
+by the false-positive rate, e.g. bloom:0.0001.
+* @param		string -- text (the mode)
+* @param		Mode& -- mode (output, the mode)
+* @param		double& -- falsePositiveRate (output, the rate if one is given,
+unchanged otherwise)
+* @return		bool -- return true if the text is a mode and its rate is between 0
+and 1
+*******************************************************************************
+*/
+bool URLSeenFilter::parseMode(const string& text, Mode& mode, double& falsePositiveRate)
+{
+	if (text == "exact") {
+		mode = EXACT;
+		return true;
+	}
+	if (text.compare(0, 5, "bloom") != 0 || (text.size() > 5 && text[5] != ':')) {
+		return false;
+	}
+	if (text.size() > 5) {
+		char* end;
+		double rate = strtod(text.c_str() + 6, &end);
+		if (end == text.c_str() + 6 || *end != '\0' || rate <= 0.0 || rate >= 1.0) {
+			return false;
+		}
+		falsePositiveRate = rate;
+	}
+	mode = BLOOM;
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function inserts a URL if it has not been seen before.
+* @param		string -- url (the validated URL)
+* @return		bool -- return true if the URL is new.
+*******************************************************************************
+*/
+bool URLSeenFilter::insert(const string& url)
+{
+	return insert(fingerprintURL(url));
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function inserts a fingerprint if it has not been seen before.
+* @param		URLFingerprint -- fingerprint (the fingerprint of the URL)
+* @return		bool -- return true if the fingerprint is new.
+*******************************************************************************
+*/
+bool URLSeenFilter::insert(URLFingerprint fingerprint)
+{
+	if (mode_ == BLOOM) {
+		return ptrBloomFilter_->insert(fingerprint);
+	}
+	return ptrSeenSet_->insert(fingerprint);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the mode.
+* @param		none
+* @return		Mode -- EXACT or BLOOM
+*******************************************************************************
+*/
+URLSeenFilter::Mode URLSeenFilter::getMode() const
+{
+	return mode_;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of URLs seen.
+* @param		none
+* @return		size_t -- the number of URLs reported as new
+*******************************************************************************
+*/
+size_t URLSeenFilter::size()
+{
+	if (mode_ == BLOOM) {
+		return ptrBloomFilter_->size();
+	}
+	return ptrSeenSet_->size();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the memory used to record the URLs.
+* @param		none
+* @return		size_t -- the number of bytes (approximate in the EXACT mode)
+*******************************************************************************
+*/
+size_t URLSeenFilter::memoryUsage()
+{
+	if (mode_ == BLOOM) {
+		return ptrBloomFilter_->memoryUsage();
+	}
+	return ptrSeenSet_->memoryUsage();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the expected false-positive rate.
+* @param		none
+* @return		double -- the probability that a new URL is reported as seen
+*******************************************************************************
+*/
+double URLSeenFilter::expectedFalsePositiveRate()
+{
+	if (mode_ == BLOOM) {
+		return ptrBloomFilter_->expectedFalsePositiveRate();
+	}
+	return 0.0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the exact set.
+* @param		none
+* @return		URLSeenSet* -- the set, or NULL in the BLOOM mode
+*******************************************************************************
+*/
+URLSeenSet* URLSeenFilter::getSeenSet()
+{
+	return ptrSeenSet_.get();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the Bloom filter.
+* @param		none
+* @return		BlockedBloomFilter* -- the filter, or NULL in the EXACT mode
+*******************************************************************************
+*/
+BlockedBloomFilter* URLSeenFilter::getBloomFilter()
+{
+	return ptrBloomFilter_.get();
+}
@@ -0,0 +1,83 @@
+/**
+*******************************************************************************
+* @file		URLSeenFilter.h
+* @brief	This file provides the interfaces of the class URLSeenFilter.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _URLSEENFILTER_H_
+#define _URLSEENFILTER_H_
+
+#include <string>
+
+//boost lib
+#include <boost/scoped_ptr.hpp>
+
+#include "URLSeenSet.h"
+#include "BlockedBloomFilter.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+
+/**
+*******************************************************************************
+* @class		URLSeenFilter
+* @brief 		This class records the discovered URLs, either exactly in a
+URLSeenSet, or in a BlockedBloomFilter whose memory is fixed up front. In the
+Bloom mode a small fraction of new URLs (the false-positive rate) is reported
+as seen and therefore not crawled.
+*******************************************************************************
+*/
+class URLSeenFilter
+{
+	public:
+		//the structure holding the URLs
+		enum Mode
+		{
+			EXACT, //URLSeenSet, no false positive, memory grows with the crawl
+			BLOOM  //BlockedBloomFilter, bounded memory, tunable false positives
+		};
+
+	private:
+		//the mode selected in the constructor or by reset()
+		Mode mode_;
+		//the exact set (EXACT mode)
+		boost::scoped_ptr<URLSeenSet> ptrSeenSet_;
+		//the Bloom filter (BLOOM mode)
+		boost::scoped_ptr<BlockedBloomFilter> ptrBloomFilter_;
+
+	public:
+ 		//constructor
+ 		URLSeenFilter(Mode mode = EXACT, size_t expectedURLs = 1000000,
+ 			double falsePositiveRate = 0.001);
+ 		//empty the filter and select its mode, before the first insertion
+ 		void reset(Mode mode, size_t expectedURLs, double falsePositiveRate);
+ 		//parse a mode, exact or bloom[:false-positive rate]
+ 		static bool parseMode(const string& text, Mode& mode, double& falsePositiveRate);
+ 		//insert a URL, return true if it had not been seen before
+ 		bool insert(const string& url);
+ 		//insert a fingerprint, return true if it had not been seen before
+ 		bool insert(URLFingerprint fingerprint);
+ 		//get the mode
+ 		Mode getMode() const;
+ 		//get the number of URLs seen
+ 		size_t size();
+ 		//get the number of bytes used
+ 		size_t memoryUsage();
+ 		//get the expected false-positive rate (0 in the EXACT mode)
+ 		double expectedFalsePositiveRate();
+ 		//get the exact set, or NULL in the BLOOM mode (for checkpoints)
+ 		URLSeenSet* getSeenSet();
+ 		//get the Bloom filter, or NULL in the EXACT mode (for checkpoints)
+ 		BlockedBloomFilter* getBloomFilter();
+
+}; //end of class URLSeenFilter
+
+} //end of namespace WebDataExtraction
+
+#endif //_URLSEENFILTER_H_
@@ -0,0 +1,157 @@
+/**
+*******************************************************************************
+* @file			URLSeenSet.cpp
+* @brief 		This file provides the implementations of the class URLSeenSet.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "URLSeenSet.h"
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class URLSeenSet.
+* @param		size_t -- numberShards (the number of lock stripes, rounded up to
+a power of 2)
+* @return		None
+*******************************************************************************
+*/
+URLSeenSet::URLSeenSet(size_t numberShards)
+{
+	size_t size = 1;
+	while (size < numberShards) {
+		size <<= 1;
+	}
+	for (size_t i = 0; i < size; i++) {
+		shards_.push_back(boost::shared_ptr<Shard>(new Shard));
+	}
+	shardMask_ = size - 1;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function inserts a URL if it has not been seen before.
+* @param		string -- url (the validated URL)
+* @return		bool -- return true if the URL is new, and false if it has been seen.
+*******************************************************************************
+*/
+bool URLSeenSet::insert(const string& url)
+{
+	return insert(fingerprintURL(url));
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function inserts a fingerprint if it has not been seen before.
+* @param		URLFingerprint -- fingerprint (the fingerprint of the URL)
+* @return		bool -- return true if the fingerprint is new, and false if it has
+been seen.
+*******************************************************************************
+*/
+bool URLSeenSet::insert(URLFingerprint fingerprint)
+{
+	Shard& shard = *shards_[fingerprint & shardMask_];
+	boost::mutex::scoped_lock lock(shard.mutex);
+	return shard.fingerprintSet.insert(fingerprint).second;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function checks whether a URL has been seen.
+* @param		string -- url (the validated URL)
+* @return		bool -- return true if the URL has been seen.
+*******************************************************************************
+*/
+bool URLSeenSet::contains(const string& url)
+{
+	URLFingerprint fingerprint = fingerprintURL(url);
+	Shard& shard = *shards_[fingerprint & shardMask_];
+	boost::mutex::scoped_lock lock(shard.mutex);
+	return shard.fingerprintSet.find(fingerprint) != shard.fingerprintSet.end();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of URLs seen.
+* @param		none
+* @return		size_t -- the number of fingerprints in all shards
+*******************************************************************************
+*/
+size_t URLSeenSet::size()
+{
+	size_t numberURLs = 0;
+	for (size_t i = 0; i < shards_.size(); i++) {
+		boost::mutex::scoped_lock lock(shards_[i]->mutex);
+		numberURLs += shards_[i]->fingerprintSet.size();
+	}
+	return numberURLs;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function estimates the memory used by the set: one bucket
+pointer per bucket, plus one heap node (next pointer and fingerprint, rounded
+up by the allocator) per URL.
+* @param		none
+* @return		size_t -- the approximate number of bytes
+*******************************************************************************
+*/
+size_t URLSeenSet::memoryUsage()
+{
+	size_t numberBytes = shards_.size() * sizeof(Shard);
+	for (size_t i = 0; i < shards_.size(); i++) {
+		boost::mutex::scoped_lock lock(shards_[i]->mutex);
+		numberBytes += shards_[i]->fingerprintSet.bucket_count() * sizeof(void*);
+		numberBytes += shards_[i]->fingerprintSet.size() * 32;
+	}
+	return numberBytes;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the number of shards.
+* @param		none
+* @return		size_t -- the number of lock stripes
+*******************************************************************************
+*/
+size_t URLSeenSet::getNumberShards() const
+{
+	return shards_.size();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function copies the fingerprints of one shard. Only that
+shard is locked, so the other shards keep taking inserts.
+* @param		size_t -- shardIndex (the shard, below getNumberShards())
+* @param		vector<URLFingerprint>& -- fingerprintVector (output, the fingerprints)
+* @return		void
+*******************************************************************************
+*/
+void URLSeenSet::copyShard(size_t shardIndex, vector<URLFingerprint>& fingerprintVector)
+{
+	Shard& shard = *shards_[shardIndex];
+	boost::mutex::scoped_lock lock(shard.mutex);
+	fingerprintVector.assign(shard.fingerprintSet.begin(), shard.fingerprintSet.end());
+}
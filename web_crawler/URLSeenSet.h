@@ -0,0 +1,76 @@
+/**
+*******************************************************************************
+* @file		URLSeenSet.h
+* @brief	This file provides the interfaces of the class URLSeenSet.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _URLSEENSET_H_
+#define _URLSEENSET_H_
+
+#include <string>
+#include <vector>
+
+//boost lib
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "URLFingerprint.h"
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+
+/**
+*******************************************************************************
+* @class		URLSeenSet
+* @brief 		This class records the URLs which have been discovered. It keeps
+the URL fingerprints in lock-striped shards, so that threads inserting different
+URLs rarely wait for each other. insert() tests and inserts in one step, so a
+URL found on several pages at once is dispatched exactly once.
+*******************************************************************************
+*/
+class URLSeenSet
+{
+	private:
+		//one stripe of the set, padded so that two locks never share a cache line
+		struct Shard
+		{
+			boost::mutex mutex;
+			boost::unordered_set<URLFingerprint> fingerprintSet;
+			char padding[64];
+		};
+
+		//the shards, selected by the low bits of the fingerprint
+		vector< boost::shared_ptr<Shard> > shards_;
+		//the number of shards minus one (the number of shards is a power of 2)
+		size_t shardMask_;
+
+	public:
+ 		//constructor
+ 		URLSeenSet(size_t numberShards = 64);
+ 		//insert a URL, return true if it had not been seen before
+ 		bool insert(const string& url);
+ 		//insert a fingerprint, return true if it had not been seen before
+ 		bool insert(URLFingerprint fingerprint);
+ 		//check whether a URL has been seen
+ 		bool contains(const string& url);
+ 		//get the number of URLs seen
+ 		size_t size();
+ 		//get the approximate number of bytes used by the shards
+ 		size_t memoryUsage();
+ 		//get the number of shards
+ 		size_t getNumberShards() const;
+ 		//copy the fingerprints of one shard (for checkpoints)
+ 		void copyShard(size_t shardIndex, vector<URLFingerprint>& fingerprintVector);
+
+}; //end of class URLSeenSet
+
+} //end of namespace WebDataExtraction
+
+#endif //_URLSEENSET_H_
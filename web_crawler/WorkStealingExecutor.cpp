@@ -0,0 +1,261 @@
+/**
+*******************************************************************************
+* @file			WorkStealingExecutor.cpp
+* @brief 		This file provides the implementations of the class
+WorkStealingExecutor.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "WorkStealingExecutor.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <boost/bind.hpp>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class WorkStealingExecutor.
+It starts the worker threads.
+* @param		int -- numberWorkers (the number of worker threads, or <= 0 for one
+per core)
+* @param		bool -- isPinning (pin each worker thread to one core)
+* @return		None
+*******************************************************************************
+*/
+WorkStealingExecutor::WorkStealingExecutor(int numberWorkers, bool isPinning) :
+	currentWorker_(releaseWorker), isPinning_(isPinning), nextWorker_(0), numberQueued_(0),
+	numberUnfinished_(0), numberExecuted_(0), numberStolen_(0), numberSleepers_(0),
+	isStopping_(false)
+{
+	if (numberWorkers <= 0) {
+		numberWorkers = max(1, (int)boost::thread::hardware_concurrency());
+	}
+	for (int i = 0; i < numberWorkers; i++) {
+		boost::shared_ptr<Worker> ptrWorker(new Worker);
+		ptrWorker->index = i;
+		workers_.push_back(ptrWorker);
+	}
+	//the deques exist before any worker may steal from them
+	for (size_t i = 0; i < workers_.size(); i++) {
+		workers_[i]->thread = boost::thread(boost::bind(&WorkStealingExecutor::run, this,
+			workers_[i]));
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class WorkStealingExecutor.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+WorkStealingExecutor::~WorkStealingExecutor()
+{
+	stop();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function does nothing: the worker state belongs to the
+executor. It is called by boost::thread_specific_ptr when a worker exits.
+* @param		Worker* -- ptrWorker (the worker state)
+* @return		void
+*******************************************************************************
+*/
+void WorkStealingExecutor::releaseWorker(Worker* /*ptrWorker*/)
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function queues a task. On a worker thread the task goes to
+the back of the deque of that worker, to run next on the same core; on another
+thread it goes to the deques in turn.
+* @param		ExecutorTask -- task (the task)
+* @return		void
+*******************************************************************************
+*/
+void WorkStealingExecutor::submit(const ExecutorTask& task)
+{
+	Worker* ptrWorker = currentWorker_.get();
+	if (ptrWorker == NULL) {
+		ptrWorker = workers_[nextWorker_++ % workers_.size()].get();
+	}
+	numberUnfinished_++;
+	{
+		boost::mutex::scoped_lock lock(ptrWorker->mutex);
+		ptrWorker->tasks.push_back(task);
+	}
+	numberQueued_++;
+	//wake up an idle worker, which steals the task if the owner is busy
+	if (numberSleepers_ > 0) {
+		boost::mutex::scoped_lock lock(idleMutex_);
+		idleCondition_.notify_one();
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns true if the calling thread is a worker of
+this executor.
+* @param		none
+* @return		bool -- return true on a worker thread
+*******************************************************************************
+*/
+bool WorkStealingExecutor::isWorkerThread()
+{
+	return currentWorker_.get() != NULL;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function takes the newest task of the own deque or, if it is
+empty, the oldest task of the deque of another worker.
+* @param		Worker& -- worker (the calling worker)
+* @param		ExecutorTask& -- task (output, the task)
+* @return		bool -- return false if all the deques are empty
+*******************************************************************************
+*/
+bool WorkStealingExecutor::takeTask(Worker& worker, ExecutorTask& task)
+{
+	{
+		boost::mutex::scoped_lock lock(worker.mutex);
+		if (!worker.tasks.empty()) {
+			task.swap(worker.tasks.back());
+			worker.tasks.pop_back();
+			numberQueued_--;
+			return true;
+		}
+	}
+	for (size_t i = 1; i < workers_.size(); i++) {
+		Worker& victim = *workers_[(worker.index + i) % workers_.size()];
+		boost::mutex::scoped_lock lock(victim.mutex);
+		if (!victim.tasks.empty()) {
+			task.swap(victim.tasks.front());
+			victim.tasks.pop_front();
+			numberQueued_--;
+			numberStolen_++;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the body of a worker thread. It runs the tasks
+until stop() is called and no task is left, sleeping while all deques are empty.
+* @param		boost::shared_ptr<Worker> -- ptrWorker (the worker state)
+* @return		void
+*******************************************************************************
+*/
+void WorkStealingExecutor::run(boost::shared_ptr<Worker> ptrWorker)
+{
+	currentWorker_.reset(ptrWorker.get());
+#ifdef __linux__
+	if (isPinning_) {
+		int numberCores = max(1, (int)boost::thread::hardware_concurrency());
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(ptrWorker->index % numberCores, &cpuSet);
+		if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) != 0) {
+			cerr << "Cannot pin worker " << ptrWorker->index << " to a core" << endl;
+		}
+	}
+#endif
+
+	ExecutorTask task;
+	while (true) {
+		if (takeTask(*ptrWorker, task)) {
+			task();
+			task.clear();
+			numberExecuted_++;
+			//the last task of a stopping executor wakes up the workers to exit
+			if (--numberUnfinished_ == 0 && isStopping_) {
+				boost::mutex::scoped_lock lock(idleMutex_);
+				idleCondition_.notify_all();
+			}
+			continue;
+		}
+		//sleep until a task is queued, or until the executor stops without work left
+		boost::mutex::scoped_lock lock(idleMutex_);
+		numberSleepers_++;
+		while (numberQueued_ <= 0 && !(isStopping_ && numberUnfinished_ <= 0)) {
+			idleCondition_.wait(lock);
+		}
+		numberSleepers_--;
+		if (numberQueued_ <= 0 && isStopping_ && numberUnfinished_ <= 0) {
+			break;
+		}
+	}
+	currentWorker_.reset();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function waits until the queued tasks, and the tasks they
+submit, have run, then stops the worker threads.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void WorkStealingExecutor::stop()
+{
+	{
+		boost::mutex::scoped_lock lock(idleMutex_);
+		isStopping_ = true;
+		idleCondition_.notify_all();
+	}
+	for (size_t i = 0; i < workers_.size(); i++) {
+		if (workers_[i]->thread.joinable()) {
+			workers_[i]->thread.join();
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the statistics of the executor.
+* @param		none
+* @return		ExecutorStats -- the tasks run, stolen and queued
+*******************************************************************************
+*/
+ExecutorStats WorkStealingExecutor::getStats() const
+{
+	ExecutorStats stats;
+	stats.numberWorkers = (int)workers_.size();
+	stats.numberExecuted = numberExecuted_;
+	stats.numberStolen = numberStolen_;
+	stats.numberQueued = numberQueued_;
+	return stats;
+}
@@ -0,0 +1,125 @@
+/**
+*******************************************************************************
+* @file		WorkStealingExecutor.h
+* @brief	This file provides the interfaces of the class WorkStealingExecutor.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _WORKSTEALINGEXECUTOR_H_
+#define _WORKSTEALINGEXECUTOR_H_
+
+#include <deque>
+#include <vector>
+
+//boost lib
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/tss.hpp>
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+//a task run by the executor
+typedef boost::function<void ()> ExecutorTask;
+
+/**
+*******************************************************************************
+* @struct		ExecutorStats
+* @brief 		This structure holds the statistics of the executor.
+*******************************************************************************
+*/
+struct ExecutorStats
+{
+	//the number of worker threads
+	int numberWorkers;
+	//the number of tasks run, and of tasks taken from the deque of another worker
+	long numberExecuted;
+	long numberStolen;
+	//the number of tasks waiting in the deques
+	long numberQueued;
+};
+
+
+/**
+*******************************************************************************
+* @class		WorkStealingExecutor
+* @brief 		This class runs tasks on a pool of worker threads, one per core
+by default, each with its own deque of tasks. A task submitted by a worker goes
+to the back of the deque of that worker, which takes its next task from the back
+too: the subtasks of a page (link extraction after storing, info extraction
+after the links) run next on the core which has the page in its cache. A task
+submitted by another thread goes to the deques in turn. An idle worker steals
+the oldest task from the front of the deque of another worker before going to
+sleep, so that no core is left idle while tasks are waiting. The workers can be
+pinned to the cores.
+*******************************************************************************
+*/
+class WorkStealingExecutor
+{
+	private:
+		//the state of one worker: its deque of tasks and its thread
+		struct Worker
+		{
+			int index;
+			boost::mutex mutex;
+			deque<ExecutorTask> tasks;
+			boost::thread thread;
+		};
+
+		//the workers
+		vector< boost::shared_ptr<Worker> > workers_;
+		//the worker running on the calling thread, NULL on the other threads
+		boost::thread_specific_ptr<Worker> currentWorker_;
+		//pin worker i to core i (modulo the number of cores)
+		bool isPinning_;
+		//the worker which receives the next task of a thread outside the pool
+		boost::atomic<size_t> nextWorker_;
+		//the number of tasks in the deques, and of tasks submitted but not finished
+		boost::atomic<long> numberQueued_;
+		boost::atomic<long> numberUnfinished_;
+		//the number of tasks run and stolen
+		boost::atomic<long> numberExecuted_;
+		boost::atomic<long> numberStolen_;
+		//mutex and condition on which the idle workers sleep
+		boost::mutex idleMutex_;
+		boost::condition_variable idleCondition_;
+		boost::atomic<int> numberSleepers_;
+		//set by stop()
+		boost::atomic<bool> isStopping_;
+
+		//the body of a worker thread
+		void run(boost::shared_ptr<Worker> ptrWorker);
+		//take a task from the back of the own deque, or steal one from another deque
+		bool takeTask(Worker& worker, ExecutorTask& task);
+		//leave the worker state to the executor when the thread exits
+		static void releaseWorker(Worker* ptrWorker);
+
+	public:
+ 		//constructor: numberWorkers <= 0 starts one worker per core
+ 		explicit WorkStealingExecutor(int numberWorkers = 0, bool isPinning = false);
+ 		//destructor: runs the queued tasks and stops the workers
+ 		~WorkStealingExecutor();
+ 		//queue a task
+ 		void submit(const ExecutorTask& task);
+ 		//return true if the calling thread is a worker of this executor
+ 		bool isWorkerThread();
+ 		//run the queued tasks, including the tasks they submit, then stop the workers
+ 		void stop();
+ 		//get the number of worker threads
+ 		int getNumberWorkers() const { return (int)workers_.size(); }
+ 		//get the statistics of the executor
+ 		ExecutorStats getStats() const;
+
+}; //end of class WorkStealingExecutor
+
+} //end of namespace WebDataExtraction
+
+#endif //_WORKSTEALINGEXECUTOR_H_
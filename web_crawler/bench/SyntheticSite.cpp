@@ -0,0 +1,424 @@
+/**
+*******************************************************************************
+* @file			SyntheticSite.cpp
+* @brief 		This file provides the implementations of the class SyntheticSite.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "SyntheticSite.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_01.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+//namespaces used in this file
+using namespace std;
+using namespace WebDataExtraction;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function mixes the bits of a number (splitmix64), to pick the
+links of a page.
+*******************************************************************************
+*/
+static boost::uint64_t mix(boost::uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function sends the whole buffer on a socket.
+* @param		int -- connectionSocket (the socket)
+* @param		string -- data (the bytes to send)
+* @return		bool -- return false if the connection is closed
+*******************************************************************************
+*/
+static bool sendAll(int connectionSocket, const string& data)
+{
+	size_t offset = 0;
+	while (offset < data.size()) {
+		ssize_t numberSent = send(connectionSocket, data.data() + offset, data.size() - offset,
+			MSG_NOSIGNAL);
+		if (numberSent <= 0) {
+			return false;
+		}
+		offset += numberSent;
+	}
+	return true;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the constructor of the class SyntheticSite.
+* @param		SyntheticSiteConfig -- config (the shape of the site)
+* @return		None
+*******************************************************************************
+*/
+SyntheticSite::SyntheticSite(const SyntheticSiteConfig& config) : config_(config),
+	listenSocket_(-1), port_(0), numberConnections_(0), isStopping_(false),
+	numberRequests_(0), numberErrors_(0), numberThrottled_(0),
+	throttleRate_(config.throttleRate), throttleTokens_(config.throttleRate),
+	lastThrottleRefill_(boost::posix_time::microsec_clock::universal_time())
+{
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the destructor of the class SyntheticSite.
+* @param		none
+* @return		None
+*******************************************************************************
+*/
+SyntheticSite::~SyntheticSite()
+{
+	stop();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function opens the listening socket on the loopback address
+and starts the accepting thread.
+* @param		int -- port (the port, or 0 to pick a free one)
+* @return		int -- return 0 if successful, or 1 if the port cannot be opened
+*******************************************************************************
+*/
+int SyntheticSite::start(int port)
+{
+	listenSocket_ = socket(AF_INET, SOCK_STREAM, 0);
+	int reuse = 1;
+	setsockopt(listenSocket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(port);
+	socklen_t addressLength = sizeof(address);
+	if (bind(listenSocket_, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+		listen(listenSocket_, 1024) != 0 ||
+		getsockname(listenSocket_, (struct sockaddr*)&address, &addressLength) != 0) {
+		cerr << "Failed to listen on port " << port << endl;
+		close(listenSocket_);
+		listenSocket_ = -1;
+		return 1;
+	}
+	port_ = ntohs(address.sin_port);
+	acceptThread_ = boost::thread(boost::bind(&SyntheticSite::acceptConnections, this));
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function closes the listening socket and the connections, and
+waits for the threads.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void SyntheticSite::stop()
+{
+	if (listenSocket_ < 0) {
+		return;
+	}
+	isStopping_ = true;
+	//wake up accept() and recv()
+	shutdown(listenSocket_, SHUT_RDWR);
+	if (acceptThread_.joinable()) {
+		acceptThread_.join();
+	}
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		for (set<int>::iterator it = connectionSockets_.begin(); it != connectionSockets_.end(); it++) {
+			shutdown(*it, SHUT_RDWR);
+		}
+	}
+	connectionThreads_.join_all();
+	close(listenSocket_);
+	listenSocket_ = -1;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the body of the accepting thread: it starts a
+thread per connection until stop() is called.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void SyntheticSite::acceptConnections()
+{
+	while (!isStopping_) {
+		int connectionSocket = accept(listenSocket_, NULL, NULL);
+		if (connectionSocket < 0) {
+			continue;
+		}
+		int noDelay = 1;
+		setsockopt(connectionSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+		boost::mutex::scoped_lock lock(mutex_);
+		if (isStopping_) {
+			close(connectionSocket);
+			break;
+		}
+		connectionSockets_.insert(connectionSocket);
+		connectionThreads_.create_thread(boost::bind(&SyntheticSite::serveConnection, this,
+			connectionSocket, config_.seed + (unsigned int)numberConnections_++));
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the body of a connection thread: it answers the
+requests of the connection until the client or stop() closes it.
+* @param		int -- connectionSocket (the socket of the connection)
+* @param		unsigned int -- seed (the seed of the latencies and errors)
+* @return		void
+*******************************************************************************
+*/
+void SyntheticSite::serveConnection(int connectionSocket, unsigned int seed)
+{
+	boost::random::mt19937 generator(seed);
+	boost::random::normal_distribution<double> normal(0.0, 1.0);
+	boost::random::uniform_01<double> uniform;
+	string requests;
+	char buffer[16384];
+	bool isKeepAlive = true;
+	while (isKeepAlive && !isStopping_) {
+		size_t headerEnd = requests.find("\r\n\r\n");
+		if (headerEnd == string::npos) {
+			ssize_t numberReceived = recv(connectionSocket, buffer, sizeof(buffer), 0);
+			if (numberReceived <= 0) {
+				break;
+			}
+			requests.append(buffer, numberReceived);
+			continue;
+		}
+		string request = requests.substr(0, headerEnd);
+		requests.erase(0, headerEnd + 4);
+		numberRequests_++;
+		isKeepAlive = !boost::algorithm::icontains(request, "Connection: close");
+
+		//GET /p/<id> or /info/<id> HTTP/1.1
+		long id = -1;
+		size_t pathStart = request.find(' ');
+		size_t idStart = (pathStart == string::npos) ? string::npos : request.find('/', pathStart + 2);
+		if (idStart != string::npos) {
+			char* end;
+			id = strtol(request.c_str() + idStart + 1, &end, 10);
+			if (end == request.c_str() + idStart + 1 || (*end != ' ' && *end != '?')) {
+				id = -1;
+			}
+		}
+		//a product page is not served under /info/, nor an info page under /p/
+		if (id >= 0 && id < config_.numberPages &&
+				request.compare(pathStart + 1, idStart - pathStart, getPath(id), 0,
+				idStart - pathStart) != 0) {
+			id = -1;
+		}
+
+		//a throttled request is answered at once, the others after their latency
+		bool isRequestThrottled = isThrottled();
+		double latencyMs = config_.latencyMedianMs * exp(config_.latencySigma * normal(generator));
+		if (latencyMs > 0 && !isRequestThrottled) {
+			boost::this_thread::sleep(boost::posix_time::microseconds((long)(latencyMs * 1000)));
+		}
+
+		string status = "200 OK";
+		string headers;
+		string body;
+		if (isRequestThrottled) {
+			status = (config_.throttleStatus == 503) ? "503 Service Unavailable" :
+				"429 Too Many Requests";
+			stringstream retryAfter;
+			retryAfter << "Retry-After: " << config_.retryAfterSeconds << "\r\n";
+			headers = retryAfter.str();
+		}
+		else if (id < 0 || id >= config_.numberPages) {
+			status = "404 Not Found";
+		}
+		else if (uniform(generator) < config_.errorRate) {
+			status = "500 Internal Server Error";
+			numberErrors_++;
+		}
+		else {
+			body = renderPage(id);
+		}
+		stringstream response;
+		response << "HTTP/1.1 " << status << "\r\nContent-Type: text/html\r\n" << headers <<
+			"Content-Length: " << body.size() << "\r\n" <<
+			(isKeepAlive ? "" : "Connection: close\r\n") << "\r\n";
+		if (!sendAll(connectionSocket, response.str() + body)) {
+			break;
+		}
+	}
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		connectionSockets_.erase(connectionSocket);
+	}
+	close(connectionSocket);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function takes a token from the throttling bucket, which is
+refilled at throttleRate tokens per second and holds one second of them.
+* @param		none
+* @return		bool -- return true if the bucket is empty and the request must be
+throttled, false if it is served or the site does not throttle
+*******************************************************************************
+*/
+bool SyntheticSite::isThrottled()
+{
+	boost::mutex::scoped_lock lock(throttleMutex_);
+	if (throttleRate_ <= 0) {
+		return false;
+	}
+	boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+	double elapsedSeconds = (now - lastThrottleRefill_).total_microseconds() / 1e6;
+	throttleTokens_ = min(throttleRate_, throttleTokens_ + elapsedSeconds * throttleRate_);
+	lastThrottleRefill_ = now;
+	if (throttleTokens_ < 1.0) {
+		numberThrottled_++;
+		return true;
+	}
+	throttleTokens_ -= 1.0;
+	return false;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function changes the throttling rate, e.g. to let a crawler
+recover from throttling.
+* @param		double -- throttleRate (the requests per second, or 0 to serve all)
+* @return		void
+*******************************************************************************
+*/
+void SyntheticSite::setThrottleRate(double throttleRate)
+{
+	boost::mutex::scoped_lock lock(throttleMutex_);
+	throttleRate_ = throttleRate;
+	throttleTokens_ = throttleRate;
+	lastThrottleRefill_ = boost::posix_time::microsec_clock::universal_time();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function checks whether a page holds a product. Page 0, the
+seed of the crawl, always does.
+* @param		long -- id (the number of the page)
+* @return		bool -- return true for a product page, false for an info page
+*******************************************************************************
+*/
+bool SyntheticSite::isProductPage(long id) const
+{
+	if (id == 0 || config_.productFraction >= 1.0) {
+		return true;
+	}
+	return (mix((boost::uint64_t)id + config_.seed * 7919) % 1000000) <
+		(boost::uint64_t)(config_.productFraction * 1000000);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the path of a page.
+* @param		long -- id (the number of the page)
+* @return		string -- /p/id for a product page, /info/id for an info page
+*******************************************************************************
+*/
+string SyntheticSite::getPath(long id) const
+{
+	stringstream path;
+	path << (isProductPage(id) ? "/p/" : "/info/") << id;
+	return path.str();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the html of a page: its links, its product
+in schema.org microdata (unless it is an info page), and filler text up to
+pageBytes.
+* @param		long -- id (the number of the page)
+* @return		string -- the html page
+*******************************************************************************
+*/
+string SyntheticSite::renderPage(long id) const
+{
+	bool isProduct = isProductPage(id);
+	stringstream page;
+	page << "<html><head><title>Synthetic " << (isProduct ? "product " : "info page ") << id <<
+		"</title></head><body>\n";
+	page << "<div class=\"nav\">\n";
+	page << "<a href=\"" << getPath((id + 1) % config_.numberPages) << "\">next</a>\n";
+	for (int k = 1; k < config_.fanout; k++) {
+		long target = (long)(mix((boost::uint64_t)id * 1000003 + k + config_.seed) %
+			(boost::uint64_t)config_.numberPages);
+		page << "<a href=\"" << getPath(target) << "\">page " << target << "</a>\n";
+	}
+	//a link leaving the site, rejected by validateURL()
+	page << "<a href=\"http://www.example.com/help\">help</a>\n</div>\n";
+	if (isProduct) {
+		page << "<div itemscope itemtype=\"http://schema.org/Product\">\n" <<
+			"<meta itemprop=\"productID\" content=\"" << id << "\"/>\n" <<
+			"<span itemprop=\"sku\">" << id << "</span>\n" <<
+			"<span itemprop=\"category\">Category " << id % 50 << "</span>\n" <<
+			"<h1 itemprop=\"name\">Synthetic product " << id << "</h1>\n" <<
+			"<img itemprop=\"image\" src=\"/images/" << id << ".jpg\"/>\n" <<
+			"<span class=\"price-was\">$" << 20 + id % 80 << ".99</span>\n" <<
+			"<span itemprop=\"price\">$" << 10 + id % 80 << ".49</span>\n</div>\n";
+	}
+	string html = page.str();
+	static const string filler = "<p>Lorem ipsum dolor sit amet, consectetur adipiscing "
+		"elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.</p>\n";
+	while (html.size() + filler.size() + 16 <= config_.pageBytes) {
+		html += filler;
+	}
+	html += "</body></html>\n";
+	return html;
+}
@@ -0,0 +1,143 @@
+/**
+*******************************************************************************
+* @file		SyntheticSite.h
+* @brief	This file provides the interfaces of the class SyntheticSite.
+* @author	Yifeng He
+* @date		Feb. 11, 2014, version 1.0
+*******************************************************************************
+**/
+
+#ifndef _SYNTHETICSITE_H_
+#define _SYNTHETICSITE_H_
+
+#include <string>
+#include <set>
+
+//boost lib
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+using namespace std;
+
+namespace WebDataExtraction
+{
+
+/**
+*******************************************************************************
+* @struct		SyntheticSiteConfig
+* @brief 		This structure holds the shape of the synthetic site.
+*******************************************************************************
+*/
+struct SyntheticSiteConfig
+{
+	//the number of pages, /p/0 to /p/(numberPages - 1)
+	long numberPages;
+	//the number of links to other pages of the site on each page
+	int fanout;
+	//the size of a page in bytes
+	size_t pageBytes;
+	//the median and the spread (sigma of its logarithm) of the response latency
+	double latencyMedianMs;
+	double latencySigma;
+	//the fraction of the requests answered with 500
+	double errorRate;
+	//the fraction of the pages holding a product, the others are info pages
+	double productFraction;
+	//the requests per second above which the site answers throttleStatus (0: never)
+	double throttleRate;
+	//the status of a throttled request, 429 or 503, and its Retry-After in seconds
+	int throttleStatus;
+	int retryAfterSeconds;
+	//the seed of the links and of the latencies
+	unsigned int seed;
+
+	//constructor with the default shape
+	SyntheticSiteConfig() : numberPages(10000), fanout(20), pageBytes(30000),
+		latencyMedianMs(5.0), latencySigma(0.5), errorRate(0.0), productFraction(1.0),
+		throttleRate(0.0), throttleStatus(429), retryAfterSeconds(1), seed(1) {}
+};
+
+
+/**
+*******************************************************************************
+* @class		SyntheticSite
+* @brief 		This class is a local HTTP/1.1 server generating a site of
+product pages, so that the crawler can be measured without a network and without
+loading a live site. Page i links to page i+1, so that every page can be
+reached from /p/0, and to fanout-1 other pages picked by a hash of i; it holds
+one schema.org product and filler text up to pageBytes. A fraction of the pages,
+picked by a hash, are info pages under /info/ without a product instead, so
+that the order of the crawl can be measured by the time to the products. Each response waits
+for a latency drawn from a log-normal distribution, and errorRate of them are
+500 errors. Above throttleRate requests per second, counted by a token bucket
+holding one second of requests, the site answers throttleStatus with a
+Retry-After header at once, as a rate-limited host does. Each connection is
+served by its own thread and kept alive.
+*******************************************************************************
+*/
+class SyntheticSite
+{
+	private:
+		//the shape of the site
+		SyntheticSiteConfig config_;
+		//the listening socket and its port
+		int listenSocket_;
+		int port_;
+		//the thread accepting the connections, and the connection threads
+		boost::thread acceptThread_;
+		boost::thread_group connectionThreads_;
+		//the sockets of the open connections, closed by stop()
+		boost::mutex mutex_;
+		set<int> connectionSockets_;
+		//the number of connections, numbering the random generators
+		long numberConnections_;
+		//set by stop()
+		boost::atomic<bool> isStopping_;
+		//the numbers of requests, of error responses and of throttled requests
+		boost::atomic<long> numberRequests_;
+		boost::atomic<long> numberErrors_;
+		boost::atomic<long> numberThrottled_;
+		//mutex protecting the throttling rate and its token bucket
+		boost::mutex throttleMutex_;
+		double throttleRate_;
+		double throttleTokens_;
+		boost::posix_time::ptime lastThrottleRefill_;
+
+		//the body of the accepting thread
+		void acceptConnections();
+		//the body of a connection thread
+		void serveConnection(int connectionSocket, unsigned int seed);
+		//check whether a request is above the throttling rate
+		bool isThrottled();
+
+	public:
+ 		//constructor
+ 		SyntheticSite(const SyntheticSiteConfig& config);
+ 		//destructor: stops the server
+ 		~SyntheticSite();
+ 		//listen on 127.0.0.1:port (0 picks a free port), return 0 on success
+ 		int start(int port = 0);
+ 		//close the connections and stop the threads
+ 		void stop();
+ 		//get the port the server listens on
+ 		int getPort() const { return port_; }
+ 		//get the number of requests and of error responses
+ 		long getNumberRequests() const { return numberRequests_; }
+ 		long getNumberErrors() const { return numberErrors_; }
+ 		long getNumberThrottled() const { return numberThrottled_; }
+ 		//change the throttling rate while the site runs (0 stops throttling)
+ 		void setThrottleRate(double throttleRate);
+ 		//check whether page id holds a product
+ 		bool isProductPage(long id) const;
+ 		//get the path of page id: /p/id for a product page, /info/id otherwise
+ 		string getPath(long id) const;
+ 		//get the html of page id, as the server sends it
+ 		string renderPage(long id) const;
+
+}; //end of class SyntheticSite
+
+} //end of namespace WebDataExtraction
+
+#endif //_SYNTHETICSITE_H_
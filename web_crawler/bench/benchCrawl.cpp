@@ -0,0 +1,334 @@
+/**
+*******************************************************************************
+* @file			benchCrawl.cpp
+* @brief 		This file provides the benchmark crawling a SyntheticSite served
+in-process, so that the throughput, the latency and the cost per page of the
+crawl can be measured offline and compared between changes.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "SyntheticSite.h"
+#include "../FetchEngine.h"
+#include "../FetchContext.h"
+#include "../CrawlFrontier.h"
+#include "../URLPrioritizer.h"
+#include "../URLSeenFilter.h"
+#include "../WorkStealingExecutor.h"
+#include "../HTMLPage.h"
+#include "../ExtractionRules.h"
+#include "../ResourceUsage.h"
+#include "../Metrics.h"
+#include "../AsyncLogger.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+using namespace std;
+using namespace WebDataExtraction;
+using namespace boost::posix_time;
+
+//the host name of the synthetic site, pinned to 127.0.0.1 with CURLOPT_RESOLVE
+static const string syntheticHost = "www.synthetic.test";
+
+//the state of the crawl shared by the page callbacks
+static CrawlFrontier* ptrFrontier = NULL;
+static URLSeenFilter* ptrSeenFilter = NULL;
+static URLPrioritizer* ptrPrioritizer = NULL;
+static ExtractionRules extractionRules;
+static string hostName;
+//the counters of the crawl
+static boost::atomic<long> numberPages(0);
+static boost::atomic<long> numberFailed(0);
+static boost::atomic<long> numberProducts(0);
+//the fractions of the products of the site whose time is reported
+static const double productMilestones[] = {0.1, 0.5, 0.9};
+static const int numberProductMilestones = 3;
+//the numbers of products of the milestones, and the ms from the start of the crawl to them
+static long milestoneProducts[numberProductMilestones];
+static long milestoneMs[numberProductMilestones];
+static ptime crawlBegin;
+//the latency of each download, from submit() to the callback
+static boost::mutex latencyMutex;
+static vector<double> latencyMsVector;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function processes a downloaded page on an executor thread, as
+the stages of the crawler do: links, then product records, whose number is fed
+back to the prioritizer of the frontier.
+* @param		LinkOrigin -- origin (where the page was found)
+* @param		LinkOrigin -- linkOrigin (the origin of the links of the page)
+* @param		FetchResult -- result (the download)
+* @return		void
+*******************************************************************************
+*/
+void processPage(LinkOrigin origin, LinkOrigin linkOrigin, const FetchResult& result)
+{
+	HTMLPage htmlPage(result.url);
+	if (htmlPage.init(result.httpStatus, result.ptrBody) != HTMLPage::INIT_SUCCESS) {
+		numberFailed++;
+	}
+	else {
+		numberPages++;
+		htmlPage.extractLinks();
+		boost::shared_ptr< set<string> > ptrLinkSet = htmlPage.getPtrLinkSet();
+		for (set<string>::iterator it = ptrLinkSet->begin(); it != ptrLinkSet->end(); it++) {
+			string validURL = validateURL(*it, hostName);
+			if (validURL != "" && ptrSeenFilter->insert(validURL)) {
+				ptrFrontier->push(validURL, linkOrigin);
+			}
+		}
+		int numberRecords = htmlPage.extractInfo(extractionRules);
+		ptrPrioritizer->recordYield(result.url, origin, numberRecords);
+		long total = (numberProducts += numberRecords);
+		for (int i = 0; i < numberProductMilestones; i++) {
+			if (total - numberRecords < milestoneProducts[i] && total >= milestoneProducts[i]) {
+				milestoneMs[i] = (microsec_clock::universal_time() - crawlBegin).total_milliseconds();
+			}
+		}
+	}
+	ptrFrontier->taskDone(result.url);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is called on a fetch engine thread when a download
+completes. It records the latency and hands the page to the executor.
+* @param		WorkStealingExecutor* -- ptrExecutor (the page processing threads)
+* @param		ptime -- submitTime (the time the URL was submitted)
+* @param		LinkOrigin -- origin (where the page was found)
+* @param		LinkOrigin -- linkOrigin (the origin of the links of the page)
+* @param		FetchResult -- result (the download)
+* @return		void
+*******************************************************************************
+*/
+void pageFetched(WorkStealingExecutor* ptrExecutor, ptime submitTime, LinkOrigin origin,
+	LinkOrigin linkOrigin, const FetchResult& result)
+{
+	double latencyMs = (microsec_clock::universal_time() - submitTime).total_microseconds() / 1000.0;
+	{
+		boost::mutex::scoped_lock lock(latencyMutex);
+		latencyMsVector.push_back(latencyMs);
+	}
+	ptrExecutor->submit(boost::bind(processPage, origin, linkOrigin, result));
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns a percentile of sorted samples.
+* @param		vector<double> -- sortedVector (the samples, sorted)
+* @param		double -- fraction (e.g. 0.99)
+* @return		double -- the percentile, or 0 if there is no sample
+*******************************************************************************
+*/
+double percentile(const vector<double>& sortedVector, double fraction)
+{
+	if (sortedVector.empty()) {
+		return 0.0;
+	}
+	size_t index = (size_t)(fraction * (sortedVector.size() - 1) + 0.5);
+	return sortedVector[index];
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function serves the synthetic site until Enter is pressed, to
+crawl it with testWebDataExtraction.
+* @param		SyntheticSiteConfig -- config (the shape of the site)
+* @param		int -- port (the port to listen on)
+* @return		int -- return 0 if successful, or 1 if the port cannot be opened
+*******************************************************************************
+*/
+int serveSite(const SyntheticSiteConfig& config, int port)
+{
+	SyntheticSite site(config);
+	if (site.start(port) != 0) {
+		return 1;
+	}
+	cout << "Serving " << config.numberPages << " pages on port " << site.getPort() <<
+		", crawl them with:" << endl << "  ./testWebDataExtraction --site http://" <<
+		syntheticHost << ":" << site.getPort() << "/p/0 --resolve " << syntheticHost << ":" <<
+		site.getPort() << ":127.0.0.1 --requests-per-second 1000" << endl <<
+		"Press Enter to stop." << endl;
+	cin.get();
+	site.stop();
+	cout << site.getNumberRequests() << " requests served, " << site.getNumberErrors() <<
+		" errors." << endl;
+	return 0;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the entrance to the benchmark. It starts the
+synthetic site, crawls it from /p/0 with the FetchEngine (without the politeness
+delays, which would only measure the configured rate) and the WorkStealingExecutor,
+and prints the throughput, the latency percentiles, the cost per page, and the
+time to the first products, which compares the orders of the frontier.
+* @param		argv[1] -- the number of pages (default 10000), or --serve PORT to
+only serve the site
+* @param		argv[2] -- the number of concurrent downloads (default 64)
+* @param		argv[3] -- the median latency of the site in ms (default 5)
+* @param		argv[4] -- the error rate of the site (default 0)
+* @param		argv[5] -- the number of page processing threads (default one per core)
+* @param		argv[6] -- the fraction of the pages holding a product (default 1)
+* @param		argv[7] -- best-first (default) or breadth-first, the order of the
+frontier
+* @param		argv[8] -- the number of pending URLs kept in memory, the others being
+spilled into the current folder (default 0, no limit)
+* @return		int -- return 0 if successful, or 1 if pages are missed
+*******************************************************************************
+*/
+int main(int argc, char* argv[])
+{
+	SyntheticSiteConfig config;
+	if (argc > 2 && strcmp(argv[1], "--serve") == 0) {
+		if (argc > 3) {
+			config.numberPages = atol(argv[3]);
+		}
+		return serveSite(config, atoi(argv[2]));
+	}
+	if (argc > 1) {
+		config.numberPages = atol(argv[1]);
+	}
+	int concurrency = (argc > 2) ? atoi(argv[2]) : 64;
+	if (argc > 3) {
+		config.latencyMedianMs = atof(argv[3]);
+	}
+	if (argc > 4) {
+		config.errorRate = atof(argv[4]);
+	}
+	int numberThreads = (argc > 5) ? atoi(argv[5]) : 0;
+	if (argc > 6) {
+		config.productFraction = atof(argv[6]);
+	}
+	bool isBreadthFirst = (argc > 7 && strcmp(argv[7], "breadth-first") == 0);
+	long frontierMemoryURLs = (argc > 8) ? atol(argv[8]) : 0;
+	if (config.numberPages <= 0 || concurrency <= 0 ||
+			(argc > 7 && !isBreadthFirst && strcmp(argv[7], "best-first") != 0)) {
+		cerr << "Usage: " << argv[0] << " [pages] [concurrency] [latency ms] [error rate]" <<
+			" [threads] [product fraction] [best-first|breadth-first] [URLs in memory]" << endl <<
+			"       " << argv[0] << " --serve PORT [pages]" << endl;
+		return 1;
+	}
+	if (extractionRules.load("../extraction.rules") != 0) {
+		return 1;
+	}
+
+	SyntheticSite site(config);
+	if (site.start() != 0) {
+		return 1;
+	}
+	stringstream hostStream;
+	hostStream << "http://" << syntheticHost << ":" << site.getPort();
+	hostName = hostStream.str();
+	FetchContext context;
+	stringstream resolveStream;
+	resolveStream << syntheticHost << ":" << site.getPort() << ":127.0.0.1";
+	context.addResolve(resolveStream.str());
+
+	URLPrioritizer urlPrioritizer;
+	CrawlFrontier crawlFrontier(concurrency, isBreadthFirst ? NULL : &urlPrioritizer);
+	URLSeenFilter urlSeenFilter(URLSeenFilter::EXACT, config.numberPages);
+	ptrFrontier = &crawlFrontier;
+	ptrSeenFilter = &urlSeenFilter;
+	ptrPrioritizer = &urlPrioritizer;
+	if (frontierMemoryURLs > 0 && crawlFrontier.startSpilling(".", frontierMemoryURLs) != 0) {
+		return 1;
+	}
+	long numberSiteProducts = 0;
+	for (long id = 0; id < config.numberPages; id++) {
+		numberSiteProducts += site.isProductPage(id) ? 1 : 0;
+	}
+	for (int i = 0; i < numberProductMilestones; i++) {
+		milestoneProducts[i] = max(1L, (long)(productMilestones[i] * numberSiteProducts));
+		milestoneMs[i] = -1;
+	}
+	WorkStealingExecutor executor(numberThreads);
+	FetchEngine fetchEngine(1, concurrency, concurrency, PageBufferFactory(), context);
+	latencyMsVector.reserve(config.numberPages);
+
+	string seedURL = hostName + "/p/0";
+	urlSeenFilter.insert(seedURL);
+	crawlFrontier.push(seedURL);
+	long cpuBegin = getCPUMicroseconds();
+	crawlBegin = microsec_clock::universal_time();
+	string url;
+	LinkOrigin origin;
+	while (crawlFrontier.pop(url, origin)) {
+		LinkOrigin linkOrigin(origin.depth + 1, urlPrioritizer.getPatternID(url));
+		fetchEngine.submit(url, boost::bind(pageFetched, &executor,
+			microsec_clock::universal_time(), origin, linkOrigin, _1));
+	}
+	double elapsedSeconds = (microsec_clock::universal_time() - crawlBegin).total_microseconds() / 1e6;
+	long cpuMicroseconds = getCPUMicroseconds() - cpuBegin;
+	fetchEngine.stop();
+	executor.stop();
+	site.stop();
+	crawlFrontier.stopSpilling();
+	//write the warnings of the failed pages before the report
+	AsyncLogger::getShared().stop();
+
+	sort(latencyMsVector.begin(), latencyMsVector.end());
+	long numberFetched = numberPages + numberFailed;
+	cout << "Site: " << config.numberPages << " pages of " << config.pageBytes << " bytes, " <<
+		config.fanout << " links per page, " << numberSiteProducts << " products, median latency " <<
+		config.latencyMedianMs << " ms, error rate " << config.errorRate << endl;
+	cout << "Crawl: " << concurrency << " concurrent downloads, " <<
+		executor.getNumberWorkers() << " processing threads, " <<
+		(isBreadthFirst ? "breadth-first" : "best-first") << " frontier (" <<
+		urlPrioritizer.getNumberPatterns() << " URL patterns)" << endl;
+	if (frontierMemoryURLs > 0) {
+		cout << "Frontier: at most " << frontierMemoryURLs << " pending URLs in memory, " <<
+			Metrics::getShared().getCounter(Metrics::getShared().addCounter("frontier_spilled_urls")) <<
+			" spilled to disk" << endl;
+	}
+	cout << numberPages << " pages crawled, " << numberFailed << " failed, " <<
+		urlSeenFilter.size() << " URLs discovered, " << numberProducts <<
+		" products extracted" << endl;
+	cout << "Throughput: " << numberFetched / elapsedSeconds << " pages/s (" <<
+		elapsedSeconds << " s)" << endl;
+	cout << "Latency: p50 " << percentile(latencyMsVector, 0.5) << " ms, p99 " <<
+		percentile(latencyMsVector, 0.99) << " ms, max " <<
+		(latencyMsVector.empty() ? 0.0 : latencyMsVector.back()) << " ms" << endl;
+	cout << "Time to the first products:";
+	for (int i = 0; i < numberProductMilestones; i++) {
+		cout << " " << milestoneProducts[i] << " in " << milestoneMs[i] << " ms" <<
+			((i + 1 < numberProductMilestones) ? "," : "");
+	}
+	cout << endl;
+	cout << "CPU: " << ((numberFetched > 0) ? cpuMicroseconds / 1000.0 / numberFetched : 0.0) <<
+		" ms per page, peak RSS " << getPeakRSSKilobytes() << " KB" << endl;
+	//the phases of the downloads recorded by the FetchContext
+	Metrics::getShared().print(cout);
+
+	//without errors every page is reachable from /p/0
+	if (config.errorRate == 0 && (long)urlSeenFilter.size() != config.numberPages) {
+		cerr << "Expected " << config.numberPages << " URLs, discovered " <<
+			urlSeenFilter.size() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,272 @@
+/**
+*******************************************************************************
+* @file			benchExtraction.cpp
+* @brief 		This file provides the micro-benchmarks of the page processing
+functions: validateURL(), HTMLPage::extractLinks() and HTMLPage::extractInfo().
+Each benchmark repeats its function, doubling the number of iterations until a
+run lasts long enough to be timed, and reports the time per call and the
+throughput.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "SyntheticSite.h"
+#include "../HTMLPage.h"
+#include "../ExtractionRules.h"
+#include "../LinkScanner.h"
+#include "../PageStore.h"
+
+#include <dirent.h>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+using namespace std;
+using namespace WebDataExtraction;
+using namespace boost::posix_time;
+
+//the shortest timed run, in seconds
+static const double minimumSeconds = 0.5;
+//keeps the results of the benchmarked functions alive
+static volatile long sink = 0;
+
+//a benchmark: run n iterations, return the number of items processed
+typedef boost::function<long (long)> Benchmark;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function loads the pages of a directory: the records of the
+PageStore segments (segment-*.seg), decoded by PageStore::readSegment(), and the
+saved .html or .htm files. The other files of the crawler folder (indexes,
+checkpoints, logs, metrics, records) are skipped.
+* @param		string -- folder (the directory holding the pages)
+* @param		vector<string>& -- pages (output, the content of each page)
+* @return		size_t -- the total number of bytes loaded
+*******************************************************************************
+*/
+size_t loadCorpus(const string& folder, vector<string>& pages)
+{
+	size_t numberBytes = 0;
+	DIR* dir = opendir(folder.c_str());
+	if (dir == NULL) {
+		cerr << "Failed to open the corpus folder " << folder << endl;
+		return 0;
+	}
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL) {
+		string name = entry->d_name;
+		size_t dot = name.rfind('.');
+		string extension = (dot == string::npos) ? "" : name.substr(dot);
+		string path = folder + "/" + name;
+		if (name.compare(0, 8, "segment-") == 0 && extension == ".seg") {
+			vector<PageRecord> records;
+			if (PageStore::readSegment(path, records) != 0) {
+				cerr << "Failed to read the segment " << path << endl;
+			}
+			for (size_t i = 0; i < records.size(); i++) {
+				if (records[i].httpStatus == 200 && !records[i].body.empty()) {
+					pages.push_back(records[i].body);
+					numberBytes += pages.back().size();
+				}
+			}
+		}
+		else if (name[0] != '.' && (extension == ".html" || extension == ".htm")) {
+			ifstream file(path.c_str(), ios::binary);
+			stringstream content;
+			content << file.rdbuf();
+			pages.push_back(content.str());
+			numberBytes += pages.back().size();
+		}
+	}
+	closedir(dir);
+	return numberBytes;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function runs a benchmark: one untimed iteration, then runs of
+1, 2, 4, ... iterations until a run lasts minimumSeconds, and prints the last run.
+* @param		string -- name (the name of the benchmark)
+* @param		Benchmark -- benchmark (the function running n iterations)
+* @param		size_t -- bytesPerIteration (the bytes processed by an iteration, or 0)
+* @return		void
+*******************************************************************************
+*/
+void runBenchmark(const string& name, Benchmark benchmark, size_t bytesPerIteration)
+{
+	sink += benchmark(1);
+	long numberIterations = 1;
+	long numberItems = 0;
+	double elapsedSeconds = 0.0;
+	while (true) {
+		ptime begin = microsec_clock::universal_time();
+		numberItems = benchmark(numberIterations);
+		elapsedSeconds = (microsec_clock::universal_time() - begin).total_microseconds() / 1e6;
+		sink += numberItems;
+		if (elapsedSeconds >= minimumSeconds || numberIterations >= (1L << 40)) {
+			break;
+		}
+		numberIterations *= 2;
+	}
+	cout << left << setw(28) << name << right << setw(12) << numberIterations << " iterations " <<
+		setw(12) << fixed << setprecision(1) << elapsedSeconds * 1e9 / numberIterations << " ns/op";
+	if (bytesPerIteration > 0) {
+		cout << setw(10) << setprecision(1) <<
+			bytesPerIteration * numberIterations / elapsedSeconds / 1e6 << " MB/s";
+	}
+	cout << setw(14) << setprecision(0) << numberItems / elapsedSeconds << " items/s" << endl;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function validates the links of the pages n times.
+* @param		vector<string>* -- ptrLinks (the href values found on the pages)
+* @param		string -- hostName (the host of the pages)
+* @param		long -- numberIterations (the number of passes over the links)
+* @return		long -- the number of links validated
+*******************************************************************************
+*/
+long benchValidateURL(const vector<string>* ptrLinks, const string& hostName, long numberIterations)
+{
+	long numberValid = 0;
+	for (long i = 0; i < numberIterations; i++) {
+		for (size_t j = 0; j < ptrLinks->size(); j++) {
+			if (validateURL((*ptrLinks)[j], hostName) != "") {
+				numberValid++;
+			}
+		}
+	}
+	sink += numberValid;
+	return numberIterations * ptrLinks->size();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function extracts the links of the pages n times, reusing one
+HTMLPage as the crawler does.
+* @param		vector<PageBuffer>* -- ptrPages (the pages)
+* @param		string -- url (the URL given to the pages)
+* @param		long -- numberIterations (the number of passes over the pages)
+* @return		long -- the number of links extracted
+*******************************************************************************
+*/
+long benchExtractLinks(const vector< boost::shared_ptr<const PageBuffer> >* ptrPages,
+	const string& url, long numberIterations)
+{
+	HTMLPage htmlPage(url);
+	long numberLinks = 0;
+	for (long i = 0; i < numberIterations; i++) {
+		for (size_t j = 0; j < ptrPages->size(); j++) {
+			htmlPage.reset(url);
+			htmlPage.init(200, (*ptrPages)[j]);
+			numberLinks += htmlPage.extractLinks();
+		}
+	}
+	return numberLinks;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function extracts the product records of the pages n times.
+* @param		vector<PageBuffer>* -- ptrPages (the pages)
+* @param		ExtractionRules* -- ptrRules (the compiled rules)
+* @param		string -- url (the URL given to the pages, selecting the rules)
+* @param		long -- numberIterations (the number of passes over the pages)
+* @return		long -- the number of records extracted
+*******************************************************************************
+*/
+long benchExtractInfo(const vector< boost::shared_ptr<const PageBuffer> >* ptrPages,
+	const ExtractionRules* ptrRules, const string& url, long numberIterations)
+{
+	HTMLPage htmlPage(url);
+	long numberRecords = 0;
+	for (long i = 0; i < numberIterations; i++) {
+		for (size_t j = 0; j < ptrPages->size(); j++) {
+			htmlPage.reset(url);
+			htmlPage.init(200, (*ptrPages)[j]);
+			numberRecords += htmlPage.extractInfo(*ptrRules);
+		}
+	}
+	return numberRecords;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the entrance to the benchmark.
+* @param		argv[1] -- the folder of the page store segments or saved html pages
+(default ../data); when it holds no page, 100 pages of a SyntheticSite are used
+* @param		argv[2] -- the URL of the pages (default http://www.walmart.ca/en/p)
+* @param		argv[3] -- the rule file (default ../extraction.rules)
+* @return		int -- return 0 if successful, or 1 if the rules cannot be loaded
+*******************************************************************************
+*/
+int main(int argc, char* argv[])
+{
+	string folder = (argc > 1) ? argv[1] : "../data";
+	string url = (argc > 2) ? argv[2] : "http://www.walmart.ca/en/p";
+	string rulesFile = (argc > 3) ? argv[3] : "../extraction.rules";
+
+	ExtractionRules extractionRules;
+	if (extractionRules.load(rulesFile) != 0) {
+		return 1;
+	}
+	vector<string> corpus;
+	size_t numberBytes = loadCorpus(folder, corpus);
+	if (corpus.empty()) {
+		SyntheticSite site((SyntheticSiteConfig()));
+		for (long id = 0; id < 100; id++) {
+			corpus.push_back(site.renderPage(id));
+			numberBytes += corpus.back().size();
+		}
+		cout << "No page found in " << folder << ", using synthetic pages" << endl;
+	}
+	cout << "Corpus: " << corpus.size() << " pages, " << numberBytes << " bytes" << endl;
+
+	//the pages as the fetch engine hands them over, and the links found on them
+	vector< boost::shared_ptr<const PageBuffer> > pages;
+	vector<string> links;
+	HTMLPage htmlPage(url);
+	for (size_t i = 0; i < corpus.size(); i++) {
+		boost::shared_ptr<PageBuffer> ptrPage(new PageBuffer);
+		ptrPage->append(corpus[i].data(), corpus[i].size());
+		pages.push_back(ptrPage);
+		htmlPage.reset(url);
+		htmlPage.init(200, ptrPage);
+		htmlPage.extractLinks();
+		links.insert(links.end(), htmlPage.getPtrLinkSet()->begin(),
+			htmlPage.getPtrLinkSet()->end());
+	}
+	htmlPage.reset(url);
+	htmlPage.init(200, pages[0]);
+	string hostName = htmlPage.getHostName();
+
+	runBenchmark("validateURL", boost::bind(benchValidateURL, &links, hostName, _1), 0);
+	runBenchmark("HTMLPage::extractLinks", boost::bind(benchExtractLinks, &pages, url, _1),
+		numberBytes);
+	runBenchmark("HTMLPage::extractInfo", boost::bind(benchExtractInfo, &pages,
+		&extractionRules, url, _1), numberBytes);
+
+	return 0;
+}
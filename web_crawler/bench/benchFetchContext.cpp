@@ -0,0 +1,146 @@
+/**
+*******************************************************************************
+* @file			benchFetchContext.cpp
+* @brief 		This file provides the benchmark downloading pages of one host
+with a new curl handle per page, as HTMLPage::init() used to, and with the
+handles of the FetchContext sharing the DNS, connection and TLS session state.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "../FetchContext.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+using namespace std;
+using namespace WebDataExtraction;
+using namespace boost::posix_time;
+
+//the number of pages downloaded and failed
+static boost::atomic<long> numberFailed(0);
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the write callback discarding the page.
+*******************************************************************************
+*/
+static size_t discardPage(char* /*data*/, size_t size, size_t nmemb, void* /*userData*/)
+{
+	return size * nmemb;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function downloads the pages of one thread.
+* @param		FetchContext* -- ptrContext (the shared caches, or NULL for a new
+handle per page)
+* @param		FetchContext* -- ptrCounter (counts the setup of the transfers)
+* @param		string -- url (the page)
+* @param		string -- caFile (the certificate of the server, or "")
+* @param		int -- numberPages (the number of pages of the thread)
+* @return		void
+*******************************************************************************
+*/
+void fetchPages(FetchContext* ptrContext, FetchContext* ptrCounter, const string& url,
+	const string& caFile, int numberPages)
+{
+	for (int i = 0; i < numberPages; i++) {
+		CURL* handle = (ptrContext != NULL) ? ptrContext->acquireThreadHandle() : curl_easy_init();
+		curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+		curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+		curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, discardPage);
+		if (caFile != "") {
+			curl_easy_setopt(handle, CURLOPT_CAINFO, caFile.c_str());
+		}
+		CURLcode curlCode = curl_easy_perform(handle);
+		if (curlCode != CURLE_OK) {
+			numberFailed++;
+		}
+		ptrCounter->recordTransfer(handle, curlCode);
+		if (ptrContext == NULL) {
+			curl_easy_cleanup(handle);
+		}
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function downloads the pages on several threads and prints
+the throughput and the connection setup.
+* @param		bool -- isSharing (use the FetchContext instead of a new handle per page)
+* @param		string -- url (the page)
+* @param		string -- caFile (the certificate of the server, or "")
+* @param		int -- numberPages (the number of pages)
+* @param		int -- numberThreads (the number of threads)
+* @return		void
+*******************************************************************************
+*/
+void runBenchmark(bool isSharing, const string& url, const string& caFile, int numberPages,
+	int numberThreads)
+{
+	FetchContext context;
+	ptime begin = microsec_clock::universal_time();
+	boost::thread_group threads;
+	for (int i = 0; i < numberThreads; i++) {
+		threads.create_thread(boost::bind(fetchPages, isSharing ? &context : NULL, &context,
+			url, caFile, numberPages / numberThreads));
+	}
+	threads.join_all();
+	double elapsedSeconds = (microsec_clock::universal_time() - begin).total_microseconds() / 1e6;
+	FetchContextStats stats = context.getStats();
+	cout << (isSharing ? "shared context:  " : "handle per page: ") << stats.numberTransfers /
+		elapsedSeconds << " pages/s, mean setup " << stats.meanSetupMs << " ms, " <<
+		(int)(stats.connectionReuseRate * 100) << "% connections reused, " <<
+		stats.numberTLSHandshakes << " TLS handshakes (mean " << stats.meanTLSHandshakeMs << " ms)";
+	if (isSharing) {
+		cout << ", " << (int)(stats.dnsHitRate * 100) << "% DNS cache hits";
+	}
+	cout << endl;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the entrance to the benchmark. Run it against a
+local HTTPS server keeping the connections alive, to measure without a network.
+* @param		argv[1] -- the page (default https://localhost:8443/)
+* @param		argv[2] -- the number of pages (default 2000)
+* @param		argv[3] -- the number of threads (default 4)
+* @param		argv[4] -- the certificate of the server (default: the system CAs)
+* @return		int -- return 0 if successful, or 1 if downloads fail
+*******************************************************************************
+*/
+int main(int argc, char* argv[])
+{
+	string url = (argc > 1) ? argv[1] : "https://localhost:8443/";
+	int numberPages = (argc > 2) ? atoi(argv[2]) : 2000;
+	int numberThreads = (argc > 3) ? atoi(argv[3]) : 4;
+	string caFile = (argc > 4) ? argv[4] : "";
+	if (numberPages <= 0 || numberThreads <= 0) {
+		cerr << "Usage: " << argv[0] << " [url] [pages] [threads] [CA file]" << endl;
+		return 1;
+	}
+
+	runBenchmark(false, url, caFile, numberPages, numberThreads);
+	runBenchmark(true, url, caFile, numberPages, numberThreads);
+	if (numberFailed > 0) {
+		cerr << numberFailed << " downloads failed" << endl;
+		return 1;
+	}
+	return 0;
+}
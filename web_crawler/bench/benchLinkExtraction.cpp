@@ -0,0 +1,354 @@
+/**
+*******************************************************************************
+* @file			benchLinkExtraction.cpp
+* @brief 		This file provides the benchmark comparing the regular expression
+link extraction with the LinkScanner over a corpus of saved pages, after
+checking that both find the same links on every page.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "../LinkScanner.h"
+#include "../PageStore.h"
+
+#include <dirent.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+
+#include <boost/regex.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+using namespace std;
+using namespace WebDataExtraction;
+using namespace boost::posix_time;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function loads the pages of a directory: the records of the
+PageStore segments (segment-*.seg), decoded by PageStore::readSegment(), and the
+saved .html or .htm files. The other files of the crawler folder (indexes,
+checkpoints, logs, metrics, records) are skipped.
+* @param		string -- folder (the directory holding the pages)
+* @param		vector<string>& -- pages (output, the content of each page)
+* @return		size_t -- the total number of bytes loaded
+*******************************************************************************
+*/
+size_t loadCorpus(const string& folder, vector<string>& pages)
+{
+	size_t numberBytes = 0;
+	DIR* dir = opendir(folder.c_str());
+	if (dir == NULL) {
+		cerr << "Failed to open the corpus folder " << folder << endl;
+		return 0;
+	}
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL) {
+		string name = entry->d_name;
+		size_t dot = name.rfind('.');
+		string extension = (dot == string::npos) ? "" : name.substr(dot);
+		string path = folder + "/" + name;
+		if (name.compare(0, 8, "segment-") == 0 && extension == ".seg") {
+			vector<PageRecord> records;
+			if (PageStore::readSegment(path, records) != 0) {
+				cerr << "Failed to read the segment " << path << endl;
+			}
+			for (size_t i = 0; i < records.size(); i++) {
+				if (records[i].httpStatus == 200 && !records[i].body.empty()) {
+					pages.push_back(records[i].body);
+					numberBytes += pages.back().size();
+				}
+			}
+		}
+		else if (name[0] != '.' && (extension == ".html" || extension == ".htm")) {
+			ifstream file(path.c_str(), ios::binary);
+			stringstream content;
+			content << file.rdbuf();
+			pages.push_back(content.str());
+			numberBytes += pages.back().size();
+		}
+	}
+	closedir(dir);
+	return numberBytes;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function extracts the links the way HTMLPage::extractLinks()
+did before the LinkScanner: a regex built per call and a set of copied matches.
+* @param		string -- page (the html page)
+* @return		size_t -- the number of links found
+*******************************************************************************
+*/
+size_t extractLinksRegex(const string& page)
+{
+	boost::regex linkPattern("[hH][rR][eE][fF]\\s*=\\s*\"([^\"]+)\"");
+	set<string> linkSet;
+	string::const_iterator start = page.begin(), end = page.end();
+	boost::match_results<std::string::const_iterator> what;
+	size_t numberLinks = 0;
+	while (boost::regex_search(start, end, what, linkPattern, boost::match_default)) {
+		numberLinks++;
+		linkSet.insert(what[1].str());
+		start = what[0].second;
+	}
+	return numberLinks;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function extracts the links with the LinkScanner.
+* @param		string -- page (the html page)
+* @return		size_t -- the number of links found
+*******************************************************************************
+*/
+size_t extractLinksScanner(const string& page)
+{
+	static const LinkScanner linkScanner(LinkScanner::HREF);
+	vector<ScannedLink> links;
+	linkScanner.scan(page.data(), page.size(), 0, links);
+	return links.size();
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function collects the href values of a page with a regular
+expression following the same rules as the LinkScanner: the attribute name
+starts the attribute, and the value is double-quoted, single-quoted or unquoted
+up to a space or '>'. The empty values are skipped.
+* @param		string -- page (the html page)
+* @param		vector<string>& -- links (output, the raw values in page order)
+* @return		void
+*******************************************************************************
+*/
+void collectLinksRegex(const string& page, vector<string>& links)
+{
+	static const boost::regex linkPattern("(?<![^ \t\n\r\f\"'/])[hH][rR][eE][fF]"
+		"[ \t\n\r\f]*=[ \t\n\r\f]*(?:\"([^\"]*)\"|'([^']*)'|([^ \t\n\r\f>\"'][^ \t\n\r\f>]*))");
+	string::const_iterator start = page.begin(), end = page.end();
+	boost::match_results<std::string::const_iterator> what;
+	while (boost::regex_search(start, end, what, linkPattern, boost::match_default)) {
+		for (int group = 1; group <= 3; group++) {
+			if (what[group].matched && what[group].length() > 0) {
+				links.push_back(what[group].str());
+			}
+		}
+		start = what[0].second;
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function collects the href values of a page with the
+IncrementalLinkScanner, fed as if the page arrived in chunks.
+* @param		string -- page (the html page)
+* @param		size_t -- chunkSize (the number of bytes per chunk)
+* @param		bool -- isDecoding (decode the character entities of the values)
+* @param		vector<string>& -- links (output, the values in page order)
+* @return		void
+*******************************************************************************
+*/
+void collectLinksIncremental(const string& page, size_t chunkSize, bool isDecoding,
+	vector<string>& links)
+{
+	IncrementalLinkScanner linkScanner(LinkScanner::HREF);
+	vector<ScannedLink> scannedLinks;
+	for (size_t length = chunkSize; length < page.size(); length += chunkSize) {
+		linkScanner.feed(page.data(), length, scannedLinks);
+	}
+	linkScanner.finish(page.data(), page.size(), scannedLinks);
+	for (size_t i = 0; i < scannedLinks.size(); i++) {
+		links.push_back((isDecoding && scannedLinks[i].hasEntity) ?
+			LinkScanner::decodeEntities(scannedLinks[i].value) : scannedLinks[i].value.to_string());
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function prints the first difference between two link lists.
+* @param		string -- name (the name of the page)
+* @param		string -- what (the lists compared)
+* @param		vector<string> -- expectedLinks (the reference)
+* @param		vector<string> -- links (the links found)
+* @return		bool -- return true if the lists are equal
+*******************************************************************************
+*/
+bool compareLinks(const string& name, const string& what, const vector<string>& expectedLinks,
+	const vector<string>& links)
+{
+	if (links == expectedLinks) {
+		return true;
+	}
+	size_t i = 0;
+	while (i < links.size() && i < expectedLinks.size() && links[i] == expectedLinks[i]) {
+		i++;
+	}
+	cerr << name << ": " << what << " differ at link " << i << ": expected \"" <<
+		(i < expectedLinks.size() ? expectedLinks[i] : "(none)") << "\", found \"" <<
+		(i < links.size() ? links[i] : "(none)") << "\" (" << expectedLinks.size() << " vs " <<
+		links.size() << " links)" << endl;
+	return false;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function checks the LinkScanner on hand-written markup: quoted,
+unquoted and entity-encoded values, and attributes which are not links, the page
+being scanned whole and fed in chunks of every size up to 64 bytes, so that
+each value is cut at each of its bytes.
+* @param		none
+* @return		int -- the number of mismatches
+*******************************************************************************
+*/
+int checkMarkup()
+{
+	string page = "<html><body><a href=\"/p/1\">one</a><a HREF='/p/2'>two</a>"
+		"<a href=/p/3>three</a><a class=x href=/p/4 id=y>four</a>\n"
+		"<a\thref = \"/p/5?a=1&amp;b=2\">five</a><a href=\"/p/&#54;\">six</a>"
+		"<a href='/p/&#x37;'>seven</a><link href=\"/style.css\"/>\n"
+		"<div data-href=\"/no/1\" title=\"a=b\"><a href=\"\">empty</a>"
+		"<a title='x' href =\n/p/8>eight</a></div><a href=\"/unterminated";
+	static const char* decodedLinks[] = {"/p/1", "/p/2", "/p/3", "/p/4", "/p/5?a=1&b=2",
+		"/p/6", "/p/7", "/style.css", "/p/8"};
+	vector<string> expectedLinks(decodedLinks, decodedLinks + sizeof(decodedLinks) /
+		sizeof(decodedLinks[0]));
+
+	int numberMismatches = 0;
+	vector<string> links;
+	collectLinksIncremental(page, page.size(), true, links);
+	numberMismatches += compareLinks("markup", "the expected and scanned links",
+		expectedLinks, links) ? 0 : 1;
+	for (size_t chunkSize = 1; chunkSize <= 64; chunkSize++) {
+		links.clear();
+		collectLinksIncremental(page, chunkSize, true, links);
+		stringstream what;
+		what << "the expected links and those scanned in chunks of " << chunkSize << " bytes";
+		numberMismatches += compareLinks("markup", what.str(), expectedLinks, links) ? 0 : 1;
+	}
+	return numberMismatches;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function checks that the regular expression, the LinkScanner
+and the IncrementalLinkScanner fed in chunks of 7 and 1460 bytes find the same
+raw values on each page of the corpus.
+* @param		vector<string> -- pages (the corpus)
+* @return		int -- the number of pages with a mismatch
+*******************************************************************************
+*/
+int checkCorpus(const vector<string>& pages)
+{
+	static const size_t chunkSizes[] = {7, 1460};
+	int numberMismatches = 0;
+	for (size_t i = 0; i < pages.size(); i++) {
+		stringstream name;
+		name << "page " << i;
+		vector<string> expectedLinks;
+		collectLinksRegex(pages[i], expectedLinks);
+		vector<string> links;
+		collectLinksIncremental(pages[i], pages[i].size(), false, links);
+		bool isEqual = compareLinks(name.str(), "the regex and scanner links", expectedLinks, links);
+		for (size_t k = 0; isEqual && k < sizeof(chunkSizes) / sizeof(chunkSizes[0]); k++) {
+			links.clear();
+			collectLinksIncremental(pages[i], chunkSizes[k], false, links);
+			stringstream what;
+			what << "the regex links and those scanned in chunks of " << chunkSizes[k] << " bytes";
+			isEqual = compareLinks(name.str(), what.str(), expectedLinks, links);
+		}
+		numberMismatches += isEqual ? 0 : 1;
+	}
+	return numberMismatches;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function runs one extraction path over the corpus and prints
+its throughput.
+* @param		string -- name (the name of the path)
+* @param		size_t (*)(const string&) -- extract (the extraction function)
+* @param		vector<string> -- pages (the corpus)
+* @param		size_t -- numberBytes (the size of the corpus)
+* @param		int -- numberRounds (the number of passes over the corpus)
+* @return		void
+*******************************************************************************
+*/
+void runBenchmark(const string& name, size_t (*extract)(const string&),
+	const vector<string>& pages, size_t numberBytes, int numberRounds)
+{
+	size_t numberLinks = 0;
+	ptime begin = microsec_clock::universal_time();
+	for (int round = 0; round < numberRounds; round++) {
+		for (size_t i = 0; i < pages.size(); i++) {
+			numberLinks += extract(pages[i]);
+		}
+	}
+	double elapsedSeconds = (microsec_clock::universal_time() - begin).total_microseconds() / 1e6;
+	cout << name << ": " << numberLinks / numberRounds << " links per pass, " <<
+		(double)numberBytes * numberRounds / elapsedSeconds / 1e6 << " MB/s, " <<
+		pages.size() * numberRounds / elapsedSeconds << " pages/s" << endl;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the entrance to the benchmark. The links found
+are checked before the extraction paths are timed.
+* @param		argv[1] -- the folder of the page store segments or saved html pages
+(default ../data)
+* @param		argv[2] -- the number of passes over the corpus (default 10)
+* @return		int -- return 0 if successful, or 1 if the corpus is empty or the
+extraction paths find different links
+*******************************************************************************
+*/
+int main(int argc, char* argv[])
+{
+	string folder = (argc > 1) ? argv[1] : "../data";
+	int numberRounds = (argc > 2) ? atoi(argv[2]) : 10;
+
+	vector<string> pages;
+	size_t numberBytes = loadCorpus(folder, pages);
+	if (pages.empty()) {
+		cerr << "No page found in " << folder << endl;
+		return 1;
+	}
+	cout << "Corpus: " << pages.size() << " pages, " << numberBytes << " bytes" << endl;
+
+	int numberMarkupMismatches = checkMarkup();
+	int numberPageMismatches = checkCorpus(pages);
+	if (numberMarkupMismatches > 0 || numberPageMismatches > 0) {
+		cerr << numberMarkupMismatches << " markup checks and " << numberPageMismatches <<
+			" pages failed" << endl;
+		return 1;
+	}
+	cout << "Links: the regex and the scanner agree on every page" << endl;
+
+	runBenchmark("boost::regex", extractLinksRegex, pages, numberBytes, numberRounds);
+	runBenchmark("LinkScanner ", extractLinksScanner, pages, numberBytes, numberRounds);
+
+	return 0;
+}
@@ -0,0 +1,203 @@
+/**
+*******************************************************************************
+* @file			benchPoliteness.cpp
+* @brief 		This file provides the check of the PolitenessScheduler against a
+SyntheticSite which throttles the requests above a rate: the concurrency limit
+of the host must fall while the site answers 429 or 503, and grow back once it
+stops throttling.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "SyntheticSite.h"
+#include "../PolitenessScheduler.h"
+#include "../FetchEngine.h"
+#include "../AsyncLogger.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+using namespace std;
+using namespace WebDataExtraction;
+
+/**
+*******************************************************************************
+* @struct		PhaseStats
+* @brief 		This structure holds the responses of one phase of the check, and
+the concurrency limits of the host seen after each of them.
+*******************************************************************************
+*/
+struct PhaseStats
+{
+	boost::mutex mutex;
+	boost::condition_variable condition;
+	//the requests of the phase not completed yet
+	long numberPending;
+	//the responses passed to the caller: 200, and throttled after the last retry
+	long numberPages;
+	long numberThrottled;
+	//the lowest and the highest concurrency limits seen
+	double minLimit;
+	double maxLimit;
+};
+
+//the scheduler under test and the host key of the site
+static PolitenessScheduler* ptrScheduler = NULL;
+static string hostName;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the callback of a request: it counts the response
+and samples the concurrency limit of the host.
+* @param		PhaseStats* -- ptrStats (the phase of the request)
+* @param		FetchResult -- result (the result of the transfer)
+* @return		void
+*******************************************************************************
+*/
+void pageFetched(PhaseStats* ptrStats, const FetchResult& result)
+{
+	double limit = ptrScheduler->getConcurrencyLimit(hostName);
+	boost::mutex::scoped_lock lock(ptrStats->mutex);
+	if (result.httpStatus == 200) {
+		ptrStats->numberPages++;
+	}
+	else if (result.httpStatus == 429 || result.httpStatus == 503) {
+		ptrStats->numberThrottled++;
+	}
+	ptrStats->minLimit = min(ptrStats->minLimit, limit);
+	ptrStats->maxLimit = max(ptrStats->maxLimit, limit);
+	if (--ptrStats->numberPending == 0) {
+		ptrStats->condition.notify_all();
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function submits the requests of a phase to the scheduler and
+waits for all of them.
+* @param		PhaseStats& -- stats (output, the responses of the phase)
+* @param		long -- firstPage (the first page requested)
+* @param		long -- numberRequests (the number of pages requested)
+* @return		void
+*******************************************************************************
+*/
+void runPhase(PhaseStats& stats, long firstPage, long numberRequests)
+{
+	stats.numberPending = numberRequests;
+	stats.numberPages = 0;
+	stats.numberThrottled = 0;
+	stats.minLimit = 1e9;
+	stats.maxLimit = 0;
+	for (long i = 0; i < numberRequests; i++) {
+		stringstream urlStream;
+		urlStream << hostName << "/p/" << firstPage + i;
+		ptrScheduler->submit(urlStream.str(), boost::bind(pageFetched, &stats, _1));
+	}
+	boost::mutex::scoped_lock lock(stats.mutex);
+	while (stats.numberPending > 0) {
+		stats.condition.wait(lock);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the entrance to the check. The scheduler may send
+far more requests per second than the site accepts; in the first phase the site
+throttles above its rate, in the second it serves every request.
+* @param		argv[1] -- the requests per second accepted by the site (default 100)
+* @param		argv[2] -- the status of the throttled requests, 429 or 503 (default 429)
+* @param		argv[3] -- the number of requests of each phase (default 400)
+* @return		int -- return 0 if the limit falls and recovers, or 1 otherwise
+*******************************************************************************
+*/
+int main(int argc, char* argv[])
+{
+	SyntheticSiteConfig config;
+	config.numberPages = 100000;
+	config.pageBytes = 2000;
+	config.latencyMedianMs = 2.0;
+	config.throttleRate = (argc > 1) ? atof(argv[1]) : 100.0;
+	config.throttleStatus = (argc > 2) ? atoi(argv[2]) : 429;
+	long numberRequests = (argc > 3) ? atol(argv[3]) : 400;
+	if (config.throttleRate <= 0 || (config.throttleStatus != 429 &&
+			config.throttleStatus != 503) || numberRequests <= 0 ||
+			2 * numberRequests > config.numberPages) {
+		cerr << "Usage: " << argv[0] << " [requests per second] [429|503] [requests]" << endl;
+		return 1;
+	}
+
+	SyntheticSite site(config);
+	if (site.start() != 0) {
+		return 1;
+	}
+	stringstream hostStream;
+	hostStream << "http://127.0.0.1:" << site.getPort();
+	hostName = hostStream.str();
+
+	PolitenessConfig politenessConfig;
+	politenessConfig.requestsPerSecond = 20 * config.throttleRate;
+	politenessConfig.burstSize = 50;
+	politenessConfig.initialConcurrency = 8;
+	politenessConfig.maxConcurrency = 32;
+	politenessConfig.backoffMs = 100;
+	FetchEngine fetchEngine(1, 64, 64);
+	PolitenessScheduler scheduler(fetchEngine, politenessConfig);
+	ptrScheduler = &scheduler;
+
+	PhaseStats throttledStats;
+	runPhase(throttledStats, 0, numberRequests);
+	double throttledLimit = scheduler.getConcurrencyLimit(hostName);
+	long numberSiteThrottled = site.getNumberThrottled();
+	site.setThrottleRate(0);
+	PhaseStats recoveryStats;
+	runPhase(recoveryStats, numberRequests, numberRequests);
+	double recoveredLimit = scheduler.getConcurrencyLimit(hostName);
+
+	scheduler.stop();
+	fetchEngine.stop();
+	site.stop();
+	AsyncLogger::getShared().stop();
+
+	cout << "Site: " << config.throttleRate << " requests per second, then no limit, " <<
+		config.throttleStatus << " with Retry-After: " << config.retryAfterSeconds << endl;
+	cout << "Throttled: " << throttledStats.numberPages << " pages, " << numberSiteThrottled <<
+		" requests throttled, " << throttledStats.numberThrottled << " given up, limit " <<
+		politenessConfig.initialConcurrency << " -> " << throttledLimit << " (min " <<
+		throttledStats.minLimit << ")" << endl;
+	cout << "Recovery:  " << recoveryStats.numberPages << " pages, limit " << throttledLimit <<
+		" -> " << recoveredLimit << " (max " << recoveryStats.maxLimit << ")" << endl;
+
+	int status = 0;
+	if (numberSiteThrottled == 0) {
+		cerr << "The site throttled no request" << endl;
+		status = 1;
+	}
+	if (throttledStats.minLimit >= politenessConfig.initialConcurrency) {
+		cerr << "The concurrency limit did not decrease under throttling" << endl;
+		status = 1;
+	}
+	if (recoveryStats.numberPages != numberRequests) {
+		cerr << recoveryStats.numberPages << " of " << numberRequests <<
+			" pages downloaded after the throttling" << endl;
+		status = 1;
+	}
+	if (recoveredLimit <= throttledLimit || recoveredLimit < politenessConfig.initialConcurrency) {
+		cerr << "The concurrency limit did not recover after the throttling" << endl;
+		status = 1;
+	}
+	return status;
+}
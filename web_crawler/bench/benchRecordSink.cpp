@@ -0,0 +1,126 @@
+/**
+*******************************************************************************
+* @file			benchRecordSink.cpp
+* @brief 		This file provides the benchmark writing generated product
+records into a local MySQL/MariaDB database with the MySQLRecordSink, in batches
+and one row per statement.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "../MySQLRecordSink.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+using namespace std;
+using namespace WebDataExtraction;
+using namespace boost::posix_time;
+
+//the number of records of a generated page
+static const int kRecordsPerPage = 20;
+//the number of threads submitting pages, as the processing threads of the crawler
+static const int kNumberSubmitters = 4;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function submits the generated pages of one thread.
+* @param		MySQLRecordSink* -- ptrSink (the sink)
+* @param		int -- first (the index of the first page of the thread)
+* @param		int -- numberPages (the number of pages of the thread)
+* @return		void
+*******************************************************************************
+*/
+void submitPages(MySQLRecordSink* ptrSink, int first, int numberPages)
+{
+	RecordBatch records;
+	for (int page = first; page < first + numberPages; page++) {
+		records.clear();
+		for (int k = 0; k < kRecordsPerPage; k++) {
+			long productID = (long)page * kRecordsPerPage + k;
+			stringstream description;
+			description << "Generated product " << productID;
+			records.append(productID, "Electronics", description.str(),
+				"http://localhost/images/product.jpg", 1999 + k * 100, 1499 + k * 100);
+		}
+		ptrSink->submit(records.view());
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function writes numberRecords records into a table and prints
+the throughput.
+* @param		MySQLSinkConfig -- config (the database, the table and the batching)
+* @param		int -- numberRecords (the number of records to write)
+* @return		bool -- return false if the database cannot be opened or records fail
+*******************************************************************************
+*/
+bool runBenchmark(const MySQLSinkConfig& config, int numberRecords)
+{
+	MySQLRecordSink sink(config);
+	if (sink.open() != 0) {
+		return false;
+	}
+	int numberPages = numberRecords / kRecordsPerPage;
+	ptime begin = microsec_clock::universal_time();
+	boost::thread_group submitters;
+	for (int i = 0; i < kNumberSubmitters; i++) {
+		int first = numberPages * i / kNumberSubmitters;
+		int last = numberPages * (i + 1) / kNumberSubmitters;
+		submitters.create_thread(boost::bind(submitPages, &sink, first, last - first));
+	}
+	submitters.join_all();
+	sink.close();
+	double elapsedSeconds = (microsec_clock::universal_time() - begin).total_microseconds() / 1e6;
+	cout << "batch " << config.batchSize << ": " << sink.getNumberRecordsWritten() <<
+		" records in " << sink.getNumberBatches() << " statements, " <<
+		sink.getNumberRecordsWritten() / elapsedSeconds << " records/s, " <<
+		sink.getNumberRecordsFailed() << " failed" << endl;
+	return sink.getNumberRecordsFailed() == 0 &&
+		sink.getNumberRecordsWritten() == (long)numberPages * kRecordsPerPage;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the entrance to the benchmark.
+* @param		argv[1] -- the database (default root@localhost/webdata)
+* @param		argv[2] -- the number of records (default 100000)
+* @param		argv[3] -- the number of records per statement (default 500)
+* @return		int -- return 0 if successful, or 1 if a run fails
+*******************************************************************************
+*/
+int main(int argc, char* argv[])
+{
+	MySQLSinkConfig config;
+	if (!config.parse((argc > 1) ? argv[1] : "root@localhost/webdata")) {
+		cerr << "Usage: " << argv[0] << " [user[:password]@host[:port]/database]" <<
+			" [records] [batch size]" << endl;
+		return 1;
+	}
+	int numberRecords = (argc > 2) ? atoi(argv[2]) : 100000;
+	config.batchSize = (argc > 3) ? atoi(argv[3]) : 500;
+
+	//the batched upserts, then one row per statement on a tenth of the records
+	config.table = "bench_products_batch";
+	bool isPassed = runBenchmark(config, numberRecords);
+	config.table = "bench_products_row";
+	config.batchSize = 1;
+	isPassed = runBenchmark(config, numberRecords / 10) && isPassed;
+
+	return isPassed ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+/**
+*******************************************************************************
+* @file			checkExtractionRules.cpp
+* @brief 		This file provides the check of the ExtractionRules: the prices
+read in cents, the selectors rejected by compile(), and the records extracted
+from hand-written pages.
+* @author		Yifeng He
+* @date			Feb. 11, 2014, Version 1.0
+*******************************************************************************
+**/
+
+#include "../ExtractionRules.h"
+#include "../RecordBatch.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <boost/cstdint.hpp>
+
+using namespace std;
+using namespace WebDataExtraction;
+
+//the number of failed checks
+static int numberFailures = 0;
+
+
+
+/**
+*******************************************************************************
+* @brief		This function counts a check and prints it if it fails.
+* @param		bool -- isPassed (the outcome of the check)
+* @param		string -- description (what is checked)
+* @return		void
+*******************************************************************************
+*/
+void check(bool isPassed, const string& description)
+{
+	if (!isPassed) {
+		cerr << "FAILED: " << description << endl;
+		numberFailures++;
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function checks the prices read in cents: each price is the
+only price of a one-product page, so that it fills both prices of the record.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void checkPrices()
+{
+	static const char* prices[] = {"$1,299.00", "1 299,00 $", "$1,299", "1299", "$19.99",
+		"12,50 &euro;", "CDN$ 5.005", "$0.994", "1 299 999,99", "Price: $7.5 (was $9)",
+		"Free", "1 2345"};
+	static const boost::int64_t cents[] = {129900, 129900, 129900, 129900, 1999,
+		1250, 501, 99, 129999999, 750,
+		0, 100};
+	ExtractionRules extractionRules;
+	check(extractionRules.compile("[*]\nid = #id\ncurrentPrice = .price\n") == 0,
+		"the price rules compile");
+	for (size_t i = 0; i < sizeof(prices) / sizeof(prices[0]); i++) {
+		string page = string("<html><body><span id=\"id\">7</span><span class=\"price\">") +
+			prices[i] + "</span></body></html>";
+		RecordBatch recordBatch;
+		int numberRecords = extractionRules.extract(page.data(), page.size(),
+			"http://shop.test", recordBatch);
+		RecordBatchView records = recordBatch.view();
+		stringstream description;
+		description << "\"" << prices[i] << "\" is read as " << cents[i] << " cents";
+		if (numberRecords == 1) {
+			description << ", not " << records.getCurrentPriceCents(0);
+		}
+		check(numberRecords == 1 && records.getCurrentPriceCents(0) == cents[i] &&
+			records.getOriginalPriceCents(0) == cents[i], description.str());
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function checks that compile() rejects the malformed rules
+without adding any of their sections, and accepts the valid selectors.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void checkSelectors()
+{
+	static const char* malformedSelectors[] = {"", "[itemprop=price", "[itemprop=\"price]",
+		"div >", "> span", "div > > span", "span @", "div..x", "div#", "[=x]", "div!x",
+		"@content"};
+	static const char* validSelectors[] = {"div.product > span[itemprop=\"price\"] @content",
+		"*[itemprop]", "#main .price.sale", "ul > li > a[href] @href",
+		"[itemtype='http://schema.org/Product'] [data-x=a>b]"};
+	ExtractionRules extractionRules;
+	cerr << "(the errors of the malformed rules follow)" << endl;
+	for (size_t i = 0; i < sizeof(malformedSelectors) / sizeof(malformedSelectors[0]); i++) {
+		string rules = string("[*]\nid = #id\ncurrentPrice = ") + malformedSelectors[i] + "\n";
+		check(extractionRules.compile(rules) == 1, string("the selector \"") +
+			malformedSelectors[i] + "\" is rejected");
+	}
+	check(extractionRules.compile("id = #id\n") == 1, "a field outside a section is rejected");
+	check(extractionRules.compile("[*]\nprice = .price\n") == 1, "an unknown field is rejected");
+	check(extractionRules.compile("[*]\n.price\n") == 1, "a line without '=' is rejected");
+	check(extractionRules.getNumberSites() == 0, "the rejected rules add no section");
+	cerr << "(end of the expected errors)" << endl;
+
+	for (size_t i = 0; i < sizeof(validSelectors) / sizeof(validSelectors[0]); i++) {
+		string rules = string("[*]\ncurrentPrice = ") + validSelectors[i] + "\n";
+		check(extractionRules.compile(rules) == 0, string("the selector \"") +
+			validSelectors[i] + "\" is accepted");
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function checks the records extracted from a page of two
+products: the record selector, the child and attribute selectors, the fields
+filled from outside the records, the relative image links, and the sections
+selected by the host.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void checkRecords()
+{
+	ExtractionRules extractionRules;
+	check(extractionRules.load("../extraction.rules") == 0, "../extraction.rules compiles");
+	check(extractionRules.compile("[shop.test]\n"
+		"record        = div.product\n"
+		"id            = [itemprop=sku] @content\n"
+		"category      = ul.breadcrumb > li.current\n"
+		"description   = .product > h2\n"
+		"image         = img.main @src\n"
+		"originalPrice = .was\n"
+		"currentPrice  = .product span[itemprop=price]\n") == 0, "the shop.test rules compile");
+	string page = "<html><body><ul class=\"breadcrumb\"><li>Home</li>"
+		"<li class=\"current\">Televisions</li></ul>"
+		"<div class=\"product\"><meta itemprop=\"sku\" content=\"SKU-101\">"
+		"<h2>Smart TV 55&quot;</h2><img class=\"main\" src=\"/img/101.jpg\">"
+		"<span class=\"was\">$1,499.00</span><span itemprop=\"price\">$1,299.00</span></div>"
+		"<div class=\"product\"><meta itemprop=\"sku\" content=\"SKU-102\">"
+		"<div><h2>Not the name</h2></div><h2>Radio</h2>"
+		"<img class=\"main\" src=\"//cdn.shop.test/102.jpg\">"
+		"<span itemprop=\"price\">24,99 $</span></div>"
+		"<div class=\"product\"><span itemprop=\"price\">$5</span></div>"
+		"</body></html>";
+
+	RecordBatch recordBatch;
+	int numberRecords = extractionRules.extract(page.data(), page.size(),
+		"http://www.shop.test", recordBatch);
+	//the third product has neither id nor description
+	check(numberRecords == 2 && recordBatch.size() == 2, "two records are extracted");
+	RecordBatchView records = recordBatch.view();
+	if (records.size() == 2) {
+		check(records.getProductID(0) == 101 && records.getProductID(1) == 102,
+			"the ids are read from the sku attributes");
+		check(records.getDescription(0) == "Smart TV 55\"" &&
+			records.getDescription(1) == "Radio", "the descriptions are the child h2");
+		check(records.getCategory(0) == "Televisions" &&
+			records.getCategory(1) == "Televisions",
+			"the breadcrumb outside the records fills the category of both");
+		check(records.getImageLink(0) == "http://www.shop.test/img/101.jpg" &&
+			records.getImageLink(1) == "http://cdn.shop.test/102.jpg",
+			"the relative image links are completed");
+		check(records.getOriginalPriceCents(0) == 149900 &&
+			records.getCurrentPriceCents(0) == 129900, "the prices of a product on sale");
+		check(records.getOriginalPriceCents(1) == 2499 &&
+			records.getCurrentPriceCents(1) == 2499,
+			"a product with one price has it as both prices");
+	}
+
+	//another host falls back on the [*] section of extraction.rules
+	string microdata = "<div itemscope itemtype=\"http://schema.org/Product\">"
+		"<span itemprop=\"sku\">555</span><span itemprop=\"name\">Kettle</span>"
+		"<span itemprop=\"price\">39.95</span></div>";
+	RecordBatch defaultBatch;
+	bool isExtracted = (extractionRules.extract(microdata.data(), microdata.size(),
+		"http://other.test", defaultBatch) == 1);
+	RecordBatchView defaultRecords = defaultBatch.view();
+	check(isExtracted && defaultRecords.getProductID(0) == 555 &&
+		defaultRecords.getDescription(0) == "Kettle" && defaultRecords.getCurrentPriceCents(0) == 3995,
+		"the [*] section applies to the hosts without a section");
+	RecordBatch noBatch;
+	check(extractionRules.extract(page.data(), page.size(), "http://shop.test.example",
+		noBatch) == 0, "a host only containing a section name does not use that section");
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the entrance to the check. Run it in the bench
+folder, next to ../extraction.rules.
+* @param		none
+* @return		int -- return 0 if every check passes, or 1 otherwise
+*******************************************************************************
+*/
+int main()
+{
+	checkPrices();
+	checkSelectors();
+	checkRecords();
+	if (numberFailures > 0) {
+		cerr << numberFailures << " checks failed" << endl;
+		return 1;
+	}
+	cout << "All the extraction rule checks passed" << endl;
+	return 0;
+}
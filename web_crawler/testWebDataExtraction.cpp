@@ -9,14 +9,33 @@ information from a website.
 **/
 
 #include "HTMLPage.h"
+#include "CrawlFrontier.h"
+#include "URLPrioritizer.h"
+#include "FetchEngine.h"
+#include "PolitenessScheduler.h"
+#include "URLSeenFilter.h"
+#include "PagePool.h"
+#include "ResourceUsage.h"
+#include "PageStore.h"
+#include "CrawlCheckpoint.h"
+#include "URLMetadataStore.h"
+#include "ExtractionRules.h"
+#include "MySQLRecordSink.h"
+#include "WorkStealingExecutor.h"
+#include "PipelineStage.h"
+#include "Metrics.h"
+#include "AsyncLogger.h"
 
-#include <boost/asio.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/bind.hpp>
-#include <boost/algorithm/string.hpp> 
+#include <boost/atomic.hpp>
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <sstream>
 
 #include <ctime>
 
@@ -25,149 +44,530 @@ using namespace WebDataExtraction;
 
 
 /******** global variables ************/
-//mutex for exclusive access to resource
-boost::mutex mutexLock;
-//the set holding the links
-set<string> dispatchSet;
-//the set to hold the completed links
-set<string> completedSet;
-//the vector holding the records of product information
-vector<Information> productRecordVector;
-//the id of the processed html file
-int fileID = 0;
+//the number of worker threads running the page pipeline (0: one per core)
+int numberWorkerThreads = 0;
+//pin each worker thread to one core
+bool isPinningThreads = false;
+//the number of fetch engine threads
+int numberFetchThreads = 1;
+//the maximum number of concurrent transfers per fetch engine thread
+int maxTransfers = 256;
+//the scorer of the links, learning which URL patterns yield product records
+URLPrioritizer urlPrioritizer;
+/*the frontier holding the links to be crawled best first, at most one task per
+transfer in flight */
+CrawlFrontier crawlFrontier(numberFetchThreads * maxTransfers, &urlPrioritizer);
+//the pending links kept in memory, the others are spilled into ./data (0: no limit)
+long frontierMemoryURLs = 1000000;
+//the number of links the Bloom filter of the discovered links is sized for
+size_t expectedSeenURLs = 100000000;
+/*the filter of the links which have been discovered, tested and inserted in one
+step; URLSeenFilter::BLOOM (--seen-filter bloom) bounds its memory for very
+large crawls */
+URLSeenFilter urlSeenFilter(URLSeenFilter::EXACT, expectedSeenURLs, 0.001);
+//the number of completed links
+boost::atomic<int> numberCompleted(0);
+//the pool recycling the HTMLPage objects and the page buffers
+PagePool pagePool;
+//the segmented store of the downloaded pages
+PageStore pageStore("./data");
+//the ETag, Last-Modified and content hash of the pages fetched by previous crawls
+URLMetadataStore urlMetadataStore("./data/url-metadata.log");
+//the pages answered with 304, and the pages downloaded again without a change
+boost::atomic<int> numberNotModified(0);
+boost::atomic<int> numberUnchanged(0);
+//the columns holding the records of product information, kept only without --mysql
+//so that the memory does not grow with the crawl
+RecordBatch productRecordBatch;
+//mutex protecting productRecordBatch
+boost::mutex productMutex;
+//the database receiving the product records, if --mysql is given
+MySQLSinkConfig mysqlConfig;
+boost::shared_ptr<MySQLRecordSink> ptrRecordSink;
+//the product extraction rules, compiled once from ./extraction.rules
+ExtractionRules extractionRules;
+//the checkpoints of the crawl state, written every checkpointSeconds (0 disables)
+CrawlCheckpoint crawlCheckpoint("./data", crawlFrontier, urlSeenFilter,
+	productRecordBatch, productMutex, numberCompleted);
+int checkpointSeconds = 60;
 //the host name of the searched website
 string hostName = "http://www.walmart.ca";
+//extract the links while the page is downloading instead of after the download
+bool isStreamingLinks = true;
+
+/**
+*******************************************************************************
+* @struct		PageTask
+* @brief 		This structure holds a downloaded page on its way through the
+store, link and info stages of the page pipeline.
+*******************************************************************************
+*/
+struct PageTask
+{
+	//the page downloaded by the FetchEngine
+	FetchResult result;
+	//where the page was found, and the origin of the links found on it
+	LinkOrigin origin;
+	LinkOrigin linkOrigin;
+	//the scanner which has seen the page during the download, or NULL
+	boost::shared_ptr<IncrementalLinkScanner> ptrLinkScanner;
+	//the parsed page, set by the store stage
+	boost::shared_ptr<HTMLPage> ptrHtmlPage;
+	//false if the page has not changed since the last crawl
+	bool isChanged;
+};
+//the stages of the page pipeline, run by the work-stealing executor
+void storePage(PageTask* ptrTask);
+void extractPageLinks(PageTask* ptrTask);
+void extractPageInfo(PageTask* ptrTask);
+void finishPage(PageTask* ptrTask);
+PipelineStage<PageTask> storeStage("store", 256, storePage);
+PipelineStage<PageTask> linkStage("link", 256, extractPageLinks);
+PipelineStage<PageTask> infoStage("info", 256, extractPageInfo);
+//the executor running the stages, started by main()
+boost::shared_ptr<WorkStealingExecutor> ptrExecutor;
+//the interval (s) of the stage reports (0 disables)
+int stageReportSeconds = 10;
+//the file replaced by the metrics every metricsSeconds (0 disables)
+string metricsFileName = "./data/metrics.prom";
+int metricsSeconds = 10;
+//the histograms and counters of the hot paths of the crawler (Metrics ids)
+int linkExtractionMetric = Metrics::getShared().addHistogram("link_extraction_us");
+int infoExtractionMetric = Metrics::getShared().addHistogram("info_extraction_us");
+int frontierDepthMetric = Metrics::getShared().addHistogram("frontier_depth");
+int pagesFetchedMetric = Metrics::getShared().addCounter("pages_fetched");
+int fetchErrorsMetric = Metrics::getShared().addCounter("fetch_errors");
+int bytesFetchedMetric = Metrics::getShared().addCounter("bytes_fetched");
+int linksDiscoveredMetric = Metrics::getShared().addCounter("links_discovered");
+//the numbers of product records whose time from the start of the crawl is reported
+const long productMilestones[] = {1, 10, 100, 1000, 10000, 100000};
+const int numberProductMilestones = sizeof(productMilestones) / sizeof(productMilestones[0]);
+//the gauges time_to_first_N_products_ms (Metrics ids), registered by main()
+int productMilestoneMetrics[numberProductMilestones];
+//the product records extracted, and the start of the crawl (Metrics::nowMicroseconds())
+boost::atomic<long> numberProducts(0);
+boost::uint64_t crawlBeginMicroseconds = 0;
 
 
 
 /**
 *******************************************************************************
-* @brief		This function validates the input URL string.
-* @param		string -- url (the http URL of the HTML page)
-* @param		string -- hostName (e.g., http://www.walmart.ca/)
-* @return		string -- return a complete and valid URL, or "" in case validation 
-failure
+* @brief		This function logs the queue depth, the throughput and the busy
+ratio of each stage of the page pipeline, and the tasks stolen by the executor.
+* @param		none
+* @return		void
 *******************************************************************************
 */
-string validateURL(string url, string hostName)
+void printStageStats()
 {
-	//the string to be returned
-	string validatedURL = "";
-	
-	if (boost::algorithm::starts_with(url, "/")) {
-		validatedURL = hostName + url;
+	StageStats stats[3] = {storeStage.getStats(), linkStage.getStats(), infoStage.getStats()};
+	for (int i = 0; i < 3; i++) {
+		AsyncLogger::getShared().log(LOG_INFO, "Stage {}: {} threads, {}/{} queued (max {}), "
+			"{} processed, {} full waits, {}% busy", stats[i].name, stats[i].numberWorkers,
+			stats[i].depth, stats[i].capacity, stats[i].maxDepth, stats[i].numberProcessed,
+			stats[i].numberFullWaits, (int)(stats[i].busyRatio * 100));
 	}
-	if (boost::algorithm::starts_with(url, "http") || 
-						boost::algorithm::starts_with(url, "www") ) {
-		if (boost::algorithm::contains(boost::algorithm::to_lower_copy(url), "walmart.ca") ) {
-			validatedURL = url;
+	ExecutorStats executorStats = ptrExecutor->getStats();
+	AsyncLogger::getShared().log(LOG_INFO, "Executor: {} threads, {} tasks, {} stolen, {} queued",
+		executorStats.numberWorkers, executorStats.numberExecuted, executorStats.numberStolen,
+		executorStats.numberQueued);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function implements the thread reporting the stages of the
+page pipeline every stageReportSeconds, until it is interrupted.
+* @param		none
+* @return		void
+*******************************************************************************
+*/
+void stageReportThread()
+{
+	try {
+		while (true) {
+			boost::this_thread::sleep(boost::posix_time::seconds(stageReportSeconds));
+			printStageStats();
 		}
-		else {
-			validatedURL = "";
-		}	
-	}		
-  
-  //finally check if the link has been processed
-  if (validatedURL != "") {
-  	//if the URL has been processed
-  	mutexLock.lock();
-  	if (completedSet.find(validatedURL) != completedSet.end()) {
-  		validatedURL = "";
-  	}
-  	mutexLock.unlock();
-  }
-  
-  //cout << "validation result: " << validatedURL << endl;
-  return validatedURL;
+	}
+	catch (boost::thread_interrupted&) {
+	}
 }
 
 
 
 /**
 *******************************************************************************
-* @brief		This function implements the processing thread.
-* @param		boost::shared_ptr< boost::asio::io_service >
+* @brief		This function counts the product records extracted, and records the
+time from the start of the crawl to each milestone they pass, which measures how
+soon the frontier reaches the product pages.
+* @param		int -- numberRecords (the records extracted from a page)
 * @return		void
 *******************************************************************************
 */
-void processingThread(boost::shared_ptr<boost::asio::io_service> ptrIOService)
+void countProducts(int numberRecords)
 {
-	mutexLock.lock();
-	std::cout << "[" << boost::this_thread::get_id() << "] Thread Start" << std::endl;
-	mutexLock.unlock();
+	long total = (numberProducts += numberRecords);
+	for (int i = 0; i < numberProductMilestones; i++) {
+		if (total - numberRecords < productMilestones[i] && total >= productMilestones[i]) {
+			long elapsedMs = (long)((Metrics::nowMicroseconds() - crawlBeginMicroseconds) / 1000);
+			Metrics::getShared().setOnce(productMilestoneMetrics[i], elapsedMs);
+			AsyncLogger::getShared().log(LOG_INFO, "The first {} products took {} ms",
+				productMilestones[i], elapsedMs);
+		}
+	}
+}
 
-	ptrIOService->run();
 
-	mutexLock.lock();
-	std::cout << "[" << boost::this_thread::get_id() << "] Thread Finish" << std::endl;
-	mutexLock.unlock();
+
+/**
+*******************************************************************************
+* @brief		This function pushes a link found on a page into the frontier if it
+is valid and has not been seen before.
+* @param		string -- link (the link on the HTML page)
+* @param		LinkOrigin -- linkOrigin (the depth of the link and the pattern of
+the page it was found on, which set its priority)
+* @return		bool -- return true if the link has been pushed
+*******************************************************************************
+*/
+bool pushLink(const string& link, const LinkOrigin& linkOrigin)
+{
+	//cout << "validating " << link << endl;
+	string validURL = validateURL(link, hostName);
+	//only the first page discovering the URL pushes it into the frontier
+	if (validURL == "" || !urlSeenFilter.insert(validURL)) {
+		return false;
+	}
+	crawlFrontier.push(validURL, linkOrigin);
+	size_t frontierDepth = crawlFrontier.pendingSize();
+	Metrics::getShared().record(frontierDepthMetric, frontierDepth);
+	Metrics::getShared().increment(linksDiscoveredMetric);
+	AsyncLogger::getShared().log(LOG_INFO, "The size of the frontier is {}", frontierDepth);
+	return true;
 }
 
 
 
 /**
 *******************************************************************************
-* @brief		This function defines the HTML parsing task.
-* @param		string -- url (the http URL of the HTML page)
+* @brief		This function pushes the links found by a LinkScanner.
+* @param		vector<ScannedLink> -- links (the scanned href values)
+* @param		LinkOrigin -- linkOrigin (the origin of the links)
+* @return		int -- the number of links pushed into the frontier
+*******************************************************************************
+*/
+int pushLinks(const vector<ScannedLink>& links, const LinkOrigin& linkOrigin)
+{
+	int numberPushed = 0;
+	for (size_t i = 0; i < links.size(); i++) {
+		string link = links[i].hasEntity ? LinkScanner::decodeEntities(links[i].value) :
+			string(links[i].value.data(), links[i].value.size());
+		if (pushLink(link, linkOrigin)) {
+			numberPushed++;
+		}
+	}
+	return numberPushed;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is called on a fetch engine thread each time a chunk
+of the page has arrived. It pushes the links found in the new bytes, so that
+they can be fetched before the download of this page is complete.
+* @param		boost::shared_ptr<IncrementalLinkScanner> -- ptrLinkScanner (the
+scanner state of this page)
+* @param		LinkOrigin -- linkOrigin (the origin of the links of this page)
+* @param		PageBuffer -- page (the page received so far)
 * @return		void
 *******************************************************************************
 */
-void parsingHTML(string url)
+void pageChunkReceived(boost::shared_ptr<IncrementalLinkScanner> ptrLinkScanner,
+	LinkOrigin linkOrigin, const PageBuffer& page)
 {
-	//validate the input url
-	string validatedURL = "";
-	validatedURL = validateURL(url, hostName);
-	//exit if the input URL is invalid
-	if (validatedURL == "")
+	vector<ScannedLink> links;
+	boost::uint64_t begin = Metrics::nowMicroseconds();
+	ptrLinkScanner->feed(page.data(), page.size(), links);
+	Metrics::getShared().record(linkExtractionMetric, Metrics::nowMicroseconds() - begin);
+	pushLinks(links, linkOrigin);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function returns the request headers which make the request of
+a URL conditional on the page having changed since the last crawl.
+* @param		string -- url (the validated URL)
+* @return		vector<string> -- If-None-Match / If-Modified-Since, or nothing if the
+URL has not been fetched before
+*******************************************************************************
+*/
+vector<string> getConditionalHeaders(const string& url)
+{
+	vector<string> requestHeaders;
+	URLMetadata metadata;
+	if (urlMetadataStore.get(url, metadata)) {
+		if (metadata.etag != "") {
+			requestHeaders.push_back("If-None-Match: " + metadata.etag);
+		}
+		if (metadata.lastModified != "") {
+			requestHeaders.push_back("If-Modified-Since: " + metadata.lastModified);
+		}
+	}
+	return requestHeaders;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the first stage of the page pipeline. It compares
+the page with the last crawl, records its validators and stores a new or changed
+page. A page answered with 304 is read back from the page store; if the stored
+copy is missing, the URL is queued again to be downloaded without condition.
+* @param		PageTask* -- ptrTask (the downloaded page, owned by the stage)
+* @return		void
+*******************************************************************************
+*/
+void storePage(PageTask* ptrTask)
+{
+	const FetchResult& result = ptrTask->result;
+	
+	//a 304 response has no body: take the copy stored by the last crawl
+	boost::shared_ptr<PageBuffer> ptrBody = result.ptrBody;
+	if (result.httpStatus == 304) {
+		PageRecord pageRecord;
+		if (pageStore.read(result.url, pageRecord) != 0) {
+			//forget the validators and queue the URL again, so that it is downloaded
+			//without condition; a request which had none is not retried
+			URLMetadata metadata;
+			bool isConditional = urlMetadataStore.get(result.url, metadata) &&
+				(metadata.etag != "" || metadata.lastModified != "");
+			metadata = URLMetadata();
+			metadata.fetchTime = result.fetchTime;
+			urlMetadataStore.update(result.url, metadata);
+			AsyncLogger::getShared().log(LOG_WARNING, "No stored copy of the unmodified page {}",
+				result.url);
+			//pushed before the task is done, so that the crawl is not seen as finished
+			if (isConditional) {
+				crawlFrontier.push(result.url, ptrTask->origin);
+			}
+			finishPage(ptrTask);
+			return;
+		}
+		ptrBody = pagePool.acquireBuffer();
+		ptrBody->append(pageRecord.body.data(), pageRecord.body.size());
+	}
+	
+	//get a recycled HTMLPage object
+	ptrTask->ptrHtmlPage = pagePool.acquirePage(result.url);
+	//init the HTMLPage object with the downloaded page
+	int initStatus = ptrTask->ptrHtmlPage->init(result.httpStatus, ptrBody);
+	if (initStatus == HTMLPage::INIT_FAILURE) {
+		finishPage(ptrTask);
 		return;
-		
-	cout << "[" << boost::this_thread::get_id() << "] is processing " << 
-		validatedURL << endl;
-		
-	//instantiate a HTMLPage object
-	HTMLPage htmlPage(validatedURL);
-	//init the HTMLPage object
-	htmlPage.init();
+	}
+	boost::shared_ptr<const PageBuffer> ptrHtmlPage = ptrTask->ptrHtmlPage->getPtrHtmlPage();
 	
-	//save the HTML page into a file
-  ofstream htmlFileStream;
-	stringstream strStream;
-	mutexLock.lock();
-	fileID++;
-	mutexLock.unlock();
-	strStream << "./data/page" << fileID << ".html";
-	string fileName=strStream.str();
-  htmlFileStream.open(fileName.c_str());
-  htmlFileStream << *htmlPage.getPtrHtmlPage();
-  htmlFileStream.close();
+	//compare the page with the last crawl and record its validators
+	URLMetadata metadata;
+	if (initStatus == HTMLPage::INIT_NOT_MODIFIED) {
+		urlMetadataStore.get(result.url, metadata);
+		ptrTask->isChanged = false;
+		numberNotModified++;
+	}
+	else {
+		boost::uint64_t contentHash = fingerprintBytes(ptrHtmlPage->data(), ptrHtmlPage->size());
+		if (urlMetadataStore.get(result.url, metadata) && metadata.contentHash == contentHash) {
+			ptrTask->isChanged = false;
+			numberUnchanged++;
+		}
+		metadata.etag = getHeaderValue(result.headers, "ETag");
+		metadata.lastModified = getHeaderValue(result.headers, "Last-Modified");
+		metadata.contentHash = contentHash;
+	}
+	metadata.fetchTime = result.fetchTime;
+	urlMetadataStore.update(result.url, metadata);
 	
-	//extract the links on the page
-	int numLinksExtracted;
-	numLinksExtracted = htmlPage.extractLinks();
-
-	boost::shared_ptr< set<string> > ptrLinkSet = htmlPage.getPtrLinkSet();
-	//insert the links into dispatchSet
-	int index = 0;	
-	for (set<string>::iterator it = ptrLinkSet->begin(); it != ptrLinkSet->end(); it++) {
-		//cout << "validating " << *it << endl;
-		string validURL = validateURL(*it, hostName);
-		if (validURL != "") {
-			index++;
-			mutexLock.lock();
-			dispatchSet.insert(validURL);
-			cout << "The size of the dispatchSet is " << dispatchSet.size() << endl;
-			mutexLock.unlock();
+	//save the new or changed HTML page with its fetch metadata into the page store,
+	//without waiting on a worker: the fetch engine threads wait for the writer
+	if (ptrTask->isChanged) {
+		pageStore.store(result.url, result.httpStatus, result.fetchTime, result.headers,
+			*ptrHtmlPage, false);
+	}
+	
+	//never blocks on a worker: the fetch engine threads wait for the later stages
+	if (!linkStage.push(ptrTask)) {
+		finishPage(ptrTask);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is the second stage of the page pipeline. It pushes
+the new links of the page into the frontier. A page answered with 304, or
+downloaded again with the same content, ends here: its links are extracted, since
+the pages it links to may have changed, but its information has been extracted
+by the last crawl.
+* @param		PageTask* -- ptrTask (the stored page, owned by the stage)
+* @return		void
+*******************************************************************************
+*/
+void extractPageLinks(PageTask* ptrTask)
+{
+	HTMLPage& htmlPage = *ptrTask->ptrHtmlPage;
+	
+	//extract the links on the page and insert the new links into the frontier
+	if (ptrTask->ptrLinkScanner) {
+		//only the tail after the last chunk is left to scan
+		boost::shared_ptr<const PageBuffer> ptrHtmlPage = htmlPage.getPtrHtmlPage();
+		vector<ScannedLink> links;
+		boost::uint64_t begin = Metrics::nowMicroseconds();
+		ptrTask->ptrLinkScanner->finish(ptrHtmlPage->data(), ptrHtmlPage->size(), links);
+		Metrics::getShared().record(linkExtractionMetric, Metrics::nowMicroseconds() - begin);
+		pushLinks(links, ptrTask->linkOrigin);
+	}
+	else {
+		boost::uint64_t begin = Metrics::nowMicroseconds();
+		htmlPage.extractLinks();
+		Metrics::getShared().record(linkExtractionMetric, Metrics::nowMicroseconds() - begin);
+		boost::shared_ptr< set<string> > ptrLinkSet = htmlPage.getPtrLinkSet();
+		for (set<string>::iterator it = ptrLinkSet->begin(); it != ptrLinkSet->end(); it++) {
+			pushLink(*it, ptrTask->linkOrigin);
 		}
-	}	
+	}
 	
-	//insert the processed link into the completedSet
-	mutexLock.lock();
-	completedSet.insert(htmlPage.getURL());
-	cout << "The size of completed set is " << completedSet.size() << endl;
-	mutexLock.unlock();
+	//count the processed link
+	int completed = ++numberCompleted;
+	AsyncLogger::getShared().log(LOG_INFO, "The size of completed set is {}", completed);
 	
-	//next extract the product information
+	//never blocks on a worker: the fetch engine threads wait for the later stages
+	if (!ptrTask->isChanged || !infoStage.push(ptrTask)) {
+		finishPage(ptrTask);
+	}
+}
+
+
 
+/**
+*******************************************************************************
+* @brief		This function is the last stage of the page pipeline. It extracts
+the product information of a new or changed page and hands the records over to
+the database writer without waiting, since a worker must not block; the fetch
+engine threads wait instead while the database is behind. Without a database the
+records are kept in productRecordBatch, saved at the end of the crawl. The number
+of records is fed back to the prioritizer of the frontier.
+* @param		PageTask* -- ptrTask (the page, owned by the stage)
+* @return		void
+*******************************************************************************
+*/
+void extractPageInfo(PageTask* ptrTask)
+{
+	HTMLPage& htmlPage = *ptrTask->ptrHtmlPage;
+	boost::uint64_t begin = Metrics::nowMicroseconds();
+	int numberRecords = htmlPage.extractInfo(extractionRules);
+	Metrics::getShared().record(infoExtractionMetric, Metrics::nowMicroseconds() - begin);
+	urlPrioritizer.recordYield(ptrTask->result.url, ptrTask->origin, numberRecords);
+	if (numberRecords > 0) {
+		countProducts(numberRecords);
+		RecordBatchView pageRecords = htmlPage.getPtrRecordBatch()->view();
+		if (ptrRecordSink) {
+			//may exceed the queue limit by the records of the pages in the pipeline
+			ptrRecordSink->submit(pageRecords, false);
+		}
+		else {
+			boost::mutex::scoped_lock lock(productMutex);
+			productRecordBatch.append(pageRecords);
+		}
+	}
+	finishPage(ptrTask);
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function ends the processing of a page at whichever stage it
+leaves the pipeline. The task is reported as done only then, so that the in-flight
+limit of the frontier also bounds the pages inside the pipeline, and a checkpoint
+never sees a page whose links or records are still queued.
+* @param		PageTask* -- ptrTask (the page, deleted here)
+* @return		void
+*******************************************************************************
+*/
+void finishPage(PageTask* ptrTask)
+{
+	crawlFrontier.taskDone(ptrTask->result.url);
+	delete ptrTask;
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function is called on a fetch engine thread when a download 
+completes. It hands the page over to the store stage, blocking the fetch engine
+thread while a stage of the pipeline, the queue of the page store or the queue of
+the database writer is full, since the workers of the executor never block.
+* @param		boost::shared_ptr<IncrementalLinkScanner> -- ptrLinkScanner (the
+scanner state of this page, or NULL)
+* @param		LinkOrigin -- origin (where the page was found)
+* @param		LinkOrigin -- linkOrigin (the origin of the links of the page)
+* @param		FetchResult -- result (the downloaded page)
+* @return		void
+*******************************************************************************
+*/
+void pageFetched(boost::shared_ptr<IncrementalLinkScanner> ptrLinkScanner,
+	LinkOrigin origin, LinkOrigin linkOrigin, const FetchResult& result)
+{
+	if (result.curlCode != CURLE_OK || result.httpStatus >= 400) {
+		Metrics::getShared().increment(fetchErrorsMetric);
+	}
+	else {
+		Metrics::getShared().increment(pagesFetchedMetric);
+	}
+	if (result.ptrBody) {
+		Metrics::getShared().increment(bytesFetchedMetric, (long)result.ptrBody->size());
+	}
+	PageTask* ptrTask = new PageTask;
+	ptrTask->result = result;
+	ptrTask->origin = origin;
+	ptrTask->linkOrigin = linkOrigin;
+	ptrTask->ptrLinkScanner = ptrLinkScanner;
+	ptrTask->isChanged = true;
+	pageStore.waitForSpace();
+	if (ptrRecordSink) {
+		ptrRecordSink->waitForSpace();
+	}
+	if (!storeStage.push(ptrTask)) {
+		finishPage(ptrTask);
+	}
+}
+
+
+
+/**
+*******************************************************************************
+* @brief		This function parses a rate given on the command line.
+* @param		char* -- text (the argument)
+* @param		double& -- rate (output, the rate, set only if it is valid)
+* @return		bool -- return true if the argument is a finite number above 0
+*******************************************************************************
+*/
+bool parseRate(const char* text, double& rate)
+{
+	char* end;
+	double value = strtod(text, &end);
+	if (end == text || *end != '\0' || !(value > 0) || value >= HUGE_VAL) {
+		return false;
+	}
+	rate = value;
+	return true;
 }
 
 
@@ -175,86 +575,299 @@ void parsingHTML(string url)
 /**
 *******************************************************************************
 * @brief		This function is the entrance to the program.
-* @param		string -- url (the http URL of the HTML page)
-* @return		int -- return 0 if successful, or 0 if unsuccessful
+* @param		int -- argc (the number of arguments)
+* @param		char** -- argv (the arguments: --resume to continue the crawl from
+the last checkpoint, --checkpoint-seconds N to set the checkpoint interval,
+--mysql user[:password]@host[:port]/database to write the product records into
+MySQL, --mysql-batch N and --mysql-flush-ms N to set the batching of the inserts,
+--threads N to set the number of threads running the page pipeline (default one
+per core), --pin-threads to pin them to the cores, --stage-report-seconds N to
+set the interval of the stage reports, --site URL to crawl another site than
+www.walmart.ca, e.g. a local synthetic site, --resolve host:port:address to pin
+a host to an address, --requests-per-second N to set the request rate per host
+(above 0),
+--metrics-file FILE and --metrics-seconds N to set where and how often the
+metrics are exported, --log-level debug|info|warning|error to set the lowest
+level of the messages written, --breadth-first to crawl the links in the order
+of their discovery instead of the pages likely to hold products first,
+--frontier-memory N to set the number of pending links kept in memory, the
+others being spilled to disk, 0 for no limit, --seen-filter exact|bloom[:rate]
+to record the discovered links exactly (default) or in a Bloom filter of fixed
+memory with the given false-positive rate, default 0.001)
+* @return		int -- return 0 if successful, or 1 if unsuccessful
 *******************************************************************************
 */
-int main( )
+int main(int argc, char* argv[])
 {
-	//start timestamp
-	clock_t begin=clock();
+	//start timestamp: the elapsed time and the CPU time of all the threads
+	boost::posix_time::ptime begin = boost::posix_time::microsec_clock::universal_time();
+	long cpuBegin = getCPUMicroseconds();
 	
 	//the input URL: the web site that we want to extract the data
 	string webSiteURL = "http://www.walmart.ca/en";
+	//the limits of the requests sent to a host
+	PolitenessConfig politenessConfig;
+	
+	//parse the arguments
+	bool isResuming = false;
+	bool isWritingMySQL = false;
+	LogLevel logLevel = LOG_INFO;
+	URLSeenFilter::Mode seenFilterMode = URLSeenFilter::EXACT;
+	double seenFalsePositiveRate = 0.001;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--resume") == 0) {
+			isResuming = true;
+		}
+		else if (strcmp(argv[i], "--checkpoint-seconds") == 0 && i + 1 < argc) {
+			checkpointSeconds = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--mysql") == 0 && i + 1 < argc && mysqlConfig.parse(argv[i + 1])) {
+			isWritingMySQL = true;
+			i++;
+		}
+		else if (strcmp(argv[i], "--mysql-batch") == 0 && i + 1 < argc) {
+			mysqlConfig.batchSize = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--mysql-flush-ms") == 0 && i + 1 < argc) {
+			mysqlConfig.flushIntervalMs = atol(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			numberWorkerThreads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--pin-threads") == 0) {
+			isPinningThreads = true;
+		}
+		else if (strcmp(argv[i], "--stage-report-seconds") == 0 && i + 1 < argc) {
+			stageReportSeconds = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--site") == 0 && i + 1 < argc) {
+			webSiteURL = argv[++i];
+			//the links of the site are completed with its scheme, host and port
+			size_t hostStart = webSiteURL.find("://");
+			hostStart = (hostStart == string::npos) ? 0 : hostStart + 3;
+			hostName = webSiteURL.substr(0, webSiteURL.find_first_of("/?#", hostStart));
+		}
+		else if (strcmp(argv[i], "--resolve") == 0 && i + 1 < argc) {
+			FetchContext::getShared().addResolve(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--requests-per-second") == 0 && i + 1 < argc &&
+				parseRate(argv[i + 1], politenessConfig.requestsPerSecond)) {
+			i++;
+		}
+		else if (strcmp(argv[i], "--metrics-file") == 0 && i + 1 < argc) {
+			metricsFileName = argv[++i];
+		}
+		else if (strcmp(argv[i], "--metrics-seconds") == 0 && i + 1 < argc) {
+			metricsSeconds = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc &&
+				AsyncLogger::parseLevel(argv[i + 1], logLevel)) {
+			AsyncLogger::getShared().setLevel(logLevel);
+			i++;
+		}
+		else if (strcmp(argv[i], "--breadth-first") == 0) {
+			crawlFrontier.setPrioritizer(NULL);
+		}
+		else if (strcmp(argv[i], "--frontier-memory") == 0 && i + 1 < argc) {
+			frontierMemoryURLs = atol(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seen-filter") == 0 && i + 1 < argc &&
+				URLSeenFilter::parseMode(argv[i + 1], seenFilterMode, seenFalsePositiveRate)) {
+			urlSeenFilter.reset(seenFilterMode, expectedSeenURLs, seenFalsePositiveRate);
+			i++;
+		}
+		else {
+			cerr << "Usage: " << argv[0] << " [--resume] [--checkpoint-seconds N]" <<
+				" [--mysql user[:password]@host[:port]/database] [--mysql-batch N]" <<
+				" [--mysql-flush-ms N] [--threads N] [--pin-threads]" <<
+				" [--stage-report-seconds N] [--site URL] [--resolve host:port:address]" <<
+				" [--requests-per-second N] [--metrics-file FILE] [--metrics-seconds N]" <<
+				" [--log-level debug|info|warning|error] [--breadth-first]" <<
+				" [--frontier-memory N] [--seen-filter exact|bloom[:rate]]" << endl;
+			return 1;
+		}
+	}
+	
+	//compile the extraction rules
+	if (extractionRules.load("./extraction.rules") != 0) {
+		return 1;
+	}
+	
+	//open the page store and the metadata of the previous crawls in the data folder
+	if (pageStore.open() != 0 || urlMetadataStore.open() != 0) {
+		return 1;
+	}
+	
+	//bound the memory of the frontier before it is filled
+	if (frontierMemoryURLs > 0 && crawlFrontier.startSpilling("./data", frontierMemoryURLs) != 0) {
+		return 1;
+	}
+	
+	//connect to the database before the crawl starts
+	if (isWritingMySQL) {
+		ptrRecordSink.reset(new MySQLRecordSink(mysqlConfig));
+		if (ptrRecordSink->open() != 0) {
+			return 1;
+		}
+	}
+	
+	//restore the frontier, the seen URLs and the records of the last crawl
+	if (isResuming) {
+		long numberResumed = crawlCheckpoint.load();
+		if (numberResumed < 0) {
+			return 1;
+		}
+		cout << "Resumed from checkpoint " << crawlCheckpoint.getSequence() << ": " <<
+			numberResumed << " links to crawl, " << numberCompleted << " completed." << endl;
+	}
 	
 	//validate the input url
 	string validatedURL = validateURL(webSiteURL, hostName);
 	//cout << validatedURL << endl;
 	
-	//pase the input URL
-	if (validatedURL != "") {
-		parsingHTML(validatedURL);
+	//seed the frontier with the input URL (already seen when resuming)
+	if (validatedURL != "" && urlSeenFilter.insert(validatedURL)) {
+		crawlFrontier.push(validatedURL);
 	}
 	
-	//variable to control the termination of processing threads
-	int isFinished = 0;
-
-	/****Set up multti-thread ***************/
-	//instantiate an io_service object
-	boost::shared_ptr<boost::asio::io_service> ptrIOService(new boost::asio::io_service);		
-	//define the processing thread associated with the io_service object
-	boost::shared_ptr<boost::asio::io_service::work> ptrProcessingThread (
-		new boost::asio::io_service::work(*ptrIOService) );
-	//creat the processing thread pool
-	int numberThreads = 4;
-	boost::thread_group processingThreadGroup;
-	for (int i = 0; i < numberThreads; i++) {
-		processingThreadGroup.create_thread( 
-			boost::bind(processingThread/*function to create a thread*/, ptrIOService/*argument*/));
+	//write the starting state, then checkpoint in the background
+	if (checkpointSeconds > 0) {
+		crawlCheckpoint.write(true);
+		crawlCheckpoint.start(checkpointSeconds);
 	}
 
+	/****Set up the page pipeline ***************/
+	//start the worker threads running the stages, and the thread reporting them
+	ptrExecutor.reset(new WorkStealingExecutor(numberWorkerThreads, isPinningThreads));
+	storeStage.setNextStage(linkStage);
+	linkStage.setNextStage(infoStage);
+	storeStage.start(*ptrExecutor);
+	linkStage.start(*ptrExecutor);
+	infoStage.start(*ptrExecutor);
+	boost::thread stageReporter;
+	if (stageReportSeconds > 0) {
+		stageReporter = boost::thread(stageReportThread);
+	}
+	//the time to the first products, from the start of the dispatch
+	for (int i = 0; i < numberProductMilestones; i++) {
+		stringstream nameStream;
+		nameStream << "time_to_first_" << productMilestones[i] << "_products_ms";
+		productMilestoneMetrics[i] = Metrics::getShared().addGauge(nameStream.str());
+	}
+	crawlBeginMicroseconds = Metrics::nowMicroseconds();
+	//export the metrics in the background
+	if (metricsSeconds > 0) {
+		Metrics::getShared().start(metricsFileName, metricsSeconds);
+	}
+
+	//the fetch engine downloading the pages
+	FetchEngine fetchEngine(numberFetchThreads, maxTransfers, 32,
+		boost::bind(&PagePool::acquireBuffer, &pagePool));
+	//the scheduler limiting the request rate and concurrency per host
+	PolitenessScheduler politenessScheduler(fetchEngine, politenessConfig);
+
 	/******* dispatch the tasks **************/
+	/*pop() blocks while the frontier is empty or all transfers are busy, and 
+	returns false once no URL is pending and no task is in flight */
 	string selectedURL = "";
-	while (isFinished == 0) {
-		//pick a task from dispatchSet
-		mutexLock.lock();
-		if (dispatchSet.size() > 0 ) {
-			selectedURL = *dispatchSet.begin();
-			dispatchSet.erase(dispatchSet.begin());
+	LinkOrigin origin;
+	while (crawlFrontier.pop(selectedURL, origin)) {
+	  //cout << "Fetching " << selectedURL << endl;
+		//the links of the page are one level deeper, and found on its pattern
+		LinkOrigin linkOrigin(origin.depth + 1, urlPrioritizer.getPatternID(selectedURL));
+		boost::shared_ptr<IncrementalLinkScanner> ptrLinkScanner;
+		FetchProgressCallback progressCallback;
+		if (isStreamingLinks) {
+			ptrLinkScanner.reset(new IncrementalLinkScanner(LinkScanner::HREF));
+			progressCallback = boost::bind(pageChunkReceived, ptrLinkScanner, linkOrigin, _1);
 		}
-	  mutexLock.unlock();	
-	  
-	  //post the task
-	  if (selectedURL != "") {
-	  	//cout << "Posting " << selectedURL << endl;
-	  	ptrIOService->post(boost::bind(parsingHTML, selectedURL));
-	  }
-	  
-	  //check if the dispatchSet is empty
-	  mutexLock.lock();
-	  if (dispatchSet.empty() ) {
-	  	isFinished = 1;
-	  }
-	  mutexLock.unlock();	  
+	  politenessScheduler.submit(selectedURL, 
+	  	boost::bind(pageFetched, ptrLinkScanner, origin, linkOrigin, _1), progressCallback,
+	  	getConditionalHeaders(selectedURL));
 	} //end of while-loop
 
-	//signal the processing threads to exit once they finish the ongoing tasks.
-	ptrProcessingThread.reset();
-	//all threads in the thread_group join
-	processingThreadGroup.join_all();
+	//stop the scheduler and the fetch engine threads
+	politenessScheduler.stop();
+	fetchEngine.stop();
+	//drain the stages in the order of the pipeline
+	storeStage.close();
+	linkStage.close();
+	infoStage.close();
+	ptrExecutor->stop();
+	stageReporter.interrupt();
+	stageReporter.join();
+	printStageStats();
+	//export the final metrics
+	Metrics::getShared().stop();
+	if (metricsSeconds > 0) {
+		Metrics::getShared().exportFile(metricsFileName);
+	}
+	//write the queued messages before the summary
+	AsyncLogger::getShared().stop();
+	//write the pages still queued for the page store
+	pageStore.close();
+	if (ptrRecordSink) {
+		ptrRecordSink->close();
+	}
+	urlMetadataStore.close();
+	//record the finished crawl, so that a resume has nothing left to do
+	if (checkpointSeconds > 0) {
+		crawlCheckpoint.stop();
+		crawlCheckpoint.write(true);
+		cout << "Checkpoint " << crawlCheckpoint.getSequence() << ": " <<
+			crawlCheckpoint.getLastCheckpointBytes() << " bytes." << endl;
+	}
+	crawlFrontier.stopSpilling();
 	
-	//print out all the processed links
-	int indexProcessedLink = 0;
-	cout << "The following HTTP links have been processed: " << endl;
-	for (set<string>::iterator it = completedSet.begin(); it != completedSet.end(); it++) {
-		indexProcessedLink++;
-		cout << "Link " << indexProcessedLink << ": " << *it << endl;
-	}
-
-	//record the total executation time
-  clock_t end = clock();
-  double elapsedTime = 1000*(double(end-begin) / CLOCKS_PER_SEC);
-  cout << "Done." << "This program totally consumed " << elapsedTime << " ms." << endl;
+	//print out the number of processed links
+	cout << numberCompleted << " HTTP links have been processed, " << 
+		urlSeenFilter.size() << " links have been discovered." << endl;
+	cout << pageStore.getNumberRecords() << " pages stored, " << 
+		pageStore.getNumberBytes() << " bytes written." << endl;
+	//save the records for analytics, to be read with MappedRecordBatch; with MySQL
+	//only the records restored from a checkpoint of a crawl without it are left here
+	if (!ptrRecordSink || productRecordBatch.size() > 0) {
+		productRecordBatch.view().writeFile("./data/products.rec");
+		cout << productRecordBatch.size() << " product records saved, " <<
+			productRecordBatch.memoryUsage() << " bytes." << endl;
+	}
+	if (ptrRecordSink) {
+		cout << ptrRecordSink->getNumberRecordsWritten() << " product records written to MySQL in " <<
+			ptrRecordSink->getNumberBatches() << " statements, " <<
+			ptrRecordSink->getNumberRecordsFailed() << " failed." << endl;
+	}
+	cout << numberNotModified << " pages not modified (304), " << numberUnchanged <<
+		" downloaded again without a change." << endl;
+	FetchContextStats fetchStats = FetchContext::getShared().getStats();
+	cout << fetchStats.numberTransfers << " transfers: " <<
+		(int)(fetchStats.connectionReuseRate * 100) << "% reused a connection, " <<
+		(int)(fetchStats.dnsHitRate * 100) << "% of the new connections hit the DNS cache, " <<
+		fetchStats.numberTLSHandshakes << " TLS handshakes (mean " << fetchStats.meanTLSHandshakeMs <<
+		" ms), mean connection setup " << fetchStats.meanSetupMs << " ms." << endl;
+	cout << PageBuffer::getNumberCopies() << " copies of page bytes were made, " <<
+		PageBuffer::getNumberBytesCopied() << " bytes copied." << endl;
+	cout << "Page objects reused " << pagePool.getNumberPageHits() << ", allocated " <<
+		pagePool.getNumberPageMisses() << "; page buffers reused " << 
+		pagePool.getNumberBufferHits() << ", allocated " << pagePool.getNumberBufferMisses() << endl;
+	long numberAllocations = getNumberAllocations();
+	if (numberAllocations >= 0 && numberCompleted > 0) {
+		cout << numberAllocations / numberCompleted << " heap allocations per page." << endl;
+	}
+	cout << "Peak RSS: " << getPeakRSSKilobytes() << " KB." << endl;
+	cout << urlPrioritizer.getNumberPatterns() << " URL patterns scored by the frontier." << endl;
+	cout << "The seen-URL filter uses " << urlSeenFilter.memoryUsage() << " bytes, " <<
+		"expected false-positive rate " << urlSeenFilter.expectedFalsePositiveRate() << endl;
+
+	Metrics::getShared().print(cout);
+	long numberDropped = AsyncLogger::getShared().getNumberDropped();
+	if (numberDropped > 0) {
+		cout << numberDropped << " log messages dropped." << endl;
+	}
+
+	//record the total execution time: clock() would count the CPU time of the threads
+	long elapsedMs = (boost::posix_time::microsec_clock::universal_time() - begin).total_milliseconds();
+	cout << "Done." << "This program took " << elapsedMs << " ms (" <<
+		(getCPUMicroseconds() - cpuBegin) / 1000 << " ms of CPU time)." << endl;
 
 	return 0;
 }